@@ -0,0 +1,221 @@
+#!/usr/bin/env python3
+#
+# This file is distributed under the University of Illinois Open Source
+# License. See LICENSE.TXT for details.
+#
+"""Run klc3 over the workloads in workloads.json and compare with a baseline.
+
+Each workload runs with fixed seeds and limits. The result of each run is
+taken from the last sample of klc3's -stats-file (instructions, states and
+solver queries), while wall time and peak RSS are measured on the process.
+
+    run_benchmark.py --klc3 <klc3> --output result.json
+    run_benchmark.py --klc3 <klc3> --baseline baseline.json
+    run_benchmark.py --klc3 <klc3> --output baseline.json   # new baseline
+    run_benchmark.py --compare result.json --baseline baseline.json
+
+A metric regresses if it exceeds the baseline by more than its threshold
+(a ratio, see --threshold). The exit code is 1 if any metric regresses.
+
+The fa18 mp1 and mp2 examples are not included, as they come without the
+input specification and gold programs to run them.
+"""
+
+import argparse
+import glob
+import json
+import os
+import shutil
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+REPO_ROOT = os.path.dirname(SCRIPT_DIR)
+
+METRICS = ['wall_time', 'peak_rss', 'inst', 'states', 'queries']
+
+# Counters are deterministic with fixed seeds unless a run hits the time limit
+DEFAULT_THRESHOLDS = {
+    'wall_time': 0.10,
+    'peak_rss': 0.10,
+    'inst': 0.02,
+    'states': 0.02,
+    'queries': 0.05,
+}
+
+
+def load_workloads(filename):
+    with open(filename) as f:
+        config = json.load(f)
+    workloads = []
+    for w in config['workloads']:
+        if 'glob' in w:
+            # One workload per file, which is run alone
+            base = os.path.join(REPO_ROOT, w['dir'])
+            for path in sorted(glob.glob(os.path.join(base, w['glob']))):
+                rel = os.path.relpath(path, base)
+                workloads.append({
+                    'name': w['name'] + '/' + os.path.splitext(rel)[0].split(os.sep, 1)[-1],
+                    'dir': w['dir'],
+                    'args': w.get('args', []) + [rel],
+                })
+        else:
+            workloads.append(w)
+    return config.get('common_args', []), config.get('max_time', 0), workloads
+
+
+def run_workload(klc3, common_args, max_time, workload, work_dir):
+    out_dir = os.path.join(work_dir, workload['name'].replace('/', '_'))
+    stats_file = os.path.join(work_dir, workload['name'].replace('/', '_') + '.jsonl')
+    cmd = [klc3] + common_args + [
+        '--output-dir=' + out_dir,
+        '--stats-file=' + stats_file,
+        '--stats-interval=3600',  # only the final sample is used
+    ]
+    if workload.get('max_time', max_time):
+        cmd.append('--max-time=%ds' % workload.get('max_time', max_time))
+    cmd += workload['args']
+
+    with open(os.path.join(work_dir, workload['name'].replace('/', '_') + '.log'), 'w') as log:
+        start = time.monotonic()
+        proc = subprocess.Popen(cmd, cwd=os.path.join(REPO_ROOT, workload['dir']), stdout=log,
+                                stderr=subprocess.STDOUT)
+        _, status, rusage = os.wait4(proc.pid, 0)
+        wall_time = time.monotonic() - start
+    proc.returncode = os.WEXITSTATUS(status) if os.WIFEXITED(status) else -os.WTERMSIG(status)
+
+    result = {
+        'wall_time': wall_time,
+        'peak_rss': rusage.ru_maxrss,  # [KB] on Linux
+        'exit_code': proc.returncode,
+    }
+    try:
+        with open(stats_file) as f:
+            sample = json.loads(f.read().splitlines()[-1])
+        result['inst'] = sample['inst']
+        result['states'] = sample['states']
+        result['queries'] = sample['queries']
+    except (OSError, IndexError, ValueError, KeyError):
+        pass  # klc3 stops before exploration, such as on assembly errors
+    return result
+
+
+def run_all(args):
+    common_args, max_time, workloads = load_workloads(args.workloads)
+    if args.filter:
+        workloads = [w for w in workloads if args.filter in w['name']]
+
+    work_dir = tempfile.mkdtemp(prefix='klc3-benchmark-')
+    results = {}
+    try:
+        for w in workloads:
+            runs = [run_workload(args.klc3, common_args, max_time, w, work_dir) for _ in range(args.repeat)]
+            # Median of wall time and RSS, counters of the first run
+            result = dict(runs[0])
+            result['wall_time'] = statistics.median(r['wall_time'] for r in runs)
+            result['peak_rss'] = statistics.median(r['peak_rss'] for r in runs)
+            results[w['name']] = result
+            print('%-48s %8.2f s %8d KB %10s inst %8s states %8s queries' % (
+                w['name'], result['wall_time'], result['peak_rss'], result.get('inst', '-'),
+                result.get('states', '-'), result.get('queries', '-')))
+            sys.stdout.flush()
+    finally:
+        if args.keep:
+            print('Output kept in ' + work_dir)
+        else:
+            shutil.rmtree(work_dir, ignore_errors=True)
+
+    return {
+        'klc3': os.path.abspath(args.klc3),
+        'time': time.strftime('%Y-%m-%dT%H:%M:%S'),
+        'repeat': args.repeat,
+        'results': results,
+    }
+
+
+def compare(current, baseline, thresholds):
+    regressions = 0
+    print('\n%-48s %-10s %14s %14s %9s' % ('Workload', 'Metric', 'Baseline', 'Current', 'Change'))
+    for name, base in sorted(baseline['results'].items()):
+        cur = current['results'].get(name)
+        if cur is None:
+            print('%-48s missing in the current result' % name)
+            continue
+        if cur.get('exit_code') != base.get('exit_code'):
+            print('%-48s %-10s %14s %14s  REGRESSION' % (name, 'exit_code', base.get('exit_code'),
+                                                        cur.get('exit_code')))
+            regressions += 1
+        for metric in METRICS:
+            if metric not in base or metric not in cur:
+                continue
+            b, c = base[metric], cur[metric]
+            change = (c - b) / b if b else (0.0 if c == b else float('inf'))
+            mark = ''
+            if change > thresholds[metric]:
+                mark = '  REGRESSION'
+                regressions += 1
+            elif change < -thresholds[metric]:
+                mark = '  improved'
+            if mark or change != 0:
+                print('%-48s %-10s %14.2f %14.2f %+8.1f%%%s' % (name, metric, b, c, change * 100, mark))
+    for name in sorted(set(current['results']) - set(baseline['results'])):
+        print('%-48s not in the baseline' % name)
+    print('\n%d regression(s)' % regressions)
+    return regressions
+
+
+def parse_thresholds(items):
+    thresholds = dict(DEFAULT_THRESHOLDS)
+    for item in items:
+        metric, _, value = item.partition('=')
+        if metric not in thresholds:
+            raise argparse.ArgumentTypeError('unknown metric ' + metric)
+        thresholds[metric] = float(value)
+    return thresholds
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--klc3', help='klc3 binary to run')
+    parser.add_argument('--workloads', default=os.path.join(SCRIPT_DIR, 'workloads.json'))
+    parser.add_argument('--filter', help='only run workloads whose names contain this string')
+    parser.add_argument('--repeat', type=int, default=1, help='runs of each workload, taking the median time')
+    parser.add_argument('--output', help='write the result to this JSON file')
+    parser.add_argument('--compare', help='compare an existing result instead of running klc3')
+    parser.add_argument('--baseline', help='baseline result to compare with (ignored if it does not exist)')
+    parser.add_argument('--threshold', action='append', default=[], metavar='METRIC=RATIO',
+                        help='allowed increase over the baseline, such as wall_time=0.2 (defaults: %s)' %
+                             ', '.join('%s=%g' % it for it in DEFAULT_THRESHOLDS.items()))
+    parser.add_argument('--keep', action='store_true', help='keep klc3 output and logs')
+    args = parser.parse_args()
+
+    thresholds = parse_thresholds(args.threshold)
+
+    if args.compare:
+        with open(args.compare) as f:
+            current = json.load(f)
+    else:
+        if not args.klc3:
+            parser.error('--klc3 is required unless --compare is given')
+        current = run_all(args)
+        if args.output:
+            with open(args.output, 'w') as f:
+                json.dump(current, f, indent=2, sort_keys=True)
+                f.write('\n')
+
+    if args.baseline:
+        if not os.path.exists(args.baseline):
+            print('No baseline at %s, skip comparison' % args.baseline)
+            return 0
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        if compare(current, baseline, thresholds) > 0:
+            return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -13,8 +13,11 @@
 #include "State.h"
 #include "MemoryValue.h"
 #include "MemoryManager.h"
+#include "SolverCostTracker.h"
 #include "StateAllocator.hpp"
 
+#include "klee/Expr/ArrayCache.h"
+
 namespace klc3 {
 
 /**
@@ -23,12 +26,23 @@ namespace klc3 {
  * @note Each State has an instance of MemoryManager. baseMem is managed by this Executor, which holds the memory when
  *       the program starts.
  * @note Life cycles of Arrays are not managed by this Executor.
+ * @note With -sym-addr-mode=array, runs of data in baseMem (split at labels and symbolic variables) are modeled as
+ *       memory regions. A symbolic LDR/STR inside a region reads from or appends to an UpdateList of the region
+ *       instead of forking a state per address. The state only forks if the address may leave the region, and the
+ *       part outside is handled by forking as usual, to keep the warnings on wild reads and writes.
  */
 class Executor : protected WithBuilder {
 
 public:
 
-    Executor(ExprBuilder *builder, Solver *solver, const map<uint16_t, ref<MemValue>> &baseMem);
+    /**
+     * @param builder
+     * @param solver
+     * @param baseMem
+     * @param arrayCache  To create arrays of memory regions. Nullptr to always fork on symbolic addresses.
+     */
+    Executor(ExprBuilder *builder, Solver *solver, const map<uint16_t, ref<MemValue>> &baseMem,
+             klee::ArrayCache *arrayCache = nullptr);
 
     State *createInitState(const vector<ref<Expr>> &constraints, uint16_t initPC, IssuePackage *issuePackage);
 
@@ -36,25 +50,114 @@ public:
 
     State *forkState(State *s) { return stateAllocator.fork(s); }
 
+    /**
+     * Allocate a state with no constraint and nothing written, for example to restore a spilled state into
+     * @param pc
+     * @param issuePackage
+     * @return
+     */
+    State *createBlankState(uint16_t pc, IssuePackage *issuePackage) {
+        return stateAllocator.createInitState(builder, baseMem, pc, issuePackage);
+    }
+
     int getAllocatedStateCount() const { return stateAllocator.getAllocatedStateCount(); }
 
     int getAliveStateCount() const { return stateAllocator.getAliveStateCount(); }
 
     void releaseState(State *state) { stateAllocator.releaseState(state); }
 
+    const StateAllocator &getStateAllocator() const { return stateAllocator; }
+
+    /**
+     * @param tracker  Attribute solver cost and forks to instructions. Nullptr to stop tracking.
+     */
+    void setSolverCostTracker(SolverCostTracker *tracker) { solverCostTracker = tracker; }
+
     klee::Statistic symAddrCacheHits;
     klee::Statistic symAddrCacheMisses;
 
+    size_t getMemRegionCount() const { return memRegions.size(); }
+
+    /**
+     * Get the words of regions whose contents are kept in memRegionUpdates, which may not be up to date in mem yet
+     * @param s
+     * @param words  Filled with the value of each word by address
+     */
+    void getMemRegionWords(const State *s, map<uint16_t, ref<Expr>> &words) const;
+
 private:
 
     Solver *solver;
 
     ref<MemValue> baseMem[0x10000];
 
+    // Instructions in baseMem indexed by address (nullptr for others), kept alive by baseMem. Since a state is broken
+    // once it tries to overwrite an instruction (ERR_OVERWRITE_INST), these stay valid for every state.
+    InstValue *instTable[0x10000];
+
     ConstraintSet initConstraints;
 
     StateAllocator stateAllocator;
 
+    SolverCostTracker *solverCostTracker = nullptr;
+
+    struct MemRegion {
+        uint16_t start;
+        uint16_t size;
+        UpdateList base;  // contents in baseMem
+    };
+
+    vector<MemRegion> memRegions;
+
+    vector<int> memRegionIndex;  // index in memRegions by address, -1 for none. Empty if not using memory regions.
+
+    void setupMemRegions(klee::ArrayCache *arrayCache);
+
+    /**
+     * Split a state on whether a symbolic address stays in the memory region of one of its possible values
+     * @param s        [in/out] Constrained to the address in the region, if a region is returned
+     * @param addr
+     * @param forWrite
+     * @param ir
+     * @param content  [out] Contents of the region (see getMemRegionContent())
+     * @param outside  [out] Fork of s with the address outside the region, or nullptr if it must be inside
+     * @return The region, or nullptr to fork on the address as usual (s untouched)
+     */
+    const MemRegion *splitOnMemRegion(State *s, const ref<Expr> &addr, bool forWrite, const ref<InstValue> &ir,
+                                      UpdateList &content, State *&outside);
+
+    /**
+     * Get the current contents of a memory region
+     * @param s
+     * @param region
+     * @param forWrite
+     * @param content  [out]
+     * @return False if the region can't be accessed as an array, as it holds uninitialized values or values to be
+     *         warned about on reading (or writing, if forWrite)
+     */
+    bool getMemRegionContent(const State *s, const MemRegion &region, bool forWrite, UpdateList &content) const;
+
+    /**
+     * Bring a word in mem up to date with memRegionUpdates, through memWriteData(), before it's accessed at a concrete
+     * address
+     * @param s
+     * @param addr
+     * @param ir  Instruction accessing the word
+     */
+    void materializeMemRegionWord(State *s, uint16_t addr, const ref<InstValue> &ir);
+
+    /**
+     * Bring all words of a region up to date and drop its contents from memRegionUpdates
+     * @param s
+     * @param region
+     * @param ir
+     */
+    void materializeMemRegion(State *s, const MemRegion &region, const ref<InstValue> &ir);
+
+    void materializeMemRegions(State *s, const ref<InstValue> &ir);
+
+    bool executeStep(State *s, StateVector &result, bool returnImmediatelyIfWillFork);
+
     void fetchInst(State *s, ref<InstValue> &ir);
 
     void updateIRAndPC(State *s, const ref<klc3::InstValue> &ir);
@@ -77,6 +180,29 @@ private:
                             vector<pair<uint16_t, ref<Expr>>> &result, int &solverCount,
                             int maxPossibleValueCount = -1) const;
 
+    /**
+     * Enumerate values by repeatedly getting a model and blocking the found value (expr != val)
+     * @param expr
+     * @param constraints [in/out]  blocking constraints of found values are appended
+     * @param result
+     * @param solverCount
+     * @param maxPossibleValueCount
+     * @param maxQueryCount  -1 for unlimited. One more query is made after the budget to check whether there are
+     *                       values left, so that constraints are still satisfiable if not exhausted
+     * @param exhausted [out]  whether all values have been found
+     * @return false if there are more than maxPossibleValueCount values
+     */
+    bool evalPossibleValuesByModel(const ref<Expr> &expr, ConstraintSet &constraints,
+                                   vector<pair<uint16_t, ref<Expr>>> &result, int &solverCount,
+                                   int maxPossibleValueCount, int maxQueryCount, bool &exhausted) const;
+
+    /**
+     * Enumerate values by binary search on bits, min and max, then splitting the range
+     */
+    bool evalPossibleValuesByRange(const ref<Expr> &expr, const ConstraintSet &constraints,
+                                   vector<pair<uint16_t, ref<Expr>>> &result, int &solverCount,
+                                   int maxPossibleValueCount = -1) const;
+
     bool evalPossibleValuesInRange(const ref<Expr> &expr, const ConstraintSet &constraints,
                                    long minVal, long maxVal,
                                    vector<pair<uint16_t, ref<Expr>>> &result, int &solverCount,
@@ -124,7 +250,18 @@ private:
     void handleExprST(State *s, const ref<Expr> &addr, const ref<Expr> &value, const ref<InstValue> &ir,
                       StateVector &result);
 
-    Issue::Type memWriteData(State *s, uint16_t addr, const ref<Expr> &value, const ref<InstValue> &ir);
+    /**
+     * Write a memory location, checking for issues
+     * @param s
+     * @param addr
+     * @param value
+     * @param ir
+     * @param syncMemRegion  Whether to append the write to memRegionUpdates. False when bringing mem up to date with
+     *                       it.
+     * @return
+     */
+    Issue::Type memWriteData(State *s, uint16_t addr, const ref<Expr> &value, const ref<InstValue> &ir,
+                             bool syncMemRegion = true);
 
     /**
      * Read a memory location.
@@ -138,7 +275,7 @@ private:
      * @param dr      If the data is to be read into a register, pass the register to here. If not pass -1.
      * @return
      */
-    Issue::Type memReadData(State *s, uint16_t addr, ref<Expr> &result, const ref<InstValue> &ir, int dr) const;
+    Issue::Type memReadData(State *s, uint16_t addr, ref<Expr> &result, const ref<InstValue> &ir, int dr);
 
     ref<Expr> getReg(State *s, Reg reg, const ref<InstValue> &ir, bool bypassUninitialized = false);
 
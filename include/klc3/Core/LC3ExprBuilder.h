@@ -0,0 +1,166 @@
+//
+// Created by liuzikai on 10/17/26.
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+
+#ifndef KLC3_LC3EXPRBUILDER_H
+#define KLC3_LC3EXPRBUILDER_H
+
+#include "klc3/Common.h"
+
+#include "llvm/ADT/SmallVector.h"
+
+namespace klc3 {
+
+/**
+ * ExprBuilder layer that canonicalizes 16-bit expressions produced by common LC-3 idioms, on top of a base builder
+ * (usually the constant folding one), so that queries reaching the solver are smaller and cache better.
+ *
+ * Add, Sub, Mul by a constant and Not are normalized as a sum of terms, c_0 + c_1 * t_1 + ... + c_n * t_n (mod 2^16),
+ * with terms sorted. So NOT then ADD #1 becomes negation, repeated ADD R,R,R becomes one multiplication by 2^k, and
+ * terms that cancel out are dropped.
+ *
+ * Eq over sums is solved for a single term (odd coefficients are inverted, even ones drop the high bits), or split
+ * into the two sides otherwise, so that "NOT, ADD #1, ADD, BRz" compares the two operands directly. AND with a
+ * constant folds nested masks and masks that keep all bits that may be set, and a single-bit mask tested against zero
+ * becomes a bit extraction.
+ *
+ * Slt and Sle against 0 (BR conditions) on a sum become a sign bit extraction if the sum is a term times 2^k, or an
+ * unsigned comparison of the positive and negative terms if the bits that may be set in the terms show that the
+ * subtraction can't overflow. Otherwise the overflow is part of the LC-3 semantics and the comparison is kept.
+ *
+ * Expressions of other widths are passed to the base builder as they are.
+ */
+class LC3ExprBuilder : public ExprBuilder {
+public:
+
+    /**
+     * @param base  Builder to construct expressions with. Owned by this builder.
+     */
+    explicit LC3ExprBuilder(ExprBuilder *base) : base(base) {}
+
+    ~LC3ExprBuilder() override { delete base; }
+
+    ref<Expr> Constant(const llvm::APInt &Value) override { return base->Constant(Value); }
+
+    ref<Expr> NotOptimized(const ref<Expr> &Index) override { return base->NotOptimized(Index); }
+
+    ref<Expr> Read(const UpdateList &Updates, const ref<Expr> &Index) override { return base->Read(Updates, Index); }
+
+    ref<Expr> Select(const ref<Expr> &Cond, const ref<Expr> &LHS, const ref<Expr> &RHS) override {
+        return base->Select(Cond, LHS, RHS);
+    }
+
+    ref<Expr> Concat(const ref<Expr> &LHS, const ref<Expr> &RHS) override { return base->Concat(LHS, RHS); }
+
+    ref<Expr> Extract(const ref<Expr> &LHS, unsigned Offset, Expr::Width W) override {
+        return base->Extract(LHS, Offset, W);
+    }
+
+    ref<Expr> ZExt(const ref<Expr> &LHS, Expr::Width W) override { return base->ZExt(LHS, W); }
+
+    ref<Expr> SExt(const ref<Expr> &LHS, Expr::Width W) override { return base->SExt(LHS, W); }
+
+    ref<Expr> Add(const ref<Expr> &LHS, const ref<Expr> &RHS) override;
+
+    ref<Expr> Sub(const ref<Expr> &LHS, const ref<Expr> &RHS) override;
+
+    ref<Expr> Mul(const ref<Expr> &LHS, const ref<Expr> &RHS) override;
+
+    ref<Expr> UDiv(const ref<Expr> &LHS, const ref<Expr> &RHS) override { return base->UDiv(LHS, RHS); }
+
+    ref<Expr> SDiv(const ref<Expr> &LHS, const ref<Expr> &RHS) override { return base->SDiv(LHS, RHS); }
+
+    ref<Expr> URem(const ref<Expr> &LHS, const ref<Expr> &RHS) override { return base->URem(LHS, RHS); }
+
+    ref<Expr> SRem(const ref<Expr> &LHS, const ref<Expr> &RHS) override { return base->SRem(LHS, RHS); }
+
+    ref<Expr> Not(const ref<Expr> &LHS) override;
+
+    ref<Expr> And(const ref<Expr> &LHS, const ref<Expr> &RHS) override;
+
+    ref<Expr> Or(const ref<Expr> &LHS, const ref<Expr> &RHS) override { return base->Or(LHS, RHS); }
+
+    ref<Expr> Xor(const ref<Expr> &LHS, const ref<Expr> &RHS) override { return base->Xor(LHS, RHS); }
+
+    ref<Expr> Shl(const ref<Expr> &LHS, const ref<Expr> &RHS) override { return base->Shl(LHS, RHS); }
+
+    ref<Expr> LShr(const ref<Expr> &LHS, const ref<Expr> &RHS) override { return base->LShr(LHS, RHS); }
+
+    ref<Expr> AShr(const ref<Expr> &LHS, const ref<Expr> &RHS) override { return base->AShr(LHS, RHS); }
+
+    ref<Expr> Eq(const ref<Expr> &LHS, const ref<Expr> &RHS) override;
+
+    ref<Expr> Ne(const ref<Expr> &LHS, const ref<Expr> &RHS) override { return base->Eq(False(), Eq(LHS, RHS)); }
+
+    ref<Expr> Ult(const ref<Expr> &LHS, const ref<Expr> &RHS) override { return base->Ult(LHS, RHS); }
+
+    ref<Expr> Ule(const ref<Expr> &LHS, const ref<Expr> &RHS) override { return base->Ule(LHS, RHS); }
+
+    ref<Expr> Ugt(const ref<Expr> &LHS, const ref<Expr> &RHS) override { return base->Ult(RHS, LHS); }
+
+    ref<Expr> Uge(const ref<Expr> &LHS, const ref<Expr> &RHS) override { return base->Ule(RHS, LHS); }
+
+    ref<Expr> Slt(const ref<Expr> &LHS, const ref<Expr> &RHS) override;
+
+    ref<Expr> Sle(const ref<Expr> &LHS, const ref<Expr> &RHS) override;
+
+    ref<Expr> Sgt(const ref<Expr> &LHS, const ref<Expr> &RHS) override { return Slt(RHS, LHS); }
+
+    ref<Expr> Sge(const ref<Expr> &LHS, const ref<Expr> &RHS) override { return Sle(RHS, LHS); }
+
+private:
+
+    ExprBuilder *base;
+
+    // c_0 + c_1 * t_1 + ... + c_n * t_n (mod 2^16)
+    struct Sum {
+        uint16_t constant = 0;
+        llvm::SmallVector<std::pair<ref<Expr>, uint16_t>, 8> terms;  // (t_i, c_i), c_i != 0 after decompose()
+    };
+
+    /**
+     * Decompose lhsCoefficient * lhs + rhsCoefficient * rhs into a sum of terms, added to sum
+     * @param rhs  Can be nullptr
+     * @return False if there are too many terms or nodes, in which case the expression should be built as it is
+     */
+    static bool decompose(const ref<Expr> &lhs, uint16_t lhsCoefficient, const ref<Expr> &rhs,
+                          uint16_t rhsCoefficient, Sum &sum);
+
+    static bool addTerms(const ref<Expr> &e, uint16_t coefficient, Sum &sum, unsigned &budget);
+
+    ref<Expr> build(const Sum &sum);
+
+    /**
+     * Build e < 0, e <= 0, e > 0 or e >= 0 for a 16-bit e built by this builder
+     */
+    enum SignTest {
+        LT_ZERO,
+        LE_ZERO,
+        GT_ZERO,
+        GE_ZERO
+    };
+
+    ref<Expr> buildSignTest(const ref<Expr> &e, SignTest test);
+
+    /**
+     * Build (t == value) for a single term
+     */
+    ref<Expr> buildTermEq(const ref<Expr> &t, uint16_t value);
+
+    /**
+     * Build bit i of a 16-bit expression as a Bool
+     */
+    ref<Expr> buildBit(const ref<Expr> &e, unsigned i);
+
+    /**
+     * Bits that may be 1 in a 16-bit expression, which is also an upper bound of its unsigned value
+     */
+    static uint16_t mayBeOneBits(const ref<Expr> &e, unsigned depth = 4);
+};
+
+}
+
+#endif //KLC3_LC3EXPRBUILDER_H
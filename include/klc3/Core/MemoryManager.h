@@ -15,6 +15,10 @@ namespace klc3 {
 
 /**
  * Memory manager
+ * @note Memory written by the program is kept in a persistent radix tree (4 levels of 16 slots, indexed by the
+ *       nibbles of the address). Copying a MemoryManager only copies the root reference, so forking a State is
+ *       O(1) no matter how much memory has been written. A write copies only the shared nodes on the path to the
+ *       slot (at most 4 nodes). Slots never written fall through to baseMem.
  */
 class MemoryManager : protected WithBuilder {
 public:
@@ -45,15 +49,81 @@ public:
 
     WriteResult writeInst(uint16_t addr, uint16_t IR);
 
-    size_t memUsage() const { return mem.size(); }
+    // Number of memory slots written in this MemoryManager (not including baseMem)
+    size_t memUsage() const { return slotCount; }
+
+    // Values written in this MemoryManager (not including baseMem), in the order of addresses
+    vector<ref<MemValue>> writtenValues() const;
+
+    /**
+     * Visit addresses whose values differ from another MemoryManager on the same baseMem. Subtrees shared by both
+     * (such as those untouched since the two forked) are skipped.
+     * @param other
+     * @param visitor  Called with (addr, value in this, value in other). Values fall through to baseMem as read().
+     */
+    template<class Visitor>
+    void forEachDifference(const MemoryManager &other, Visitor visitor) const;
 
 private:
 
     ref<MemValue> *baseMem;
 
-    std::unordered_map<uint16_t, ref<MemValue>> mem;  // memory slots
+    template<class T>
+    struct TrieNode {
+        T slots[16];
+
+        // Required by klee::ref-managed objects
+        class klee::ReferenceCounter _refCount;
+    };
+
+    using LeafNode = TrieNode<ref<MemValue>>;   // indexed by addr[3:0]
+    using Level2Node = TrieNode<ref<LeafNode>>;  // indexed by addr[7:4]
+    using Level1Node = TrieNode<ref<Level2Node>>;  // indexed by addr[11:8]
+    using RootNode = TrieNode<ref<Level1Node>>;  // indexed by addr[15:12]
+
+    ref<RootNode> root;  // memory slots, shared among copies until written
+
+    size_t slotCount = 0;
+
+    /**
+     * Make sure node is exclusively owned by this MemoryManager before modifying it
+     * @param node  Null node will be allocated. Shared node will be replaced by a copy of itself.
+     * @return The node that can be modified in place
+     */
+    template<class T>
+    static T *mutableNode(ref<T> &node);
+
+    // Child of a node, or null if the node is null
+    template<class T>
+    static auto childOf(const ref<T> &node, unsigned i) -> typename std::decay<decltype(node->slots[i])>::type {
+        return node.isNull() ? nullptr : node->slots[i];
+    }
 };
 
+template<class Visitor>
+void MemoryManager::forEachDifference(const MemoryManager &other, Visitor visitor) const {
+    assert(baseMem == other.baseMem && "Comparing MemoryManagers of different baseMem");
+    if (root.get() == other.root.get()) return;
+    for (unsigned i1 = 0; i1 < 16; i1++) {
+        ref<Level1Node> a1 = childOf(root, i1), b1 = childOf(other.root, i1);
+        if (a1.get() == b1.get()) continue;
+        for (unsigned i2 = 0; i2 < 16; i2++) {
+            ref<Level2Node> a2 = childOf(a1, i2), b2 = childOf(b1, i2);
+            if (a2.get() == b2.get()) continue;
+            for (unsigned i3 = 0; i3 < 16; i3++) {
+                ref<LeafNode> a3 = childOf(a2, i3), b3 = childOf(b2, i3);
+                if (a3.get() == b3.get()) continue;
+                for (unsigned i4 = 0; i4 < 16; i4++) {
+                    ref<MemValue> a = childOf(a3, i4), b = childOf(b3, i4);
+                    if (a.get() == b.get()) continue;
+                    auto addr = (uint16_t) ((i1 << 12U) | (i2 << 8U) | (i3 << 4U) | i4);
+                    visitor(addr, a.isNull() ? baseMem[addr] : a, b.isNull() ? baseMem[addr] : b);
+                }
+            }
+        }
+    }
+}
+
 }
 
 
@@ -188,7 +188,7 @@ public:
         CC_NZP = 7
     };
 
-    InstValue(uint16_t addr, ref <Expr> IR) : MemValue(addr, std::move(IR)) {}
+    InstValue(uint16_t addr, ref <Expr> IR) : MemValue(addr, std::move(IR)), raw_(castConstant(e)) {}
 
     /**
      * Dynamically allocate an InstValue
@@ -208,7 +208,7 @@ public:
 
     bool isRET() const { return (instID() == JMP && baseR() == 7); }
 
-    uint16_t ir() const { return castConstant(e); }
+    uint16_t ir() const { return raw_; }  // decoded once, since e is constant and never changes
 
     Reg dr() const { return (Reg) ((ir() >> 9) & 0x7); }
 
@@ -258,6 +258,8 @@ public:
 
 private:
 
+    uint16_t raw_;
+
     InstDef def_;
 
     bool matchInst();
@@ -0,0 +1,225 @@
+//
+// Created by liuzikai on 10/17/26.
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+
+#ifndef KLC3_PERSISTENTVECTOR_HPP
+#define KLC3_PERSISTENTVECTOR_HPP
+
+#include "klc3/Common.h"
+
+#include <iterator>
+#include <memory>
+
+namespace klc3 {
+
+/**
+ * An append-mostly sequence whose copies share their common prefix.
+ *
+ * Elements are stored in ref-counted chunks of CHUNK_SIZE, each pointing to the previous one, and the vector only
+ * holds the last chunk. Copying is O(1). Appending or popping copies the last chunk (at most CHUNK_SIZE elements)
+ * if it is shared with other copies, and never touches the previous chunks. So for histories of forked states,
+ * memory grows with divergence rather than with depth times the number of states.
+ *
+ * All chunks but the last are full, so element i is at offset i % CHUNK_SIZE of chunk i / CHUNK_SIZE.
+ * back() is O(1). Random access walks back from the last chunk. Iteration collects the chunks once.
+ *
+ * @note Provides what std::stack needs, so it can be used as the container of a stack.
+ */
+template<class T, unsigned CHUNK_SIZE = 16>
+class PersistentVector {
+private:
+
+    struct Chunk {
+        ref<Chunk> prev;
+        unsigned count = 0;
+        T items[CHUNK_SIZE];
+
+        // Required by klee::ref-managed objects
+        class klee::ReferenceCounter _refCount;
+    };
+
+public:
+
+    using value_type = T;
+    using size_type = size_t;
+    using reference = T &;
+    using const_reference = const T &;
+
+    class const_iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T *;
+        using reference = const T &;
+
+        const_iterator() = default;
+
+        reference operator*() const { return (*chunks)[index / CHUNK_SIZE]->items[index % CHUNK_SIZE]; }
+        pointer operator->() const { return &**this; }
+        reference operator[](difference_type n) const { return *(*this + n); }
+
+        const_iterator &operator++() { ++index; return *this; }
+        const_iterator operator++(int) { const_iterator ret = *this; ++index; return ret; }
+        const_iterator &operator--() { --index; return *this; }
+        const_iterator operator--(int) { const_iterator ret = *this; --index; return ret; }
+        const_iterator &operator+=(difference_type n) { index += n; return *this; }
+        const_iterator &operator-=(difference_type n) { index -= n; return *this; }
+        const_iterator operator+(difference_type n) const { const_iterator ret = *this; return ret += n; }
+        const_iterator operator-(difference_type n) const { const_iterator ret = *this; return ret -= n; }
+        difference_type operator-(const const_iterator &it) const { return (difference_type) index - it.index; }
+
+        bool operator==(const const_iterator &it) const { return index == it.index; }
+        bool operator!=(const const_iterator &it) const { return index != it.index; }
+        bool operator<(const const_iterator &it) const { return index < it.index; }
+        bool operator>(const const_iterator &it) const { return index > it.index; }
+        bool operator<=(const const_iterator &it) const { return index <= it.index; }
+        bool operator>=(const const_iterator &it) const { return index >= it.index; }
+
+    private:
+        std::shared_ptr<const vector<const Chunk *>> chunks;  // null for end()
+        size_t index = 0;
+
+        const_iterator(std::shared_ptr<const vector<const Chunk *>> chunks, size_t index)
+                : chunks(std::move(chunks)), index(index) {}
+
+        friend class PersistentVector;
+    };
+
+    using iterator = const_iterator;  // elements are only modified through back() or operator[]
+
+    PersistentVector() = default;
+
+    PersistentVector(std::initializer_list<T> init) {
+        for (const auto &item : init) push_back(item);
+    }
+
+    template<class InputIt>
+    PersistentVector(InputIt first, InputIt last) {
+        for (; first != last; ++first) push_back(*first);
+    }
+
+    size_t size() const { return tail.isNull() ? 0 : chunkCount() * CHUNK_SIZE - CHUNK_SIZE + tail->count; }
+
+    bool empty() const { return tail.isNull(); }
+
+    void clear() { tail = nullptr; }
+
+    const T &back() const {
+        assert(!empty());
+        return tail->items[tail->count - 1];
+    }
+
+    T &back() {
+        assert(!empty());
+        return mutableTail()->items[tail->count - 1];
+    }
+
+    const T &front() const { return (*this)[0]; }
+
+    const T &operator[](size_t i) const { return chunkAt(i)->items[i % CHUNK_SIZE]; }
+
+    T &operator[](size_t i) {
+        assert(i < size() && "Index out of range");
+        // Copy the shared chunks from the last one back to the one holding i (path copying)
+        ref<Chunk> *chunk = &tail;
+        for (size_t n = tailIndex - i / CHUNK_SIZE;; n--) {
+            if ((*chunk)->_refCount.getCount() > 1) *chunk = new Chunk(**chunk);
+            if (n == 0) break;
+            chunk = &(*chunk)->prev;
+        }
+        return (*chunk)->items[i % CHUNK_SIZE];
+    }
+
+    void push_back(const T &value) {
+        if (tail.isNull() || tail->count == CHUNK_SIZE) {
+            ref<Chunk> chunk = new Chunk();
+            chunk->prev = tail;
+            tail = chunk;
+            tailIndex = (tail->prev.isNull() ? 0 : tailIndex + 1);
+        }
+        Chunk *chunk = mutableTail();
+        chunk->items[chunk->count++] = value;
+    }
+
+    template<class... Args>
+    T &emplace_back(Args &&... args) {
+        push_back(T(std::forward<Args>(args)...));
+        return back();
+    }
+
+    void pop_back() {
+        assert(!empty());
+        if (tail->count == 1) {
+            tail = tail->prev;
+            if (!tail.isNull()) tailIndex--;
+        } else {
+            Chunk *chunk = mutableTail();
+            chunk->items[--chunk->count] = T();  // release the element
+        }
+    }
+
+    const_iterator begin() const {
+        auto chunks = std::make_shared<vector<const Chunk *>>(chunkCount());
+        size_t i = chunks->size();
+        for (const Chunk *chunk = tail.get(); chunk != nullptr; chunk = chunk->prev.get()) {
+            (*chunks)[--i] = chunk;
+        }
+        return const_iterator(std::move(chunks), 0);
+    }
+
+    const_iterator end() const { return const_iterator(nullptr, size()); }
+
+    const_iterator cbegin() const { return begin(); }
+
+    const_iterator cend() const { return end(); }
+
+    bool operator==(const PersistentVector &v) const {
+        if (tail.get() == v.tail.get()) return true;  // shared
+        return size() == v.size() && std::equal(begin(), end(), v.begin());
+    }
+
+    bool operator!=(const PersistentVector &v) const { return !(*this == v); }
+
+    bool operator<(const PersistentVector &v) const {
+        return std::lexicographical_compare(begin(), end(), v.begin(), v.end());
+    }
+
+    bool operator>(const PersistentVector &v) const { return v < *this; }
+
+    bool operator<=(const PersistentVector &v) const { return !(v < *this); }
+
+    bool operator>=(const PersistentVector &v) const { return !(*this < v); }
+
+private:
+
+    ref<Chunk> tail;
+
+    size_t tailIndex = 0;  // index of the tail chunk, valid if tail is not null
+
+    size_t chunkCount() const { return tail.isNull() ? 0 : tailIndex + 1; }
+
+    const Chunk *chunkAt(size_t i) const {
+        assert(i < size() && "Index out of range");
+        const Chunk *chunk = tail.get();
+        for (size_t n = tailIndex - i / CHUNK_SIZE; n > 0; n--) chunk = chunk->prev.get();
+        return chunk;
+    }
+
+    /**
+     * Make sure the last chunk is exclusively owned by this vector before modifying it
+     */
+    Chunk *mutableTail() {
+        if (tail->_refCount.getCount() > 1) {
+            tail = new Chunk(*tail);  // copying the chunk only increases the reference count of the previous one
+        }
+        return tail.get();
+    }
+};
+
+}
+
+#endif //KLC3_PERSISTENTVECTOR_HPP
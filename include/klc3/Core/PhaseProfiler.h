@@ -0,0 +1,168 @@
+//
+// Created by liuzikai on 10/17/26.
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+
+#ifndef KLC3_PHASEPROFILER_H
+#define KLC3_PHASEPROFILER_H
+
+#include "klc3/Common.h"
+
+#include <array>
+#include <chrono>
+
+namespace klc3 {
+
+/**
+ * Break down the run time of klc3 into phases of the main loop.
+ *
+ * Phases nest. A nested phase pauses the enclosing one, so the time of each phase is exclusive and the times of all
+ * phases sum up to the time since construction. Time that no scope covers is charged to OTHER.
+ *
+ * Each enter/leave reads a monotonic clock once. Profiling is optional, so scopes take a nullable profiler and cost a
+ * null check when it is disabled.
+ */
+class PhaseProfiler {
+public:
+
+    enum Phase {
+        OTHER,
+        EXECUTOR_STEP,
+        COVERAGE_UPDATE,
+        SUBROUTINE_UPDATE,
+        SEARCHER,
+        GOLD_EXECUTION,
+        CROSS_CHECK,
+        MAINTENANCE,  // progress report, spilling, checkpoints and stats file
+        VARIABLE_INDUCTION,
+        RESULT_GENERATION,
+        PHASE_COUNT
+    };
+
+    /**
+     * Short name of a phase, used as keys in the stats file
+     * @param phase
+     * @return
+     */
+    static const char *getPhaseName(Phase phase);
+
+    PhaseProfiler();
+
+    PhaseProfiler(const PhaseProfiler &) = delete;
+
+    void enter(Phase phase);
+
+    void leave();
+
+    /**
+     * RAII scope of a phase
+     */
+    class Scope {
+    public:
+        /**
+         * @param profiler  Nullptr if profiling is disabled
+         * @param phase
+         */
+        Scope(PhaseProfiler *profiler, Phase phase) : profiler(profiler) {
+            if (profiler) profiler->enter(phase);
+        }
+
+        Scope(const Scope &) = delete;
+
+        ~Scope() {
+            if (profiler) profiler->leave();
+        }
+
+    private:
+        PhaseProfiler *profiler;
+    };
+
+    /**
+     * @param phase
+     * @return Exclusive time of a phase in microseconds, including the running one
+     */
+    uint64_t getTime(Phase phase) const;
+
+    /**
+     * @return Time since construction in microseconds
+     */
+    uint64_t getTotalTime() const;
+
+    /**
+     * @param phase
+     * @return Times that a phase is entered
+     */
+    uint64_t getCount(Phase phase) const { return counts[phase]; }
+
+    /**
+     * Print a table of the count, time and share of each phase
+     * @param os
+     */
+    void printBreakdown(llvm::raw_ostream &os) const;
+
+private:
+
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point startTime;
+    Clock::time_point lastSwitch;  // when the running phase is entered or resumed
+    vector<Phase> stack;  // running phases, the innermost at the back
+
+    std::array<Clock::duration, PHASE_COUNT> times{};
+    std::array<uint64_t, PHASE_COUNT> counts{};
+};
+
+/**
+ * Time series of the exploration, written every few seconds by the main loop.
+ *
+ * A file ending with ".csv" is written as CSV with a header line. Otherwise, each sample is a line of JSON. Rates are
+ * over the interval since the last sample.
+ */
+class StatsFile {
+public:
+
+    struct Sample {
+        int allocatedStates;
+        int aliveStates;
+        long long totalInst;
+        uint64_t solverQueries;  // queries that reach the underlying solver
+        uint64_t solverTime;  // [us]
+        float coverage;
+        size_t issueCount;
+    };
+
+    /**
+     * @param filename
+     * @param profiler  Must outlive this object
+     */
+    StatsFile(const string &filename, const PhaseProfiler *profiler);
+
+    StatsFile(const StatsFile &) = delete;
+
+    /**
+     * @return Whether the file is opened
+     */
+    bool isOpen() const { return os != nullptr; }
+
+    /**
+     * Append a sample and flush it, so that a worker process forked afterwards does not write it again
+     * @param sample
+     */
+    void write(const Sample &sample);
+
+private:
+
+    std::unique_ptr<llvm::raw_fd_ostream> os;
+    const PhaseProfiler *profiler;
+    bool csv;
+
+    bool hasLast = false;
+    uint64_t lastTime = 0;  // [us]
+    Sample last{};
+};
+
+}
+
+#endif //KLC3_PHASEPROFILER_H
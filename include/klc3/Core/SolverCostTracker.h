@@ -0,0 +1,100 @@
+//
+// Created by liuzikai on 10/17/26.
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+
+#ifndef KLC3_SOLVERCOSTTRACKER_H
+#define KLC3_SOLVERCOSTTRACKER_H
+
+#include "MemoryValue.h"
+
+#include <chrono>
+
+namespace klc3 {
+
+/**
+ * Attribute solver cost and forks to the instructions that cause them, to find the lines of a test program that make
+ * the exploration explode.
+ *
+ * Solver calls are wrapped in a Scope of the instruction: BR conditions, symbolic addresses of LDR/STR (and other
+ * memory accesses with symbolic addresses), and comparison with gold, which is attributed to the last instruction of
+ * the test program before it halts.
+ */
+class SolverCostTracker {
+public:
+
+    struct Cost {
+        uint64_t calls = 0;  // times that the instruction asks the solver
+        uint64_t queries = 0;  // queries that reach the underlying solver, cache hits excluded
+        uint64_t time = 0;  // [us] spent in the solver chain
+        uint64_t forks = 0;  // states forked
+
+        void add(const Cost &other) {
+            calls += other.calls;
+            queries += other.queries;
+            time += other.time;
+            forks += other.forks;
+        }
+    };
+
+    /**
+     * RAII scope of solver calls for an instruction
+     */
+    class Scope {
+    public:
+        /**
+         * @param tracker  Nullptr if not tracking
+         * @param inst     Nullptr to skip attribution
+         */
+        Scope(SolverCostTracker *tracker, const InstValue *inst);
+
+        Scope(const Scope &) = delete;
+
+        ~Scope();
+
+    private:
+        SolverCostTracker *tracker;
+        const InstValue *inst;
+        std::chrono::steady_clock::time_point startTime;
+        uint64_t startQueries = 0;
+    };
+
+    void addForks(const InstValue *inst, uint64_t count);
+
+    /**
+     * @param inst
+     * @return Nullptr if the instruction has no cost
+     */
+    const Cost *getCost(const InstValue *inst) const;
+
+    /**
+     * @return Max solver time of an instruction in microseconds
+     */
+    uint64_t getMaxTime() const;
+
+    bool empty() const { return costs.empty(); }
+
+    /**
+     * Print costs aggregated by source lines, the most expensive first
+     * @param os
+     * @param maxLines  Max count of lines to print, 0 for all
+     */
+    void printReport(llvm::raw_ostream &os, size_t maxLines = 0) const;
+
+private:
+
+    struct Entry {
+        ref<InstValue> inst;  // keep the instruction alive
+        Cost cost;
+    };
+
+    unordered_map<const InstValue *, Entry> costs;
+
+    Cost &costOf(const InstValue *inst);
+};
+
+}
+
+#endif //KLC3_SOLVERCOSTTRACKER_H
@@ -42,16 +42,38 @@ public:
      */
     ref<Expr> getReg(Reg r) const {
         assert(r <= R_R7 && "Use getReg only for R0-R7");
+        if (reg[r].isNull() && (concreteRegMask & (1u << r))) {
+            reg[r] = buildConstant(concreteReg[r]);  // materialize a concrete register on demand
+        }
         return reg[r];
     }
 
+    /**
+     * Get value stored in a register if it is concrete, without building an Expr
+     * @param r  The register index
+     * @param value [out]
+     * @return False if the register is symbolic or uninitialized
+     */
+    bool getConcreteReg(Reg r, uint16_t &value) const {
+        assert(r <= R_R7 && "Use getConcreteReg only for R0-R7");
+        if (concreteRegMask & (1u << r)) {
+            value = concreteReg[r];
+            return true;
+        }
+        if (!reg[r].isNull() && reg[r]->getKind() == Expr::Constant) {
+            value = castConstant(reg[r]);
+            return true;
+        }
+        return false;
+    }
+
     uint16_t getPC() const { return pc; }
 
     ref<Expr> getIR() const { return ir; }
 
     ref<Expr> getCCExpr() const {
         // NUM_REGS for uninitialized CC
-        return ccRef <= R_R7 ? reg[ccRef] : nullptr;
+        return ccRef <= R_R7 ? getReg(ccRef) : nullptr;
     }
 
     Reg getCCSrcReg() const { return ccRef; }
@@ -59,9 +81,15 @@ public:
     void setReg(Reg r, const ref<Expr> &value) {
         assert(r <= R_R7 && "Use getReg only for R0-R7");
         reg[r] = value;
+        concreteRegMask &= ~(1u << r);
     }
 
-    void setReg(Reg r, uint16_t value) { setReg(r, buildConstant(value)); }
+    void setReg(Reg r, uint16_t value) {
+        assert(r <= R_R7 && "Use getReg only for R0-R7");
+        concreteReg[r] = value;
+        concreteRegMask |= (1u << r);
+        reg[r] = nullptr;  // built by getReg() only when needed
+    }
 
     void setCC(Reg r) { ccRef = r; }
 
@@ -74,7 +102,7 @@ public:
     MemoryManager mem;
     IssuePackage *issuePackage;
 
-    vector<ref<Expr>> lc3Out;
+    PersistentVector<ref<Expr>> lc3Out;
 
     /**
      * Propose a new state issue. If non-null location is given, this function assert that it is the last node of path.
@@ -106,13 +134,20 @@ public:
     ref<InstValue> ccChangeLocation;
     unordered_map<uint16_t, pair<Reg, ref<InstValue>>> memStoringUninitReg;
 
+    // Contents of memory regions written with symbolic addresses, by the start address of the region. An entry is
+    // authoritative over mem, whose words are brought up to date when accessed at concrete addresses or when the state
+    // completes (see Executor::materializeMemRegionWord). A missing entry is rebuilt from mem.
+    unordered_map<uint16_t, UpdateList> memRegionUpdates;
+
+    size_t checkedOutputLength = 0;  // output checked against the gold program before halting (-stream-output-check)
+
     // ================ Filled by CoverageTracker ================
     bool coveredNewEdge = false;  // should not get copied when fork
     Path statePath;  // guiding edges (see Edge::isGuidingEdge(), init PC edge included) + last edge till HALTED/BROKEN
 
     // ================ Filled by SubroutineTracker ================
-    stack<uint16_t> colorStack;
-    stack<Node *> jsrStack;
+    stack<uint16_t, PersistentVector<uint16_t>> colorStack;
+    stack<Node *, PersistentVector<Node *>> jsrStack;
     bool stackHasMessedUp = false;
 
     // ================ Filled by PruningSearcher ================
@@ -123,10 +158,11 @@ public:
         uint16_t loopColor = 0;
     };
 
-    vector<LoopLayer> loopStack;
+    vector<LoopLayer> loopStack;  // as shallow as the loop nesting, and copying a LoopLayer is O(1)
 
     bool coveredNewSegment = false;  // should not get copied when fork
     bool avoidLoopReductionPostpone = false;  // should not get copied when fork
+    bool postponed = false;  // held in the postponed list, should not get copied when fork
 
     // NOTICE: whenever adding fields, make sure it get copied in copy constructor
 
@@ -150,10 +186,12 @@ private:
      */
     State(const State &s);
 
-    State *fork() const;  // can only called from StateAllocator for unified management
-
     int uid;  // unique ID assigned by the StateAllocator
 
+    // Intrusive list of alive states, maintained by the StateAllocator (not copied)
+    State *prevAlive = nullptr;
+    State *nextAlive = nullptr;
+
     friend class StateAllocator;
 
 private:
@@ -162,7 +200,9 @@ private:
 
     uint16_t pc;
     ref<Expr> ir;
-    array<ref<Expr>, 8> reg;  // R0-R7, nullptr for uninitialized register;
+    mutable array<ref<Expr>, 8> reg;  // R0-R7, nullptr for uninitialized register or not yet materialized concrete value
+    array<uint16_t, 8> concreteReg;  // raw values of concrete registers, valid if the bit in concreteRegMask is set
+    uint8_t concreteRegMask = 0;
     Reg ccRef; // the last Reg that was set to be CC, NUM_REGS for uninitialized CC
 
     // NOTICE: whenever adding fields, make sure it get copied in copy constructor
@@ -15,41 +15,54 @@ namespace klc3 {
 /**
  * This class manage the life cycle of States.
  * When releasing a state, it's user's responsibility to make sure the pointer to be released is not used elsewhere.
+ * @note States are constructed in slabs of STATES_PER_SLAB slots and released slots are reused, since a run creates
+ *       and releases a large number of short-lived states. Alive states are linked through State::prevAlive and
+ *       State::nextAlive, so that releasing a state is O(1).
  */
 class StateAllocator {
 public:
 
+    static constexpr unsigned STATES_PER_SLAB = 64;
+
+    StateAllocator() = default;
+
+    StateAllocator(const StateAllocator &) = delete;
+
+    StateAllocator &operator=(const StateAllocator &) = delete;
+
     State *createInitState(ExprBuilder *builder, ref<MemValue> *baseMemArray, uint16_t initPC, IssuePackage *issuePackage) {
-        auto *ret = new State(builder, baseMemArray, initPC, issuePackage);
-        ret->uid = totalAllocatedStateCount;
-        totalAllocatedStateCount++;
-        aliveStates.insert(ret);
+        auto *ret = new(allocateSlot()) State(builder, baseMemArray, initPC, issuePackage);
+        registerState(ret);
         return ret;
     }
 
     State *fork(State *state) {
-        State *ret = state->fork();
-        ret->uid = totalAllocatedStateCount;
-        totalAllocatedStateCount++;
-        aliveStates.insert(ret);
+        auto *ret = new(allocateSlot()) State(*state);
+        assert(state->constraints.size() == ret->constraints.size() && "Lost constraints during forking!");
+        registerState(ret);
         return ret;
     }
 
     void releaseState(State *state) {
-        auto it = aliveStates.find(state);
-        assert(it != aliveStates.end());
-        aliveStates.erase(it);
-        delete state;
+        assert((state->prevAlive != nullptr || aliveHead == state) && "Releasing a state that is not alive");
+        if (state->prevAlive) state->prevAlive->nextAlive = state->nextAlive;
+        else aliveHead = state->nextAlive;
+        if (state->nextAlive) state->nextAlive->prevAlive = state->prevAlive;
+        aliveStateCount--;
+
+        state->~State();
+        freeSlots.push_back(state);
     }
 
     ~StateAllocator() {
-        for (State *it: aliveStates) {
-            delete it;
+        for (State *s = aliveHead; s != nullptr;) {
+            State *next = s->nextAlive;
+            s->~State();
+            s = next;
+        }
+        for (void *slab : slabs) {
+            ::operator delete(slab);
         }
-    }
-
-    const set<State *> &getAllStates() const {
-        return aliveStates;
     }
 
     /**
@@ -57,13 +70,59 @@ public:
      */
     int getAllocatedStateCount() const { return totalAllocatedStateCount; }
 
-    int getAliveStateCount() const { return aliveStates.size(); }
+    int getAliveStateCount() const { return aliveStateCount; }
+
+    int getPeakAliveStateCount() const { return peakAliveStateCount; }
+
+    size_t getPoolBytes() const { return slabs.size() * STATES_PER_SLAB * sizeof(State); }
+
+    // Allocations that reuse a released slot rather than a fresh one
+    int getReusedSlotCount() const { return reusedSlotCount; }
 
 private:
 
     int totalAllocatedStateCount = 0;
 
-    set<State *> aliveStates;
+    int aliveStateCount = 0;
+
+    int peakAliveStateCount = 0;
+
+    int reusedSlotCount = 0;
+
+    State *aliveHead = nullptr;
+
+    vector<void *> slabs;
+
+    unsigned nextFreshSlot = 0;  // in the last slab
+
+    vector<void *> freeSlots;  // released slots
+
+    void *allocateSlot() {
+        if (!freeSlots.empty()) {
+            reusedSlotCount++;
+            void *ret = freeSlots.back();
+            freeSlots.pop_back();
+            return ret;
+        }
+        if (slabs.empty() || nextFreshSlot == STATES_PER_SLAB) {
+            slabs.push_back(::operator new(STATES_PER_SLAB * sizeof(State)));
+            nextFreshSlot = 0;
+        }
+        return static_cast<char *>(slabs.back()) + (nextFreshSlot++) * sizeof(State);
+    }
+
+    void registerState(State *state) {
+        state->uid = totalAllocatedStateCount;
+        totalAllocatedStateCount++;
+
+        state->prevAlive = nullptr;
+        state->nextAlive = aliveHead;
+        if (aliveHead) aliveHead->prevAlive = state;
+        aliveHead = state;
+
+        aliveStateCount++;
+        if (aliveStateCount > peakAliveStateCount) peakAliveStateCount = aliveStateCount;
+    }
 
 };
 
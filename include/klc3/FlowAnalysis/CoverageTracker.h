@@ -27,6 +27,10 @@ public:
 
     float calculateCoverage() const;
 
+    /**
+     * Recount coverage after covered flags of edges are set from outside (see Checkpointer)
+     */
+    void recountCoverage();
 
 private:
 
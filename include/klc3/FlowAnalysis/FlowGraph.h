@@ -178,6 +178,9 @@ public:
     Node *from() const { return from_; };
     Node *to() const { return to_; };
 
+    // Position in FlowGraph::allEdges(). Edges are never removed, so it identifies the edge throughout the run.
+    unsigned index() const { return index_; }
+
     string fromContext() const { return from() ? from()->context() : "<none>"; }
 
     string toContext() const { return to() ? to()->context() : "<none>"; }
@@ -239,6 +242,7 @@ protected:
     Type type_;
     Node *from_;
     Node *to_;
+    unsigned index_;
 
     Edge() = default;  // constructor only open to FlowGraph
 
@@ -9,6 +9,7 @@
 #define KLC3_FLOWGRAPHBASIC_H
 
 #include "klc3/Common.h"
+#include "klc3/Core/PersistentVector.hpp"
 
 namespace klc3 {
 
@@ -73,7 +74,7 @@ public:
     auto back() { return es.back(); }
 
 protected:
-    vector<Edge *> es;
+    PersistentVector<Edge *> es;  // copies of a path share the common prefix
 };
 
 class Subgraph;
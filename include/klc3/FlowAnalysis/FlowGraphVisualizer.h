@@ -11,6 +11,7 @@
 #include "FlowGraph.h"
 #include "CoverageTracker.h"
 #include "LoopAnalyzer.h"
+#include "klc3/Core/SolverCostTracker.h"
 
 namespace klc3 {
 
@@ -53,6 +54,9 @@ public:
 
     void drawGlobalCoverage(const CoverageTracker *ct, uint16_t initPC);
 
+    // Color lines by their solver time, from yellow to red, and annotate them with their cost
+    void drawSolverHeatMap(const SolverCostTracker *tracker);
+
     void showOnlySubgraph(const Subgraph &sg);
 
     void compress();
@@ -106,9 +110,10 @@ public:
     static void visualizeAllLoops(const PathString& outputPath,
                                   const FlowGraph *flowGraph, const LoopAnalyzer *loopAnalyzer);
 
-    // Output coverage.png/dot
+    // Output coverage.png/dot, with a heat map of solver cost if costTracker is given
     static void visualizeCoverage(const PathString& outputPath,
-                                  const FlowGraph *flowGraph, const CoverageTracker *coverageTracker);
+                                  const FlowGraph *flowGraph, const CoverageTracker *coverageTracker,
+                                  const SolverCostTracker *costTracker = nullptr);
 
     // Output png/dot with given path and filename
     static void visualizeStatePaths(const PathString& outputPath,
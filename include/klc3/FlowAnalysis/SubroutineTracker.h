@@ -46,6 +46,13 @@ public:
 
     Subgraph getSubroutineSubgraph(const string &label) const;
 
+    /**
+     * Add or replace a subroutine, such as one identified at runtime in a previous run (see Checkpointer). Colors of
+     * nodes are not changed.
+     * @param info
+     */
+    void restoreSubroutine(const SubroutineInfo &info);
+
 private:
 
     FlowGraph *fg;
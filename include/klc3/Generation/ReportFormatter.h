@@ -28,6 +28,15 @@ public:
      */
     virtual string getReportExtension() = 0;
 
+    /**
+     * Evaluate expressions under an assignment. They are compiled into one ExprTape, so that subexpressions shared by
+     * them (such as those of output characters from a string loop) are evaluated only once.
+     * @param exprs  Non-null expressions
+     * @param assignment
+     * @return Values of exprs
+     */
+    static vector<uint16_t> evaluateAll(const vector<ref<Expr>> &exprs, const Assignment &assignment);
+
     /// NOTE: all functions starting with "formatted" or "print" don't print extra linefeed after last line.
 
     virtual string formattedLocation(const ref <MemValue> &val) {
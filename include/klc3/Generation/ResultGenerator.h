@@ -19,6 +19,8 @@ namespace klc3 {
 
 extern llvm::cl::OptionCategory KLC3OutputCat;
 
+extern llvm::cl::opt<string> TestCaseNameSuffix;
+
 class ResultGenerator {
 public:
 
@@ -38,6 +38,11 @@ public:
 
     KLC3Loader(const KLC3Loader &loader) = default;
 
+    // Copy a loader but collect issues into another IssuePackage (usually a copy of the original one)
+    KLC3Loader(const KLC3Loader &loader, IssuePackage *issuePackage) : KLC3Loader(loader) {
+        this->issuePackage = issuePackage;
+    }
+
     void loadLC3OS(const string &filename);
 
     /**
@@ -0,0 +1,143 @@
+//
+// Created by liuzikai on 10/17/26.
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+
+#ifndef KLC3_CHECKPOINTER_H
+#define KLC3_CHECKPOINTER_H
+
+#include "klc3/FlowAnalysis/CoverageTracker.h"
+#include "klc3/FlowAnalysis/SubroutineTracker.h"
+#include "klc3/Searcher/Searcher.h"
+#include "klc3/Searcher/StateSerializer.h"
+#include "klc3/Searcher/StateSpiller.h"
+
+#include <functional>
+
+namespace klc3 {
+
+/**
+ * Save the exploration of the test program to <directory>/checkpoint and continue it in a later run.
+ *
+ * A checkpoint holds everything that the exploration accumulates after static analysis: the states held by the
+ * searcher (postponed ones included), the spilled states, the states referred to by issues and their final
+ * constraints, the searcher progress (such as uncovered loop segments of PruningSearcher), edges identified at
+ * runtime, coverage and subroutine information on the FlowGraph, the issues and the counters of the main loop. The
+ * run that resumes must be given the same programs, so that static analysis rebuilds the same FlowGraph, which is
+ * checked with a fingerprint.
+ *
+ * Descriptions of issues are completed before they are written, as their callbacks may refer to gold states, which
+ * are not saved.
+ *
+ * startWrite() forks a writer process that streams the checkpoint from a copy-on-write snapshot of the exploration,
+ * so the main loop only pays for the fork. The checkpoint is written to a temporary file and then renamed, so a
+ * crash in the middle leaves the last checkpoint intact.
+ *
+ * @note A child worker of WorkerPool does not own the writer of its parent. Checkpoints only cover one process, so
+ *       they should not be written after workers split.
+ */
+class Checkpointer {
+public:
+
+    /**
+     * Counters of the main loop, which are continued by the resumed run
+     */
+    struct Progress {
+        long long totalInstCount = 0;
+        int maxStepCount = 0;
+        int maxSolverCount = 0;
+        int divergeStateCount = 0;
+        int searcherLevel = 0;
+    };
+
+    using AssignmentFunc = std::function<Assignment(const State *s, Issue::Type type)>;
+
+    /**
+     * Must be constructed after static analysis and before the exploration starts, when all the edges in the
+     * FlowGraph are static ones.
+     * @param stateSpiller         Nullptr if states are not spilled
+     * @param finalConstraintSets  Final constraints of the states that raised issues in comparison with gold
+     * @param induceAssignment     Used to complete issue descriptions
+     */
+    Checkpointer(const StateSerializer *serializer, FlowGraph *fg, CoverageTracker *coverageTracker,
+                 SubroutineTracker *subroutineTracker, Searcher *searcher, IssuePackage *issuePackage,
+                 StateSpiller *stateSpiller, unordered_map<const State *, ConstraintSet> *finalConstraintSets,
+                 AssignmentFunc induceAssignment);
+
+    Checkpointer(const Checkpointer &) = delete;
+
+    /**
+     * Wait for the writer (if any)
+     */
+    ~Checkpointer();
+
+    /**
+     * Start writing a checkpoint in a forked writer process and return at once
+     * @param directory
+     * @param progress
+     * @return False if the last checkpoint is still being written or fork fails
+     */
+    bool startWrite(const string &directory, const Progress &progress);
+
+    /**
+     * Write a checkpoint in this process, after the one being written (if any) is done
+     * @param directory
+     * @param progress
+     * @return Whether the checkpoint is written
+     */
+    bool write(const string &directory, const Progress &progress);
+
+    /**
+     * Check whether the writer has finished, which should be called periodically
+     * @param wait  Block until the writer finishes
+     */
+    void poll(bool wait = false);
+
+    bool isWriting() const { return writerPid > 0; }
+
+    int getWrittenCount() const { return writtenCount; }
+
+    /**
+     * Load the checkpoint in a directory before the exploration starts. States are put back into the searcher, or the
+     * spiller if they were spilled (loaded into the searcher if there is no spiller). Issues replace the ones in the
+     * IssuePackage.
+     * @param directory
+     * @param mem       Memory to look up issue locations
+     * @param progress  Filled with the counters of the main loop
+     * @return Whether the checkpoint is loaded. On failure, the modules may be partially updated and the run should
+     *         stop.
+     */
+    bool load(const string &directory, const map<uint16_t, ref<MemValue>> &mem, Progress &progress);
+
+private:
+
+    static constexpr int VERSION = 1;
+
+    const StateSerializer *serializer;
+    FlowGraph *fg;
+    CoverageTracker *coverageTracker;
+    SubroutineTracker *subroutineTracker;
+    Searcher *searcher;
+    IssuePackage *issuePackage;
+    StateSpiller *stateSpiller;
+    unordered_map<const State *, ConstraintSet> *finalConstraintSets;
+    AssignmentFunc induceAssignment;
+
+    size_t staticEdgeCount;
+    uint64_t fingerprint;  // of the static FlowGraph
+
+    int writerPid = -1;
+    int writtenCount = 0;
+
+    static string getPath(const string &directory);
+
+    bool writeFile(const string &directory, const Progress &progress);
+
+    void completeIssueDescs();
+};
+
+}
+
+#endif //KLC3_CHECKPOINTER_H
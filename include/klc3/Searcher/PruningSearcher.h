@@ -29,6 +29,16 @@ public:
 
     void setLevel(int level) override { fetchLevel = level; }
 
+    StateVector evict(size_t count, const std::function<bool(const State *)> &canEvict) override;
+
+    void restore(const StateVector &states) override;
+
+    StateVector getHeldStates() const override;
+
+    void saveProgress(llvm::raw_ostream &out) const override;
+
+    bool loadProgress(StringRef data) override;
+
     const set<State *> &getCompletedStates() const override { return internalSearcher->getCompletedStates(); }
 
     void clearCompletedStates() override { internalSearcher->clearCompletedStates(); }
@@ -11,12 +11,20 @@
 #include "klc3/Core/State.h"
 #include "klc3/FlowAnalysis/FlowGraph.h"
 
+#include <algorithm>
 #include <vector>
 #include <stack>
 #include <deque>
+#include <functional>
 
 namespace klc3 {
 
+/**
+ * Seed for searchers that make random choices, given by -seed or from the current time
+ * @return
+ */
+unsigned getSearcherSeed();
+
 /**
  * @note Searcher stores pointers of States, but never create or destroy them.
  */
@@ -70,10 +78,66 @@ public:
      */
     virtual void setLevel(int level) { (void) level; }
 
+    /**
+     * Take out NORMAL states of the lowest priority, for example to spill them out of memory
+     * @param count     Max count of states to take out
+     * @param canEvict  States on which it returns false are kept
+     * @return States taken out, which are no longer held by the searcher
+     */
+    virtual StateVector evict(size_t count, const std::function<bool(const State *)> &canEvict) {
+        (void) count;
+        (void) canEvict;
+        return {};
+    }
+
+    /**
+     * Put back states taken out by evict(). Unlike push(), they are not new results of a step.
+     * @param states
+     */
+    virtual void restore(const StateVector &states) { push(states); }
+
+    /**
+     * Get all NORMAL states held by the searcher regardless of the level, for example to checkpoint them. Putting them
+     * back with restore() in the same order recovers the searcher.
+     * @return
+     */
+    virtual StateVector getHeldStates() const { return getNormalStates(); }
+
+    /**
+     * Write the progress of the searcher other than the states it holds, for example to checkpoint it
+     * @param out
+     */
+    virtual void saveProgress(llvm::raw_ostream &out) const { (void) out; }
+
+    /**
+     * Load the progress written by saveProgress() into a searcher that has not started
+     * @param data
+     * @return Whether data is well formed
+     */
+    virtual bool loadProgress(StringRef data) { return data.empty(); }
+
 protected:
 
     std::set<State *> completedStates;
 
+    /**
+     * Move states on which canEvict returns true from the front of a container to evicted, until evicted has count
+     * states. The order of the other states is kept.
+     */
+    template<class Container>
+    static void evictFromFront(Container &states, size_t count, const std::function<bool(const State *)> &canEvict,
+                               StateVector &evicted) {
+        auto kept = states.begin();
+        for (auto it = states.begin(); it != states.end(); ++it) {
+            if (evicted.size() < count && canEvict(*it)) {
+                evicted.push_back(*it);
+            } else {
+                *kept++ = *it;
+            }
+        }
+        states.erase(kept, states.end());
+    }
+
 };
 
 /**
@@ -105,6 +169,15 @@ public:
         return {normalStates.begin(), normalStates.end()};
     }
 
+    StateVector evict(size_t count, const std::function<bool(const State *)> &canEvict) override {
+        StateVector ret;
+        // The back of the queue is explored last
+        std::reverse(normalStates.begin(), normalStates.end());
+        evictFromFront(normalStates, count, canEvict, ret);
+        std::reverse(normalStates.begin(), normalStates.end());
+        return ret;
+    }
+
 protected:
 
     std::deque<State *> normalStates;
@@ -140,6 +213,12 @@ public:
         return {normalStates.begin(), normalStates.end()};
     }
 
+    StateVector evict(size_t count, const std::function<bool(const State *)> &canEvict) override {
+        StateVector ret;
+        evictFromFront(normalStates, count, canEvict, ret);  // the bottom of the stack is explored last
+        return ret;
+    }
+
 protected:
 
     std::deque<State *> normalStates;
@@ -185,6 +264,13 @@ public:
         return ret;
     }
 
+    StateVector evict(size_t count, const std::function<bool(const State *)> &canEvict) override {
+        StateVector ret;
+        evictFromFront(s1, count, canEvict, ret);  // the bottom of the stacks are explored last
+        evictFromFront(s0, count, canEvict, ret);
+        return ret;
+    }
+
 protected:
     std::deque<State *> s0;
     std::deque<State *> s1;
@@ -197,7 +283,7 @@ class RandomPickingSearcher : public Searcher {
 public:
 
     RandomPickingSearcher() {
-        time_t seed = std::time(nullptr);
+        unsigned seed = getSearcherSeed();
         progInfo() << "RandomPickingSearcher: seed " << seed << "\n";
         std::srand(seed);
     }
@@ -236,6 +322,12 @@ public:
         return ret;
     }
 
+    StateVector evict(size_t count, const std::function<bool(const State *)> &canEvict) override {
+        StateVector ret;
+        evictFromFront(otherNormalState, count, canEvict, ret);  // states are picked at random anyway
+        return ret;
+    }
+
 protected:
 
     State *pickedState = nullptr;
@@ -0,0 +1,124 @@
+//
+// Created by liuzikai on 10/17/26.
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+
+#ifndef KLC3_STATEMERGER_H
+#define KLC3_STATEMERGER_H
+
+#include "klc3/Core/Executor.h"
+#include "klc3/FlowAnalysis/FlowGraph.h"
+
+#include <memory>
+
+namespace klc3 {
+
+/**
+ * Merge states forked at a symbolic BR when they meet again at the join node, to curb the path explosion of code like
+ * "if (x < 0) x = -x" in loops.
+ *
+ * The join node of a BR is its immediate post-dominator within the subroutine, computed on the static FlowGraph with
+ * JSR(R) and TRAP stepping over to the next instruction, and RET, HALT and JMP leaving the subroutine.
+ *
+ * A symbolic BR fork opens a region of the join node at the depth of the JSR stack. All states descending from the
+ * fork are members of the region. A member reaching the join node at the same depth is held, and a member that halts,
+ * breaks or returns from the subroutine leaves the region. Once all members alive are held, the held states are
+ * merged and released. Regions nest, so a released state may be held again by an enclosing region.
+ *
+ * Two states are merged if they have the same PC, JSR stack, CC register, output length, and the same registers and
+ * memory locations uninitialized. The merged state takes the common constraints and the disjunction of the remaining
+ * ones. Registers, memory and output that differ become Select expressions over the path condition of the first state.
+ * The path (statePath) of the first state is kept.
+ *
+ * States are referred to by their UIDs, so a released state slot reused by the StateAllocator is never mistaken.
+ *
+ * @note Held states are not in the searcher. If the searcher drains while states are held (such as when a member is
+ *       stuck at a dynamic JMP that the static analysis can't see), flush() releases them as they are.
+ * @note Not compatible with PruningSearcher (which keeps track of loop segments of each state), state spilling,
+ *       checkpoints or multiple workers, which move states out of sight of the StateMerger.
+ */
+class StateMerger : protected WithBuilder {
+public:
+
+    StateMerger(ExprBuilder *builder, Executor *executor, const FlowGraph *flowGraph);
+
+    StateMerger(const StateMerger &) = delete;
+
+    /**
+     * Update regions after a step, before the result is pushed into the searcher
+     * @param parent  The state that was stepped
+     * @param result  [in/out] States from Executor::step(). States held at join nodes are removed, and states released
+     *                from join nodes (merged or not) are appended.
+     */
+    void update(State *parent, StateVector &result);
+
+    /**
+     * Release all held states without merging and stop tracking all regions
+     * @return Released states
+     */
+    StateVector flush();
+
+    size_t getHeldStateCount() const { return heldStateCount; }
+
+    int getRegionCount() const { return regionCount; }
+
+    int getMergedStateCount() const { return mergedStateCount; }
+
+    int getFlushCount() const { return flushCount; }
+
+private:
+
+    Executor *executor;
+
+    unordered_map<const Node *, const Node *> joinNodes;  // BR node -> join node
+
+    struct Region {
+        const Node *join;
+        size_t depth;  // of the JSR stack
+        int aliveCount = 0;  // members not yet left, including held ones
+        StateVector held;
+    };
+
+    using RegionStack = vector<std::shared_ptr<Region>>;  // the innermost at the back
+
+    unordered_map<int, RegionStack> regionsOf;  // by State UID, only for states in any region
+
+    size_t heldStateCount = 0;
+
+    int regionCount = 0;
+
+    int mergedStateCount = 0;
+
+    int flushCount = 0;
+
+    void computeJoinNodes(const FlowGraph *flowGraph);
+
+    /**
+     * Hold the state at the join node of its innermost region, or remove it from regions it has left
+     * @param s
+     * @param released    [out] The state is appended if it is not held
+     * @param dirtyRegions  [out] Regions whose counts changed
+     */
+    void process(State *s, StateVector &released, vector<std::shared_ptr<Region>> &dirtyRegions);
+
+    /**
+     * Merge the held states of a region whose members are all held, and process the remaining ones again
+     */
+    void complete(const std::shared_ptr<Region> &region, StateVector &released,
+                  vector<std::shared_ptr<Region>> &dirtyRegions);
+
+    static bool canMerge(const State *a, const State *b);
+
+    /**
+     * Merge b into a. b is left untouched, to be released by the caller.
+     * @return False if the constraints of a and b can't be told apart or values differ in width, in which case a is
+     *         left untouched
+     */
+    bool merge(State *a, const State *b);
+};
+
+}
+
+#endif //KLC3_STATEMERGER_H
@@ -0,0 +1,68 @@
+//
+// Created by liuzikai on 10/17/26.
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+
+#ifndef KLC3_STATESERIALIZER_H
+#define KLC3_STATESERIALIZER_H
+
+#include "klc3/Core/Executor.h"
+#include "klc3/FlowAnalysis/LoopAnalyzer.h"
+
+namespace klee {
+class ArrayCache;
+}
+
+namespace klc3 {
+
+/**
+ * Write a State into a plain-text record and read it back, used by StateSpiller and Checkpointer.
+ *
+ * A record is a short header (registers, the memory written by the program, output, path metadata) followed by a
+ * kquery of the constraints, whose values are all the expressions referred to in the header. Edges are written as
+ * their indices (see Edge::index()), nodes as their addresses and loops as the addresses of their entry nodes. Arrays
+ * are parsed into the given ArrayCache, so expressions of a read state share arrays with the other states.
+ *
+ * A read state is a new State (with a new UID) equivalent to the written one.
+ */
+class StateSerializer {
+public:
+
+    StateSerializer(Executor *executor, ExprBuilder *builder, klee::ArrayCache *arrayCache,
+                    IssuePackage *issuePackage, const FlowGraph *fg, const set<Loop *> &allLoops);
+
+    string serialize(const State *s) const;
+
+    /**
+     * @param data
+     * @param name   Name of the source, for parse errors
+     * @param edges  If given, edge indices in data are looked up in it instead of FlowGraph::allEdges(), for records
+     *               written by another process whose FlowGraph has grown differently (see WorkerPool)
+     * @return The new state. Nullptr if data is malformed or refers to edges, nodes or loops that do not exist.
+     */
+    State *deserialize(StringRef data, const string &name, const vector<Edge *> *edges = nullptr) const;
+
+    /**
+     * Write a constraint set alone as a kquery
+     * @param constraints
+     * @return
+     */
+    string serializeConstraints(const ConstraintSet &constraints) const;
+
+    bool deserializeConstraints(StringRef data, const string &name, ConstraintSet &constraints) const;
+
+private:
+
+    Executor *executor;
+    ExprBuilder *builder;
+    klee::ArrayCache *arrayCache;
+    IssuePackage *issuePackage;
+    const FlowGraph *fg;
+    unordered_map<int, Loop *> loopByEntryAddr;
+};
+
+}
+
+#endif //KLC3_STATESERIALIZER_H
@@ -0,0 +1,118 @@
+//
+// Created by liuzikai on 10/17/26.
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+
+#ifndef KLC3_STATESPILLER_H
+#define KLC3_STATESPILLER_H
+
+#include "klc3/Searcher/StateSerializer.h"
+
+#include <functional>
+
+namespace klc3 {
+
+/**
+ * Move NORMAL states out of memory into a spill file and bring them back later.
+ *
+ * A spilled state is written as a StateSerializer record, which stays valid as the FlowGraph only grows during the
+ * run. The state is then released.
+ *
+ * States are reloaded in the reverse order of spilling, so the space of a reloaded state is reused by later ones.
+ * A reloaded state is a new State (with a new UID) equivalent to the spilled one.
+ *
+ * @note The spill file is private to the process. After workers split (see WorkerPool), a child worker should call
+ *       reset(), leaving the states spilled before the split to the main worker.
+ */
+class StateSpiller {
+public:
+
+    StateSpiller(Executor *executor, const StateSerializer *serializer);
+
+    StateSpiller(const StateSpiller &) = delete;
+
+    ~StateSpiller();
+
+    /**
+     * Whether a state can be spilled. A state that raised issues is referred to by them, so it is never spilled.
+     * @param s
+     * @return
+     */
+    static bool canSpill(const State *s) { return s->status == State::NORMAL && !s->triggerNewIssue; }
+
+    /**
+     * Write a state to the spill file and release it
+     * @param s  Must be spillable (see canSpill()) and not held by any searcher
+     * @return False if failed to write the file, in which case the state is left untouched
+     */
+    bool spill(State *s);
+
+    /**
+     * Reload the states spilled most recently
+     * @param count  Max count of states to reload
+     * @return Reloaded states
+     */
+    StateVector reload(size_t count);
+
+    /**
+     * Drop all spilled states and start over with a new spill file
+     */
+    void reset();
+
+    /**
+     * Add a record written by StateSerializer as a spilled state, without loading it into memory
+     * @param data
+     * @return False if failed to write the file
+     */
+    bool adopt(StringRef data);
+
+    /**
+     * Read the records of all spilled states, in the order of spilling
+     * @param callback  Stop reading if it returns false
+     * @return False if failed to read the file or stopped by callback
+     */
+    bool forEachRecord(const std::function<bool(StringRef)> &callback) const;
+
+    /**
+     * While held, the space of reloaded states is not reused, so the records spilled before stay intact for another
+     * process reading the file (see Checkpointer)
+     * @param hold
+     */
+    void setHold(bool hold);
+
+    size_t getSpilledStateCount() const { return records.size(); }
+
+    int getTotalSpillCount() const { return totalSpillCount; }
+
+    int getTotalReloadCount() const { return totalReloadCount; }
+
+    uint64_t getPeakFileSize() const { return peakFileSize; }
+
+private:
+
+    Executor *executor;
+    const StateSerializer *serializer;
+
+    string path;
+    int fd = -1;
+    uint64_t fileEnd = 0;
+    uint64_t heldEnd = 0;  // new records are written after this offset, see setHold()
+
+    vector<pair<uint64_t, size_t>> records;  // offset and size of each spilled state, in the order of spilling
+
+    int totalSpillCount = 0;
+    int totalReloadCount = 0;
+    uint64_t peakFileSize = 0;
+
+    bool openFile();
+
+    void closeFile();
+
+    bool appendRecord(StringRef data);
+};
+
+}
+
+#endif //KLC3_STATESPILLER_H
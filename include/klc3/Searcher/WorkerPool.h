@@ -0,0 +1,208 @@
+//
+// Created by liuzikai on 10/17/26.
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+
+#ifndef KLC3_WORKERPOOL_H
+#define KLC3_WORKERPOOL_H
+
+#include "klc3/Core/State.h"
+#include "klc3/FlowAnalysis/CoverageTracker.h"
+#include "klc3/Searcher/Searcher.h"
+#include "klc3/Searcher/StateSerializer.h"
+#include "klc3/Verification/IssuePackage.h"
+
+#include <functional>
+
+namespace klc3 {
+
+/**
+ * Split the exploration of the test program into several worker processes.
+ *
+ * Expressions, the ExprBuilder and the solver are not thread-safe (reference counts of klee::ref are not atomic), so
+ * instead of sharing states among threads, the process forks once the searcher holds enough NORMAL states. Each
+ * worker inherits a copy of everything (including its own solver chain and caches) and starts with its share of the
+ * states existing at the split. States created after the split belong to the worker that creates them.
+ *
+ * Work is redistributed as workers run out of states. The main worker (index 0) coordinates through a socket to each
+ * child. An idle worker asks for work with requestWork(). The main worker hands it some of its own states, or asks a
+ * busy child to donate, which the child does in its next poll(). Donated states are moved as StateSerializer records,
+ * together with the edges the donor has identified since the split, so that the receiver can translate edge indices.
+ * Once all workers are idle, the main worker tells the children to quit.
+ *
+ * At the end, each child worker generates test cases for the issues raised after the split and sends them to the
+ * main worker, along with its edge coverage. The main worker merges them into its IssuePackage and FlowGraph before
+ * filtering and reporting. Issues raised before the split are only reported by the main worker.
+ *
+ * @note SubroutineTracker and searcher statistics are not shared among workers.
+ */
+class WorkerPool {
+public:
+
+    WorkerPool(unsigned workerCount, Executor *executor, const StateSerializer *serializer, FlowGraph *fg);
+
+    bool isWaitingToSplit() const { return workerCount > 1 && !hasSplit; }
+
+    /**
+     * Fork worker processes if there are enough NORMAL states. Return in every worker.
+     * @param normalStates      NORMAL states to be distributed among workers
+     * @param allocatedStateCount  Count of states allocated so far. States with smaller UIDs that are not in
+     *                             normalStates (such as postponed ones) are distributed by UID.
+     * @return Whether workers are created. False if there are not enough states yet or fork fails.
+     */
+    bool split(const StateVector &normalStates, int allocatedStateCount);
+
+    /**
+     * Whether workers are running, so that poll() and requestWork() are to be used
+     * @return
+     */
+    bool isSplit() const { return hasSplit && (isChild() || !children.empty()); }
+
+    /**
+     * Whether the state is to be explored by another worker
+     * @param s
+     * @return
+     */
+    bool isForeign(const State *s) const;
+
+    bool isChild() const { return workerIndex > 0; }
+
+    unsigned getWorkerIndex() const { return workerIndex; }
+
+    /**
+     * Handle messages from other workers without blocking, such as donating states from searcher to idle workers. To
+     * be called regularly during the exploration.
+     * @param searcher
+     * @return False if the main worker asks this child worker to stop
+     */
+    bool poll(Searcher *searcher);
+
+    /**
+     * Wait for states from other workers after the searcher drains
+     * @param shouldStop  Checked regularly while waiting
+     * @return States taken over from other workers. Empty if all workers are idle, or if this child worker is asked
+     *         to stop, or if shouldStop returns true.
+     */
+    StateVector requestWork(const std::function<bool()> &shouldStop);
+
+    /**
+     * Send completed issues and edge coverage of this child worker to the main worker
+     * @param issuePackage
+     */
+    void sendResults(const IssuePackage &issuePackage);
+
+    /**
+     * Stop all child workers, wait for them, and merge their issues and edge coverage
+     * @param issuePackage
+     * @param mem  Memory to look up issue locations
+     * @param coverageTracker  Recounted after merging the coverage
+     * @return 0 if all child workers exit normally, otherwise the exit code of the first one that fails (-1 if killed
+     *         by a signal)
+     */
+    int collectResults(IssuePackage &issuePackage, const map<uint16_t, ref<MemValue>> &mem,
+                       CoverageTracker *coverageTracker);
+
+    int getDonatedStateCount() const { return donatedStateCount; }
+
+    int getReceivedStateCount() const { return receivedStateCount; }
+
+private:
+
+    unsigned workerCount;
+    Executor *executor;
+    const StateSerializer *serializer;
+    FlowGraph *fg;
+
+    bool hasSplit = false;
+
+    unsigned workerIndex = 0;
+
+    unsigned startedWorkerCount = 1;  // only for the main worker
+
+    int splitStateCount = 0;
+
+    size_t splitEdgeCount = 0;  // edges before this index are the same in all workers
+
+    unordered_map<const State *, unsigned> stateOwners;  // NORMAL states at the split and their workers
+
+    struct Child {
+        int pid;
+        int fd;                  // socket to the child
+        bool waiting = false;    // asked for work and not served yet
+        bool asked = false;      // asked to donate and not replied yet
+        bool finished = false;   // sent its results or exited
+        string results;
+    };
+
+    vector<Child> children;  // only for the main worker
+
+    int pendingDonationCount = 0;  // only for the main worker
+
+    int socketToMain = -1;  // only for child workers
+
+    int donatedStateCount = 0;
+    int receivedStateCount = 0;
+
+    /**
+     * Take out up to half of the NORMAL states of searcher and write them into a message payload
+     * @param searcher
+     * @return Payload of the donated states, or empty if nothing can be donated
+     */
+    string donate(Searcher *searcher);
+
+    /**
+     * Read states written by donate()
+     * @param payload
+     * @return
+     */
+    StateVector adopt(StringRef payload);
+
+    /**
+     * Write "D <from> <to> <type>" for each edge identified since the split, after the count of all edges
+     * @param out
+     */
+    void writeEdges(llvm::raw_ostream &out) const;
+
+    /**
+     * Read edges written by writeEdges() from the front of data, identifying the ones not seen here yet
+     * @param data
+     * @param edges  Set to the local edges by the indices of the writer
+     * @return False if data is malformed
+     */
+    bool readEdges(StringRef &data, vector<Edge *> &edges);
+
+    /**
+     * Merge results written by sendResults() into issuePackage and the FlowGraph
+     * @param data
+     * @param issuePackage
+     * @param mem
+     * @return False if data is malformed
+     */
+    bool mergeResults(StringRef data, IssuePackage &issuePackage, const map<uint16_t, ref<MemValue>> &mem);
+
+    /// Main worker only
+
+    /**
+     * Handle messages from children, waiting up to timeout
+     * @param timeout  In ms, same as poll()
+     * @param adopted  Appended with donated states taken over by the main worker
+     */
+    void receiveFromChildren(int timeout, StateVector &adopted);
+
+    /**
+     * Serve waiting children with states from searcher (if given), and ask busy children to donate to the rest
+     * @param searcher     Nullptr if the main worker is waiting for work itself
+     * @param selfWaiting  Whether the main worker is waiting for work
+     */
+    void dispatch(Searcher *searcher, bool selfWaiting);
+
+    void quitChildren();
+
+    bool quitSent = false;
+};
+
+}
+
+#endif //KLC3_WORKERPOOL_H
@@ -33,6 +33,27 @@ public:
      */
     vector <Issue::Type> compare(State *goldState, State *testState, ConstraintSet &finalConstraints);
 
+    /**
+     * Whether the output of a test state that has not halted can no longer match the output of a gold state, that is,
+     * the output is longer than the gold one, or can't equal the prefix of the gold one of the same length.
+     * @param goldState   A HALTED gold state
+     * @param testState
+     * @param constraints Constraints of both states
+     * @return True if the output must differ
+     */
+    bool outputMustDiverge(const State *goldState, const State *testState, const ConstraintSet &constraints) const;
+
+    /**
+     * Raise ERR_INCORRECT_OUTPUT on a test state before it halts, for which outputMustDiverge() holds on all
+     * compatible gold states. The test state is set to BROKEN if the issue is an ERROR.
+     * @param goldState  One of the compatible gold states, to show the expected output <- set triggerNewIssue
+     * @param testState  <- raise the issue on it
+     * @return Whether the issue is accepted
+     */
+    bool raiseEarlyOutputIssue(State *goldState, State *testState);
+
+    bool comparesOutput() const { return checkLists.find(Issue::ERR_INCORRECT_OUTPUT) != checkLists.end(); }
+
     struct ThingToCompare {
         enum Type {
             OUTPUT,
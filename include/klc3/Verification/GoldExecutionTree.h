@@ -0,0 +1,86 @@
+//
+// Created by liuzikai on 10/17/26.
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+
+#ifndef KLC3_GOLDEXECUTIONTREE_H
+#define KLC3_GOLDEXECUTIONTREE_H
+
+#include "klc3/Core/Executor.h"
+
+#include <functional>
+
+namespace klc3 {
+
+/**
+ * Execution tree of the gold program, explored lazily and shared by all test states.
+ *
+ * Instead of running the gold program under the constraints of each HALTED test state, the gold program runs under its
+ * own path constraints only. At each fork, a child is explored only if its path condition is compatible with the
+ * constraints of some test state asking for it, and explored nodes are kept for later test states. A gold leaf is
+ * HALTED, and the same gold run under the test constraints would have ended up with the leaf constraints added.
+ *
+ * @note Gold states in the tree are never released.
+ */
+class GoldExecutionTree : protected WithBuilder {
+public:
+
+    GoldExecutionTree(ExprBuilder *builder, Solver *solver, Executor *goldExecutor, State *goldStartupState);
+
+    enum Result {
+        COMPLETED,
+        GOLD_ISSUE,  // a compatible gold path breaks or raises an issue
+        STOPPED  // shouldStop returns true
+    };
+
+    /**
+     * Get all HALTED gold states whose path conditions are compatible with the given constraints
+     * @param constraints  Constraints of a test state
+     * @param leaves       [out] Compatible gold leaves, APPEND
+     * @param shouldStop   Checked during gold execution
+     * @return
+     */
+    Result getLeaves(const ConstraintSet &constraints, StateVector &leaves, const std::function<bool()> &shouldStop);
+
+    unsigned getNodeCount() const { return nodeCount; }
+
+private:
+
+    Solver *solver;
+    Executor *goldExecutor;
+
+    struct Node {
+        /*
+         * NORMAL: the node is not expanded yet
+         * HALTED: leaf
+         * BROKEN: leaf with gold issue
+         * nullptr: the node has forked into children
+         */
+        State *state;
+        bool faulty;  // the state breaks or raises an issue
+        ref<Expr> pathCondition;  // conjunction of all constraints of the state, for compatibility check
+        vector<std::unique_ptr<Node>> children;
+    };
+
+    std::unique_ptr<Node> root;
+
+    unsigned nodeCount = 0;
+
+    std::unique_ptr<Node> newNode(State *state);
+
+    /**
+     * Run the state of the node until it forks or completes
+     * @param node
+     * @param shouldStop
+     * @return False if stopped. The node can be expanded again later.
+     */
+    bool expand(Node *node, const std::function<bool()> &shouldStop);
+
+    bool isCompatible(const ConstraintSet &constraints, const Node *node) const;
+};
+
+}
+
+#endif //KLC3_GOLDEXECUTIONTREE_H
@@ -11,6 +11,8 @@
 #include "klc3/Common.h"
 #include "Issue.h"
 
+#include <functional>
+
 namespace klc3 {
 
 // Forward declaration
@@ -83,6 +85,31 @@ public:
 
     void callBackForAllDesc(const map<const State *, Assignment> &assignments);
 
+    /**
+     * Write all issues into a plain string, so that another process can merge them back (see mergeSerialized()).
+     * @note States are not serialized. Issue descriptions should be completed (callBackForAllDesc()) and test cases
+     *       should be generated before serialization, unless the states are saved elsewhere (see Checkpointer).
+     * @param out
+     * @param stateIndex  If given, written for each IssueInfo to refer to its State (-1 for none)
+     */
+    void serialize(llvm::raw_ostream &out, const std::function<int(const State *)> &stateIndex = nullptr) const;
+
+    /**
+     * Merge issues written by serialize() into this package. Merged IssueInfos have no associated State, but keep
+     *  their notes, step counts and generated test case names.
+     * @param data
+     * @param mem   Memory to look up issue locations. If a location is not found, a new MemValue is created.
+     * @param stateByIndex  If given, associate IssueInfos with States by the indices written by serialize()
+     * @return Whether data is well formed
+     */
+    bool mergeSerialized(StringRef data, const map<uint16_t, ref<MemValue>> &mem,
+                         const std::function<State *(int)> &stateByIndex = nullptr);
+
+    /**
+     * Drop all issues, keeping the issue types
+     */
+    void clearIssues() { issues.clear(); }
+
 private:
 
     /**
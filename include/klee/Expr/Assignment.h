@@ -12,6 +12,7 @@
 
 #include "klee/Expr/Constraints.h"
 #include "klee/Expr/ExprEvaluator.h"
+#include "klee/Expr/ExprTape.h"
 
 #include <map>
 
@@ -49,6 +50,9 @@ namespace klee {
 
     template<typename InputIterator>
     bool satisfies(InputIterator begin, InputIterator end);
+    // NOTE: [liuzikai] check the constraints compiled as the roots of tape,
+    // which is cheaper when many assignments are checked against them
+    bool satisfies(ExprTape &tape);
     void dump();
   };
   
@@ -0,0 +1,154 @@
+//===-- ExprTape.h ----------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+// NOTE: [liuzikai] added for klc3
+
+#ifndef KLEE_EXPRTAPE_H
+#define KLEE_EXPRTAPE_H
+
+#include "klee/Expr/Expr.h"
+#include "klee/Expr/ExprHashMap.h"
+
+#include <vector>
+
+namespace klee {
+  class Assignment;
+
+/// Expressions compiled once into a register-based instruction tape, to be
+/// evaluated under many assignments. Evaluating an expression with
+/// Assignment::evaluate walks the expression DAG with an ExprVisitor on each
+/// call, while running the tape is a single pass over a flat array of
+/// instructions. Common subexpressions, within and across the compiled
+/// expressions, are computed once.
+///
+/// Each compiled expression is a root of the tape. A run evaluates all roots
+/// with the same results as Assignment::evaluate, or fails if some root can't
+/// be evaluated to a constant on the tape, in which case the caller should
+/// fall back to Assignment::evaluate.
+class ExprTape {
+public:
+  /// Compile e as a root of the tape.
+  /// \return The index of the root.
+  unsigned compile(const ref<Expr> &e);
+
+  const std::vector<ref<Expr>> &getRoots() const { return roots; }
+
+  /// Evaluate all roots under an assignment.
+  /// \return False if some root is wider than 64 bits, divides by zero, or
+  /// reads a value left free by the assignment (allowFreeValues).
+  bool run(const Assignment &a);
+
+  /// The value of a root from the last successful run.
+  uint64_t getValue(unsigned root) const { return registers[rootRegisters[root]]; }
+
+  /// The number of assignments runBatch() evaluates at once
+  static const unsigned BatchSize = 16;
+
+  /// Evaluate all roots under a batch of assignments at once. The values of
+  /// each array element are laid out as one contiguous vector across the
+  /// batch (structure of arrays), and each instruction is a loop over the
+  /// batch that the compiler can vectorize.
+  /// \param batch - At most BatchSize assignments.
+  /// \param evaluated [out] - Whether the roots were evaluated under each
+  /// assignment, as run() would return.
+  void runBatch(const std::vector<const Assignment *> &batch,
+                std::vector<bool> &evaluated);
+
+  /// The value of a root under the i-th assignment of the last runBatch().
+  uint64_t getBatchValue(unsigned root, unsigned i) const {
+    return batchRegisters[rootRegisters[root] * BatchSize + i];
+  }
+
+private:
+  enum Opcode {
+    Const, Read,
+    Select, Concat, Extract, SExt,
+    Add, Sub, Mul, UDiv, SDiv, URem, SRem,
+    Not, And, Or, Xor, Shl, LShr, AShr,
+    Eq, Ne, Ult, Ule, Ugt, Uge, Slt, Sle, Sgt, Sge
+  };
+
+  struct Instruction {
+    Opcode op;
+    Expr::Width width;    // of the result
+    int a, b, c;          // operand registers
+    uint64_t imm;         // constant, array slot, extract offset or operand width
+  };
+
+  std::vector<Instruction> code; // the register of an instruction is its index
+  std::vector<ref<Expr>> roots;
+  std::vector<int> rootRegisters; // -1 if the root is not supported
+  bool complete = true;           // all roots are supported
+
+  std::vector<const Array *> arrays; // read on the tape
+  ExprHashMap<int> compiled;
+  std::vector<uint64_t> registers;
+
+  /// Bindings of the arrays during a run
+  std::vector<const std::vector<unsigned char> *> bound;
+
+  std::vector<uint64_t> batchRegisters;
+  /// Values of symbolic array elements during runBatch(), by array slot, at
+  /// [index * BatchSize + i] for the i-th assignment
+  std::vector<std::vector<uint64_t>> elements;
+  /// Whether reads of an array may hit a free value, at
+  /// [slot * BatchSize + i] for the i-th assignment
+  std::vector<uint8_t> mayBeFree;
+
+  int emit(Opcode op, Expr::Width width, int a = -1, int b = -1, int c = -1, uint64_t imm = 0);
+
+  /// \return The register of e, or -1 if not supported
+  int compileExpr(const ref<Expr> &e);
+  int compileRead(const ReadExpr *re);
+  unsigned arraySlot(const Array *array);
+
+  /// Execute instruction i, other than Read, on N lanes of registers. Lanes
+  /// that divide by zero are marked in failed.
+  template <unsigned N>
+  void execute(size_t i, uint64_t *regs, uint8_t *failed) const;
+
+  /// Read an element as Assignment::evaluate does.
+  /// \return False if the value is free.
+  static bool readElement(const Array *array,
+                          const std::vector<unsigned char> *bytes,
+                          bool allowFreeValues, unsigned index,
+                          uint64_t &value);
+};
+
+/// Candidate assignments of the expressions compiled on a tape, checked
+/// against them ExprTape::BatchSize at a time with ExprTape::runBatch().
+/// Assignments that can't be evaluated on the tape are checked with
+/// Assignment::evaluate.
+class AssignmentBatch {
+  ExprTape &key;
+  std::vector<Assignment *> candidates;
+  std::vector<const Assignment *> batch;
+  std::vector<bool> evaluated;
+
+public:
+  /// The first candidate found to satisfy all roots of the tape, if any
+  Assignment *found = nullptr;
+
+  AssignmentBatch(ExprTape &_key) : key(_key) {}
+
+  /// Add a candidate, and check the batch if it is full.
+  /// \return True if a satisfying assignment has been found.
+  bool add(Assignment *a) {
+    candidates.push_back(a);
+    return candidates.size() == ExprTape::BatchSize && flush();
+  }
+
+  /// Check the candidates added so far.
+  /// \return True if a satisfying assignment has been found.
+  bool flush();
+};
+
+} // namespace klee
+
+#endif /* KLEE_EXPRTAPE_H */
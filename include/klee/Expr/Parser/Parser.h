@@ -20,6 +20,7 @@ namespace llvm {
 }
 
 namespace klee {
+  class ArrayCache;
   class ExprBuilder;
 
 namespace expr {
@@ -230,6 +231,16 @@ namespace expr {
     /// expressions.
     static Parser *Create(const std::string Name, const llvm::MemoryBuffer *MB,
                           ExprBuilder *Builder, bool ClearArrayAfterQuery);
+
+    // NOTE: [liuzikai] added for klc3
+    /// CreateParser - Create a parser implementation that creates arrays in
+    /// the given ArrayCache rather than its own. Parsed expressions then stay
+    /// valid after the parser is destroyed, and symbolic arrays of the same
+    /// name and size are the same Array objects as those already in the
+    /// cache.
+    static Parser *Create(const std::string Name, const llvm::MemoryBuffer *MB,
+                          ExprBuilder *Builder, ArrayCache *TheArrayCache,
+                          bool ClearArrayAfterQuery);
   };
 }
 }
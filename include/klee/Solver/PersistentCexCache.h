@@ -0,0 +1,83 @@
+//===-- PersistentCexCache.h ------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+// NOTE: [liuzikai] added for klc3
+
+#ifndef KLEE_PERSISTENTCEXCACHE_H
+#define KLEE_PERSISTENTCEXCACHE_H
+
+#include "klee/Expr/Assignment.h"
+
+#include <list>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace klee {
+
+/// Counterexamples (models) kept across runs. Arrays are identified by their
+/// names and sizes, so models found by one run can be tried in later runs on
+/// the same input space. CexCachingSolver tries these models before asking
+/// the underlying solver and adds every new model found by the solver.
+///
+/// At most maxSize models are kept. The least recently used one is evicted.
+class PersistentCexCache {
+public:
+  PersistentCexCache(std::string path, unsigned maxSize)
+      : path(std::move(path)), maxSize(maxSize) {}
+
+  /// Load models from the file. Bindings of arrays that do not match any of
+  /// the given arrays (by name, size, domain and range) are dropped.
+  /// \return The number of models loaded.
+  unsigned load(const std::vector<const Array *> &arrays);
+
+  /// Save models to the file, most recently used first.
+  bool save() const;
+
+  /// Find a model that satisfies all expressions in key. The model found is
+  /// marked as most recently used.
+  /// \return The model, or nullptr if none satisfies. Only valid until the
+  /// next call to add().
+  const Assignment *find(const std::set<ref<Expr>> &key);
+
+  /// Add a model as the most recently used one. A model already kept is
+  /// only marked as most recently used.
+  void add(const Assignment &assignment);
+
+  unsigned size() const { return models.size(); }
+
+private:
+  typedef std::list<Assignment>::iterator model_iterator;
+
+  struct ModelLessThan {
+    typedef void is_transparent;
+    bool operator()(model_iterator a, model_iterator b) const {
+      return a->bindings < b->bindings;
+    }
+    bool operator()(model_iterator a, const Assignment &b) const {
+      return a->bindings < b.bindings;
+    }
+    bool operator()(const Assignment &a, model_iterator b) const {
+      return a.bindings < b->bindings;
+    }
+  };
+
+  std::string path;
+  unsigned maxSize;
+  std::list<Assignment> models; // most recently used first
+  std::set<model_iterator, ModelLessThan> index; // of models, by bindings
+
+  /// Insert a model not kept yet at pos, evicting the least recently used
+  /// one if the cache is full.
+  void insert(model_iterator pos, const Assignment &assignment);
+};
+
+} // namespace klee
+
+#endif /* KLEE_PERSISTENTCEXCACHE_H */
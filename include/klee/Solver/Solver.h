@@ -20,6 +20,7 @@ namespace klee {
   class ConstraintSet;
   class Expr;
   class SolverImpl;
+  class PersistentCexCache;
 
   /// Collection of meta data that a solver can have access to. This is
   /// independent of the actual constraints but can be used as a two-way
@@ -235,13 +236,27 @@ namespace klee {
   /// \param s - The underlying solver to use.
   Solver *createCachingSolver(Solver *s);
 
+  /// createPersistentCachingSolver - Create a solver which caches validity
+  /// of queries by their canonical form (arrays renamed by first occurrence),
+  /// loading the cache from the given file at creation and saving it back at
+  /// destruction. At most maxSize queries are kept, and the least recently
+  /// used one is evicted.
+  ///
+  /// \param s - The underlying solver to use.
+  /// \param path - The cache file.
+  /// \param maxSize - The maximal number of queries kept.
+  Solver *createPersistentCachingSolver(Solver *s, const std::string &path,
+                                        unsigned maxSize);
+
   /// createCexCachingSolver - Create a counterexample caching solver. This is a
   /// more sophisticated cache which records counterexamples for a constraint
   /// set and uses subset/superset relations among constraints to try and
   /// quickly find satisfying assignments.
   ///
   /// \param s - The underlying solver to use.
-  Solver *createCexCachingSolver(Solver *s);
+  /// \param persistentCache - Models kept across runs (optional).
+  Solver *createCexCachingSolver(Solver *s,
+                                 PersistentCexCache *persistentCache = nullptr);
 
   /// createFastCexSolver - Create a "fast counterexample solver", which tries
   /// to quickly compute a satisfying assignment for a constraint set using
@@ -250,6 +265,22 @@ namespace klee {
   /// \param s - The underlying solver to use.
   Solver *createFastCexSolver(Solver *s);
 
+  /// createIntervalSolver - Create a solver which tries to answer queries over
+  /// 16-bit expressions from the intervals and known bits learned from the
+  /// constraints, and from a few assignments picked from those intervals,
+  /// before forwarding to the underlying solver.
+  ///
+  /// \param s - The underlying solver to use.
+  Solver *createIntervalSolver(Solver *s);
+
+  /// createEnumerationSolver - Create a solver which answers queries over a
+  /// few array elements of at most 16 bits by trying all their values, and
+  /// forwards other queries to the underlying solver.
+  ///
+  /// \param s - The underlying solver to use.
+  /// \param maxElements - The maximum number of array elements to enumerate.
+  Solver *createEnumerationSolver(Solver *s, unsigned maxElements);
+
   /// createIndependentSolver - Create a solver which will eliminate any
   /// unnecessary constraints before propogating the query to the underlying
   /// solver.
@@ -37,6 +37,14 @@ namespace stats {
   extern Statistic independentElementSetCacheLookupTime;
   extern Statistic independentElementSetConstructTime;
 
+  // Note: [liuzikai] statistics for IntervalSolver
+  extern Statistic intervalSolverQueries;
+  extern Statistic intervalSolverHits;
+
+  // Note: [liuzikai] statistics for EnumerationSolver
+  extern Statistic enumerationSolverQueries;
+  extern Statistic enumerationSolverHits;
+
 #ifdef KLEE_ARRAY_DEBUG
   extern Statistic arrayHashTime;
 #endif
@@ -10,6 +10,7 @@
 #ifndef KLEE_FILEHANDLING_H
 #define KLEE_FILEHANDLING_H
 
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/raw_ostream.h"
 #include <memory>
 #include <string>
@@ -22,6 +23,18 @@ klee_open_output_file(const std::string &path, std::string &error);
 std::unique_ptr<llvm::raw_ostream>
 klee_open_compressed_output_file(const std::string &path, std::string &error);
 #endif
+
+// NOTE: [liuzikai] added for klc3
+/// Write a file through a uniquely named temporary file in the same
+/// directory, which is renamed to path once complete. The file is never left
+/// half-written, even if several processes save it at the same time.
+/// \param write - Write the content. Return false to abandon the file.
+/// \param error - Set if the file can't be written (not if abandoned)
+/// \return Whether the file is written
+bool klee_write_file_atomically(
+    const std::string &path,
+    llvm::function_ref<bool(llvm::raw_fd_ostream &)> write,
+    std::string &error);
 } // namespace klee
 
 #endif /* KLEE_FILEHANDLING_H */
@@ -30,6 +30,15 @@ void Assignment::dump() {
   }
 }
 
+bool Assignment::satisfies(ExprTape &tape) {
+  if (!tape.run(*this))
+    return satisfies(tape.getRoots().begin(), tape.getRoots().end());
+  for (unsigned i = 0, e = tape.getRoots().size(); i != e; ++i)
+    if (!tape.getValue(i))
+      return false;
+  return true;
+}
+
 ConstraintSet Assignment::createConstraintsFromAssignment() const {
   ConstraintSet result;
   for (const auto &binding : bindings) {
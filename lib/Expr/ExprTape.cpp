@@ -0,0 +1,413 @@
+//===-- ExprTape.cpp ------------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+// NOTE: [liuzikai] added for klc3
+
+#include "klee/Expr/ExprTape.h"
+
+#include "klee/Expr/Assignment.h"
+
+#include <algorithm>
+
+using namespace klee;
+
+static inline uint64_t widthMask(Expr::Width w) {
+  return w >= 64 ? ~0ULL : (1ULL << w) - 1;
+}
+
+static inline int64_t signExtend(uint64_t value, Expr::Width w) {
+  return w >= 64 ? (int64_t) value : (int64_t) (value << (64 - w)) >> (64 - w);
+}
+
+int ExprTape::emit(Opcode op, Expr::Width width, int a, int b, int c, uint64_t imm) {
+  code.push_back({op, width, a, b, c, imm});
+  return (int) code.size() - 1;
+}
+
+unsigned ExprTape::compile(const ref<Expr> &e) {
+  int reg = compileExpr(e);
+  if (reg < 0)
+    complete = false;
+  roots.push_back(e);
+  rootRegisters.push_back(reg);
+  return roots.size() - 1;
+}
+
+unsigned ExprTape::arraySlot(const Array *array) {
+  auto it = std::find(arrays.begin(), arrays.end(), array);
+  if (it != arrays.end())
+    return it - arrays.begin();
+  arrays.push_back(array);
+  return arrays.size() - 1;
+}
+
+int ExprTape::compileRead(const ReadExpr *re) {
+  const Array *root = re->updates.root;
+  if (root->getRange() > 64 || root->getDomain() > 64)
+    return -1;
+  int index = compileExpr(re->index);
+  if (index < 0)
+    return -1;
+  int value = emit(Read, root->getRange(), index, -1, -1, arraySlot(root));
+
+  // Updates as selects, from the oldest one, as the newest matching update is
+  // the value read
+  std::vector<const UpdateNode *> updates;
+  for (const UpdateNode *un = re->updates.head.get(); un; un = un->next.get())
+    updates.push_back(un);
+  for (auto it = updates.rbegin(); it != updates.rend(); ++it) {
+    int updateIndex = compileExpr((*it)->index), updateValue = compileExpr((*it)->value);
+    if (updateIndex < 0 || updateValue < 0)
+      return -1;
+    int hit = emit(Eq, Expr::Bool, index, updateIndex);
+    value = emit(Select, root->getRange(), hit, updateValue, value);
+  }
+  return value;
+}
+
+int ExprTape::compileExpr(const ref<Expr> &e) {
+  auto it = compiled.find(e);
+  if (it != compiled.end())
+    return it->second;
+
+  int reg = -1;
+  Expr::Width w = e->getWidth();
+  if (w > 64) {
+    // not supported
+  } else if (const ConstantExpr *ce = dyn_cast<ConstantExpr>(e)) {
+    reg = emit(Const, w, -1, -1, -1, ce->getZExtValue());
+  } else if (const ReadExpr *re = dyn_cast<ReadExpr>(e)) {
+    reg = compileRead(re);
+  } else if (e->getKind() == Expr::NotOptimized || e->getKind() == Expr::ZExt) {
+    reg = compileExpr(e->getKid(0)); // values are kept zero-extended
+  } else {
+    int kids[3] = {-1, -1, -1};
+    bool supported = true;
+    for (unsigned i = 0; i < e->getNumKids(); i++) {
+      kids[i] = compileExpr(e->getKid(i));
+      supported &= (kids[i] >= 0);
+    }
+
+    Opcode op = Const;
+    uint64_t imm = e->getNumKids() > 0 ? e->getKid(0)->getWidth() : 0;
+    switch (e->getKind()) {
+    case Expr::Select: op = Select; break;
+    case Expr::Concat: op = Concat; imm = e->getKid(1)->getWidth(); break;
+    case Expr::Extract: op = Extract; imm = cast<ExtractExpr>(e)->offset; break;
+    case Expr::SExt: op = SExt; break;
+    case Expr::Add: op = Add; break;
+    case Expr::Sub: op = Sub; break;
+    case Expr::Mul: op = Mul; break;
+    case Expr::UDiv: op = UDiv; break;
+    case Expr::SDiv: op = SDiv; break;
+    case Expr::URem: op = URem; break;
+    case Expr::SRem: op = SRem; break;
+    case Expr::Not: op = Not; break;
+    case Expr::And: op = And; break;
+    case Expr::Or: op = Or; break;
+    case Expr::Xor: op = Xor; break;
+    case Expr::Shl: op = Shl; break;
+    case Expr::LShr: op = LShr; break;
+    case Expr::AShr: op = AShr; break;
+    case Expr::Eq: op = Eq; break;
+    case Expr::Ne: op = Ne; break;
+    case Expr::Ult: op = Ult; break;
+    case Expr::Ule: op = Ule; break;
+    case Expr::Ugt: op = Ugt; break;
+    case Expr::Uge: op = Uge; break;
+    case Expr::Slt: op = Slt; break;
+    case Expr::Sle: op = Sle; break;
+    case Expr::Sgt: op = Sgt; break;
+    case Expr::Sge: op = Sge; break;
+    default: supported = false; break;
+    }
+    if (supported)
+      reg = emit(op, w, kids[0], kids[1], kids[2], imm);
+  }
+
+  compiled.insert(std::make_pair(e, reg));
+  return reg;
+}
+
+/// Compute r = f(a, b, c) on N lanes. The operands are restrict parameters,
+/// so that the loop gets vectorized.
+template <unsigned N, typename F>
+static inline void forLanes(uint64_t *__restrict r, const uint64_t *__restrict a,
+                            const uint64_t *__restrict b,
+                            const uint64_t *__restrict c, F f) {
+  for (unsigned l = 0; l < N; l++)
+    r[l] = f(a[l], b[l], c[l]);
+}
+
+template <unsigned N>
+void ExprTape::execute(size_t i, uint64_t *regs, uint8_t *failed) const {
+  static const uint64_t none[N] = {};
+  const Instruction &inst = code[i];
+  uint64_t *r = regs + i * N;
+  const uint64_t *a = inst.a >= 0 ? regs + inst.a * N : none;
+  const uint64_t *b = inst.b >= 0 ? regs + inst.b * N : none;
+  const uint64_t *c = inst.c >= 0 ? regs + inst.c * N : none;
+  const Expr::Width w = inst.width;
+  const Expr::Width ow = (Expr::Width) inst.imm; // operand width, where used
+  const uint64_t mask = widthMask(w);
+  const uint64_t imm = inst.imm;
+
+  switch (inst.op) {
+  case Const:
+    forLanes<N>(r, a, b, c, [=](uint64_t, uint64_t, uint64_t) { return imm; });
+    break;
+  case Read:
+    assert(0 && "reads are executed by the caller");
+    break;
+
+  case Select:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t z) { return x ? y : z; });
+    break;
+  case Concat:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t) { return (x << ow) | y; });
+    break;
+  case Extract:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t, uint64_t) { return (x >> ow) & mask; });
+    break;
+  case SExt:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t, uint64_t) { return (uint64_t) signExtend(x, ow) & mask; });
+    break;
+
+  case Add:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t) { return (x + y) & mask; });
+    break;
+  case Sub:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t) { return (x - y) & mask; });
+    break;
+  case Mul:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t) { return (x * y) & mask; });
+    break;
+
+  // Division by zero is left symbolic by ExprEvaluator. Such lanes fail, and
+  // divide by 1 here.
+  case UDiv:
+  case URem:
+  case SDiv:
+  case SRem:
+    for (unsigned l = 0; l < N; l++)
+      failed[l] |= (b[l] == 0);
+    if (inst.op == UDiv) {
+      forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t) { return x / (y ? y : 1); });
+    } else if (inst.op == URem) {
+      forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t) { return x % (y ? y : 1); });
+    } else {
+      bool div = (inst.op == SDiv);
+      forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t) {
+        int64_t sx = signExtend(x, ow), sy = signExtend(y, ow);
+        if (sy == -1) // avoid the overflow of INT64_MIN / -1, which wraps
+          return div ? (-(uint64_t) sx) & mask : 0;
+        if (sy == 0)
+          sy = 1;
+        return (uint64_t) (div ? sx / sy : sx % sy) & mask;
+      });
+    }
+    break;
+
+  case Not:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t, uint64_t) { return ~x & mask; });
+    break;
+  case And:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t) { return x & y; });
+    break;
+  case Or:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t) { return x | y; });
+    break;
+  case Xor:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t) { return x ^ y; });
+    break;
+  // Shifting by at least the width shifts out all bits, as APInt does
+  case Shl:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t) {
+      return y >= w ? 0 : (x << (y & 63)) & mask;
+    });
+    break;
+  case LShr:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t) {
+      return y >= w ? 0 : x >> (y & 63);
+    });
+    break;
+  case AShr:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t) {
+      return (uint64_t) (signExtend(x, w) >> (y >= w ? w - 1 : y)) & mask;
+    });
+    break;
+
+  case Eq:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t) { return (uint64_t) (x == y); });
+    break;
+  case Ne:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t) { return (uint64_t) (x != y); });
+    break;
+  case Ult:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t) { return (uint64_t) (x < y); });
+    break;
+  case Ule:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t) { return (uint64_t) (x <= y); });
+    break;
+  case Ugt:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t) { return (uint64_t) (x > y); });
+    break;
+  case Uge:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t) { return (uint64_t) (x >= y); });
+    break;
+  case Slt:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t) {
+      return (uint64_t) (signExtend(x, ow) < signExtend(y, ow));
+    });
+    break;
+  case Sle:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t) {
+      return (uint64_t) (signExtend(x, ow) <= signExtend(y, ow));
+    });
+    break;
+  case Sgt:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t) {
+      return (uint64_t) (signExtend(x, ow) > signExtend(y, ow));
+    });
+    break;
+  case Sge:
+    forLanes<N>(r, a, b, c, [=](uint64_t x, uint64_t y, uint64_t) {
+      return (uint64_t) (signExtend(x, ow) >= signExtend(y, ow));
+    });
+    break;
+  }
+}
+
+bool ExprTape::readElement(const Array *array,
+                           const std::vector<unsigned char> *bytes,
+                           bool allowFreeValues, unsigned index,
+                           uint64_t &value) {
+  // The same as ExprEvaluator::evalRead and Assignment::evaluate
+  value = 0;
+  if (array->isConstantArray() && index < array->size) {
+    value = array->constantValues[index]->getZExtValue();
+  } else if (bytes && index < bytes->size()) {
+    unsigned wordSize = array->getRange() / 8;
+    for (unsigned k = 0; k < wordSize && index * wordSize + k < bytes->size(); k++)
+      value |= (uint64_t) (*bytes)[index * wordSize + k] << (8U * k);
+  } else if (allowFreeValues) {
+    return false;
+  }
+  return true;
+}
+
+bool ExprTape::run(const Assignment &assignment) {
+  if (!complete)
+    return false;
+
+  bound.resize(arrays.size());
+  for (size_t i = 0; i < arrays.size(); i++) {
+    auto it = assignment.bindings.find(arrays[i]);
+    bound[i] = (it != assignment.bindings.end()) ? &it->second : nullptr;
+  }
+
+  registers.resize(code.size());
+  uint64_t *r = registers.data();
+  uint8_t failed = 0;
+  for (size_t i = 0; i < code.size(); i++) {
+    const Instruction &inst = code[i];
+    if (inst.op == Read) {
+      if (!readElement(arrays[inst.imm], bound[inst.imm], assignment.allowFreeValues,
+                       (unsigned) r[inst.a], r[i]))
+        return false;
+    } else {
+      execute<1>(i, r, &failed);
+      if (failed)
+        return false;
+    }
+  }
+  return true;
+}
+
+void ExprTape::runBatch(const std::vector<const Assignment *> &batch,
+                        std::vector<bool> &evaluated) {
+  const unsigned N = BatchSize;
+  assert(batch.size() <= N && "batch too large");
+  evaluated.assign(batch.size(), complete);
+  if (!complete)
+    return;
+
+  // Array elements in structure of arrays. Only symbolic arrays are laid out,
+  // as elements of constant arrays are the same for all assignments.
+  bound.assign(arrays.size() * N, nullptr);
+  elements.resize(arrays.size());
+  mayBeFree.assign(arrays.size() * N, 0);
+  for (size_t slot = 0; slot < arrays.size(); slot++) {
+    const Array *array = arrays[slot];
+    if (array->isConstantArray())
+      continue;
+    std::vector<uint64_t> &values = elements[slot];
+    values.assign(array->size * N, 0);
+    for (unsigned l = 0; l < batch.size(); l++) {
+      auto it = batch[l]->bindings.find(array);
+      const std::vector<unsigned char> *bytes =
+          (it != batch[l]->bindings.end()) ? &it->second : nullptr;
+      bound[slot * N + l] = bytes;
+      for (unsigned index = 0; index < array->size; index++) {
+        if (!readElement(array, bytes, batch[l]->allowFreeValues, index,
+                         values[index * N + l]))
+          mayBeFree[slot * N + l] = 1;
+      }
+    }
+  }
+
+  batchRegisters.assign(code.size() * N, 0);
+  uint64_t *regs = batchRegisters.data();
+  uint8_t failed[N] = {};
+  for (size_t i = 0; i < code.size(); i++) {
+    const Instruction &inst = code[i];
+    if (inst.op != Read) {
+      execute<N>(i, regs, failed);
+      continue;
+    }
+    const Array *array = arrays[inst.imm];
+    const uint64_t *index = regs + inst.a * N;
+    uint64_t *r = regs + i * N;
+    for (unsigned l = 0; l < batch.size(); l++) {
+      if (!array->isConstantArray() && index[l] < array->size &&
+          !mayBeFree[inst.imm * N + l]) {
+        r[l] = elements[inst.imm][index[l] * N + l];
+      } else if (!readElement(array, bound[inst.imm * N + l],
+                              batch[l]->allowFreeValues, (unsigned) index[l],
+                              r[l])) {
+        failed[l] = 1;
+      }
+    }
+  }
+
+  for (unsigned l = 0; l < batch.size(); l++)
+    if (failed[l])
+      evaluated[l] = false;
+}
+
+bool AssignmentBatch::flush() {
+  if (candidates.empty())
+    return found != nullptr;
+  batch.assign(candidates.begin(), candidates.end());
+  key.runBatch(batch, evaluated);
+  const std::vector<ref<Expr>> &roots = key.getRoots();
+  for (unsigned i = 0; i < candidates.size() && !found; ++i) {
+    bool satisfied = true;
+    if (evaluated[i]) {
+      for (unsigned r = 0; r < roots.size() && satisfied; ++r)
+        satisfied = key.getBatchValue(r, i) != 0;
+    } else {
+      satisfied = candidates[i]->satisfies(roots.begin(), roots.end());
+    }
+    if (satisfied)
+      found = candidates[i];
+  }
+  candidates.clear();
+  return found != nullptr;
+}
@@ -108,7 +108,10 @@ namespace {
     const std::string Filename;
     const MemoryBuffer *TheMemoryBuffer;
     ExprBuilder *Builder;
-    ArrayCache TheArrayCache;
+    // NOTE: [liuzikai] arrays can be created in an external cache, so that
+    // parsed expressions can outlive the parser
+    ArrayCache OwnedArrayCache;
+    ArrayCache *TheArrayCache;
     bool ClearArrayAfterQuery;
 
     Lexer TheLexer;
@@ -322,8 +325,10 @@ namespace {
 
   public:
     ParserImpl(const std::string _Filename, const MemoryBuffer *MB,
-               ExprBuilder *_Builder, bool _ClearArrayAfterQuery)
+               ExprBuilder *_Builder, ArrayCache *_ArrayCache,
+               bool _ClearArrayAfterQuery)
         : Filename(_Filename), TheMemoryBuffer(MB), Builder(_Builder),
+          TheArrayCache(_ArrayCache ? _ArrayCache : &OwnedArrayCache),
           ClearArrayAfterQuery(_ClearArrayAfterQuery), TheLexer(MB),
           MaxErrors(~0u), NumErrors(0) {}
 
@@ -526,11 +531,11 @@ DeclResult ParserImpl::ParseArrayDecl() {
   const Identifier *Label = GetOrCreateIdentifier(Name);
   const Array *Root;
   if (!Values.empty())
-    Root = TheArrayCache.CreateArray(Label->Name, Size.get(), &Values[0],
+    Root = TheArrayCache->CreateArray(Label->Name, Size.get(), &Values[0],
                                      &Values[0] + Values.size(),
                                      DomainType.get(), RangeType.get());
   else
-    Root = TheArrayCache.CreateArray(Label->Name, Size.get(), 0, 0, DomainType.get(), RangeType.get());
+    Root = TheArrayCache->CreateArray(Label->Name, Size.get(), 0, 0, DomainType.get(), RangeType.get());
   ArrayDecl *AD = new ArrayDecl(Label, Size.get(), 
                                 DomainType.get(), RangeType.get(), Root);
 
@@ -1327,7 +1332,7 @@ VersionResult ParserImpl::ParseVersionSpecifier() {
   if (!Res.isValid()) {
     // FIXME: I'm not sure if this is right. Do we need a unique array here?
     Res =
-        VersionResult(true, UpdateList(TheArrayCache.CreateArray("", 0), NULL));
+        VersionResult(true, UpdateList(TheArrayCache->CreateArray("", 0), NULL));
   }
   
   if (Label)
@@ -1661,7 +1666,15 @@ Parser::~Parser() {
 
 Parser *Parser::Create(const std::string Filename, const MemoryBuffer *MB,
                        ExprBuilder *Builder, bool ClearArrayAfterQuery) {
-  ParserImpl *P = new ParserImpl(Filename, MB, Builder, ClearArrayAfterQuery);
+  return Create(Filename, MB, Builder, nullptr, ClearArrayAfterQuery);
+}
+
+// NOTE: [liuzikai] added for klc3
+Parser *Parser::Create(const std::string Filename, const MemoryBuffer *MB,
+                       ExprBuilder *Builder, ArrayCache *TheArrayCache,
+                       bool ClearArrayAfterQuery) {
+  ParserImpl *P = new ParserImpl(Filename, MB, Builder, TheArrayCache,
+                                 ClearArrayAfterQuery);
   P->Initialize();
   return P;
 }
@@ -16,6 +16,7 @@
 #include "klee/Expr/ExprUtil.h"
 #include "klee/Expr/ExprVisitor.h"
 #include "klee/Support/OptionCategories.h"
+#include "klee/Solver/PersistentCexCache.h"
 #include "klee/Statistics/TimerStatIncrementer.h"
 #include "klee/Solver/SolverImpl.h"
 #include "klee/Solver/SolverStats.h"
@@ -83,9 +84,15 @@ class CexCachingSolver : public SolverImpl {
   }
 
   bool getAssignment(const Query& query, Assignment *&result);
+
+  // NOTE: [liuzikai] models kept across runs, tried before the solver
+  PersistentCexCache *persistentCache;
+
+  Assignment *memoizeAssignment(Assignment *binding, bool persist = true);
   
 public:
-  CexCachingSolver(Solver *_solver) : solver(_solver) {}
+  CexCachingSolver(Solver *_solver, PersistentCexCache *_persistentCache)
+      : solver(_solver), persistentCache(_persistentCache) {}
   ~CexCachingSolver();
   
   bool computeTruth(const Query&, bool &isValid);
@@ -110,13 +117,13 @@ struct NonNullAssignment {
   bool operator()(Assignment *a) const { return a!=0; }
 };
 
-struct NullOrSatisfyingAssignment {
-  KeyType &key;
-  
-  NullOrSatisfyingAssignment(KeyType &_key) : key(_key) {}
+struct NullOrBatchedAssignment {
+  AssignmentBatch &batch;
 
-  bool operator()(Assignment *a) const { 
-    return !a || a->satisfies(key.begin(), key.end()); 
+  NullOrBatchedAssignment(AssignmentBatch &_batch) : batch(_batch) {}
+
+  bool operator()(Assignment *a) const {
+    return !a || batch.add(a);
   }
 };
 
@@ -134,6 +141,11 @@ bool CexCachingSolver::searchForAssignment(KeyType &key, Assignment *&result) {
     return true;
   }
 
+  // NOTE: [liuzikai] compile the key once for all the assignments tried below
+  ExprTape keyTape;
+  for (const auto &e : key)
+    keyTape.compile(e);
+
   if (CexCacheTryAll) {
     // Look for a satisfying assignment for a superset, which is trivially an
     // assignment for any subset.
@@ -153,14 +165,18 @@ bool CexCachingSolver::searchForAssignment(KeyType &key, Assignment *&result) {
 
     // Otherwise, iterate through the set of current assignments to see if one
     // of them satisfies the query.
+    AssignmentBatch candidates(keyTape);
     for (assignmentsTable_ty::iterator it = assignmentsTable.begin(), 
            ie = assignmentsTable.end(); it != ie; ++it) {
-      Assignment *a = *it;
-      if (a->satisfies(key.begin(), key.end())) {
-        result = a;
+      if (candidates.add(*it)) {
+        result = candidates.found;
         return true;
       }
     }
+    if (candidates.flush()) {
+      result = candidates.found;
+      return true;
+    }
   } else {
     // FIXME: Which order? one is sure to be better.
 
@@ -175,8 +191,13 @@ bool CexCachingSolver::searchForAssignment(KeyType &key, Assignment *&result) {
     // assignment. While searching subsets, we also explicitly the solutions for
     // satisfiable subsets to see if they solve the current query and return
     // them if so. This is cheap and frequently succeeds.
-    if (!lookup) 
-      lookup = cache.findSubset(key, NullOrSatisfyingAssignment(key));
+    // NOTE: [liuzikai] the solutions are checked in batches as they are found
+    AssignmentBatch candidates(keyTape);
+    if (!lookup) {
+      lookup = cache.findSubset(key, NullOrBatchedAssignment(candidates));
+      if (lookup ? *lookup != nullptr : candidates.flush())
+        lookup = &candidates.found;
+    }
 
     // If either lookup succeeded, then we have a cached solution.
     if (lookup) {
@@ -219,11 +240,39 @@ bool CexCachingSolver::lookupAssignment(const Query &query,
   return found;
 }
 
+/// memoizeAssignment - Take the ownership of binding and return the equal
+/// one in assignmentsTable.
+///
+/// \param persist - Whether to add a new binding to the persistent cache.
+Assignment *CexCachingSolver::memoizeAssignment(Assignment *binding,
+                                                bool persist) {
+  std::pair<assignmentsTable_ty::iterator, bool>
+    res = assignmentsTable.insert(binding);
+  if (!res.second) {
+    delete binding;
+    return *res.first;
+  }
+  if (persistentCache && persist)
+    persistentCache->add(*binding);
+  return binding;
+}
+
 bool CexCachingSolver::getAssignment(const Query& query, Assignment *&result) {
   KeyType key;
   if (lookupAssignment(query, key, result))
     return true;
 
+  // NOTE: [liuzikai] try models from previous runs before the solver
+  if (persistentCache) {
+    if (const Assignment *a = persistentCache->find(key)) {
+      ++stats::queryCexCacheHits;
+      // Already kept, and marked as most recently used by find()
+      result = memoizeAssignment(new Assignment(*a), false);
+      cache.insert(key, result);
+      return true;
+    }
+  }
+
   std::vector<const Array*> objects;
   findSymbolicObjects(key.begin(), key.end(), objects);
 
@@ -235,15 +284,8 @@ bool CexCachingSolver::getAssignment(const Query& query, Assignment *&result) {
     
   Assignment *binding;
   if (hasSolution) {
-    binding = new Assignment(objects, values);
-
     // Memoize the result.
-    std::pair<assignmentsTable_ty::iterator, bool>
-      res = assignmentsTable.insert(binding);
-    if (!res.second) {
-      delete binding;
-      binding = *res.first;
-    }
+    binding = memoizeAssignment(new Assignment(objects, values));
     
     if (DebugCexCacheCheckBinding)
       if (!binding->satisfies(key.begin(), key.end())) {
@@ -384,6 +426,7 @@ void CexCachingSolver::setCoreSolverTimeout(time::Span timeout) {
 
 ///
 
-Solver *klee::createCexCachingSolver(Solver *_solver) {
-  return new Solver(new CexCachingSolver(_solver));
+Solver *klee::createCexCachingSolver(Solver *_solver,
+                                     PersistentCexCache *persistentCache) {
+  return new Solver(new CexCachingSolver(_solver, persistentCache));
 }
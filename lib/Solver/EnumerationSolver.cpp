@@ -0,0 +1,526 @@
+//===-- EnumerationSolver.cpp ---------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+// NOTE: [liuzikai] added for klc3. Many LC-3 assignments take one or two
+// symbolic words, so after independent constraint slicing a query often reads
+// a single 16-bit array element. This incomplete solver compiles such a query
+// (constraints and expression) into a straight-line program over lanes of
+// 16-bit values, and tries all values of the symbolic elements, a batch of
+// values of the innermost element at a time. Each instruction is a plain loop
+// over the lanes that the compiler vectorizes. Queries over more elements,
+// wider values, or operations that are not supported go to the secondary
+// solver.
+
+#include "klee/Solver/Solver.h"
+
+#include "klee/Expr/Constraints.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Expr/ExprHashMap.h"
+#include "klee/Solver/IncompleteSolver.h"
+#include "klee/Solver/SolverStats.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+/// Values of the innermost symbolic element tried at once
+const unsigned LANES = 256;
+
+/// A straight-line program over lanes of values of at most 16 bits. Every
+/// register holds values masked to the width of the expression it computes,
+/// and booleans as 0 or 1.
+class LaneProgram {
+public:
+  /// An array element that is enumerated
+  struct Variable {
+    const Array *array;
+    unsigned index;
+    Expr::Width width;
+  };
+
+  /// Compile expressions into the program
+  /// \return The register of the value of e, or -1 if e is not supported
+  int compile(const ref<Expr> &e);
+
+  /// Register of the conjunction of the given boolean registers
+  int conjunction(const std::vector<int> &regs);
+
+  const std::vector<Variable> &getVariables() const { return variables; }
+
+  /// Run the program with the innermost variable taking values
+  /// [base, base + LANES) across the lanes, and other variables the given
+  /// values. All lanes are computed, even those beyond the range of the
+  /// innermost variable, so that the loops have a constant trip count and get
+  /// vectorized at -O2.
+  /// \param values - Values of all variables, where that of the innermost one
+  /// is ignored
+  void run(const std::vector<uint16_t> &values, uint16_t base);
+
+  const uint16_t *getRegister(int reg) const { return &lanes[reg * LANES]; }
+
+private:
+  enum Opcode {
+    CONST, VAR, INNER_VAR, LOOKUP,
+    ADD, SUB, MUL, AND, OR, XOR, NOT, SHL, LSHR, ASHR,
+    EQ, ULT, ULE, SLT, SLE, SELECT, SEXT, EXTRACT, CONCAT
+  };
+
+  struct Instruction {
+    Opcode op;
+    Expr::Width width;      // of the result
+    int a, b, c;            // operand registers
+    uint64_t imm;           // constant, variable, table, operand width or shift
+  };
+
+  std::vector<Instruction> code; // the register of an instruction is its index
+  std::vector<Variable> variables;
+  std::vector<std::vector<uint16_t>> tables; // of constant arrays
+  ExprHashMap<int> registers;
+  std::map<std::pair<const Array *, unsigned>, int> variableRegisters;
+  std::vector<uint16_t> lanes;
+
+  int emit(Opcode op, Expr::Width width, int a = -1, int b = -1, int c = -1, uint64_t imm = 0) {
+    code.push_back({op, width, a, b, c, imm});
+    return (int) code.size() - 1;
+  }
+
+  int compileUncached(const ref<Expr> &e);
+  int compileRead(const ReadExpr *re);
+  int compileVariable(const Array *array, unsigned index);
+};
+
+int LaneProgram::compile(const ref<Expr> &e) {
+  auto it = registers.find(e);
+  if (it != registers.end())
+    return it->second;
+  int reg = compileUncached(e);
+  registers.insert(std::make_pair(e, reg));
+  return reg;
+}
+
+int LaneProgram::compileVariable(const Array *array, unsigned index) {
+  auto key = std::make_pair(array, index);
+  auto it = variableRegisters.find(key);
+  if (it != variableRegisters.end())
+    return it->second;
+  // The first variable is the innermost one
+  int reg = emit(variables.empty() ? INNER_VAR : VAR, array->getRange(), -1, -1, -1, variables.size());
+  variables.push_back({array, index, array->getRange()});
+  variableRegisters[key] = reg;
+  return reg;
+}
+
+int LaneProgram::compileRead(const ReadExpr *re) {
+  const Array *root = re->updates.root;
+  if (root->getRange() > 16 || root->getDomain() > 16)
+    return -1;
+  int index = compile(re->index);
+  if (index < 0)
+    return -1;
+
+  // The initial value
+  int value;
+  if (root->isConstantArray()) {
+    std::vector<uint16_t> table(root->size);
+    for (unsigned i = 0; i < root->size; i++)
+      table[i] = (uint16_t) root->constantValues[i]->getZExtValue();
+    tables.push_back(std::move(table));
+    value = emit(LOOKUP, root->getRange(), index, -1, -1, tables.size() - 1);
+  } else if (const ConstantExpr *ce = dyn_cast<ConstantExpr>(re->index)) {
+    if (ce->getZExtValue() >= root->size)
+      return -1;
+    value = compileVariable(root, (unsigned) ce->getZExtValue());
+  } else {
+    return -1; // any element may be read
+  }
+
+  // Updates, from the oldest one
+  std::vector<const UpdateNode *> updates;
+  for (const UpdateNode *un = re->updates.head.get(); un; un = un->next.get())
+    updates.push_back(un);
+  for (auto it = updates.rbegin(); it != updates.rend(); ++it) {
+    int updateIndex = compile((*it)->index), updateValue = compile((*it)->value);
+    if (updateIndex < 0 || updateValue < 0)
+      return -1;
+    int hit = emit(EQ, Expr::Bool, index, updateIndex, -1, root->getDomain());
+    value = emit(SELECT, root->getRange(), updateValue, value, hit);
+  }
+  return value;
+}
+
+int LaneProgram::compileUncached(const ref<Expr> &e) {
+  Expr::Width w = e->getWidth();
+  if (w > 16)
+    return -1;
+
+  if (const ConstantExpr *ce = dyn_cast<ConstantExpr>(e))
+    return emit(CONST, w, -1, -1, -1, ce->getZExtValue());
+  if (const ReadExpr *re = dyn_cast<ReadExpr>(e))
+    return compileRead(re);
+
+  Opcode op;
+  switch (e->getKind()) {
+  case Expr::NotOptimized:
+    return compile(e->getKid(0));
+  case Expr::ZExt:
+    return compile(e->getKid(0)); // values are kept zero-extended
+  case Expr::SExt: {
+    int a = compile(e->getKid(0));
+    return a < 0 ? -1 : emit(SEXT, w, a, -1, -1, e->getKid(0)->getWidth());
+  }
+  case Expr::Extract: {
+    int a = compile(e->getKid(0));
+    return a < 0 ? -1 : emit(EXTRACT, w, a, -1, -1, cast<ExtractExpr>(e)->offset);
+  }
+  case Expr::Not: {
+    int a = compile(e->getKid(0));
+    return a < 0 ? -1 : emit(NOT, w, a);
+  }
+  case Expr::Select: {
+    int c = compile(e->getKid(0)), a = compile(e->getKid(1)), b = compile(e->getKid(2));
+    return (a < 0 || b < 0 || c < 0) ? -1 : emit(SELECT, w, a, b, c);
+  }
+  case Expr::Concat: {
+    int a = compile(e->getKid(0)), b = compile(e->getKid(1));
+    return (a < 0 || b < 0) ? -1 : emit(CONCAT, w, a, b, -1, e->getKid(1)->getWidth());
+  }
+
+  case Expr::Add: op = ADD; break;
+  case Expr::Sub: op = SUB; break;
+  case Expr::Mul: op = MUL; break;
+  case Expr::And: op = AND; break;
+  case Expr::Or: op = OR; break;
+  case Expr::Xor: op = XOR; break;
+  case Expr::Shl: op = SHL; break;
+  case Expr::LShr: op = LSHR; break;
+  case Expr::AShr: op = ASHR; break;
+  case Expr::Eq: op = EQ; break;
+  case Expr::Ult: op = ULT; break;
+  case Expr::Ule: op = ULE; break;
+  case Expr::Slt: op = SLT; break;
+  case Expr::Sle: op = SLE; break;
+
+  case Expr::Ne:
+  case Expr::Ugt:
+  case Expr::Uge:
+  case Expr::Sgt:
+  case Expr::Sge: {
+    // Not built by the ExprBuilders, but handled for completeness
+    int a = compile(e->getKid(0)), b = compile(e->getKid(1));
+    if (a < 0 || b < 0)
+      return -1;
+    Expr::Width ow = e->getKid(0)->getWidth();
+    switch (e->getKind()) {
+    case Expr::Ne: return emit(NOT, Expr::Bool, emit(EQ, Expr::Bool, a, b, -1, ow));
+    case Expr::Ugt: return emit(ULT, Expr::Bool, b, a, -1, ow);
+    case Expr::Uge: return emit(ULE, Expr::Bool, b, a, -1, ow);
+    case Expr::Sgt: return emit(SLT, Expr::Bool, b, a, -1, ow);
+    default: return emit(SLE, Expr::Bool, b, a, -1, ow);
+    }
+  }
+
+  default:
+    return -1; // division is not used by LC-3, and the rest are wider
+  }
+
+  int a = compile(e->getKid(0)), b = compile(e->getKid(1));
+  if (a < 0 || b < 0)
+    return -1;
+  return emit(op, w, a, b, -1, e->getKid(0)->getWidth());
+}
+
+int LaneProgram::conjunction(const std::vector<int> &regs) {
+  int ret = emit(CONST, Expr::Bool, -1, -1, -1, 1);
+  for (int reg : regs)
+    ret = emit(AND, Expr::Bool, ret, reg);
+  return ret;
+}
+
+/// Operand for instructions that take fewer than three
+const uint16_t NO_OPERAND[LANES] = {};
+
+/// Compute r = f(a, b, c) lane by lane. The operands are restrict parameters,
+/// so that the loop gets vectorized.
+template <typename F>
+inline void forLanes(uint16_t *__restrict r, const uint16_t *__restrict a, const uint16_t *__restrict b,
+                     const uint16_t *__restrict c, F f) {
+  for (unsigned l = 0; l < LANES; l++)
+    r[l] = (uint16_t) f(a[l], b[l], c[l], l);
+}
+
+void LaneProgram::run(const std::vector<uint16_t> &values, uint16_t base) {
+  lanes.resize(code.size() * LANES);
+  uint16_t *regs = lanes.data();
+
+  for (size_t i = 0; i < code.size(); i++) {
+    const Instruction &inst = code[i];
+    uint16_t *r = regs + i * LANES;
+    const uint16_t *a = inst.a >= 0 ? regs + inst.a * LANES : NO_OPERAND;
+    const uint16_t *b = inst.b >= 0 ? regs + inst.b * LANES : NO_OPERAND;
+    const uint16_t *c = inst.c >= 0 ? regs + inst.c * LANES : NO_OPERAND;
+    const unsigned width = inst.width;
+    const uint16_t mask = (uint16_t) ((1U << width) - 1);
+    // The sign bit of the operand width, for signed operations
+    const uint16_t sign = (inst.imm >= 1 && inst.imm <= 16) ? (uint16_t) (1U << (inst.imm - 1)) : 0;
+    const uint64_t imm = inst.imm;
+
+    switch (inst.op) {
+    case CONST:
+      forLanes(r, a, b, c, [=](uint16_t, uint16_t, uint16_t, unsigned) { return imm; });
+      break;
+    case VAR: {
+      uint16_t value = values[imm];
+      forLanes(r, a, b, c, [=](uint16_t, uint16_t, uint16_t, unsigned) { return value; });
+      break;
+    }
+    case INNER_VAR:
+      forLanes(r, a, b, c, [=](uint16_t, uint16_t, uint16_t, unsigned l) { return base + l; });
+      break;
+    case LOOKUP: {
+      const uint16_t *table = tables[imm].data();
+      size_t size = tables[imm].size();
+      forLanes(r, a, b, c, [=](uint16_t x, uint16_t, uint16_t, unsigned) { return x < size ? table[x] : 0; });
+      break;
+    }
+    case ADD:
+      forLanes(r, a, b, c, [=](uint16_t x, uint16_t y, uint16_t, unsigned) { return (x + y) & mask; });
+      break;
+    case SUB:
+      forLanes(r, a, b, c, [=](uint16_t x, uint16_t y, uint16_t, unsigned) { return (x - y) & mask; });
+      break;
+    case MUL:
+      forLanes(r, a, b, c, [=](uint16_t x, uint16_t y, uint16_t, unsigned) { return ((uint32_t) x * y) & mask; });
+      break;
+    case AND:
+      forLanes(r, a, b, c, [=](uint16_t x, uint16_t y, uint16_t, unsigned) { return x & y; });
+      break;
+    case OR:
+      forLanes(r, a, b, c, [=](uint16_t x, uint16_t y, uint16_t, unsigned) { return x | y; });
+      break;
+    case XOR:
+      forLanes(r, a, b, c, [=](uint16_t x, uint16_t y, uint16_t, unsigned) { return x ^ y; });
+      break;
+    case NOT:
+      forLanes(r, a, b, c, [=](uint16_t x, uint16_t, uint16_t, unsigned) { return ~x & mask; });
+      break;
+    // Shift amounts of at least the width shift out all bits. Otherwise they
+    // are less than 16.
+    case SHL:
+      forLanes(r, a, b, c, [=](uint16_t x, uint16_t y, uint16_t, unsigned) {
+        return y >= width ? 0 : ((uint32_t) x << (y & 15)) & mask;
+      });
+      break;
+    case LSHR:
+      forLanes(r, a, b, c, [=](uint16_t x, uint16_t y, uint16_t, unsigned) {
+        return y >= width ? 0 : x >> (y & 15);
+      });
+      break;
+    case ASHR:
+      forLanes(r, a, b, c, [=](uint16_t x, uint16_t y, uint16_t, unsigned) {
+        int32_t v = (int32_t) (x ^ sign) - (int32_t) sign; // sign-extended
+        return (v >> (y >= width ? width - 1 : y)) & mask;
+      });
+      break;
+    case EQ:
+      forLanes(r, a, b, c, [=](uint16_t x, uint16_t y, uint16_t, unsigned) { return x == y; });
+      break;
+    case ULT:
+      forLanes(r, a, b, c, [=](uint16_t x, uint16_t y, uint16_t, unsigned) { return x < y; });
+      break;
+    case ULE:
+      forLanes(r, a, b, c, [=](uint16_t x, uint16_t y, uint16_t, unsigned) { return x <= y; });
+      break;
+    // Flipping the sign bit maps the signed order to the unsigned one
+    case SLT:
+      forLanes(r, a, b, c, [=](uint16_t x, uint16_t y, uint16_t, unsigned) {
+        return (uint16_t) (x ^ sign) < (uint16_t) (y ^ sign);
+      });
+      break;
+    case SLE:
+      forLanes(r, a, b, c, [=](uint16_t x, uint16_t y, uint16_t, unsigned) {
+        return (uint16_t) (x ^ sign) <= (uint16_t) (y ^ sign);
+      });
+      break;
+    case SELECT:
+      forLanes(r, a, b, c, [=](uint16_t x, uint16_t y, uint16_t z, unsigned) { return z ? x : y; });
+      break;
+    case SEXT:
+      forLanes(r, a, b, c, [=](uint16_t x, uint16_t, uint16_t, unsigned) { return ((x ^ sign) - sign) & mask; });
+      break;
+    case EXTRACT:
+      forLanes(r, a, b, c, [=](uint16_t x, uint16_t, uint16_t, unsigned) { return (x >> imm) & mask; });
+      break;
+    case CONCAT:
+      forLanes(r, a, b, c, [=](uint16_t x, uint16_t y, uint16_t, unsigned) { return ((uint32_t) x << imm) | y; });
+      break;
+    }
+  }
+}
+
+class EnumerationSolver : public IncompleteSolver {
+  unsigned maxElements;
+
+  /// What enumeration finds about a query
+  struct Result {
+    bool canBeTrue = false, canBeFalse = false;
+    std::vector<uint16_t> trueValues, falseValues; // of the variables
+    uint16_t exprValue = 0; // under the first satisfying values
+  };
+
+  enum StopAt {
+    FIRST_SOLUTION,   // any satisfying values
+    FIRST_FALSE,      // satisfying values under which the expression is false
+    TRUE_AND_FALSE    // both outcomes
+  };
+
+  /// Compile and enumerate the query
+  /// \param[out] program - The compiled program, for its variables
+  /// \return False if the query is not supported
+  bool enumerate(const Query &query, StopAt stopAt, LaneProgram &program, Result &result);
+
+public:
+  explicit EnumerationSolver(unsigned maxElements) : maxElements(maxElements) {}
+
+  IncompleteSolver::PartialValidity computeValidity(const Query &) override;
+  IncompleteSolver::PartialValidity computeTruth(const Query &) override;
+  bool computeValue(const Query &, ref<Expr> &result) override;
+  bool computeInitialValues(const Query &, const std::vector<const Array *> &objects,
+                            std::vector<std::vector<unsigned char>> &values, bool &hasSolution) override;
+};
+
+bool EnumerationSolver::enumerate(const Query &query, StopAt stopAt, LaneProgram &program, Result &result) {
+  ++stats::enumerationSolverQueries;
+
+  std::vector<int> constraintRegs;
+  for (const auto &c : query.constraints) {
+    int reg = program.compile(c);
+    if (reg < 0)
+      return false;
+    constraintRegs.push_back(reg);
+  }
+  int exprReg = program.compile(query.expr);
+  if (exprReg < 0)
+    return false;
+  int feasibleReg = program.conjunction(constraintRegs);
+
+  const std::vector<LaneProgram::Variable> &variables = program.getVariables();
+  if (variables.size() > maxElements)
+    return false;
+
+  // Odometer over the variables, with the innermost one across the lanes
+  std::vector<uint16_t> values(variables.size(), 0);
+  uint32_t innerRange = variables.empty() ? 1 : 1U << variables[0].width;
+  while (true) {
+    for (uint32_t base = 0; base < innerRange; base += LANES) {
+      unsigned count = (unsigned) std::min<uint32_t>(LANES, innerRange - base);
+      program.run(values, (uint16_t) base);
+      const uint16_t *feasible = program.getRegister(feasibleReg);
+      const uint16_t *expr = program.getRegister(exprReg);
+      for (unsigned l = 0; l < count; l++) {
+        if (!feasible[l])
+          continue;
+        if (!result.canBeTrue && !result.canBeFalse)
+          result.exprValue = expr[l];
+        bool &seen = expr[l] ? result.canBeTrue : result.canBeFalse;
+        if (!seen) {
+          seen = true;
+          std::vector<uint16_t> &model = expr[l] ? result.trueValues : result.falseValues;
+          model = values;
+          if (!model.empty())
+            model[0] = (uint16_t) (base + l);
+        }
+        if (stopAt == FIRST_SOLUTION ||
+            (stopAt == FIRST_FALSE && result.canBeFalse) ||
+            (stopAt == TRUE_AND_FALSE && result.canBeTrue && result.canBeFalse))
+          return true;
+      }
+    }
+    // Next values of the outer variables
+    size_t k = 1;
+    for (; k < values.size(); k++) {
+      if (++values[k] & ((1U << variables[k].width) - 1))
+        break;
+      values[k] = 0;
+    }
+    if (k >= values.size())
+      return true;
+  }
+}
+
+IncompleteSolver::PartialValidity EnumerationSolver::computeValidity(const Query &query) {
+  LaneProgram program;
+  Result result;
+  if (!enumerate(query, TRUE_AND_FALSE, program, result))
+    return IncompleteSolver::None;
+  ++stats::enumerationSolverHits;
+  if (result.canBeTrue && result.canBeFalse)
+    return IncompleteSolver::TrueOrFalse;
+  // Vacuously true if the constraints are infeasible
+  return result.canBeFalse ? IncompleteSolver::MustBeFalse : IncompleteSolver::MustBeTrue;
+}
+
+IncompleteSolver::PartialValidity EnumerationSolver::computeTruth(const Query &query) {
+  LaneProgram program;
+  Result result;
+  if (!enumerate(query, FIRST_FALSE, program, result))
+    return IncompleteSolver::None;
+  ++stats::enumerationSolverHits;
+  return result.canBeFalse ? IncompleteSolver::MustBeFalse : IncompleteSolver::MustBeTrue;
+}
+
+bool EnumerationSolver::computeValue(const Query &query, ref<Expr> &result) {
+  LaneProgram program;
+  Result r;
+  if (!enumerate(query, FIRST_SOLUTION, program, r))
+    return false;
+  if (!r.canBeTrue && !r.canBeFalse)
+    return false; // infeasible constraints, for the secondary solver to report
+  ++stats::enumerationSolverHits;
+  result = ConstantExpr::create(r.exprValue, query.expr->getWidth());
+  return true;
+}
+
+bool EnumerationSolver::computeInitialValues(const Query &query, const std::vector<const Array *> &objects,
+                                             std::vector<std::vector<unsigned char>> &values, bool &hasSolution) {
+  LaneProgram program;
+  Result result;
+  if (!enumerate(query, FIRST_FALSE, program, result))
+    return false;
+  ++stats::enumerationSolverHits;
+
+  hasSolution = result.canBeFalse;
+  if (!hasSolution)
+    return true;
+
+  // Elements not in the query are not constrained by it
+  values.clear();
+  for (const Array *array : objects)
+    values.emplace_back(array->size * ((array->getRange() + 7) / 8), 0);
+  const std::vector<LaneProgram::Variable> &variables = program.getVariables();
+  for (size_t k = 0; k < variables.size(); k++) {
+    auto it = std::find(objects.begin(), objects.end(), variables[k].array);
+    if (it == objects.end())
+      continue;
+    std::vector<unsigned char> &bytes = values[it - objects.begin()];
+    unsigned wordSize = (variables[k].array->getRange() + 7) / 8;
+    for (unsigned b = 0; b < wordSize; b++)
+      bytes[variables[k].index * wordSize + b] = (unsigned char) ((result.falseValues[k] >> (8 * b)) & 0xFF);
+  }
+  return true;
+}
+
+} // namespace
+
+Solver *klee::createEnumerationSolver(Solver *s, unsigned maxElements) {
+  return new Solver(new StagedSolverImpl(new EnumerationSolver(maxElements), s));
+}
@@ -0,0 +1,976 @@
+//===-- IntervalSolver.cpp ------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+// NOTE: [liuzikai] added for klc3. Most branch conditions of LC-3 programs
+// compare a 16-bit expression against a constant, under constraints that are
+// simple ranges on input words (such as the numerical and printable string
+// constraints of the input space). This incomplete solver learns unsigned and
+// signed intervals and known bits of sub-expressions from the constraints,
+// propagates them through the query expression, and answers the query when
+// the result is decisive. Otherwise it tries a few assignments picked from the
+// learned intervals, which are checked concretely against the constraints, to
+// witness the query being true or false. Anything else goes to the secondary
+// solver.
+
+#include "klee/Solver/Solver.h"
+
+#include "klee/Expr/Assignment.h"
+#include "klee/Expr/Constraints.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Expr/ExprHashMap.h"
+#include "klee/Solver/IncompleteSolver.h"
+#include "klee/Solver/SolverStats.h"
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+/// Widths beyond this are not tracked. klc3 only builds Int16 and Bool
+/// expressions, plus extractions from them.
+const unsigned MAX_WIDTH = 16;
+
+/// Limit on the depth of backward propagation from a constraint
+const unsigned MAX_REFINE_DEPTH = 8;
+
+/// Limit on the number of indices to join over for a constant array read with
+/// a symbolic index
+const unsigned MAX_CONST_ARRAY_JOIN = 64;
+
+/// An over-approximation of the values of an expression, as the intersection
+/// of an unsigned interval, a signed interval and known bits
+struct AbstractValue {
+  Expr::Width width = 0;
+  bool tracked = false; // false if the width is beyond MAX_WIDTH
+  int64_t ulo = 0, uhi = 0;
+  int64_t slo = 0, shi = 0;
+  uint64_t zeros = 0, ones = 0; // known bits
+
+  uint64_t mask() const { return (1ULL << width) - 1; }
+  int64_t modulus() const { return 1LL << width; }
+  int64_t half() const { return 1LL << (width - 1); }
+
+  static AbstractValue top(Expr::Width w) {
+    AbstractValue v;
+    v.width = w;
+    if (w == 0 || w > MAX_WIDTH)
+      return v;
+    v.tracked = true;
+    v.ulo = 0;
+    v.uhi = (int64_t) v.mask();
+    v.slo = -v.half();
+    v.shi = v.half() - 1;
+    return v;
+  }
+
+  static AbstractValue point(Expr::Width w, uint64_t value) {
+    AbstractValue v = top(w);
+    if (!v.tracked)
+      return v;
+    value &= v.mask();
+    v.ulo = v.uhi = (int64_t) value;
+    v.ones = value;
+    v.zeros = ~value & v.mask();
+    v.normalize();
+    return v;
+  }
+
+  static AbstractValue boolean(bool value) {
+    return point(Expr::Bool, value ? 1 : 0);
+  }
+
+  bool isPoint(uint64_t &value) const {
+    if (!tracked || ulo != uhi)
+      return false;
+    value = (uint64_t) ulo;
+    return true;
+  }
+
+  bool isTop() const { return !tracked || (ulo == 0 && uhi == (int64_t) mask() && (zeros | ones) == 0); }
+
+  static int64_t toSigned(uint64_t value, Expr::Width w) {
+    return (value >> (w - 1)) & 1 ? (int64_t) value - (1LL << w) : (int64_t) value;
+  }
+
+  /// Tighten the three parts against each other. Return false if the set
+  /// of values is empty.
+  bool normalize() {
+    if (!tracked)
+      return true;
+    for (int round = 0; round < 2; round++) {
+      // Bits bound the unsigned and signed intervals
+      ulo = std::max(ulo, (int64_t) ones);
+      uhi = std::min(uhi, (int64_t) (mask() & ~zeros));
+      uint64_t sign = 1ULL << (width - 1);
+      if (ones & sign)
+        shi = std::min(shi, (int64_t) -1);
+      if (zeros & sign)
+        slo = std::max(slo, (int64_t) 0);
+
+      // Signed and unsigned intervals bound each other when they don't cross
+      // the sign boundary
+      if (slo >= 0) {
+        ulo = std::max(ulo, slo);
+        uhi = std::min(uhi, shi);
+      } else if (shi < 0) {
+        ulo = std::max(ulo, slo + modulus());
+        uhi = std::min(uhi, shi + modulus());
+      }
+      if (ulo > uhi)
+        return false;
+      if (uhi < half()) {
+        slo = std::max(slo, ulo);
+        shi = std::min(shi, uhi);
+      } else if (ulo >= half()) {
+        slo = std::max(slo, ulo - modulus());
+        shi = std::min(shi, uhi - modulus());
+      }
+      if (slo > shi)
+        return false;
+
+      // The common high bits of the unsigned bounds are known
+      uint64_t diff = (uint64_t) ulo ^ (uint64_t) uhi;
+      for (unsigned s = 1; s < 64; s <<= 1)
+        diff |= diff >> s;
+      uint64_t common = ~diff & mask();
+      ones |= (uint64_t) ulo & common;
+      zeros |= ~(uint64_t) ulo & common;
+      if (zeros & ones)
+        return false;
+    }
+    return true;
+  }
+
+  /// Intersect with another value of the same width. Return false if empty.
+  bool intersect(const AbstractValue &other) {
+    if (!other.tracked)
+      return true;
+    if (!tracked) {
+      *this = other;
+      return true;
+    }
+    ulo = std::max(ulo, other.ulo);
+    uhi = std::min(uhi, other.uhi);
+    slo = std::max(slo, other.slo);
+    shi = std::min(shi, other.shi);
+    zeros |= other.zeros;
+    ones |= other.ones;
+    if (ulo > uhi || slo > shi || (zeros & ones))
+      return false;
+    return normalize();
+  }
+
+  static AbstractValue join(const AbstractValue &a, const AbstractValue &b) {
+    if (!a.tracked || !b.tracked)
+      return top(a.width);
+    AbstractValue v = top(a.width);
+    v.ulo = std::min(a.ulo, b.ulo);
+    v.uhi = std::max(a.uhi, b.uhi);
+    v.slo = std::min(a.slo, b.slo);
+    v.shi = std::max(a.shi, b.shi);
+    v.zeros = a.zeros & b.zeros;
+    v.ones = a.ones & b.ones;
+    v.normalize();
+    return v;
+  }
+
+  /// Number of low bits known
+  unsigned knownLowBits() const {
+    unsigned n = 0;
+    while (n < width && (((zeros | ones) >> n) & 1))
+      n++;
+    return n;
+  }
+};
+
+/// Learned facts and abstract evaluation for one query
+class IntervalAnalysis {
+  ExprHashMap<AbstractValue> facts; // learned from the constraints
+  ExprHashMap<AbstractValue> cache; // of eval(), only once learning is done
+  bool learning = true;
+
+public:
+  /// Learn from the constraints. Return false if they are found infeasible.
+  bool learnAll(const ConstraintSet &constraints) {
+    // Two rounds, so that facts learned later help learning disequalities
+    for (int round = 0; round < 2; round++) {
+      for (const auto &c : constraints) {
+        if (!learn(c, true))
+          return false;
+      }
+    }
+    learning = false;
+    return true;
+  }
+
+  AbstractValue eval(const ref<Expr> &e);
+
+  /// Read expressions of symbolic arrays at constant indices with learned
+  /// facts, which are the leaves that witnesses assign values to
+  void collectLeaves(std::vector<std::pair<const ReadExpr *, AbstractValue>> &leaves) const {
+    for (const auto &it : facts) {
+      if (const ReadExpr *re = dyn_cast<ReadExpr>(it.first)) {
+        if (re->updates.head.isNull() && re->updates.root->isSymbolicArray() &&
+            isa<ConstantExpr>(re->index) && it.second.tracked)
+          leaves.emplace_back(re, it.second);
+      }
+    }
+  }
+
+private:
+  bool learn(const ref<Expr> &c, bool truth);
+
+  /// Refine the values of e to within r. Return false if nothing remains.
+  bool refine(const ref<Expr> &e, const AbstractValue &r, unsigned depth = 0);
+
+  AbstractValue evalUncached(const ref<Expr> &e);
+
+  static AbstractValue compare(Expr::Kind kind, const AbstractValue &a, const AbstractValue &b);
+};
+
+bool IntervalAnalysis::learn(const ref<Expr> &c, bool truth) {
+  switch (c->getKind()) {
+  case Expr::Constant:
+    return cast<ConstantExpr>(c)->isTrue() == truth;
+
+  case Expr::Not:
+    if (c->getWidth() == Expr::Bool)
+      return learn(c->getKid(0), !truth);
+    return true;
+
+  case Expr::And:
+    if (c->getWidth() == Expr::Bool && truth)
+      return learn(c->getKid(0), true) && learn(c->getKid(1), true);
+    return true;
+
+  case Expr::Or:
+    if (c->getWidth() == Expr::Bool && !truth)
+      return learn(c->getKid(0), false) && learn(c->getKid(1), false);
+    return true;
+
+  case Expr::Extract:
+    if (c->getWidth() == Expr::Bool)
+      return refine(c, AbstractValue::boolean(truth));
+    return true;
+
+  case Expr::Eq:
+  case Expr::Ult:
+  case Expr::Ule:
+  case Expr::Slt:
+  case Expr::Sle:
+    break;
+
+  default:
+    return true;
+  }
+
+  ref<Expr> left = c->getKid(0), right = c->getKid(1);
+  Expr::Width w = left->getWidth();
+
+  if (w == Expr::Bool && c->getKind() == Expr::Eq) {
+    // Eq(true/false, X) is how booleans are negated
+    if (const ConstantExpr *ce = dyn_cast<ConstantExpr>(left))
+      return learn(right, ce->isTrue() == truth);
+    return true;
+  }
+  if (w > MAX_WIDTH)
+    return true;
+
+  // One side must be a constant
+  const ConstantExpr *constant = dyn_cast<ConstantExpr>(left);
+  bool constantOnLeft = true;
+  ref<Expr> e = right;
+  if (!constant) {
+    constant = dyn_cast<ConstantExpr>(right);
+    constantOnLeft = false;
+    e = left;
+  }
+  if (!constant)
+    return true;
+  uint64_t value = constant->getZExtValue();
+  int64_t signedValue = AbstractValue::toSigned(value, w);
+
+  AbstractValue r = AbstractValue::top(w);
+  switch (c->getKind()) {
+  case Expr::Eq:
+    if (truth)
+      return refine(e, AbstractValue::point(w, value));
+    {
+      // Only a disequality at the bounds helps
+      AbstractValue cur = eval(e);
+      if (!cur.tracked)
+        return true;
+      if (cur.ulo == (int64_t) value)
+        r.ulo = cur.ulo + 1;
+      else if (cur.uhi == (int64_t) value)
+        r.uhi = cur.uhi - 1;
+      if (cur.slo == signedValue)
+        r.slo = cur.slo + 1;
+      else if (cur.shi == signedValue)
+        r.shi = cur.shi - 1;
+      if (r.ulo > r.uhi || r.slo > r.shi)
+        return false;
+    }
+    break;
+
+  // constant < e, constant <= e, e < constant, e <= constant, or their
+  // negations, expressed as bounds
+  case Expr::Ult:
+  case Expr::Ule: {
+    bool strict = (c->getKind() == Expr::Ult);
+    // e > value (or >=) if the constant is on the left and truth holds, etc.
+    bool lowerBound = (constantOnLeft == truth);
+    bool isStrict = (strict == truth);
+    if (lowerBound)
+      r.ulo = (int64_t) value + (isStrict ? 1 : 0);
+    else
+      r.uhi = (int64_t) value - (isStrict ? 1 : 0);
+    if (r.ulo > r.uhi)
+      return false;
+    break;
+  }
+  case Expr::Slt:
+  case Expr::Sle: {
+    bool strict = (c->getKind() == Expr::Slt);
+    bool lowerBound = (constantOnLeft == truth);
+    bool isStrict = (strict == truth);
+    if (lowerBound)
+      r.slo = signedValue + (isStrict ? 1 : 0);
+    else
+      r.shi = signedValue - (isStrict ? 1 : 0);
+    if (r.slo > r.shi)
+      return false;
+    break;
+  }
+  default:
+    return true;
+  }
+  if (!r.normalize())
+    return false;
+  return refine(e, r);
+}
+
+bool IntervalAnalysis::refine(const ref<Expr> &e, const AbstractValue &r, unsigned depth) {
+  if (!r.tracked || isa<ConstantExpr>(e)) {
+    if (const ConstantExpr *ce = dyn_cast<ConstantExpr>(e)) {
+      AbstractValue v = AbstractValue::point(e->getWidth(), ce->getZExtValue());
+      return v.intersect(r);
+    }
+    return true;
+  }
+
+  auto it = facts.find(e);
+  if (it == facts.end())
+    it = facts.insert(std::make_pair(e, AbstractValue::top(e->getWidth()))).first;
+  if (!it->second.intersect(r))
+    return false;
+  const AbstractValue v = it->second;
+
+  if (depth >= MAX_REFINE_DEPTH)
+    return true;
+
+  // Propagate back to the kid where the operation is invertible
+  Expr::Width w = e->getWidth();
+  switch (e->getKind()) {
+  case Expr::Add: {
+    const ConstantExpr *ce = dyn_cast<ConstantExpr>(e->getKid(0));
+    ref<Expr> x = e->getKid(1);
+    if (!ce) {
+      ce = dyn_cast<ConstantExpr>(e->getKid(1));
+      x = e->getKid(0);
+    }
+    if (!ce)
+      return true;
+    int64_t k = (int64_t) ce->getZExtValue();
+    AbstractValue xr = AbstractValue::top(w);
+    // Shift the intervals back by k, unless they wrap around
+    int64_t lo = (v.ulo - k) & (int64_t) v.mask(), hi = (v.uhi - k) & (int64_t) v.mask();
+    if (lo <= hi && hi - lo == v.uhi - v.ulo) {
+      xr.ulo = lo;
+      xr.uhi = hi;
+    }
+    // The same in the signed order, which is the unsigned order biased by half
+    lo = ((v.slo + v.half() - k) & (int64_t) v.mask()) - v.half();
+    hi = ((v.shi + v.half() - k) & (int64_t) v.mask()) - v.half();
+    if (lo <= hi && hi - lo == v.shi - v.slo) {
+      xr.slo = lo;
+      xr.shi = hi;
+    }
+    if (!xr.normalize())
+      return false;
+    if (xr.isTop())
+      return true;
+    return refine(x, xr, depth + 1);
+  }
+
+  case Expr::Not: {
+    AbstractValue xr = AbstractValue::top(w);
+    xr.ulo = (int64_t) v.mask() - v.uhi;
+    xr.uhi = (int64_t) v.mask() - v.ulo;
+    xr.slo = -v.shi - 1;
+    xr.shi = -v.slo - 1;
+    xr.zeros = v.ones;
+    xr.ones = v.zeros;
+    if (!xr.normalize())
+      return false;
+    return refine(e->getKid(0), xr, depth + 1);
+  }
+
+  case Expr::And: {
+    // A result bit of 1 needs the bit of x to be 1. So does a result bit of 0
+    // with the mask bit set.
+    const ConstantExpr *ce = dyn_cast<ConstantExpr>(e->getKid(0));
+    ref<Expr> x = e->getKid(1);
+    if (!ce) {
+      ce = dyn_cast<ConstantExpr>(e->getKid(1));
+      x = e->getKid(0);
+    }
+    if (!ce)
+      return true;
+    uint64_t m = ce->getZExtValue();
+    AbstractValue xr = AbstractValue::top(w);
+    xr.ones = v.ones & m;
+    xr.zeros = v.zeros & m;
+    if (!xr.normalize())
+      return false;
+    if (xr.isTop())
+      return true;
+    return refine(x, xr, depth + 1);
+  }
+
+  case Expr::ZExt: {
+    ref<Expr> x = e->getKid(0);
+    Expr::Width xw = x->getWidth();
+    AbstractValue xr = AbstractValue::top(xw);
+    if (!xr.tracked)
+      return true;
+    if (v.ulo > (int64_t) xr.mask())
+      return false;
+    xr.ulo = v.ulo;
+    xr.uhi = std::min(v.uhi, (int64_t) xr.mask());
+    xr.zeros = v.zeros & xr.mask();
+    xr.ones = v.ones & xr.mask();
+    if (!xr.normalize())
+      return false;
+    return refine(x, xr, depth + 1);
+  }
+
+  case Expr::Extract: {
+    const ExtractExpr *ee = cast<ExtractExpr>(e);
+    ref<Expr> x = ee->expr;
+    AbstractValue xr = AbstractValue::top(x->getWidth());
+    if (!xr.tracked)
+      return true;
+    xr.zeros = (v.zeros << ee->offset) & xr.mask();
+    xr.ones = (v.ones << ee->offset) & xr.mask();
+    if (!xr.normalize())
+      return false;
+    return refine(x, xr, depth + 1);
+  }
+
+  default:
+    return true;
+  }
+}
+
+AbstractValue IntervalAnalysis::eval(const ref<Expr> &e) {
+  if (learning)
+    return evalUncached(e);
+  auto it = cache.find(e);
+  if (it != cache.end())
+    return it->second;
+  AbstractValue v = evalUncached(e);
+  cache.insert(std::make_pair(e, v));
+  return v;
+}
+
+AbstractValue IntervalAnalysis::compare(Expr::Kind kind, const AbstractValue &a, const AbstractValue &b) {
+  if (!a.tracked || !b.tracked)
+    return AbstractValue::top(Expr::Bool);
+  switch (kind) {
+  case Expr::Eq:
+  case Expr::Ne: {
+    uint64_t va, vb;
+    bool isEq;
+    if (a.isPoint(va) && b.isPoint(vb))
+      isEq = (va == vb);
+    else if (a.uhi < b.ulo || b.uhi < a.ulo || a.shi < b.slo || b.shi < a.slo ||
+             (a.ones & b.zeros) || (a.zeros & b.ones))
+      isEq = false;
+    else
+      return AbstractValue::top(Expr::Bool);
+    return AbstractValue::boolean(isEq == (kind == Expr::Eq));
+  }
+  case Expr::Ult:
+    if (a.uhi < b.ulo) return AbstractValue::boolean(true);
+    if (a.ulo >= b.uhi) return AbstractValue::boolean(false);
+    break;
+  case Expr::Ule:
+    if (a.uhi <= b.ulo) return AbstractValue::boolean(true);
+    if (a.ulo > b.uhi) return AbstractValue::boolean(false);
+    break;
+  case Expr::Slt:
+    if (a.shi < b.slo) return AbstractValue::boolean(true);
+    if (a.slo >= b.shi) return AbstractValue::boolean(false);
+    break;
+  case Expr::Sle:
+    if (a.shi <= b.slo) return AbstractValue::boolean(true);
+    if (a.slo > b.shi) return AbstractValue::boolean(false);
+    break;
+  case Expr::Ugt:
+    return compare(Expr::Ult, b, a);
+  case Expr::Uge:
+    return compare(Expr::Ule, b, a);
+  case Expr::Sgt:
+    return compare(Expr::Slt, b, a);
+  case Expr::Sge:
+    return compare(Expr::Sle, b, a);
+  default:
+    break;
+  }
+  return AbstractValue::top(Expr::Bool);
+}
+
+AbstractValue IntervalAnalysis::evalUncached(const ref<Expr> &e) {
+  Expr::Width w = e->getWidth();
+  if (const ConstantExpr *ce = dyn_cast<ConstantExpr>(e))
+    return w <= MAX_WIDTH ? AbstractValue::point(w, ce->getZExtValue()) : AbstractValue::top(w);
+
+  AbstractValue v = AbstractValue::top(w);
+  if (!v.tracked && e->getKind() != Expr::Eq && e->getKind() < Expr::CmpKindFirst)
+    return v;
+
+  switch (e->getKind()) {
+  case Expr::NotOptimized:
+    v = eval(e->getKid(0));
+    break;
+
+  case Expr::Read: {
+    // A constant array without updates, joined over the possible indices
+    const ReadExpr *re = cast<ReadExpr>(e);
+    const Array *root = re->updates.root;
+    if (re->updates.head.isNull() && root->isConstantArray()) {
+      AbstractValue index = eval(re->index);
+      if (index.tracked && index.uhi - index.ulo < (int64_t) MAX_CONST_ARRAY_JOIN) {
+        bool first = true;
+        for (int64_t i = index.ulo; i <= index.uhi && i < (int64_t) root->size; i++) {
+          AbstractValue elem = AbstractValue::point(w, root->constantValues[i]->getZExtValue());
+          v = first ? elem : AbstractValue::join(v, elem);
+          first = false;
+        }
+      }
+    }
+    break;
+  }
+
+  case Expr::Select: {
+    AbstractValue cond = eval(e->getKid(0));
+    uint64_t c;
+    if (cond.isPoint(c))
+      v = eval(e->getKid(c ? 1 : 2));
+    else
+      v = AbstractValue::join(eval(e->getKid(1)), eval(e->getKid(2)));
+    break;
+  }
+
+  case Expr::Concat: {
+    AbstractValue a = eval(e->getKid(0)), b = eval(e->getKid(1));
+    if (a.tracked && b.tracked) {
+      v.ulo = (a.ulo << b.width) | b.ulo;
+      v.uhi = (a.uhi << b.width) | b.uhi;
+      v.zeros = (a.zeros << b.width) | b.zeros;
+      v.ones = (a.ones << b.width) | b.ones;
+    }
+    break;
+  }
+
+  case Expr::Extract: {
+    const ExtractExpr *ee = cast<ExtractExpr>(e);
+    AbstractValue a = eval(ee->expr);
+    if (a.tracked) {
+      v.zeros = (a.zeros >> ee->offset) & v.mask();
+      v.ones = (a.ones >> ee->offset) & v.mask();
+      if (ee->offset == 0 && a.uhi <= (int64_t) v.mask()) {
+        v.ulo = a.ulo;
+        v.uhi = a.uhi;
+      }
+    }
+    break;
+  }
+
+  case Expr::ZExt: {
+    AbstractValue a = eval(e->getKid(0));
+    if (a.tracked) {
+      v.ulo = a.ulo;
+      v.uhi = a.uhi;
+      v.zeros = a.zeros | (v.mask() & ~a.mask());
+      v.ones = a.ones;
+    }
+    break;
+  }
+
+  case Expr::SExt: {
+    AbstractValue a = eval(e->getKid(0));
+    if (a.tracked) {
+      v.slo = a.slo;
+      v.shi = a.shi;
+    }
+    break;
+  }
+
+  case Expr::Add:
+  case Expr::Sub: {
+    AbstractValue a = eval(e->getKid(0)), b = eval(e->getKid(1));
+    if (!a.tracked || !b.tracked)
+      break;
+    bool add = (e->getKind() == Expr::Add);
+    int64_t M = v.modulus(), H = v.half();
+    int64_t lo = add ? a.ulo + b.ulo : a.ulo - b.uhi;
+    int64_t hi = add ? a.uhi + b.uhi : a.uhi - b.ulo;
+    // Both bounds wrap the same number of times, or the interval is lost
+    int64_t shift = (lo >= 0 ? lo / M : -((-lo + M - 1) / M)) * M;
+    if (hi - shift < M) {
+      v.ulo = lo - shift;
+      v.uhi = hi - shift;
+    }
+    lo = add ? a.slo + b.slo : a.slo - b.shi;
+    hi = add ? a.shi + b.shi : a.shi - b.slo;
+    shift = ((lo + H) >= 0 ? (lo + H) / M : -((-(lo + H) + M - 1) / M)) * M;
+    if (hi - shift < H) {
+      v.slo = lo - shift;
+      v.shi = hi - shift;
+    }
+    // Low bits known in both operands
+    unsigned n = std::min(a.knownLowBits(), b.knownLowBits());
+    if (n > 0) {
+      uint64_t lowMask = (n >= 64 ? ~0ULL : (1ULL << n) - 1);
+      uint64_t low = (add ? a.ones + b.ones : a.ones - b.ones) & lowMask;
+      v.ones = low;
+      v.zeros = ~low & lowMask;
+    }
+    break;
+  }
+
+  case Expr::Mul: {
+    AbstractValue a = eval(e->getKid(0)), b = eval(e->getKid(1));
+    if (!a.tracked || !b.tracked)
+      break;
+    uint64_t c;
+    if (!a.isPoint(c)) {
+      if (!b.isPoint(c))
+        break;
+      std::swap(a, b);
+    }
+    // Multiplying b by a constant c
+    if ((int64_t) c * b.uhi < v.modulus()) {
+      v.ulo = (int64_t) c * b.ulo;
+      v.uhi = (int64_t) c * b.uhi;
+    }
+    int64_t sc = AbstractValue::toSigned(c, w);
+    int64_t p1 = sc * b.slo, p2 = sc * b.shi;
+    if (std::min(p1, p2) >= -v.half() && std::max(p1, p2) < v.half()) {
+      v.slo = std::min(p1, p2);
+      v.shi = std::max(p1, p2);
+    }
+    if (c != 0) {
+      unsigned tz = 0;
+      while (!((c >> tz) & 1))
+        tz++;
+      v.zeros = (1ULL << tz) - 1;
+    }
+    break;
+  }
+
+  case Expr::UDiv:
+  case Expr::URem: {
+    AbstractValue a = eval(e->getKid(0)), b = eval(e->getKid(1));
+    uint64_t c;
+    if (!a.tracked || !b.isPoint(c) || c == 0)
+      break;
+    if (e->getKind() == Expr::UDiv) {
+      v.ulo = a.ulo / (int64_t) c;
+      v.uhi = a.uhi / (int64_t) c;
+    } else {
+      v.uhi = std::min(a.uhi, (int64_t) c - 1);
+    }
+    break;
+  }
+
+  case Expr::Not: {
+    AbstractValue a = eval(e->getKid(0));
+    if (a.tracked) {
+      v.ulo = (int64_t) v.mask() - a.uhi;
+      v.uhi = (int64_t) v.mask() - a.ulo;
+      v.slo = -a.shi - 1;
+      v.shi = -a.slo - 1;
+      v.zeros = a.ones;
+      v.ones = a.zeros;
+    }
+    break;
+  }
+
+  case Expr::And:
+  case Expr::Or:
+  case Expr::Xor: {
+    AbstractValue a = eval(e->getKid(0)), b = eval(e->getKid(1));
+    if (!a.tracked || !b.tracked)
+      break;
+    if (e->getKind() == Expr::And) {
+      v.ones = a.ones & b.ones;
+      v.zeros = a.zeros | b.zeros;
+      v.uhi = std::min(a.uhi, b.uhi);
+    } else if (e->getKind() == Expr::Or) {
+      v.ones = a.ones | b.ones;
+      v.zeros = a.zeros & b.zeros;
+      v.ulo = std::max(a.ulo, b.ulo);
+    } else {
+      v.ones = (a.ones & b.zeros) | (a.zeros & b.ones);
+      v.zeros = (a.zeros & b.zeros) | (a.ones & b.ones);
+    }
+    break;
+  }
+
+  case Expr::Shl:
+  case Expr::LShr:
+  case Expr::AShr: {
+    AbstractValue a = eval(e->getKid(0)), b = eval(e->getKid(1));
+    uint64_t c;
+    if (!a.tracked || !b.isPoint(c))
+      break;
+    if (c >= w) {
+      if (e->getKind() != Expr::AShr)
+        v = AbstractValue::point(w, 0);
+      break;
+    }
+    uint64_t shiftedOut = (e->getKind() == Expr::Shl ? (1ULL << c) - 1 : v.mask() & ~(v.mask() >> c));
+    if (e->getKind() == Expr::Shl) {
+      v.ones = (a.ones << c) & v.mask();
+      v.zeros = ((a.zeros << c) | shiftedOut) & v.mask();
+      if ((a.uhi << c) < v.modulus()) {
+        v.ulo = a.ulo << c;
+        v.uhi = a.uhi << c;
+      }
+    } else if (e->getKind() == Expr::LShr) {
+      v.ones = a.ones >> c;
+      v.zeros = (a.zeros >> c) | shiftedOut;
+      v.ulo = a.ulo >> c;
+      v.uhi = a.uhi >> c;
+    } else {
+      v.slo = a.slo >> c;
+      v.shi = a.shi >> c;
+    }
+    break;
+  }
+
+  case Expr::Eq:
+  case Expr::Ne:
+  case Expr::Ult:
+  case Expr::Ule:
+  case Expr::Ugt:
+  case Expr::Uge:
+  case Expr::Slt:
+  case Expr::Sle:
+  case Expr::Sgt:
+  case Expr::Sge:
+    v = compare(e->getKind(), eval(e->getKid(0)), eval(e->getKid(1)));
+    break;
+
+  default:
+    break;
+  }
+
+  if (!v.normalize())
+    v = AbstractValue::top(w); // unreachable; leave it to the secondary solver
+
+  // Facts on the expression itself
+  auto it = facts.find(e);
+  if (it != facts.end()) {
+    AbstractValue refined = v;
+    if (refined.intersect(it->second))
+      v = refined;
+  }
+  return v;
+}
+
+class IntervalSolver : public IncompleteSolver {
+  /// Try assignments picked from the learned intervals. Each one that satisfies
+  /// the constraints witnesses the value of the query expression.
+  /// \param[out] witness - The first satisfying assignment, if any
+  /// \param[out] canBeTrue, canBeFalse - What witnesses show
+  void findWitnesses(const Query &query, IntervalAnalysis &analysis, Assignment *witness,
+                     bool &canBeTrue, bool &canBeFalse);
+
+public:
+  IncompleteSolver::PartialValidity computeValidity(const Query &) override;
+  IncompleteSolver::PartialValidity computeTruth(const Query &) override;
+  bool computeValue(const Query &, ref<Expr> &result) override;
+  bool computeInitialValues(const Query &, const std::vector<const Array *> &objects,
+                            std::vector<std::vector<unsigned char>> &values, bool &hasSolution) override;
+};
+
+void IntervalSolver::findWitnesses(const Query &query, IntervalAnalysis &analysis, Assignment *witness,
+                                   bool &canBeTrue, bool &canBeFalse) {
+  canBeTrue = canBeFalse = false;
+
+  std::vector<std::pair<const ReadExpr *, AbstractValue>> leaves;
+  analysis.collectLeaves(leaves);
+
+  // Each leaf at its unsigned and signed bounds. Leaves without facts are 0.
+  for (int pick = 0; pick < 4; pick++) {
+    Assignment a(false);
+    for (const auto &leaf : leaves) {
+      const ReadExpr *re = leaf.first;
+      const AbstractValue &v = leaf.second;
+      int64_t value = (pick == 0 ? v.ulo : pick == 1 ? v.uhi : pick == 2 ? v.slo : v.shi);
+      const Array *array = re->updates.root;
+      unsigned wordSize = (array->getRange() + 7) / 8;
+      auto &bytes = a.bindings[array];
+      if (bytes.empty())
+        bytes.resize(array->size * wordSize, 0);
+      uint64_t index = cast<ConstantExpr>(re->index)->getZExtValue();
+      if (index >= array->size)
+        continue;
+      for (unsigned k = 0; k < wordSize; k++)
+        bytes[index * wordSize + k] = (unsigned char) (((uint64_t) value >> (8 * k)) & 0xFF);
+    }
+    if (!a.satisfies(query.constraints.begin(), query.constraints.end()))
+      continue;
+    ref<Expr> result = a.evaluate(query.expr);
+    const ConstantExpr *ce = dyn_cast<ConstantExpr>(result);
+    if (!ce)
+      continue;
+    if (witness && !canBeTrue && !canBeFalse)
+      *witness = a;
+    if (ce->isTrue())
+      canBeTrue = true;
+    else
+      canBeFalse = true;
+    if (canBeTrue && canBeFalse)
+      break;
+    if (leaves.empty())
+      break; // all picks are the same
+  }
+}
+
+IncompleteSolver::PartialValidity IntervalSolver::computeValidity(const Query &query) {
+  ++stats::intervalSolverQueries;
+  IntervalAnalysis analysis;
+  if (!analysis.learnAll(query.constraints))
+    return IncompleteSolver::None;
+
+  uint64_t value;
+  if (analysis.eval(query.expr).isPoint(value)) {
+    ++stats::intervalSolverHits;
+    return value ? IncompleteSolver::MustBeTrue : IncompleteSolver::MustBeFalse;
+  }
+
+  bool canBeTrue, canBeFalse;
+  findWitnesses(query, analysis, nullptr, canBeTrue, canBeFalse);
+  if (canBeTrue && canBeFalse) {
+    ++stats::intervalSolverHits;
+    return IncompleteSolver::TrueOrFalse;
+  }
+  if (canBeTrue)
+    return IncompleteSolver::MayBeTrue;
+  if (canBeFalse)
+    return IncompleteSolver::MayBeFalse;
+  return IncompleteSolver::None;
+}
+
+IncompleteSolver::PartialValidity IntervalSolver::computeTruth(const Query &query) {
+  ++stats::intervalSolverQueries;
+  IntervalAnalysis analysis;
+  if (!analysis.learnAll(query.constraints))
+    return IncompleteSolver::None;
+
+  uint64_t value;
+  if (analysis.eval(query.expr).isPoint(value) && value) {
+    ++stats::intervalSolverHits;
+    return IncompleteSolver::MustBeTrue;
+  }
+
+  // Not valid only with a concrete counterexample, as the constraints may be
+  // infeasible
+  bool canBeTrue, canBeFalse;
+  findWitnesses(query, analysis, nullptr, canBeTrue, canBeFalse);
+  if (canBeFalse) {
+    ++stats::intervalSolverHits;
+    return IncompleteSolver::MustBeFalse;
+  }
+  return IncompleteSolver::None;
+}
+
+bool IntervalSolver::computeValue(const Query &query, ref<Expr> &result) {
+  ++stats::intervalSolverQueries;
+  IntervalAnalysis analysis;
+  if (!analysis.learnAll(query.constraints))
+    return false;
+
+  uint64_t value;
+  if (analysis.eval(query.expr).isPoint(value)) {
+    ++stats::intervalSolverHits;
+    result = ConstantExpr::create(value, query.expr->getWidth());
+    return true;
+  }
+
+  // Any value under a satisfying assignment
+  Assignment witness(false);
+  bool canBeTrue, canBeFalse;
+  findWitnesses(query.withExpr(ConstantExpr::alloc(0, Expr::Bool)), analysis, &witness, canBeTrue, canBeFalse);
+  if (!canBeFalse)
+    return false;
+  ref<Expr> value_ = witness.evaluate(query.expr);
+  if (!isa<ConstantExpr>(value_))
+    return false;
+  ++stats::intervalSolverHits;
+  result = value_;
+  return true;
+}
+
+bool IntervalSolver::computeInitialValues(const Query &query, const std::vector<const Array *> &objects,
+                                          std::vector<std::vector<unsigned char>> &values, bool &hasSolution) {
+  ++stats::intervalSolverQueries;
+  IntervalAnalysis analysis;
+  if (!analysis.learnAll(query.constraints)) {
+    // The learned facts over-approximate the feasible values, so nothing is
+    // feasible
+    ++stats::intervalSolverHits;
+    hasSolution = false;
+    return true;
+  }
+
+  // A satisfying assignment under which the query expression is false
+  Assignment witness(false);
+  bool canBeTrue, canBeFalse;
+  findWitnesses(query, analysis, &witness, canBeTrue, canBeFalse);
+  if (!canBeFalse || canBeTrue)
+    return false; // the witness kept is the first one, which must be a false one
+
+  ++stats::intervalSolverHits;
+  hasSolution = true;
+  values.clear();
+  for (const Array *array : objects) {
+    auto it = witness.bindings.find(array);
+    if (it != witness.bindings.end()) {
+      values.push_back(it->second);
+    } else {
+      values.emplace_back(array->size * ((array->getRange() + 7) / 8), 0);
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+Solver *klee::createIntervalSolver(Solver *s) {
+  return new Solver(new StagedSolverImpl(new IntervalSolver(), s));
+}
@@ -0,0 +1,410 @@
+//===-- PersistentCachingSolver.cpp ---------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+// NOTE: [liuzikai] added for klc3. Unlike CachingSolver, queries are keyed by
+// a canonical text form in which arrays are numbered by first occurrence, so
+// queries that only differ in array names share one entry. The cache can be
+// saved to and loaded from a file, so that repeated runs on the same input
+// space start warm. The number of entries is capped, with the least recently
+// used evicted, and the file is rewritten from the entries kept on each save.
+
+#include "klee/Solver/Solver.h"
+
+#include "klee/Expr/Constraints.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Solver/IncompleteSolver.h"
+#include "klee/Solver/SolverImpl.h"
+#include "klee/Solver/SolverStats.h"
+#include "klee/Support/ErrorHandling.h"
+#include "klee/Support/FileHandling.h"
+
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <list>
+#include <string>
+#include <unordered_map>
+
+using namespace klee;
+
+namespace {
+
+/// Writes a query in a canonical text form. Shared sub-expressions are
+/// written once and referred to by their index afterwards, so the size of the
+/// output is linear in the size of the DAG.
+class QueryCanonicalizer {
+  llvm::raw_string_ostream os;
+  std::unordered_map<const Expr *, unsigned> exprIDs;
+  std::unordered_map<const UpdateNode *, unsigned> updateIDs;
+  std::unordered_map<const Array *, unsigned> arrayIDs;
+
+  void writeArray(const Array *array) {
+    auto it = arrayIDs.find(array);
+    if (it != arrayIDs.end()) {
+      os << 'a' << it->second;
+      return;
+    }
+    unsigned id = arrayIDs.size();
+    arrayIDs[array] = id;
+    os << 'a' << id << '[' << array->size << ':' << array->domain << ':'
+       << array->range;
+    for (const auto &c : array->constantValues) {
+      os << ' ';
+      writeExpr(c);
+    }
+    os << ']';
+  }
+
+  void writeUpdates(const UpdateNode *un) {
+    if (!un) {
+      os << '-';
+      return;
+    }
+    auto it = updateIDs.find(un);
+    if (it != updateIDs.end()) {
+      os << 'u' << it->second;
+      return;
+    }
+    os << '{';
+    writeExpr(un->index);
+    os << '=';
+    writeExpr(un->value);
+    os << ' ';
+    writeUpdates(un->next.get());
+    os << '}';
+    unsigned id = updateIDs.size();
+    updateIDs[un] = id;
+  }
+
+public:
+  explicit QueryCanonicalizer(std::string &out) : os(out) {}
+
+  void writeExpr(const ref<Expr> &e) {
+    if (const ConstantExpr *ce = dyn_cast<ConstantExpr>(e)) {
+      std::string value;
+      ce->toString(value, 16);
+      os << 'c' << ce->getWidth() << ':' << value;
+      return;
+    }
+
+    auto it = exprIDs.find(e.get());
+    if (it != exprIDs.end()) {
+      os << '@' << it->second;
+      return;
+    }
+
+    os << '(' << e->getKind() << ':' << e->getWidth();
+    if (const ExtractExpr *ee = dyn_cast<ExtractExpr>(e)) {
+      os << ':' << ee->offset;
+    } else if (const ReadExpr *re = dyn_cast<ReadExpr>(e)) {
+      os << ' ';
+      writeArray(re->updates.root);
+      os << ' ';
+      writeUpdates(re->updates.head.get());
+    }
+    for (unsigned i = 0; i < e->getNumKids(); i++) {
+      os << ' ';
+      writeExpr(e->getKid(i));
+    }
+    os << ')';
+
+    unsigned id = exprIDs.size();
+    exprIDs[e.get()] = id;
+  }
+
+  void writeQuery(const ConstraintSet &constraints, const ref<Expr> &expr) {
+    for (const auto &c : constraints) {
+      writeExpr(c);
+      os << ';';
+    }
+    os << '?';
+    writeExpr(expr);
+    os.flush();
+  }
+};
+
+class PersistentCachingSolver : public SolverImpl {
+private:
+  struct CacheEntry {
+    IncompleteSolver::PartialValidity validity;
+    std::list<const std::string *>::iterator lruPosition;
+  };
+
+  typedef std::unordered_map<std::string, CacheEntry> cache_map;
+
+  /// The canonical key of a query, computed once for the lookup and the
+  /// insertion
+  struct CacheKey {
+    std::string key;
+    bool negationUsed;
+  };
+
+  Solver *solver;
+  cache_map cache;
+  std::list<const std::string *> lru; // keys in cache, most recently used first
+  std::string path;
+  unsigned maxSize;
+  bool modified = false;
+
+  CacheKey canonicalizeQuery(const Query &query);
+
+  void cacheInsert(const CacheKey &key, IncompleteSolver::PartialValidity result);
+
+  bool cacheLookup(const CacheKey &key, IncompleteSolver::PartialValidity &result);
+
+  /// Insert or update an entry as the most recently used one (or the least
+  /// recently used one if atBack), evicting the least recently used entry if
+  /// the cache is full.
+  void insertEntry(const std::string &key,
+                   IncompleteSolver::PartialValidity validity,
+                   bool atBack = false);
+
+  void load();
+
+  void save();
+
+public:
+  PersistentCachingSolver(Solver *s, std::string path, unsigned maxSize)
+      : solver(s), path(std::move(path)), maxSize(maxSize) {
+    load();
+  }
+  ~PersistentCachingSolver() {
+    save();
+    delete solver;
+  }
+
+  bool computeValidity(const Query &, Solver::Validity &result);
+  bool computeTruth(const Query &, bool &isValid);
+  bool computeValue(const Query &query, ref<Expr> &result) {
+    return solver->impl->computeValue(query, result);
+  }
+  bool computeInitialValues(const Query &query,
+                            const std::vector<const Array *> &objects,
+                            std::vector<std::vector<unsigned char>> &values,
+                            bool &hasSolution) {
+    return solver->impl->computeInitialValues(query, objects, values,
+                                              hasSolution);
+  }
+  SolverRunStatus getOperationStatusCode() {
+    return solver->impl->getOperationStatusCode();
+  }
+  char *getConstraintLog(const Query &query) {
+    return solver->impl->getConstraintLog(query);
+  }
+  void setCoreSolverTimeout(time::Span timeout) {
+    solver->impl->setCoreSolverTimeout(timeout);
+  }
+};
+
+/** @returns the canonical key of the given query. As in CachingSolver, the
+    "smaller" one of the query expression and its negation is used, and
+    negationUsed is set to true if it is the negation. */
+PersistentCachingSolver::CacheKey
+PersistentCachingSolver::canonicalizeQuery(const Query &query) {
+  ref<Expr> negatedExpr = Expr::createIsZero(query.expr);
+  CacheKey key;
+  key.negationUsed = (query.expr.compare(negatedExpr) >= 0);
+  QueryCanonicalizer(key.key).writeQuery(
+      query.constraints, key.negationUsed ? negatedExpr : query.expr);
+  return key;
+}
+
+bool PersistentCachingSolver::cacheLookup(
+    const CacheKey &key, IncompleteSolver::PartialValidity &result) {
+  auto it = cache.find(key.key);
+  if (it == cache.end())
+    return false;
+  lru.splice(lru.begin(), lru, it->second.lruPosition);
+  result = (key.negationUsed
+                ? IncompleteSolver::negatePartialValidity(it->second.validity)
+                : it->second.validity);
+  return true;
+}
+
+void PersistentCachingSolver::cacheInsert(
+    const CacheKey &key, IncompleteSolver::PartialValidity result) {
+  insertEntry(key.key, key.negationUsed
+                           ? IncompleteSolver::negatePartialValidity(result)
+                           : result);
+  modified = true;
+}
+
+void PersistentCachingSolver::insertEntry(
+    const std::string &key, IncompleteSolver::PartialValidity validity,
+    bool atBack) {
+  auto it = cache.find(key);
+  if (it != cache.end()) {
+    it->second.validity = validity;
+    lru.splice(atBack ? lru.end() : lru.begin(), lru, it->second.lruPosition);
+    return;
+  }
+  if (maxSize == 0)
+    return;
+  if (cache.size() >= maxSize) {
+    cache.erase(*lru.back());
+    lru.pop_back();
+  }
+  it = cache.emplace(key, CacheEntry{validity, lru.end()}).first;
+  it->second.lruPosition =
+      lru.insert(atBack ? lru.end() : lru.begin(), &it->first);
+}
+
+void PersistentCachingSolver::load() {
+  auto bufOrErr = llvm::MemoryBuffer::getFile(path);
+  if (!bufOrErr)
+    return; // start with an empty cache
+
+  // One entry per line: "<PartialValidity> <key>", most recently used first
+  llvm::StringRef data = bufOrErr.get()->getBuffer();
+  while (!data.empty() && cache.size() < maxSize) {
+    llvm::StringRef line;
+    std::tie(line, data) = data.split('\n');
+    int validity;
+    if (line.size() < 3 || line[1] != ' ' ||
+        line.substr(0, 1).getAsInteger(10, validity) ||
+        validity > IncompleteSolver::MayBeTrue + 2) {
+      klee_warning("Ignoring malformed query cache file %s", path.c_str());
+      cache.clear();
+      lru.clear();
+      return;
+    }
+    insertEntry(line.substr(2).str(),
+                (IncompleteSolver::PartialValidity)(validity - 2), true);
+  }
+}
+
+void PersistentCachingSolver::save() {
+  if (!modified)
+    return;
+
+  // Only the entries kept are written, so the file doesn't grow beyond maxSize
+  // entries. Other processes may share the file, which is replaced as a whole.
+  std::string error;
+  bool written = klee_write_file_atomically(
+      path,
+      [&](llvm::raw_fd_ostream &out) {
+        for (const std::string *key : lru) {
+          // PartialValidity (None is never stored) ranges from -2 to 2,
+          // shifted to a single digit
+          out << (cache.find(*key)->second.validity + 2) << ' ' << *key
+              << '\n';
+        }
+        return true;
+      },
+      error);
+  if (!written) {
+    klee_warning("Failed to save query cache to %s: %s", path.c_str(),
+                 error.c_str());
+  }
+}
+
+bool PersistentCachingSolver::computeValidity(const Query &query,
+                                              Solver::Validity &result) {
+  CacheKey key = canonicalizeQuery(query);
+  IncompleteSolver::PartialValidity cachedResult;
+  bool tmp, cacheHit = cacheLookup(key, cachedResult);
+
+  if (cacheHit) {
+    switch (cachedResult) {
+    case IncompleteSolver::MustBeTrue:
+      result = Solver::True;
+      ++stats::queryCacheHits;
+      return true;
+    case IncompleteSolver::MustBeFalse:
+      result = Solver::False;
+      ++stats::queryCacheHits;
+      return true;
+    case IncompleteSolver::TrueOrFalse:
+      result = Solver::Unknown;
+      ++stats::queryCacheHits;
+      return true;
+    case IncompleteSolver::MayBeTrue: {
+      ++stats::queryCacheMisses;
+      if (!solver->impl->computeTruth(query, tmp))
+        return false;
+      cacheInsert(key, tmp ? IncompleteSolver::MustBeTrue
+                             : IncompleteSolver::TrueOrFalse);
+      result = tmp ? Solver::True : Solver::Unknown;
+      return true;
+    }
+    case IncompleteSolver::MayBeFalse: {
+      ++stats::queryCacheMisses;
+      if (!solver->impl->computeTruth(query.negateExpr(), tmp))
+        return false;
+      cacheInsert(key, tmp ? IncompleteSolver::MustBeFalse
+                             : IncompleteSolver::TrueOrFalse);
+      result = tmp ? Solver::False : Solver::Unknown;
+      return true;
+    }
+    default:
+      break; // None, treat as a miss
+    }
+  }
+
+  ++stats::queryCacheMisses;
+
+  if (!solver->impl->computeValidity(query, result))
+    return false;
+
+  switch (result) {
+  case Solver::True:
+    cachedResult = IncompleteSolver::MustBeTrue;
+    break;
+  case Solver::False:
+    cachedResult = IncompleteSolver::MustBeFalse;
+    break;
+  default:
+    cachedResult = IncompleteSolver::TrueOrFalse;
+    break;
+  }
+
+  cacheInsert(key, cachedResult);
+  return true;
+}
+
+bool PersistentCachingSolver::computeTruth(const Query &query, bool &isValid) {
+  CacheKey key = canonicalizeQuery(query);
+  IncompleteSolver::PartialValidity cachedResult;
+  bool cacheHit = cacheLookup(key, cachedResult);
+
+  // a cached result of MayBeTrue forces us to check whether
+  // a False assignment exists.
+  if (cacheHit && cachedResult != IncompleteSolver::MayBeTrue &&
+      cachedResult != IncompleteSolver::None) {
+    ++stats::queryCacheHits;
+    isValid = (cachedResult == IncompleteSolver::MustBeTrue);
+    return true;
+  }
+
+  ++stats::queryCacheMisses;
+
+  if (!solver->impl->computeTruth(query, isValid))
+    return false;
+
+  if (isValid) {
+    cachedResult = IncompleteSolver::MustBeTrue;
+  } else if (cacheHit && cachedResult == IncompleteSolver::MayBeTrue) {
+    // We know a true assignment exists, and query isn't valid, so
+    // must be TrueOrFalse.
+    cachedResult = IncompleteSolver::TrueOrFalse;
+  } else {
+    cachedResult = IncompleteSolver::MayBeFalse;
+  }
+
+  cacheInsert(key, cachedResult);
+  return true;
+}
+
+} // namespace
+
+Solver *klee::createPersistentCachingSolver(Solver *_solver,
+                                            const std::string &path,
+                                            unsigned maxSize) {
+  return new Solver(new PersistentCachingSolver(_solver, path, maxSize));
+}
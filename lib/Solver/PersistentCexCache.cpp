@@ -0,0 +1,173 @@
+//===-- PersistentCexCache.cpp --------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+// NOTE: [liuzikai] added for klc3
+
+#include "klee/Solver/PersistentCexCache.h"
+
+#include "klee/Support/ErrorHandling.h"
+#include "klee/Support/FileHandling.h"
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <map>
+
+using namespace klee;
+
+/*
+ * File format, one record per line:
+ *   A <size> <domain> <range> <name>     declares the next array index
+ *   M <array index>:<hex bytes> ...      a model
+ */
+
+unsigned PersistentCexCache::load(const std::vector<const Array *> &arrays) {
+  auto bufOrErr = llvm::MemoryBuffer::getFile(path);
+  if (!bufOrErr)
+    return 0; // start with an empty cache
+
+  std::map<std::string, const Array *> arraysByName;
+  for (const Array *array : arrays)
+    arraysByName[array->name] = array;
+
+  std::vector<const Array *> fileArrays; // nullptr for unmatched arrays
+  llvm::StringRef data = bufOrErr.get()->getBuffer();
+  while (!data.empty()) {
+    llvm::StringRef line;
+    std::tie(line, data) = data.split('\n');
+    if (line.empty())
+      continue;
+
+    if (line.startswith("A ")) {
+      llvm::SmallVector<llvm::StringRef, 4> fields;
+      line.substr(2).split(fields, ' ', 3, false);
+      unsigned size, domain, range;
+      if (fields.size() != 4 || fields[0].getAsInteger(10, size) ||
+          fields[1].getAsInteger(10, domain) ||
+          fields[2].getAsInteger(10, range)) {
+        klee_warning("Malformed array in cex cache file %s", path.c_str());
+        break;
+      }
+      auto it = arraysByName.find(fields[3].str());
+      if (it != arraysByName.end() && it->second->size == size &&
+          it->second->getDomain() == domain &&
+          it->second->getRange() == range) {
+        fileArrays.push_back(it->second);
+      } else {
+        fileArrays.push_back(nullptr);
+      }
+
+    } else if (line.startswith("M ")) {
+      if (models.size() >= maxSize)
+        break;
+      llvm::SmallVector<llvm::StringRef, 16> bindings;
+      line.substr(2).split(bindings, ' ', -1, false);
+      Assignment assignment;
+      for (llvm::StringRef binding : bindings) {
+        llvm::StringRef indexStr, bytesStr;
+        std::tie(indexStr, bytesStr) = binding.split(':');
+        unsigned index;
+        if (indexStr.getAsInteger(10, index) || index >= fileArrays.size())
+          continue;
+        const Array *array = fileArrays[index];
+        if (!array)
+          continue; // not in the current input space
+        std::string bytes = llvm::fromHex(bytesStr);
+        if (bytes.size() != array->size * (array->getRange() / 8))
+          continue;
+        assignment.bindings[array] =
+            std::vector<unsigned char>(bytes.begin(), bytes.end());
+      }
+      // Models are tried before use, so a partial model is still useful
+      if (!assignment.bindings.empty() && !index.count(assignment))
+        insert(models.end(), assignment);
+
+    } else {
+      klee_warning("Malformed line in cex cache file %s", path.c_str());
+      break;
+    }
+  }
+  return models.size();
+}
+
+bool PersistentCexCache::save() const {
+  // Other processes may share the file, which is replaced as a whole
+  std::string error;
+  bool written = klee_write_file_atomically(
+      path,
+      [&](llvm::raw_fd_ostream &out) {
+        std::map<const Array *, unsigned> arrayIndices;
+        for (const auto &model : models) {
+          for (const auto &binding : model.bindings) {
+            const Array *array = binding.first;
+            if (arrayIndices.count(array))
+              continue;
+            unsigned index = arrayIndices.size();
+            arrayIndices[array] = index;
+            out << "A " << array->size << ' ' << array->getDomain() << ' '
+                << array->getRange() << ' ' << array->name << '\n';
+          }
+        }
+        for (const auto &model : models) {
+          out << 'M';
+          for (const auto &binding : model.bindings) {
+            out << ' ' << arrayIndices[binding.first] << ':'
+                << llvm::toHex(llvm::ArrayRef<uint8_t>(binding.second));
+          }
+          out << '\n';
+        }
+        return true;
+      },
+      error);
+  if (!written) {
+    klee_warning("Failed to save cex cache to %s: %s", path.c_str(),
+                 error.c_str());
+  }
+  return written;
+}
+
+const Assignment *PersistentCexCache::find(const std::set<ref<Expr>> &key) {
+  if (models.empty())
+    return nullptr;
+  ExprTape keyTape; // compiled once for all models
+  for (const auto &e : key)
+    keyTape.compile(e);
+  AssignmentBatch candidates(keyTape);
+  for (auto it = models.begin(); it != models.end(); ++it) {
+    if (candidates.add(&*it))
+      break;
+  }
+  if (!candidates.flush())
+    return nullptr;
+  // Mark as most recently used
+  auto it = index.find(*candidates.found);
+  assert(it != index.end());
+  models.splice(models.begin(), models, *it);
+  return &models.front();
+}
+
+void PersistentCexCache::add(const Assignment &assignment) {
+  auto it = index.find(assignment);
+  if (it != index.end())
+    models.splice(models.begin(), models, *it);
+  else
+    insert(models.begin(), assignment);
+}
+
+void PersistentCexCache::insert(model_iterator pos,
+                                const Assignment &assignment) {
+  if (models.size() >= maxSize) {
+    if (maxSize == 0)
+      return;
+    index.erase(std::prev(models.end()));
+    models.pop_back();
+  }
+  index.insert(models.insert(pos, assignment));
+}
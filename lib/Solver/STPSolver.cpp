@@ -17,6 +17,7 @@
 #include "klee/Expr/Constraints.h"
 #include "klee/Expr/ExprUtil.h"
 #include "klee/Support/OptionCategories.h"
+#include "klee/Solver/SolverCmdLine.h"
 #include "klee/Solver/SolverImpl.h"
 #include "klee/Support/ErrorHandling.h"
 
@@ -46,6 +47,9 @@ llvm::cl::opt<bool> IgnoreSolverFailures(
 
 static unsigned char *shared_memory_ptr = nullptr;
 static int shared_memory_id = 0;
+// NOTE: [liuzikai] a process forked from the one that allocated the region
+// (such as klc3 workers) must not share it, see attachSharedMemory()
+static pid_t shared_memory_pid = 0;
 // Darwin by default has a very small limit on the maximum amount of shared
 // memory, which will quickly be exhausted by KLEE running its tests in
 // parallel. For now, we work around this by just requesting a smaller size --
@@ -57,6 +61,18 @@ static const unsigned shared_memory_size = 1 << 16;
 static const unsigned shared_memory_size = 1 << 20;
 #endif
 
+static void attachSharedMemory() {
+  shared_memory_id =
+      shmget(IPC_PRIVATE, shared_memory_size, IPC_CREAT | 0700);
+  if (shared_memory_id < 0)
+    llvm::report_fatal_error("unable to allocate shared memory region");
+  shared_memory_ptr = (unsigned char *)shmat(shared_memory_id, nullptr, 0);
+  if (shared_memory_ptr == (void *)-1)
+    llvm::report_fatal_error("unable to attach shared memory region");
+  shmctl(shared_memory_id, IPC_RMID, nullptr);
+  shared_memory_pid = getpid();
+}
+
 static void stp_error_handler(const char *err_msg) {
   fprintf(stderr, "error: STP Error: %s\n", err_msg);
   abort();
@@ -72,6 +88,15 @@ private:
   bool useForkedSTP;
   SolverRunStatus runStatusCode;
 
+  /// Constraints kept asserted in the VC, one push level each
+  /// (--use-incremental-solver)
+  std::vector<ref<Expr>> assertedConstraints;
+
+  /// Pop levels of asserted constraints that are not a prefix of the given
+  /// constraints, and assert the rest of them
+  void syncAssertedConstraints(const ConstraintSet &constraints);
+  void popAssertedConstraints();
+
 public:
   explicit STPSolverImpl(bool useForkedSTP, bool optimizeDivides = true);
   ~STPSolverImpl() override;
@@ -109,14 +134,7 @@ STPSolverImpl::STPSolverImpl(bool useForkedSTP, bool optimizeDivides)
 
   if (useForkedSTP) {
     assert(shared_memory_id == 0 && "shared memory id already allocated");
-    shared_memory_id =
-        shmget(IPC_PRIVATE, shared_memory_size, IPC_CREAT | 0700);
-    if (shared_memory_id < 0)
-      llvm::report_fatal_error("unable to allocate shared memory region");
-    shared_memory_ptr = (unsigned char *)shmat(shared_memory_id, nullptr, 0);
-    if (shared_memory_ptr == (void *)-1)
-      llvm::report_fatal_error("unable to attach shared memory region");
-    shmctl(shared_memory_id, IPC_RMID, nullptr);
+    attachSharedMemory();
   }
 }
 
@@ -133,7 +151,33 @@ STPSolverImpl::~STPSolverImpl() {
 
 /***/
 
+void STPSolverImpl::syncAssertedConstraints(const ConstraintSet &constraints) {
+  size_t prefix = 0;
+  auto it = constraints.begin(), ie = constraints.end();
+  while (prefix < assertedConstraints.size() && it != ie &&
+         assertedConstraints[prefix] == *it) {
+    ++prefix;
+    ++it;
+  }
+  while (assertedConstraints.size() > prefix) {
+    vc_pop(vc);
+    assertedConstraints.pop_back();
+  }
+  for (; it != ie; ++it) {
+    vc_push(vc);
+    vc_assertFormula(vc, builder->construct(*it));
+    assertedConstraints.push_back(*it);
+  }
+}
+
+void STPSolverImpl::popAssertedConstraints() {
+  for (size_t i = 0; i < assertedConstraints.size(); ++i)
+    vc_pop(vc);
+  assertedConstraints.clear();
+}
+
 char *STPSolverImpl::getConstraintLog(const Query &query) {
+  popAssertedConstraints();
   vc_push(vc);
 
   for (const auto &constraint : query.constraints)
@@ -220,6 +264,13 @@ runAndGetCexForked(::VC vc, STPBuilder *builder, ::VCExpr q,
                    const std::vector<const Array *> &objects,
                    std::vector<std::vector<unsigned char>> &values,
                    bool &hasSolution, time::Span timeout) {
+  if (shared_memory_pid != getpid()) {
+    // This process is forked after the region was allocated, which is still
+    // attached to the parent. Switch to a private one.
+    shmdt(shared_memory_ptr);
+    attachSharedMemory();
+  }
+
   unsigned char *pos = shared_memory_ptr;
   unsigned sum = 0;
   for (const auto object : objects)
@@ -333,10 +384,15 @@ bool STPSolverImpl::computeInitialValues(
   runStatusCode = SOLVER_RUN_STATUS_FAILURE;
   TimerStatIncrementer t(stats::queryTime);
 
-  vc_push(vc);
+  if (UseIncrementalCoreSolver) {
+    syncAssertedConstraints(query.constraints);
+    vc_push(vc); // level for this query only
+  } else {
+    vc_push(vc);
 
-  for (const auto &constraint : query.constraints)
-    vc_assertFormula(vc, builder->construct(constraint));
+    for (const auto &constraint : query.constraints)
+      vc_assertFormula(vc, builder->construct(constraint));
+  }
 
   ++stats::queries;
   ++stats::queryCounterexamples;
@@ -84,6 +84,16 @@ cl::opt<bool> UseForkedCoreSolver(
     cl::desc("Run the core SMT solver in a forked process (default=true)"),
     cl::init(true), cl::cat(SolvingCat));
 
+cl::opt<bool> UseIncrementalCoreSolver(
+    "use-incremental-solver",
+    cl::desc("Keep constraints asserted in the core SMT solver between "
+             "queries, and only assert constraints that differ from the "
+             "previous query (STP and Z3 only, default=false). With STP in "
+             "forked mode (the default), each query is still solved in a "
+             "fresh child process: only the assertions are kept between "
+             "queries, not the solver state"),
+    cl::init(false), cl::cat(SolvingCat));
+
 cl::opt<bool> CoreSolverOptimizeDivides(
     "solver-optimize-divides",
     cl::desc("Optimize constant divides into add/shift/multiplies before "
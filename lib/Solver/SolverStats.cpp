@@ -33,6 +33,14 @@ size_t stats::independentElementSetCacheSize = 0;
 Statistic stats::independentElementSetCacheLookupTime("IndependentElementSetCacheLookupTime", "IELTime");
 Statistic stats::independentElementSetConstructTime("IndependentElementSetConstructTime", "IECTime");
 
+// Note: [liuzikai] statistics for IntervalSolver
+Statistic stats::intervalSolverQueries("IntervalSolverQueries", "IvQueries");
+Statistic stats::intervalSolverHits("IntervalSolverHits", "IvHits");
+
+// Note: [liuzikai] statistics for EnumerationSolver
+Statistic stats::enumerationSolverQueries("EnumerationSolverQueries", "EnQueries");
+Statistic stats::enumerationSolverHits("EnumerationSolverHits", "EnHits");
+
 #ifdef KLEE_ARRAY_DEBUG
 Statistic stats::arrayHashTime("ArrayHashTime", "AHtime");
 #endif
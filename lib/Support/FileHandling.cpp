@@ -12,6 +12,7 @@
 #include "klee/Config/config.h"
 #include "klee/Support/ErrorHandling.h"
 
+#include "llvm/ADT/SmallString.h"
 #include "llvm/Support/FileSystem.h"
 
 #ifdef HAVE_ZLIB_H
@@ -45,4 +46,40 @@ klee_open_compressed_output_file(const std::string &path, std::string &error) {
   return f;
 }
 #endif
+
+// NOTE: [liuzikai] added for klc3
+bool klee_write_file_atomically(
+    const std::string &path,
+    llvm::function_ref<bool(llvm::raw_fd_ostream &)> write,
+    std::string &error) {
+  error = "";
+  int fd;
+  llvm::SmallString<128> tmpPath;
+  if (std::error_code ec =
+          llvm::sys::fs::createUniqueFile(path + "-%%%%%%.tmp", fd, tmpPath)) {
+    error = ec.message();
+    return false;
+  }
+
+  bool written;
+  {
+    llvm::raw_fd_ostream out(fd, /*shouldClose=*/true);
+    written = write(out);
+    out.close();
+    if (out.has_error()) {
+      error = out.error().message();
+      out.clear_error();
+      written = false;
+    }
+  }
+  if (written) {
+    if (std::error_code ec = llvm::sys::fs::rename(tmpPath, path)) {
+      error = ec.message();
+      written = false;
+    }
+  }
+  if (!written)
+    llvm::sys::fs::remove(tmpPath);
+  return written;
+}
 }
@@ -7,6 +7,8 @@
 
 #include "klc3/Core/Executor.h"
 #include "klc3/Generation/ReportFormatter.h"
+#include "klee/Expr/ExprUtil.h"
+#include "klee/Solver/SolverImpl.h"
 
 #define LOG_BR_FORK  0
 #define LOG_SYM_ADDR_FORK 0
@@ -25,7 +27,49 @@ llvm::cl::opt<int> ForkOnSymAddrThreshold(
         llvm::cl::init(0),
         llvm::cl::cat(KLC3ExecutionCat));
 
-Executor::Executor(ExprBuilder *builder, Solver *solver, const map<uint16_t, ref<MemValue>> &mem)
+enum class SymAddrEnumMethod {
+    AUTO,
+    RANGE,
+    MODEL
+};
+
+llvm::cl::opt<SymAddrEnumMethod> SymAddrEnum(
+        "sym-addr-enum",
+        llvm::cl::desc("Method to enumerate possible values of a symbolic address (default=auto)"),
+        llvm::cl::values(
+                clEnumValN(SymAddrEnumMethod::AUTO, "auto",
+                           "Enumerate by models first and switch to range splitting if there are many values"),
+                clEnumValN(SymAddrEnumMethod::RANGE, "range", "Binary search on bits, min and max, then split ranges"),
+                clEnumValN(SymAddrEnumMethod::MODEL, "model", "Repeatedly get a model and block its value")
+        ),
+        llvm::cl::init(SymAddrEnumMethod::AUTO),
+        llvm::cl::cat(KLC3ExecutionCat));
+
+enum class SymAddrModeOption {
+    FORK,
+    ARRAY
+};
+
+llvm::cl::opt<SymAddrModeOption> SymAddrMode(
+        "sym-addr-mode",
+        llvm::cl::desc("How to access memory at a symbolic address with LDR/STR/LDI/STI (default=fork)"),
+        llvm::cl::values(
+                clEnumValN(SymAddrModeOption::FORK, "fork", "Fork a state for each possible address"),
+                clEnumValN(SymAddrModeOption::ARRAY, "array",
+                           "Model runs of data (split at labels and symbolic variables) as arrays, and only fork a "
+                           "state if the address may leave the run")
+        ),
+        llvm::cl::init(SymAddrModeOption::FORK),
+        llvm::cl::cat(KLC3ExecutionCat));
+
+/*
+ * Range splitting takes ~50 queries before it gets to the first value (16 steps each for bits, min and max), while
+ * model enumeration takes one query per value. Beyond this many values, range splitting is usually cheaper.
+ */
+static constexpr int MODEL_ENUM_BUDGET = 32;
+
+Executor::Executor(ExprBuilder *builder, Solver *solver, const map<uint16_t, ref<MemValue>> &mem,
+                   klee::ArrayCache *arrayCache)
         : WithBuilder(builder),
           symAddrCacheHits("SymAddrCacheHits", "SAHits"),
           symAddrCacheMisses("SymAddrCacheMisses", "SAMiss"), solver(solver) {
@@ -35,6 +79,16 @@ Executor::Executor(ExprBuilder *builder, Solver *solver, const map<uint16_t, ref
         baseMem[m.first] = m.second;
     }
 
+    // Pre-decode instructions so that fetching them skips the memory lookup
+    for (unsigned addr = 0; addr < 0x10000; addr++) {
+        const ref<MemValue> &val = baseMem[addr];
+        instTable[addr] = (!val.isNull() && val->type == MemValue::MEM_INST ? dyn_cast<InstValue>(val.get()) : nullptr);
+    }
+
+    if (SymAddrMode == SymAddrModeOption::ARRAY && arrayCache != nullptr) {
+        setupMemRegions(arrayCache);
+    }
+
     if (ForkOnSymAddrThreshold != 0) {
         newProgWarn() << "using the symbolic address cache with threshold " << ForkOnSymAddrThreshold
                       << ", which is only effective for well designed input spaces.\n";
@@ -67,6 +121,17 @@ State *Executor::createInitState(const vector<ref<Expr>> &constraints, uint16_t
 }
 
 bool Executor::step(State *s, StateVector &result, bool returnImmediatelyIfWillFork) {
+    if (!executeStep(s, result, returnImmediatelyIfWillFork)) return false;
+    if (!memRegionIndex.empty()) {
+        // Memory of completed states is checked and reported as a whole, so bring it up to date
+        for (State *t : result) {
+            if (t->status != State::NORMAL) materializeMemRegions(t, t->latestInst[0]);
+        }
+    }
+    return true;
+}
+
+bool Executor::executeStep(State *s, StateVector &result, bool returnImmediatelyIfWillFork) {
     result.clear();
 
     /// Phase 1. Fetch Instruction
@@ -170,6 +235,11 @@ bool Executor::step(State *s, StateVector &result, bool returnImmediatelyIfWillF
 void Executor::fetchInst(State *s, ref<InstValue> &ir) {
     uint16_t pc = s->getPC();
 
+    if (instTable[pc] != nullptr) {
+        ir = instTable[pc];
+        return;
+    }
+
     ref<MemValue> val = s->mem.read(pc);
 
     if (!val.isNull() && val->type == MemValue::MEM_INST) {
@@ -196,7 +266,10 @@ void Executor::updateIRAndPC(State *s, const ref<InstValue> &ir) {
 }
 
 void Executor::executeSTR(State *s, const ref<InstValue> &ir, StateVector &result) {
+    uint16_t base;
     handleExprST(s,
+                 s->getConcreteReg(ir->baseR(), base) ?
+                 static_cast<ref<Expr>>(buildConstant(base + ir->imm6())) :  // auto wrap 0xFFFF
                  builder->Add(getReg(s, ir->baseR(), ir), buildConstant(ir->imm6())),
                  getReg(s, ir->sr(), ir, true),  // bypass uninitialized register null value
                  ir,
@@ -221,8 +294,23 @@ void Executor::handleExprST(State *s, const ref<Expr> &addr, const ref<Expr> &va
         result.push_back(s);
     } else {
 
+        State *outside = s;
+        if (!memRegionIndex.empty() && !value.isNull()) {
+            UpdateList content(nullptr, nullptr);
+            const MemRegion *region = splitOnMemRegion(s, addr, true, ir, content, outside);
+            if (region != nullptr) {
+                // Only append the write to the contents of the region. Words in mem are brought up to date when they
+                // are accessed at concrete addresses (see materializeMemRegionWord()).
+                content.extend(builder->Sub(addr, buildConstant(region->start)), value);
+                s->memRegionUpdates.erase(region->start);
+                s->memRegionUpdates.emplace(region->start, content);
+                result.push_back(s);
+                if (outside == nullptr) return;
+            }
+        }
+
         vector<pair<uint16_t, State *>> instances;
-        forkOnRange(s, addr, ir, instances);
+        forkOnRange(outside, addr, ir, instances);
         assert(!instances.empty() && "Immediate address evaluate to no range, which means constraints have conflicts");
 
         for (auto &it : instances) {
@@ -237,7 +325,13 @@ void Executor::handleExprST(State *s, const ref<Expr> &addr, const ref<Expr> &va
 
 void Executor::executeLDR(State *s, const ref<InstValue> &ir, StateVector &result) {
     Reg DR = ir->dr();
-    ref<Expr> midAddr = builder->Add(getReg(s, ir->baseR(), ir), buildConstant(ir->imm6()));
+    uint16_t base;
+    ref<Expr> midAddr;
+    if (s->getConcreteReg(ir->baseR(), base)) {
+        midAddr = buildConstant(base + ir->imm6());  // auto wrap 0xFFFF
+    } else {
+        midAddr = builder->Add(getReg(s, ir->baseR(), ir), buildConstant(ir->imm6()));
+    }
     handleExprLD(s, DR, midAddr, ir, result);
 }
 
@@ -271,8 +365,20 @@ Executor::handleExprLD(State *s, Reg DR, const ref<Expr> &addr, const ref<InstVa
 
     } else {
 
+        State *outside = s;
+        if (!memRegionIndex.empty()) {
+            UpdateList content(nullptr, nullptr);
+            const MemRegion *region = splitOnMemRegion(s, addr, false, ir, content, outside);
+            if (region != nullptr) {
+                setReg(s, DR, builder->Read(content, builder->Sub(addr, buildConstant(region->start))), ir);
+                setCC(s, DR, ir);
+                result.push_back(s);
+                if (outside == nullptr) return;
+            }
+        }
+
         vector<pair<uint16_t, State *>> instances;
-        forkOnRange(s, addr, ir, instances);
+        forkOnRange(outside, addr, ir, instances);
         assert(!instances.empty() && "Immediate address evaluate to no range, which means constraints have conflicts");
 
         for (auto &it : instances) {
@@ -292,6 +398,156 @@ Executor::handleExprLD(State *s, Reg DR, const ref<Expr> &addr, const ref<InstVa
     }
 }
 
+void Executor::setupMemRegions(klee::ArrayCache *arrayCache) {
+    auto isRegionData = [&](unsigned addr) {
+        const ref<MemValue> &val = baseMem[addr];
+        return !val.isNull() && val->type == MemValue::MEM_DATA && !val->belongsToOS && !val->e.isNull() &&
+               val->e->getWidth() == Expr::Int16;
+    };
+    auto symbolicArrayOf = [&](unsigned addr) -> const Array * {
+        if (auto read = dyn_cast<klee::ReadExpr>(baseMem[addr]->e)) return read->updates.root;
+        return nullptr;
+    };
+
+    memRegionIndex.assign(0x10000, -1);
+    unsigned addr = 0;
+    while (addr < 0xFE00) {  // not including device registers
+        if (!isRegionData(addr)) {
+            addr++;
+            continue;
+        }
+        unsigned end = addr + 1;
+        while (end < 0xFE00 && isRegionData(end) && baseMem[end]->labels.empty() &&
+               symbolicArrayOf(end) == symbolicArrayOf(end - 1)) {
+            end++;
+        }
+
+        auto size = (uint16_t) (end - addr);
+        if (size >= 2) {  // a single location is not worth an array
+            // A symbolic variable as a whole uses its own array. Otherwise, constants go into a constant array and
+            // the other values are updates on it.
+            const Array *array = symbolicArrayOf(addr);
+            bool wholeArray = (array != nullptr && array->size == size);
+            for (unsigned i = 0; wholeArray && i < size; i++) {
+                auto read = dyn_cast<klee::ReadExpr>(baseMem[addr + i]->e);
+                auto index = dyn_cast<ConstantExpr>(read->index);
+                wholeArray = (read->updates.head.isNull() && index != nullptr && index->getZExtValue() == i);
+            }
+            UpdateList base(array, nullptr);
+            if (!wholeArray) {
+                vector<ref<ConstantExpr>> values;
+                values.reserve(size);
+                for (unsigned i = 0; i < size; i++) {
+                    auto c = dyn_cast<ConstantExpr>(baseMem[addr + i]->e);
+                    values.push_back(c == nullptr ? ConstantExpr::create(0, Expr::Int16) : ref<ConstantExpr>(c));
+                }
+                base = UpdateList(arrayCache->CreateArray(("mem_" + toLC3Hex(addr)).str(), size, &values.front(),
+                                                          &values.back() + 1, Expr::Int16, Expr::Int16),
+                                  nullptr);
+                for (unsigned i = 0; i < size; i++) {
+                    if (baseMem[addr + i]->e->getKind() != Expr::Constant) base.extend(buildConstant(i), baseMem[addr + i]->e);
+                }
+            }
+            for (unsigned i = 0; i < size; i++) memRegionIndex[addr + i] = (int) memRegions.size();
+            memRegions.push_back(MemRegion{(uint16_t) addr, size, base});
+        }
+        addr = end;
+    }
+}
+
+const Executor::MemRegion *Executor::splitOnMemRegion(State *s, const ref<Expr> &addr, bool forWrite,
+                                                      const ref<InstValue> &ir, UpdateList &content,
+                                                      State *&outside) {
+    SolverCostTracker::Scope costScope(solverCostTracker, ir.get());
+
+    // Take the region of one possible address
+    ref<ConstantExpr> value;
+    bool success = solver->getValue(Query(s->constraints, addr), value);
+    assert(success && "Unexpected solver failure");
+    s->solverCount++;
+    int index = memRegionIndex[value->getZExtValue()];
+    if (index == -1) return nullptr;
+    const MemRegion &region = memRegions[index];
+
+    if (!getMemRegionContent(s, region, forWrite, content)) return nullptr;
+
+    ref<Expr> inRegion = builder->And(builder->Ule(buildConstant(region.start), addr),
+                                      builder->Ule(addr, buildConstant(region.start + region.size - 1)));
+    bool mustBeInRegion;
+    success = solver->mustBeTrue(Query(s->constraints, inRegion), mustBeInRegion);
+    assert(success && "Unexpected solver failure");
+    s->solverCount++;
+
+    if (mustBeInRegion) {
+        outside = nullptr;
+    } else {
+        outside = stateAllocator.fork(s);
+        outside->addConstraint(Expr::createIsZero(inRegion));
+        s->addConstraint(inRegion);
+        if (solverCostTracker) solverCostTracker->addForks(ir.get(), 1);
+    }
+    return &region;
+}
+
+bool Executor::getMemRegionContent(const State *s, const MemRegion &region, bool forWrite,
+                                   UpdateList &content) const {
+    auto it = s->memRegionUpdates.find(region.start);
+    if (it != s->memRegionUpdates.end()) {
+        content = it->second;  // all locations have been written by the program
+        return true;
+    }
+
+    content = region.base;
+    for (unsigned i = 0; i < region.size; i++) {
+        uint16_t addr = region.start + i;
+        ref<MemValue> val = s->mem.read(addr);
+        if (val.get() == baseMem[addr].get()) continue;
+        if (val.isNull() || val->type != MemValue::MEM_DATA || val->e.isNull()) return false;
+        content.extend(buildConstant(i), val->e);
+    }
+    // Flags only appear in baseMem, as values written by the program are created without them
+    for (unsigned i = 0; i < region.size; i++) {
+        uint16_t addr = region.start + i;
+        ref<MemValue> val = s->mem.read(addr);
+        if (val.get() != baseMem[addr].get()) continue;
+        auto data = dyn_cast<DataValue>(val);
+        if (forWrite ? data->forRead : data->forWrite) return false;
+    }
+    return true;
+}
+
+void Executor::materializeMemRegionWord(State *s, uint16_t addr, const ref<InstValue> &ir) {
+    if (s->memRegionUpdates.empty() || memRegionIndex.empty() || memRegionIndex[addr] == -1) return;
+    const MemRegion &region = memRegions[memRegionIndex[addr]];
+    auto it = s->memRegionUpdates.find(region.start);
+    if (it == s->memRegionUpdates.end()) return;
+
+    ref<Expr> value = builder->Read(it->second, buildConstant(addr - region.start));
+    ref<MemValue> oldVal = s->mem.read(addr);
+    if (!oldVal.isNull() && !oldVal->e.isNull() && oldVal->e == value) return;  // already up to date
+    memWriteData(s, addr, value, ir, false);
+}
+
+void Executor::materializeMemRegion(State *s, const MemRegion &region, const ref<InstValue> &ir) {
+    for (unsigned i = 0; i < region.size; i++) materializeMemRegionWord(s, region.start + i, ir);
+    s->memRegionUpdates.erase(region.start);
+}
+
+void Executor::materializeMemRegions(State *s, const ref<InstValue> &ir) {
+    while (!s->memRegionUpdates.empty()) {
+        materializeMemRegion(s, memRegions[memRegionIndex[s->memRegionUpdates.begin()->first]], ir);
+    }
+}
+
+void Executor::getMemRegionWords(const State *s, map<uint16_t, ref<Expr>> &words) const {
+    for (const auto &it : s->memRegionUpdates) {
+        const MemRegion &region = memRegions[memRegionIndex[it.first]];
+        for (unsigned i = 0; i < region.size; i++) {
+            words[region.start + i] = builder->Read(it.second, buildConstant(i));
+        }
+    }
+}
+
 /**
  * Fork states by range of given expression
  * @param s
@@ -301,10 +557,16 @@ Executor::handleExprLD(State *s, Reg DR, const ref<Expr> &addr, const ref<InstVa
 void Executor::forkOnRange(State *s, const ref<Expr> &val, const ref<InstValue> &ir,
                            vector<pair<uint16_t, State *>> &instances) {
     vector<pair<uint16_t, ref<Expr>>> values;
-    evalPossibleValuesWithCache(val, s->constraints, values, s->solverCount);
+    {
+        SolverCostTracker::Scope costScope(solverCostTracker, ir.get());
+        evalPossibleValuesWithCache(val, s->constraints, values, s->solverCount);
+    }
 
     if (values.empty()) return;  // no valid range
     if (values.size() > 1) {  // need to fork
+#if !DISABLE_FORK_ON_SYM_ADDR
+        if (solverCostTracker) solverCostTracker->addForks(ir.get(), values.size() - 1);
+#endif
 #if LOG_SYM_ADDR_FORK
         progInfo() << "Fork " << values.size() - 1 << " states" << "  At: " << ir->sourceContext() << "\n";
 #endif
@@ -398,6 +660,70 @@ bool Executor::evalPossibleValues(const ref<Expr> &expr, const ConstraintSet &co
                                   int maxPossibleValueCount) const {
     assert(expr->getWidth() == Expr::Int16);
 
+    if (SymAddrEnum == SymAddrEnumMethod::RANGE) {
+        return evalPossibleValuesByRange(expr, constraints, result, solverCount, maxPossibleValueCount);
+    }
+
+    ConstraintSet blockedConstraints = constraints;
+    bool exhausted;
+    if (!evalPossibleValuesByModel(expr, blockedConstraints, result, solverCount, maxPossibleValueCount,
+                                   SymAddrEnum == SymAddrEnumMethod::MODEL ? -1 : MODEL_ENUM_BUDGET, exhausted)) {
+        return false;
+    }
+    if (exhausted) return true;
+
+    // Too many values for models, find the rest by range splitting, with found values excluded. The constraints are
+    // known to be satisfiable here, or the range search would find values vacuously.
+    return evalPossibleValuesByRange(expr, blockedConstraints, result, solverCount, maxPossibleValueCount);
+}
+
+bool Executor::evalPossibleValuesByModel(const ref<Expr> &expr, ConstraintSet &constraints,
+                                         vector<pair<uint16_t, ref<Expr>>> &result, int &solverCount,
+                                         int maxPossibleValueCount, int maxQueryCount, bool &exhausted) const {
+    vector<const Array *> arrays;
+    klee::findSymbolicObjects(expr, arrays);
+
+    exhausted = false;
+    for (int queryCount = 0; maxQueryCount == -1 || queryCount <= maxQueryCount; queryCount++) {
+        uint16_t val;
+        if (arrays.empty()) {
+            if (queryCount > 0) {
+                exhausted = true;
+                return true;
+            }
+            val = castConstant(expr);
+        } else {
+            vector<vector<unsigned char>> values;
+            // Solver::getInitialValues() doesn't tell a solver failure from no solution, so ask the impl directly.
+            // No solution means all values are blocked.
+            bool hasSolution;
+            bool success = solver->impl->computeInitialValues(Query(constraints, builder->False()), arrays, values,
+                                                              hasSolution);
+            assert(success && "Unexpected solver failure");
+            solverCount++;
+            if (!hasSolution) {
+                exhausted = true;
+                return true;
+            }
+            // The query beyond the budget only checks whether there are values left for the caller to find
+            if (queryCount == maxQueryCount) return true;
+            val = castConstant(Assignment(arrays, values).evaluate(expr));
+        }
+
+        ref<Expr> c = builder->Eq(expr, buildConstant(val));
+        result.emplace_back(val, c);
+        if (maxPossibleValueCount != -1 && (int) result.size() > maxPossibleValueCount) return false;
+
+        // Block this value
+        constraints.push_back(Expr::createIsZero(c));
+    }
+    return true;
+}
+
+bool Executor::evalPossibleValuesByRange(const ref<Expr> &expr, const ConstraintSet &constraints,
+                                         vector<pair<uint16_t, ref<Expr>>> &result, int &solverCount,
+                                         int maxPossibleValueCount) const {
+
     uint16_t minVal, maxVal;
     bool res, success;
 
@@ -590,6 +916,8 @@ void Executor::executeBR(State *s, const ref<InstValue> &ir, StateVector &result
 
         ref<Expr> continueCond = Expr::createIsZero(brCond);
         continueState->addConstraint(continueCond);
+
+        if (solverCostTracker) solverCostTracker->addForks(ir.get(), 1);
 #if LOG_BR_FORK
         progInfo() << "Fork 1 state" << "  At: " << ir->sourceContext() << "\n";
 #endif
@@ -615,17 +943,30 @@ Solver::Validity Executor::solveBRCond(State *s, const ref<InstValue> &ir, ref<E
         case InstValue::CC_NZP:
             brCond = nullptr;
             return klee::Solver::True;  // always branch
+        default:
+            break;
+    }
+
+    // Concrete fast path, no Expr is built
+    uint16_t ccVal;
+    if (s->getCCSrcReg() <= R_R7 && s->getConcreteReg(s->getCCSrcReg(), ccVal)) {
+        brCond = nullptr;
+        unsigned ccFlag = ((int16_t) ccVal < 0 ? InstValue::CC_N : (ccVal == 0 ? InstValue::CC_Z : InstValue::CC_P));
+        return (ir->cc() & ccFlag) ? klee::Solver::True : klee::Solver::False;
+    }
+
+    switch (ir->cc()) {
         case InstValue::CC_N:
             brCond = builder->Slt(getCCExpr(s, ir), buildConstant(0));
             break;
         case InstValue::CC_Z:
-            brCond = Expr::createIsZero(getCCExpr(s, ir));
+            brCond = builder->Eq(buildConstant(0), getCCExpr(s, ir));
             break;
         case InstValue::CC_P:
             brCond = builder->Slt(buildConstant(0), getCCExpr(s, ir));
             break;
         case InstValue::CC_NP:
-            brCond = Expr::createIsZero(Expr::createIsZero(getCCExpr(s, ir)));
+            brCond = builder->Ne(buildConstant(0), getCCExpr(s, ir));
             break;
         case InstValue::CC_NZ:
             brCond = builder->Sle(getCCExpr(s, ir), buildConstant(0));
@@ -633,6 +974,8 @@ Solver::Validity Executor::solveBRCond(State *s, const ref<InstValue> &ir, ref<E
         case InstValue::CC_ZP:
             brCond = builder->Sle(buildConstant(0), getCCExpr(s, ir));
             break;
+        default:
+            assert(!"CC_NONE and CC_NZP should have been handled");
     }
 
     // Constant folding builder
@@ -648,8 +991,11 @@ Solver::Validity Executor::solveBRCond(State *s, const ref<InstValue> &ir, ref<E
 #endif
 
     klee::Solver::Validity ret;
-    bool success = solver->evaluate(Query(s->constraints, brCond), ret);
-    assert(success && "Unhandled solver failure");
+    {
+        SolverCostTracker::Scope costScope(solverCostTracker, ir.get());
+        bool success = solver->evaluate(Query(s->constraints, brCond), ret);
+        assert(success && "Unhandled solver failure");
+    }
     s->solverCount++;
 
 #if 0
@@ -693,6 +1039,11 @@ void Executor::executeJMP(State *s, const ref<InstValue> &ir) {
     }
 
     if (s->status == State::NORMAL) {
+        uint16_t concretePC;
+        if (s->getConcreteReg(ir->baseR(), concretePC)) {
+            setReg(s, R_PC, concretePC, ir);
+            return;
+        }
         ref<Expr> newPC = getReg(s, ir->baseR(), ir);
         if (newPC->getKind() != Expr::Constant) {
             if (auto issueInfo = s->newStateIssue(Issue::ERR_SYMBOLIC_PC, ir)) {
@@ -725,6 +1076,16 @@ void Executor::executeJSRR(State *s, const ref<InstValue> &ir) {
 
 void Executor::executeADD(State *s, const ref<InstValue> &ir) {
     Reg dr = ir->dr();
+
+    // Concrete fast path, no Expr is built
+    uint16_t val1, val2;
+    if (s->getConcreteReg(ir->sr1(), val1) &&
+        (ir->instDef().format == InstValue::FMT_RRR ? s->getConcreteReg(ir->sr2(), val2) : (val2 = ir->imm5(), true))) {
+        setReg(s, dr, (uint16_t) (val1 + val2), ir);
+        setCC(s, dr, ir);
+        return;
+    }
+
     ref<Expr> op1 = getReg(s, ir->sr1(), ir);
     ref<Expr> op2 = (ir->instDef().format == InstValue::FMT_RRR ?
                      getReg(s, ir->sr2(), ir) :
@@ -788,6 +1149,15 @@ void Executor::executeADD(State *s, const ref<InstValue> &ir) {
 void Executor::executeAND(State *s, const ref<InstValue> &ir) {
     Reg dr = ir->dr();
 
+    // Concrete fast path. Uninitialized registers go through the slow path below for warnings.
+    uint16_t val1, val2;
+    if (s->getConcreteReg(ir->sr1(), val1) &&
+        (ir->instDef().format == InstValue::FMT_RRR ? s->getConcreteReg(ir->sr2(), val2) : (val2 = ir->imm5(), true))) {
+        setReg(s, dr, (uint16_t) (val1 & val2), ir);
+        setCC(s, dr, ir);
+        return;
+    }
+
     // Here we don't use getReg(), since we don't want to give warning when AND an uninitialized reg with 0
     ref<Expr> op1 = s->getReg(ir->sr1());
     ref<Expr> op2 = (ir->instDef().format == InstValue::FMT_RRR ?
@@ -826,7 +1196,12 @@ void Executor::executeAND(State *s, const ref<InstValue> &ir) {
 
 void Executor::executeNOT(State *s, const ref<InstValue> &ir) {
     Reg DR = ir->dr();
-    setReg(s, DR, builder->Not(getReg(s, ir->sr1(), ir)), ir);
+    uint16_t val;
+    if (s->getConcreteReg(ir->sr1(), val)) {
+        setReg(s, DR, (uint16_t) ~val, ir);
+    } else {
+        setReg(s, DR, builder->Not(getReg(s, ir->sr1(), ir)), ir);
+    }
     setCC(s, DR, ir);
 }
 
@@ -854,10 +1229,12 @@ void Executor::executeTRAP(State *s, const ref<InstValue> &ir) {
     setReg(s, R_PC, castConstant(newPC), ir);
 }
 
-Issue::Type Executor::memReadData(State *s, uint16_t addr, ref<Expr> &result, const ref<InstValue> &ir, int dr) const {
+Issue::Type Executor::memReadData(State *s, uint16_t addr, ref<Expr> &result, const ref<InstValue> &ir, int dr) {
 
     Issue::Type ret = Issue::NO_ISSUE;
 
+    materializeMemRegionWord(s, addr, ir);
+
     ref<MemValue> value = s->mem.read(addr);
 
     if (value.isNull()) {  // this is nullptr MemValue, which means the memory is never wrote
@@ -920,7 +1297,8 @@ Issue::Type Executor::memReadData(State *s, uint16_t addr, ref<Expr> &result, co
     return ret;
 }
 
-Issue::Type Executor::memWriteData(State *s, uint16_t addr, const ref<Expr> &value, const ref<InstValue> &ir) {
+Issue::Type Executor::memWriteData(State *s, uint16_t addr, const ref<Expr> &value, const ref<InstValue> &ir,
+                                   bool syncMemRegion) {
 
     Issue::Type ret = Issue::NO_ISSUE;
 
@@ -945,7 +1323,7 @@ Issue::Type Executor::memWriteData(State *s, uint16_t addr, const ref<Expr> &val
 
         } else if (oldVal->type == MemValue::MEM_INST) {
 
-            // We don't allow overwriting inst since it makes changes to the flow graph
+            // We don't allow overwriting inst since it makes changes to the flow graph (and instTable)
             ref<InstValue> oldInst = dyn_cast<InstValue>(oldVal);
             if (auto issueInfo = s->newStateIssue(Issue::ERR_OVERWRITE_INST, ir)) {
                 issueInfo->setNote("writing to addr " + toLC3Hex(addr) + ", original: " +
@@ -977,6 +1355,19 @@ Issue::Type Executor::memWriteData(State *s, uint16_t addr, const ref<Expr> &val
         }
     }
 
+    if (syncMemRegion && !s->memRegionUpdates.empty() && !memRegionIndex.empty() && memRegionIndex[addr] != -1) {
+        // Keep the written region in sync
+        const MemRegion &region = memRegions[memRegionIndex[addr]];
+        auto it = s->memRegionUpdates.find(region.start);
+        if (it != s->memRegionUpdates.end()) {
+            if (value.isNull()) {
+                materializeMemRegion(s, region, ir);  // can't be accessed as an array any more
+            } else {
+                it->second.extend(buildConstant(addr - region.start), value);
+            }
+        }
+    }
+
     MemoryManager::WriteResult result = s->mem.writeData(addr, value);
     switch (result) {
         case MemoryManager::WRITE_SUCCESS:
@@ -0,0 +1,353 @@
+//
+// Created by liuzikai on 10/17/26.
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+
+#include "klc3/Core/LC3ExprBuilder.h"
+
+#include "llvm/Support/MathExtras.h"
+
+#include <algorithm>
+
+namespace klc3 {
+
+// Sums beyond these limits are built as they are, to keep the normalization cheap
+static constexpr unsigned MAX_SUM_TERMS = 8;
+static constexpr unsigned MAX_SUM_NODES = 64;
+
+static inline const ConstantExpr *asConstant(const ref<Expr> &e) {
+    return dyn_cast<ConstantExpr>(e);
+}
+
+static inline uint16_t constantValue(const ref<Expr> &e) {
+    return (uint16_t) asConstant(e)->getZExtValue();
+}
+
+static inline bool isZeroConstant(const ref<Expr> &e) {
+    const ConstantExpr *c = asConstant(e);
+    return c != nullptr && c->isZero();
+}
+
+// Set all bits below the highest set bit
+static inline uint16_t smearRight(uint32_t x) {
+    x |= x >> 1;
+    x |= x >> 2;
+    x |= x >> 4;
+    x |= x >> 8;
+    return (uint16_t) x;
+}
+
+// Inverse of an odd number mod 2^16, by Newton's iteration (each one doubles the correct low bits)
+static inline uint16_t inverseOfOdd(uint16_t odd) {
+    uint32_t inv = odd;  // correct for the low 3 bits
+    for (int i = 0; i < 4; i++) inv = (inv * (2 - odd * inv)) & 0xFFFF;
+    return (uint16_t) inv;
+}
+
+bool LC3ExprBuilder::addTerms(const ref<Expr> &e, uint16_t coefficient, Sum &sum, unsigned &budget) {
+    if (budget == 0) return false;
+    budget--;
+
+    if (coefficient == 0) return true;
+
+    switch (e->getKind()) {
+        case Expr::Constant:
+            sum.constant += (uint16_t) ((uint32_t) coefficient * constantValue(e));
+            return true;
+        case Expr::Add:
+            return addTerms(e->getKid(0), coefficient, sum, budget) &&
+                   addTerms(e->getKid(1), coefficient, sum, budget);
+        case Expr::Sub:
+            return addTerms(e->getKid(0), coefficient, sum, budget) &&
+                   addTerms(e->getKid(1), (uint16_t) -coefficient, sum, budget);
+        case Expr::Mul:
+            if (asConstant(e->getKid(0))) {
+                return addTerms(e->getKid(1), (uint16_t) ((uint32_t) coefficient * constantValue(e->getKid(0))),
+                                sum, budget);
+            } else if (asConstant(e->getKid(1))) {
+                return addTerms(e->getKid(0), (uint16_t) ((uint32_t) coefficient * constantValue(e->getKid(1))),
+                                sum, budget);
+            }
+            break;
+        case Expr::Not:
+            // ~x = -x - 1
+            sum.constant -= coefficient;
+            return addTerms(e->getKid(0), (uint16_t) -coefficient, sum, budget);
+        default:
+            break;
+    }
+
+    for (auto &term : sum.terms) {
+        if (term.first == e) {
+            term.second += coefficient;
+            return true;
+        }
+    }
+    if (sum.terms.size() >= MAX_SUM_TERMS) return false;
+    sum.terms.emplace_back(e, coefficient);
+    return true;
+}
+
+bool LC3ExprBuilder::decompose(const ref<Expr> &lhs, uint16_t lhsCoefficient, const ref<Expr> &rhs,
+                               uint16_t rhsCoefficient, Sum &sum) {
+    unsigned budget = MAX_SUM_NODES;
+    if (!addTerms(lhs, lhsCoefficient, sum, budget)) return false;
+    if (!rhs.isNull() && !addTerms(rhs, rhsCoefficient, sum, budget)) return false;
+
+    sum.terms.erase(std::remove_if(sum.terms.begin(), sum.terms.end(), [](const std::pair<ref<Expr>, uint16_t> &t) {
+        return t.second == 0;
+    }), sum.terms.end());
+    std::sort(sum.terms.begin(), sum.terms.end(), [](const std::pair<ref<Expr>, uint16_t> &a,
+                                                     const std::pair<ref<Expr>, uint16_t> &b) {
+        return a.first->compare(*b.first) < 0;
+    });
+    return true;
+}
+
+ref<Expr> LC3ExprBuilder::build(const Sum &sum) {
+    // Terms with "negative" coefficients are subtracted, so that negation doesn't show up as multiplying by 0xFFFF
+    ref<Expr> pos, neg;
+    for (const auto &term : sum.terms) {
+        bool negative = term.second >= 0x8000;
+        uint16_t c = negative ? (uint16_t) -term.second : term.second;
+        ref<Expr> scaled = (c == 1 ? term.first : base->Mul(base->Constant(c, Expr::Int16), term.first));
+        ref<Expr> &acc = negative ? neg : pos;
+        acc = acc.isNull() ? scaled : base->Add(acc, scaled);
+    }
+
+    ref<Expr> k = base->Constant(sum.constant, Expr::Int16);
+    if (pos.isNull() && neg.isNull()) return k;
+    if (pos.isNull()) {
+        if (sum.constant == 0xFFFF && sum.terms.size() == 1 && sum.terms[0].second == 0xFFFF) {
+            return base->Not(sum.terms[0].first);  // -t - 1 = ~t
+        }
+        return base->Sub(k, neg);
+    }
+    ref<Expr> ret = (neg.isNull() ? pos : base->Sub(pos, neg));
+    return sum.constant == 0 ? ret : base->Add(k, ret);
+}
+
+ref<Expr> LC3ExprBuilder::Add(const ref<Expr> &LHS, const ref<Expr> &RHS) {
+    if (LHS->getWidth() != Expr::Int16 || (asConstant(LHS) && asConstant(RHS))) return base->Add(LHS, RHS);
+    Sum sum;
+    if (!decompose(LHS, 1, RHS, 1, sum)) return base->Add(LHS, RHS);
+    return build(sum);
+}
+
+ref<Expr> LC3ExprBuilder::Sub(const ref<Expr> &LHS, const ref<Expr> &RHS) {
+    if (LHS->getWidth() != Expr::Int16 || (asConstant(LHS) && asConstant(RHS))) return base->Sub(LHS, RHS);
+    Sum sum;
+    if (!decompose(LHS, 1, RHS, 0xFFFF, sum)) return base->Sub(LHS, RHS);
+    return build(sum);
+}
+
+ref<Expr> LC3ExprBuilder::Mul(const ref<Expr> &LHS, const ref<Expr> &RHS) {
+    if (LHS->getWidth() != Expr::Int16 || (asConstant(LHS) == nullptr) == (asConstant(RHS) == nullptr)) {
+        return base->Mul(LHS, RHS);
+    }
+    // Multiplying by a constant only, which is how ADD R,R,R is built
+    const ref<Expr> &x = (asConstant(LHS) ? RHS : LHS);
+    uint16_t c = constantValue(asConstant(LHS) ? LHS : RHS);
+    Sum sum;
+    if (!decompose(x, c, nullptr, 0, sum)) return base->Mul(LHS, RHS);
+    return build(sum);
+}
+
+ref<Expr> LC3ExprBuilder::Not(const ref<Expr> &LHS) {
+    if (LHS->getWidth() != Expr::Int16 || asConstant(LHS)) return base->Not(LHS);
+    Sum sum;
+    sum.constant = 0xFFFF;  // ~x = -x - 1
+    if (!decompose(LHS, 0xFFFF, nullptr, 0, sum)) return base->Not(LHS);
+    return build(sum);
+}
+
+ref<Expr> LC3ExprBuilder::And(const ref<Expr> &LHS, const ref<Expr> &RHS) {
+    if (LHS->getWidth() != Expr::Int16) return base->And(LHS, RHS);
+    const ConstantExpr *maskExpr = asConstant(LHS) ? asConstant(LHS) : asConstant(RHS);
+    if (maskExpr == nullptr || (asConstant(LHS) && asConstant(RHS))) return base->And(LHS, RHS);
+
+    uint16_t mask = (uint16_t) maskExpr->getZExtValue();
+    const ref<Expr> &x = (asConstant(LHS) ? RHS : LHS);
+
+    if (x->getKind() == Expr::And) {
+        // Nested masks
+        for (unsigned i = 0; i < 2; i++) {
+            if (asConstant(x->getKid(i))) {
+                return And(base->Constant(mask & constantValue(x->getKid(i)), Expr::Int16), x->getKid(1 - i));
+            }
+        }
+    }
+
+    uint16_t bits = mayBeOneBits(x);
+    if ((bits & ~mask) == 0) return x;  // all bits that may be set are kept
+    if ((bits & mask) == 0) return base->Constant(0, Expr::Int16);
+    return base->And(base->Constant(mask, Expr::Int16), x);
+}
+
+ref<Expr> LC3ExprBuilder::Eq(const ref<Expr> &LHS, const ref<Expr> &RHS) {
+    if (LHS->getWidth() != Expr::Int16 || (asConstant(LHS) && asConstant(RHS))) return base->Eq(LHS, RHS);
+
+    // LHS - RHS == 0
+    Sum diff;
+    if (!decompose(LHS, 1, RHS, 0xFFFF, diff)) return base->Eq(LHS, RHS);
+
+    if (diff.terms.empty()) return diff.constant == 0 ? True() : False();
+
+    if (diff.terms.size() == 1) {
+        // c * t == target, where c = 2^j * odd. The low j bits of c * t are always 0 and the rest are determined by the
+        // low 16 - j bits of t.
+        const ref<Expr> &t = diff.terms[0].first;
+        uint16_t c = diff.terms[0].second;
+        uint16_t target = (uint16_t) -diff.constant;
+        unsigned j = llvm::countTrailingZeros(c);
+        if (target & ((1U << j) - 1)) return False();
+        unsigned w = 16 - j;
+        uint16_t value = (uint16_t) (((uint32_t) (target >> j) * inverseOfOdd((uint16_t) (c >> j))) &
+                                     ((1U << w) - 1));
+        if (j == 0) return buildTermEq(t, value);
+        return base->Eq(base->Constant(value, w), base->Extract(t, 0, w));
+    }
+
+    // Move the negative terms to the other side, such as (a - b == 0) => (a == b)
+    Sum pos, neg;
+    for (const auto &term : diff.terms) {
+        if (term.second < 0x8000) pos.terms.push_back(term);
+        else neg.terms.emplace_back(term.first, (uint16_t) -term.second);
+    }
+    if (neg.terms.empty()) return base->Eq(base->Constant((uint16_t) -diff.constant, Expr::Int16), build(pos));
+    if (pos.terms.empty()) return base->Eq(base->Constant(diff.constant, Expr::Int16), build(neg));
+    pos.constant = diff.constant;
+    return base->Eq(build(pos), build(neg));
+}
+
+ref<Expr> LC3ExprBuilder::Slt(const ref<Expr> &LHS, const ref<Expr> &RHS) {
+    if (LHS->getWidth() != Expr::Int16 || (asConstant(LHS) && asConstant(RHS))) return base->Slt(LHS, RHS);
+    if (isZeroConstant(RHS)) return buildSignTest(LHS, LT_ZERO);
+    if (isZeroConstant(LHS)) return buildSignTest(RHS, GT_ZERO);
+    return base->Slt(LHS, RHS);
+}
+
+ref<Expr> LC3ExprBuilder::Sle(const ref<Expr> &LHS, const ref<Expr> &RHS) {
+    if (LHS->getWidth() != Expr::Int16 || (asConstant(LHS) && asConstant(RHS))) return base->Sle(LHS, RHS);
+    if (isZeroConstant(RHS)) return buildSignTest(LHS, LE_ZERO);
+    if (isZeroConstant(LHS)) return buildSignTest(RHS, GE_ZERO);
+    return base->Sle(LHS, RHS);
+}
+
+ref<Expr> LC3ExprBuilder::buildSignTest(const ref<Expr> &e, SignTest test) {
+    auto asItIs = [&]() -> ref<Expr> {
+        ref<Expr> zero = base->Constant(0, Expr::Int16);
+        switch (test) {
+            case LT_ZERO: return base->Slt(e, zero);
+            case LE_ZERO: return base->Sle(e, zero);
+            case GT_ZERO: return base->Slt(zero, e);
+            case GE_ZERO: return base->Sle(zero, e);
+        }
+        return nullptr;
+    };
+
+    Sum sum;
+    if (!decompose(e, 1, nullptr, 0, sum)) return asItIs();
+
+    if ((test == LT_ZERO || test == GE_ZERO) && sum.constant == 0 && sum.terms.size() == 1 &&
+        llvm::isPowerOf2_32(sum.terms[0].second)) {
+        // The sign bit of t * 2^j, such as the one tested by "ADD R1,R1,R1; BRn" in loops printing binary
+        ref<Expr> bit = buildBit(sum.terms[0].first, 15 - llvm::countTrailingZeros(sum.terms[0].second));
+        return test == LT_ZERO ? bit : base->Eq(False(), bit);
+    }
+
+    // The sum doesn't overflow if the bits that may be set in terms bound it within [-2^15, 2^15). Then
+    // pos - neg + k < 0 <=> pos + k < neg if k >= 0, or pos < neg - k otherwise, without overflow as unsigned.
+    int64_t posMax = 0, negMax = 0;
+    Sum pos, neg;
+    for (const auto &term : sum.terms) {
+        if (term.second < 0x8000) {
+            posMax += (int64_t) term.second * mayBeOneBits(term.first);
+            pos.terms.push_back(term);
+        } else {
+            negMax += (int64_t) (uint16_t) -term.second * mayBeOneBits(term.first);
+            neg.terms.emplace_back(term.first, (uint16_t) -term.second);
+        }
+    }
+    auto k = (int16_t) sum.constant;
+    if (posMax + k > INT16_MAX || k - negMax < INT16_MIN) return asItIs();
+
+    if (k > 0) pos.constant = (uint16_t) k;
+    else neg.constant = (uint16_t) -k;
+    ref<Expr> a = build(pos), b = build(neg);
+    switch (test) {
+        case LT_ZERO: return base->Ult(a, b);
+        case LE_ZERO: return base->Ule(a, b);
+        case GT_ZERO: return base->Ult(b, a);
+        case GE_ZERO: return base->Ule(b, a);
+    }
+    return asItIs();
+}
+
+ref<Expr> LC3ExprBuilder::buildTermEq(const ref<Expr> &t, uint16_t value) {
+    uint16_t bits = mayBeOneBits(t);
+    if (value & ~bits) return False();
+
+    if (t->getKind() == Expr::And && asConstant(t->getKid(0)) && llvm::isPowerOf2_32(constantValue(t->getKid(0)))) {
+        // Testing a single bit, such as "AND R2,R1,R3; BRz" with R3 holding a bit mask. value is either 0 or the mask.
+        ref<Expr> bit = buildBit(t->getKid(1), llvm::countTrailingZeros(constantValue(t->getKid(0))));
+        return value != 0 ? bit : base->Eq(False(), bit);
+    }
+
+    return base->Eq(base->Constant(value, Expr::Int16), t);
+}
+
+ref<Expr> LC3ExprBuilder::buildBit(const ref<Expr> &e, unsigned i) {
+    if (!((mayBeOneBits(e) >> i) & 1)) return False();
+    if (asConstant(e)) return True();  // the bit is set as shown above
+    if (e->getKind() == Expr::And) {
+        // The mask has the bit set, as shown above
+        if (asConstant(e->getKid(0))) return buildBit(e->getKid(1), i);
+        if (asConstant(e->getKid(1))) return buildBit(e->getKid(0), i);
+    }
+    return base->Extract(e, i, Expr::Bool);
+}
+
+uint16_t LC3ExprBuilder::mayBeOneBits(const ref<Expr> &e, unsigned depth) {
+    if (e->getWidth() != Expr::Int16) return 0xFFFF;
+    if (asConstant(e)) return constantValue(e);
+    if (depth == 0) return 0xFFFF;
+
+    switch (e->getKind()) {
+        case Expr::And:
+            return mayBeOneBits(e->getKid(0), depth - 1) & mayBeOneBits(e->getKid(1), depth - 1);
+        case Expr::Or:
+        case Expr::Xor:
+            return mayBeOneBits(e->getKid(0), depth - 1) | mayBeOneBits(e->getKid(1), depth - 1);
+        case Expr::Select:
+            return mayBeOneBits(e->getKid(1), depth - 1) | mayBeOneBits(e->getKid(2), depth - 1);
+        case Expr::ZExt: {
+            Expr::Width w = e->getKid(0)->getWidth();
+            return w < 16 ? (uint16_t) ((1U << w) - 1) : 0xFFFF;
+        }
+        case Expr::LShr:
+            if (asConstant(e->getKid(1))) {
+                uint16_t shift = constantValue(e->getKid(1));
+                return shift >= 16 ? 0 : (uint16_t) (mayBeOneBits(e->getKid(0), depth - 1) >> shift);
+            }
+            break;
+        case Expr::Add: {
+            // Bounded by the sum of the bounds if it doesn't overflow
+            uint32_t max = (uint32_t) mayBeOneBits(e->getKid(0), depth - 1) + mayBeOneBits(e->getKid(1), depth - 1);
+            return max <= 0xFFFF ? smearRight(max) : 0xFFFF;
+        }
+        case Expr::Mul:
+            if (asConstant(e->getKid(0))) {
+                uint32_t max = (uint32_t) constantValue(e->getKid(0)) * mayBeOneBits(e->getKid(1), depth - 1);
+                return max <= 0xFFFF ? smearRight(max) : 0xFFFF;
+            }
+            break;
+        default:
+            break;
+    }
+    return 0xFFFF;
+}
+
+}
@@ -33,11 +33,20 @@ ref<MemValue> MemoryManager::read(uint16_t addr) const {
             break;
     }
 
-    // Find in this level
-    auto it = mem.find(addr);
-    if (it != mem.end()) {
-        // For symbolic DataValue, its expression is already constructed as ReadExpr
-        return it->second;
+    // Find in the trie
+    // For symbolic DataValue, its expression is already constructed as ReadExpr
+    if (!root.isNull()) {
+        const ref<Level1Node> &l1 = root->slots[(addr >> 12U) & 0xFU];
+        if (!l1.isNull()) {
+            const ref<Level2Node> &l2 = l1->slots[(addr >> 8U) & 0xFU];
+            if (!l2.isNull()) {
+                const ref<LeafNode> &leaf = l2->slots[(addr >> 4U) & 0xFU];
+                if (!leaf.isNull()) {
+                    const ref<MemValue> &val = leaf->slots[addr & 0xFU];
+                    if (!val.isNull()) return val;
+                }
+            }
+        }
     }
 
     // Read the base memory
@@ -66,11 +75,46 @@ MemoryManager::WriteResult MemoryManager::write(uint16_t addr, const ref<MemValu
             break;
     }
 
-    mem[addr] = value;
+    // Path copying: only nodes shared with other MemoryManagers get duplicated
+    Level1Node *l1 = mutableNode(mutableNode(root)->slots[(addr >> 12U) & 0xFU]);
+    Level2Node *l2 = mutableNode(l1->slots[(addr >> 8U) & 0xFU]);
+    LeafNode *leaf = mutableNode(l2->slots[(addr >> 4U) & 0xFU]);
+    ref<MemValue> &slot = leaf->slots[addr & 0xFU];
+    if (slot.isNull()) slotCount++;
+    slot = value;
 
     return WRITE_SUCCESS;
 }
 
+vector<ref<MemValue>> MemoryManager::writtenValues() const {
+    vector<ref<MemValue>> ret;
+    ret.reserve(slotCount);
+    if (root.isNull()) return ret;
+    for (const auto &l1 : root->slots) {
+        if (l1.isNull()) continue;
+        for (const auto &l2 : l1->slots) {
+            if (l2.isNull()) continue;
+            for (const auto &leaf : l2->slots) {
+                if (leaf.isNull()) continue;
+                for (const auto &val : leaf->slots) {
+                    if (!val.isNull()) ret.push_back(val);
+                }
+            }
+        }
+    }
+    return ret;
+}
+
+template<class T>
+T *MemoryManager::mutableNode(ref<T> &node) {
+    if (node.isNull()) {
+        node = new T();
+    } else if (node->_refCount.getCount() > 1) {
+        node = new T(*node);  // copying the slots only increases reference counts of children
+    }
+    return node.get();
+}
+
 MemoryManager::WriteResult MemoryManager::writeData(uint16_t addr, const ref<Expr> &value) {
     ref<MemValue> v = DataValue::alloc(addr, value);
     return write(addr, v);
@@ -0,0 +1,157 @@
+//
+// Created by liuzikai on 10/17/26.
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+
+#include "klc3/Core/PhaseProfiler.h"
+
+#include "llvm/Support/Format.h"
+
+namespace klc3 {
+
+namespace {
+
+uint64_t toMicroseconds(std::chrono::steady_clock::duration d) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+
+}
+
+const char *PhaseProfiler::getPhaseName(Phase phase) {
+    switch (phase) {
+        case OTHER:
+            return "other";
+        case EXECUTOR_STEP:
+            return "step";
+        case COVERAGE_UPDATE:
+            return "coverage";
+        case SUBROUTINE_UPDATE:
+            return "subroutine";
+        case SEARCHER:
+            return "searcher";
+        case GOLD_EXECUTION:
+            return "gold";
+        case CROSS_CHECK:
+            return "cross_check";
+        case MAINTENANCE:
+            return "maintenance";
+        case VARIABLE_INDUCTION:
+            return "induction";
+        case RESULT_GENERATION:
+            return "generation";
+        default:
+            assert(!"Invalid phase");
+            return "";
+    }
+}
+
+PhaseProfiler::PhaseProfiler() : startTime(Clock::now()), lastSwitch(startTime), stack({OTHER}) {}
+
+void PhaseProfiler::enter(Phase phase) {
+    auto now = Clock::now();
+    times[stack.back()] += now - lastSwitch;
+    lastSwitch = now;
+    stack.push_back(phase);
+    counts[phase]++;
+}
+
+void PhaseProfiler::leave() {
+    assert(stack.size() > 1 && "Leaving a phase that is not entered");
+    auto now = Clock::now();
+    times[stack.back()] += now - lastSwitch;
+    lastSwitch = now;
+    stack.pop_back();
+}
+
+uint64_t PhaseProfiler::getTime(Phase phase) const {
+    Clock::duration ret = times[phase];
+    if (stack.back() == phase) ret += Clock::now() - lastSwitch;
+    return toMicroseconds(ret);
+}
+
+uint64_t PhaseProfiler::getTotalTime() const {
+    return toMicroseconds(Clock::now() - startTime);
+}
+
+void PhaseProfiler::printBreakdown(llvm::raw_ostream &os) const {
+    uint64_t totalTime = getTotalTime();
+    os << "Phase               Count     Time (s)    Share     Avg (us)\n";
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        auto phase = static_cast<Phase>(i);
+        uint64_t time = getTime(phase);
+        os << llvm::format("%-12s %12llu %12.3f %7.2f%% %12.2f\n",
+                           getPhaseName(phase),
+                           (unsigned long long) counts[phase],
+                           time / 1e6,
+                           totalTime == 0 ? 0.0 : 100.0 * time / totalTime,
+                           counts[phase] == 0 ? 0.0 : (double) time / counts[phase]);
+    }
+    os << llvm::format("total                     %12.3f\n", totalTime / 1e6);
+}
+
+StatsFile::StatsFile(const string &filename, const PhaseProfiler *profiler) : profiler(profiler) {
+    csv = llvm::StringRef(filename).endswith(".csv");
+
+    std::error_code errorCode;
+    os = std::make_unique<llvm::raw_fd_ostream>(filename, errorCode, llvm::sys::fs::F_None);
+    if (errorCode) {
+        newProgWarn() << "Failed to open stats file " << filename << ": " << errorCode.message() << "\n";
+        os.reset();
+        return;
+    }
+
+    if (csv) {
+        *os << "time,states,alive,inst,inst_per_s,queries,queries_per_s,solver_time,coverage,issues";
+        for (int i = 0; i < PhaseProfiler::PHASE_COUNT; i++) {
+            *os << "," << PhaseProfiler::getPhaseName(static_cast<PhaseProfiler::Phase>(i));
+        }
+        *os << "\n";
+        os->flush();
+    }
+}
+
+void StatsFile::write(const Sample &sample) {
+    if (!os) return;
+
+    uint64_t time = profiler->getTotalTime();
+    double interval = (time - (hasLast ? lastTime : 0)) / 1e6;
+    double instRate = 0, queryRate = 0;
+    if (interval > 0) {
+        instRate = (sample.totalInst - (hasLast ? last.totalInst : 0)) / interval;
+        queryRate = (sample.solverQueries - (hasLast ? last.solverQueries : 0)) / interval;
+    }
+
+    // Time in seconds, rates per second
+    if (csv) {
+        *os << llvm::format("%.3f,%d,%d,%lld,%.1f,%llu,%.1f,%.3f,%.4f,%zu",
+                            time / 1e6, sample.allocatedStates, sample.aliveStates, sample.totalInst, instRate,
+                            (unsigned long long) sample.solverQueries, queryRate, sample.solverTime / 1e6,
+                            sample.coverage, sample.issueCount);
+        for (int i = 0; i < PhaseProfiler::PHASE_COUNT; i++) {
+            *os << llvm::format(",%.3f", profiler->getTime(static_cast<PhaseProfiler::Phase>(i)) / 1e6);
+        }
+        *os << "\n";
+    } else {
+        *os << llvm::format("{\"time\": %.3f, \"states\": %d, \"alive\": %d, \"inst\": %lld, \"inst_per_s\": %.1f, "
+                            "\"queries\": %llu, \"queries_per_s\": %.1f, \"solver_time\": %.3f, \"coverage\": %.4f, "
+                            "\"issues\": %zu, \"phases\": {",
+                            time / 1e6, sample.allocatedStates, sample.aliveStates, sample.totalInst, instRate,
+                            (unsigned long long) sample.solverQueries, queryRate, sample.solverTime / 1e6,
+                            sample.coverage, sample.issueCount);
+        for (int i = 0; i < PhaseProfiler::PHASE_COUNT; i++) {
+            auto phase = static_cast<PhaseProfiler::Phase>(i);
+            *os << (i == 0 ? "" : ", ")
+                << llvm::format("\"%s\": %.3f", PhaseProfiler::getPhaseName(phase), profiler->getTime(phase) / 1e6);
+        }
+        *os << "}}\n";
+    }
+    os->flush();
+
+    hasLast = true;
+    lastTime = time;
+    last = sample;
+}
+
+}
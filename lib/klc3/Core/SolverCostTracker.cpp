@@ -0,0 +1,98 @@
+//
+// Created by liuzikai on 10/17/26.
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+
+#include "klc3/Core/SolverCostTracker.h"
+
+#include "klee/Solver/SolverStats.h"
+
+#include "llvm/Support/Format.h"
+
+namespace klc3 {
+
+SolverCostTracker::Scope::Scope(SolverCostTracker *tracker, const InstValue *inst)
+        : tracker(inst != nullptr ? tracker : nullptr), inst(inst) {
+    if (this->tracker) {
+        startTime = std::chrono::steady_clock::now();
+        startQueries = klee::stats::queries;
+    }
+}
+
+SolverCostTracker::Scope::~Scope() {
+    if (tracker) {
+        Cost &cost = tracker->costOf(inst);
+        cost.calls++;
+        cost.queries += klee::stats::queries - startQueries;
+        cost.time += std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - startTime).count();
+    }
+}
+
+SolverCostTracker::Cost &SolverCostTracker::costOf(const InstValue *inst) {
+    auto it = costs.find(inst);
+    if (it == costs.end()) {
+        it = costs.emplace(inst, Entry{const_cast<InstValue *>(inst), Cost()}).first;
+    }
+    return it->second.cost;
+}
+
+void SolverCostTracker::addForks(const InstValue *inst, uint64_t count) {
+    if (inst == nullptr || count == 0) return;
+    costOf(inst).forks += count;
+}
+
+const SolverCostTracker::Cost *SolverCostTracker::getCost(const InstValue *inst) const {
+    auto it = costs.find(inst);
+    return it != costs.end() ? &it->second.cost : nullptr;
+}
+
+uint64_t SolverCostTracker::getMaxTime() const {
+    uint64_t ret = 0;
+    for (const auto &it : costs) {
+        if (it.second.cost.time > ret) ret = it.second.cost.time;
+    }
+    return ret;
+}
+
+void SolverCostTracker::printReport(llvm::raw_ostream &os, size_t maxLines) const {
+    // Aggregate by source lines. One line usually holds one instruction, but a copy of the code (such as the entry
+    // code) shares its lines.
+    struct Line {
+        const InstValue *inst;  // the first one, for location and content
+        Cost cost;
+    };
+    map<string, Line> lines;
+    uint64_t totalTime = 0;
+    for (const auto &it : costs) {
+        const InstValue *inst = it.first;
+        auto lineIt = lines.emplace(inst->sourceLocation(), Line{inst, Cost()}).first;
+        lineIt->second.cost.add(it.second.cost);
+        totalTime += it.second.cost.time;
+    }
+
+    vector<const Line *> sortedLines;
+    sortedLines.reserve(lines.size());
+    for (const auto &it : lines) sortedLines.push_back(&it.second);
+    std::sort(sortedLines.begin(), sortedLines.end(), [](const Line *a, const Line *b) {
+        if (a->cost.time != b->cost.time) return a->cost.time > b->cost.time;
+        return a->cost.forks > b->cost.forks;
+    });
+    if (maxLines != 0 && sortedLines.size() > maxLines) sortedLines.resize(maxLines);
+
+    os << "    Time (s)    Share    Queries      Calls      Forks  Source\n";
+    for (const Line *line : sortedLines) {
+        const Cost &cost = line->cost;
+        os << llvm::format("%12.3f %7.2f%% %10llu %10llu %10llu  ",
+                           cost.time / 1e6,
+                           totalTime == 0 ? 0.0 : 100.0 * cost.time / totalTime,
+                           (unsigned long long) cost.queries,
+                           (unsigned long long) cost.calls,
+                           (unsigned long long) cost.forks)
+           << line->inst->sourceContext() << "\n";
+    }
+}
+
+}
@@ -23,31 +23,28 @@ State::State(const State &s)
           latestInst(s.latestInst), latestNonOSInst(s.latestNonOSInst),
           stepCount(s.stepCount), solverCount(s.solverCount),
           regChangeLocation(s.regChangeLocation), ccChangeLocation(s.ccChangeLocation),
-          memStoringUninitReg(s.memStoringUninitReg), statePath(s.statePath),
+          memStoringUninitReg(s.memStoringUninitReg), memRegionUpdates(s.memRegionUpdates),
+          checkedOutputLength(s.checkedOutputLength), statePath(s.statePath),
           colorStack(s.colorStack), jsrStack(s.jsrStack), stackHasMessedUp(s.stackHasMessedUp),
           loopStack(s.loopStack), constraintManager(constraints),
           /* --- private members --- */
-          pc(s.pc), ir(s.ir), reg(s.reg), ccRef(s.ccRef) {
+          pc(s.pc), ir(s.ir), reg(s.reg), concreteReg(s.concreteReg), concreteRegMask(s.concreteRegMask),
+          ccRef(s.ccRef) {
 
-    // Should not copy coveredNewEdge, coveredNewSegment and avoidLoopReductionPostpone
+    // Should not copy coveredNewEdge, coveredNewSegment, avoidLoopReductionPostpone and postponed
 
     assert(status == NORMAL && "Only normal state should be forked");
 }
 
-State *State::fork() const {
-    auto *s = new State(*this);
-    assert(constraints.size() == s->constraints.size() && "Lost constraints during forking!");
-    return s;
-}
-
 void State::dumpRegs(llvm::raw_ostream &os) const {
     // Dump R0 - R7
     for (int i = R_R0; i <= R_R7; i++) {
         os << "R" << i << ": ";
-        if (reg[(Reg) i].isNull()) {
+        uint16_t value;
+        if (getConcreteReg((Reg) i, value)) {
+            os << toLC3Hex(value) << "    ";
+        } else if (reg[(Reg) i].isNull()) {
             os << "{uninitialized}    ";
-        } else if (reg[(Reg) i]->getKind() == Expr::Constant) {
-            os << toLC3Hex(castConstant(reg[(Reg) i])) << "    ";
         } else {
             reg[(Reg) i]->print(os);
             os << "\n";
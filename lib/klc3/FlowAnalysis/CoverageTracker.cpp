@@ -141,6 +141,16 @@ float CoverageTracker::calculateCoverage() const {
     return (float) coveredEdgeCount / (float) totalEdgeToCover;
 }
 
+void CoverageTracker::recountCoverage() {
+    coveredEdgeCount = totalEdgeToCover = 0;
+    for (const auto &edge : fg->allEdges()) {
+        if (edge->type() < Edge::TYPE_RUNTIME_COUNT) {
+            totalEdgeToCover++;
+            if (edge->covered) coveredEdgeCount++;
+        }
+    }
+}
+
 void CoverageTracker::newEdgeCallback(Edge *edge) {
     if (edge->type() < Edge::TYPE_RUNTIME_COUNT) {
         totalEdgeToCover++;
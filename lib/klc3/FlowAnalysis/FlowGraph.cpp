@@ -39,6 +39,7 @@ Edge *FlowGraph::newEdge(Node *from, Node *to, Edge::Type type) {
     edge->type_ = type;
     edge->from_ = from;
     edge->to_ = to;
+    edge->index_ = edges.size();
     edges.emplace_back(edge);
     if (from != nullptr) {
         if(type < Edge::TYPE_RUNTIME_COUNT) from->runtimeOutEdges_.emplace_back(edge);
@@ -366,7 +367,7 @@ void Path::compress() {
             res.emplace_back(e);
         }
     }
-    es = std::move(res);
+    es = PersistentVector<Edge *>(res.begin(), res.end());
 }
 
 bool Path::appendCompressed(Edge *edge, bool isLast) {
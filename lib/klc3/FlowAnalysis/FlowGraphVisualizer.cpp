@@ -12,6 +12,7 @@
 #include <graphviz/gvc.h>
 #include <graphviz/cgraph.h>
 #include <fstream>
+#include <cmath>
 
 namespace klc3 {
 
@@ -298,6 +299,29 @@ void FlowGraphVisualizer::drawGlobalCoverage(const CoverageTracker *ct, uint16_t
     }
 }
 
+void FlowGraphVisualizer::drawSolverHeatMap(const SolverCostTracker *tracker) {
+    assert(!compressed && "Should not work on compressed graph");
+
+    uint64_t maxTime = tracker->getMaxTime();
+    if (maxTime == 0) return;
+
+    for (const auto &node : fg->allNodes()) {
+        if (node->inst().isNull()) continue;
+        const SolverCostTracker::Cost *cost = tracker->getCost(node->inst().get());
+        if (cost == nullptr || cost->time == 0) continue;
+
+        // Log scale, as a few lines usually take most of the time
+        double heat = std::log1p((double) cost->time) / std::log1p((double) maxTime);
+        string color = std::to_string(0.15 * (1 - heat)) + " 1 " + std::to_string(0.7 + 0.3 * heat);
+
+        auto *vNode = nodeToVNode[node];
+        assert(vNode->contentLines.size() == 1 && "Uncompressed node should have one line");
+        string &line = vNode->contentLines[0];
+        line = "<FONT COLOR=\"" + color + "\"><B>" + line + "</B>  [" + floatToString(cost->time / 1e6, 2) + " s, " +
+               std::to_string(cost->queries) + " q, " + std::to_string(cost->forks) + " f]</FONT>";
+    }
+}
+
 void FlowGraphVisualizer::generate(const string &outputBaseName) {
 
     dotNodeCount = 0;
@@ -560,13 +584,15 @@ void FlowGraphVisualizer::visualizeAllLoops(const PathString &outputPath, const
 }
 
 void FlowGraphVisualizer::visualizeCoverage(const PathString &outputPath, const FlowGraph *flowGraph,
-                                            const CoverageTracker *coverageTracker) {
+                                            const CoverageTracker *coverageTracker,
+                                            const SolverCostTracker *costTracker) {
 
     PathString compressedFlowGraphFilename(outputPath);
     llvm::sys::path::append(compressedFlowGraphFilename, "coverage");
     auto visualizer = std::make_unique<FlowGraphVisualizer>(flowGraph);
     visualizer->colorBasedOnSubroutines();
     visualizer->drawGlobalCoverage(coverageTracker, flowGraph->getInitPC());
+    if (costTracker) visualizer->drawSolverHeatMap(costTracker);
     visualizer->compress();
     visualizer->generate(compressedFlowGraphFilename.c_str());
 
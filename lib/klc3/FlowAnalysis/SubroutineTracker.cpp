@@ -318,6 +318,11 @@ vector<SubroutineTracker::SubroutineInfo> SubroutineTracker::getSubroutines() co
     return ret;
 }
 
+void SubroutineTracker::restoreSubroutine(const SubroutineInfo &info) {
+    subroutines[info.color] = info;
+    nameToColor[info.name] = info.color;
+}
+
 void SubroutineTracker::postCheckState(State *s) {
     if (!s->stackHasMessedUp && s->colorStack.top() != fg->getInitPC()) {
         s->newStateIssue(Issue::WARN_HALT_IN_SUBROUTINE, s->latestNonOSInst[0]);
@@ -64,15 +64,23 @@ void createReportFormatter() {
     }
 }
 
+vector<uint16_t> ReportFormatter::evaluateAll(const vector<ref<Expr>> &exprs, const Assignment &assignment) {
+    klee::ExprTape tape;
+    for (const auto &e : exprs) tape.compile(e);
+    vector<uint16_t> ret;
+    ret.reserve(exprs.size());
+    if (tape.run(assignment)) {
+        for (unsigned i = 0; i < exprs.size(); i++) ret.push_back(tape.getValue(i));
+    } else {
+        for (const auto &e : exprs) ret.push_back(castConstant(assignment.evaluate(e)));
+    }
+    return ret;
+}
+
 bool ReportFormatter::printLC3Out(llvm::raw_ostream &out, const State *state, const Assignment &assignment) {
     bool hasUnprintableCharacter = false;
-    for (const auto &val : state->lc3Out) {
-        uint16_t c;
-        if (val->getKind() == klee::Expr::Constant) {
-            c = castConstant(val);
-        } else {
-            c = castConstant(assignment.evaluate(val));
-        }
+    vector<ref<Expr>> exprs(state->lc3Out.begin(), state->lc3Out.end());
+    for (uint16_t c : evaluateAll(exprs, assignment)) {
         if (printCharacter(out, c)) {
             hasUnprintableCharacter = true;
         }
@@ -127,13 +135,19 @@ void ReportFormatter::reportOutputComment(llvm::raw_ostream &out, bool hasUnprin
 
 void ReportFormatter::reportRegisters(llvm::raw_ostream &out, const State *state, const Assignment &assignment,
                                       const vector<Reg> &regs) {
+    vector<ref<Expr>> exprs;
+    for (Reg r : regs) {
+        if (!state->getReg(r).isNull()) exprs.push_back(state->getReg(r));
+    }
+    vector<uint16_t> values = evaluateAll(exprs, assignment);
+    size_t valueIndex = 0;
     for (Reg r : regs) {
         const ref<Expr> &e = state->getReg(r);
         out << "R" << (int) r << "=";
         if (e.isNull()) {
             out << "<bits>" << " ";
         } else {
-            out << toLC3Hex(castConstant(assignment.evaluate(e))) << "  ";
+            out << toLC3Hex(values[valueIndex++]) << "  ";
         }
     }
     out << "\n";
@@ -143,6 +157,21 @@ void ReportFormatter::reportMemory(llvm::raw_ostream &out, const State *state, c
                                    uint16_t addrStart, uint16_t addrEnd) {
     // Reference: lc3sim.c, not support wrap over
     // addrEnd is inclusive
+
+    // Evaluate all initialized locations at once
+    vector<ref<Expr>> exprs;
+    for (unsigned long addr = addrStart; addr <= addrEnd; addr++) {
+        ref<MemValue> val = state->mem.read(addr);
+        if (!val.isNull() && !val->e.isNull()) exprs.push_back(val->e);
+    }
+    vector<uint16_t> evaluated = evaluateAll(exprs, assignment);
+    unordered_map<uint16_t, uint16_t> values;  // addr -> value
+    size_t valueIndex = 0;
+    for (unsigned long addr = addrStart; addr <= addrEnd; addr++) {
+        ref<MemValue> val = state->mem.read(addr);
+        if (!val.isNull() && !val->e.isNull()) values[addr] = evaluated[valueIndex++];
+    }
+
     for (unsigned long start = (addrStart / 12) * 12; start <= addrEnd; start += 12) {
         out << to4DigitHex(start) << ": ";
         for (unsigned long i = 0, addr = start; i < 12; i++, addr++) {
@@ -151,7 +180,7 @@ void ReportFormatter::reportMemory(llvm::raw_ostream &out, const State *state, c
                 if (val.isNull() || val->e.isNull()) {  // unspecified memory location or uninitialized value
                     out << "bits ";
                 } else {
-                    out << to4DigitHex(castConstant(assignment.evaluate(val->e))) << " ";
+                    out << to4DigitHex(values[addr]) << " ";
                 }
             } else {
                 out << "     ";
@@ -164,7 +193,7 @@ void ReportFormatter::reportMemory(llvm::raw_ostream &out, const State *state, c
                 if (val.isNull() || val->e.isNull()) {  // unspecified memory location or uninitialized value
                     out << '.';
                 } else {
-                    uint16_t num = castConstant(assignment.evaluate(val->e));
+                    uint16_t num = values[addr];
                     if (num < 0x100 && isprint(num)) {
                         out << static_cast<char>(num);
                     } else {
@@ -222,7 +251,7 @@ void ReportFormatterMarkdown::generateReport(llvm::raw_ostream &out, const Issue
         for (const auto &info : infos) {
             if (!info.note.empty()) {
                 out << "**NOTE**: ";
-                if (info.s != nullptr) {
+                if (info.s != nullptr || !info.generatedCaseName.empty()) {  // may be merged from another worker
                     if (!info.generatedCaseName.empty()) {
                         out << "in [" << info.generatedCaseName << "]("
                             << ReportRelativePath << info.generatedCaseName << "), ";
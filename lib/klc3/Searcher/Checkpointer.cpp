@@ -0,0 +1,497 @@
+//
+// Created by liuzikai on 10/17/26.
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+
+#include "klc3/Searcher/Checkpointer.h"
+
+#include "klee/Support/FileHandling.h"
+
+#include "llvm/Support/Errno.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace klc3 {
+
+/*
+ * Checkpoint format. Nodes are written as addresses ("-" for null), edges as indices (-1 for null).
+ *   KLC3CKPT <version>
+ *   G <initPC> <node count> <static edge count> <fingerprint>
+ *   N <totalInstCount> <maxStepCount> <maxSolverCount> <divergeStateCount> <searcherLevel>
+ *   D <from> <to> <type>                            an edge identified at runtime, in the order of creation
+ *   E <edge> <covered> <flags> <isImproperRET> <associatedEdge>      for every edge
+ *   V <node> <subroutineEntry> <possibleRETPoint> <color> ...         for every node
+ *   T <color> <entry> <name>                        a subroutine, followed by its exits and entry-exit pairs
+ *   TX <exit> ...
+ *   TP <entry edge>:<exit edge>,... ...
+ *   H <size>                                        followed by the searcher progress and a newline
+ *   X <size> <N | S | I>                            followed by a StateSerializer record and a newline. Records are
+ *                                                   numbered from 0. N for states held by the searcher, S for spilled
+ *                                                   states, I for states only referred to by issues.
+ *   F <record> <size>                               followed by the kquery of final constraints and a newline
+ *   I <size>                                        followed by the serialized IssuePackage and a newline
+ *   END
+ */
+
+namespace {
+
+// FNV-1a, which unlike llvm::hash_code is stable across runs
+void hashBytes(uint64_t &h, StringRef bytes) {
+    for (unsigned char c : bytes) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+}
+
+void hashInt(uint64_t &h, uint64_t value) {
+    hashBytes(h, StringRef(reinterpret_cast<const char *>(&value), sizeof(value)));
+}
+
+void writeNode(llvm::raw_ostream &out, const Node *node) {
+    if (node == nullptr) out << " -";
+    else out << " " << node->addr();
+}
+
+}
+
+Checkpointer::Checkpointer(const StateSerializer *serializer, FlowGraph *fg,
+                           CoverageTracker *coverageTracker, SubroutineTracker *subroutineTracker, Searcher *searcher,
+                           IssuePackage *issuePackage, StateSpiller *stateSpiller,
+                           unordered_map<const State *, ConstraintSet> *finalConstraintSets,
+                           AssignmentFunc induceAssignment)
+        : serializer(serializer), fg(fg), coverageTracker(coverageTracker),
+          subroutineTracker(subroutineTracker), searcher(searcher), issuePackage(issuePackage),
+          stateSpiller(stateSpiller), finalConstraintSets(finalConstraintSets),
+          induceAssignment(std::move(induceAssignment)) {
+
+    staticEdgeCount = fg->allEdges().size();
+
+    fingerprint = 14695981039346656037ULL;
+    for (const auto &node : fg->allNodes()) {
+        hashInt(fingerprint, node->addr());
+        hashBytes(fingerprint, node->inst()->sourceContent);
+    }
+    for (const auto &edge : fg->allEdges()) {
+        hashInt(fingerprint, edge->from() ? edge->from()->addr() : -1);
+        hashInt(fingerprint, edge->to() ? edge->to()->addr() : -1);
+        hashInt(fingerprint, edge->type());
+    }
+}
+
+Checkpointer::~Checkpointer() {
+    poll(true);
+}
+
+string Checkpointer::getPath(const string &directory) {
+    PathString path(directory);
+    llvm::sys::path::append(path, "checkpoint");
+    return path.str().str();
+}
+
+bool Checkpointer::startWrite(const string &directory, const Progress &progress) {
+    poll();
+    if (writerPid > 0) return false;
+
+    // Avoid buffered output getting duplicated in the writer
+    llvm::outs().flush();
+    llvm::errs().flush();
+    fflush(nullptr);
+
+    int pid = fork();
+    if (pid == -1) {
+        newProgWarn() << "Failed to fork checkpoint writer: " << llvm::sys::StrError(errno) << "\n";
+        return false;
+    }
+    if (pid == 0) {
+        // Writer, working on a copy-on-write snapshot of the exploration
+        bool ok = writeFile(directory, progress);
+        llvm::outs().flush();
+        llvm::errs().flush();
+        _exit(ok ? 0 : 1);  // skip destructors and exit handlers, which belong to the parent (such as saving caches)
+    }
+    writerPid = pid;
+    // The writer reads spilled states from the spill file shared with this process
+    if (stateSpiller) stateSpiller->setHold(true);
+    return true;
+}
+
+bool Checkpointer::write(const string &directory, const Progress &progress) {
+    poll(true);
+    if (!writeFile(directory, progress)) return false;
+    writtenCount++;
+    return true;
+}
+
+void Checkpointer::poll(bool wait) {
+    if (writerPid <= 0) return;
+    int status;
+    int ret;
+    while ((ret = waitpid(writerPid, &status, wait ? 0 : WNOHANG)) < 0 && errno == EINTR) {}
+    if (ret == 0) return;  // still writing
+
+    if (ret < 0) {
+        // Not a child of this process, such as in a child worker after workers split
+    } else if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+        writtenCount++;
+    } else {
+        newProgWarn() << "Checkpoint writer failed\n";
+    }
+    writerPid = -1;
+    if (stateSpiller) stateSpiller->setHold(false);
+}
+
+void Checkpointer::completeIssueDescs() {
+    map<const State *, Assignment> assignments;
+    for (const auto &it : issuePackage->getIssues()) {
+        for (const auto &info : it.second) {
+            if (info.descCallback != nullptr && assignments.find(info.s) == assignments.end()) {
+                assignments.emplace(info.s, induceAssignment(info.s, it.first.type));
+            }
+        }
+    }
+    issuePackage->callBackForAllDesc(assignments);
+}
+
+bool Checkpointer::writeFile(const string &directory, const Progress &progress) {
+    string path = getPath(directory);
+    string error;
+    bool written = klee::klee_write_file_atomically(path, [&](llvm::raw_fd_ostream &out) {
+        out << "KLC3CKPT " << VERSION << "\n";
+        out << "G " << fg->getInitPC() << " " << fg->allNodes().size() << " " << staticEdgeCount << " "
+            << fingerprint << "\n";
+        out << "N " << progress.totalInstCount << " " << progress.maxStepCount << " " << progress.maxSolverCount << " "
+            << progress.divergeStateCount << " " << progress.searcherLevel << "\n";
+
+        /// FlowGraph
+
+        const auto &edges = fg->allEdges();
+        for (size_t i = staticEdgeCount; i < edges.size(); i++) {
+            out << "D";
+            writeNode(out, edges[i]->from());
+            writeNode(out, edges[i]->to());
+            out << " " << (int) edges[i]->type() << "\n";
+        }
+        for (const auto &edge : edges) {
+            out << "E " << edge->index() << " " << edge->covered << " " << edge->flags << " " << edge->isImproperRET
+                << " " << (edge->associatedEdge ? (int) edge->associatedEdge->index() : -1) << "\n";
+        }
+        for (const auto &node : fg->allNodes()) {
+            out << "V " << node->addr() << " " << node->subroutineEntry << " " << node->possibleRETPoint;
+            for (const auto &color : node->subroutineColors) out << " " << color;
+            out << "\n";
+        }
+        for (const auto &subroutine : subroutineTracker->getSubroutines()) {
+            out << "T " << subroutine.color;
+            writeNode(out, subroutine.entry);
+            out << " " << subroutine.name << "\n";
+            out << "TX";
+            for (const auto &exit : subroutine.exits) writeNode(out, exit);
+            out << "\n";
+            out << "TP";
+            for (const auto &it : subroutine.eePairs) {
+                out << " " << it.first->index() << ":";
+                for (size_t i = 0; i < it.second.size(); i++) {
+                    out << (i == 0 ? "" : ",") << it.second[i]->index();
+                }
+            }
+            out << "\n";
+        }
+
+        /// Searcher
+
+        {
+            string data;
+            llvm::raw_string_ostream os(data);
+            searcher->saveProgress(os);
+            os.flush();
+            out << "H " << data.size() << "\n" << data << "\n";
+        }
+
+        /// States
+
+        unordered_map<const State *, int> stateIndices;
+        int recordCount = 0;
+        auto writeState = [&](const State *s, char kind) {
+            string data = serializer->serialize(s);
+            out << "X " << data.size() << " " << kind << "\n" << data << "\n";
+            stateIndices[s] = recordCount++;
+        };
+
+        for (const auto &s : searcher->getHeldStates()) writeState(s, 'N');
+        if (stateSpiller) {
+            bool ok = stateSpiller->forEachRecord([&](StringRef data) {
+                out << "X " << data.size() << " S\n" << data << "\n";
+                recordCount++;
+                return !out.has_error();
+            });
+            if (!ok) return false;
+        }
+
+        completeIssueDescs();
+        for (const auto &it : issuePackage->getIssues()) {
+            for (const auto &info : it.second) {
+                if (info.s != nullptr && stateIndices.find(info.s) == stateIndices.end()) writeState(info.s, 'I');
+            }
+        }
+
+        for (const auto &it : stateIndices) {
+            auto it2 = finalConstraintSets->find(it.first);
+            if (it2 != finalConstraintSets->end()) {
+                string data = serializer->serializeConstraints(it2->second);
+                out << "F " << it.second << " " << data.size() << "\n" << data << "\n";
+            }
+        }
+
+        /// Issues
+
+        {
+            string data;
+            llvm::raw_string_ostream os(data);
+            issuePackage->serialize(os, [&](const State *s) {
+                auto it = stateIndices.find(s);
+                return it == stateIndices.end() ? -1 : it->second;
+            });
+            os.flush();
+            out << "I " << data.size() << "\n" << data << "\n";
+        }
+
+        out << "END\n";
+        return true;
+    }, error);
+    if (!written && !error.empty()) {
+        newProgWarn() << "Failed to write " << path << ": " << error << "\n";
+    }
+    return written;
+}
+
+bool Checkpointer::load(const string &directory, const map<uint16_t, ref<MemValue>> &mem, Progress &progress) {
+    string path = getPath(directory);
+    auto bufOrErr = llvm::MemoryBuffer::getFile(path);
+    if (!bufOrErr) {
+        newProgErr() << "Failed to open " << path << ": " << bufOrErr.getError().message() << "\n";
+        return false;
+    }
+    StringRef data = bufOrErr.get()->getBuffer();
+
+    auto malformed = [&](const llvm::Twine &what) {
+        newProgErr() << "Malformed checkpoint " << path << ": " << what << "\n";
+        return false;
+    };
+
+    SmallVector<StringRef, 16> tokens;
+    auto nextLine = [&]() {
+        StringRef line;
+        std::tie(line, data) = data.split('\n');
+        tokens.clear();
+        line.split(tokens, ' ', -1, false);
+        return !tokens.empty();
+    };
+    auto nextBlob = [&](size_t size, StringRef &blob) {
+        if (data.size() < size + 1 || data[size] != '\n') return false;
+        blob = data.substr(0, size);
+        data = data.drop_front(size + 1);
+        return true;
+    };
+    auto toInt = [&](StringRef token, auto &value) {
+        return !token.getAsInteger(10, value);
+    };
+    auto toNode = [&](StringRef token, Node *&node) {
+        int addr;
+        if (token == "-") {
+            node = nullptr;
+            return true;
+        }
+        if (!toInt(token, addr) || addr < 0 || addr > 0xFFFF) return false;
+        node = fg->getNodeByAddr(addr);
+        return node != nullptr;
+    };
+    auto toEdge = [&](StringRef token, Edge *&edge) {
+        int index;
+        if (!toInt(token, index) || index >= (int) fg->allEdges().size()) return false;
+        edge = (index < 0 ? nullptr : fg->allEdges()[index]);
+        return true;
+    };
+
+    /// Header
+
+    int version;
+    if (!nextLine() || tokens.size() != 2 || tokens[0] != "KLC3CKPT" || !toInt(tokens[1], version)) {
+        return malformed("not a checkpoint");
+    }
+    if (version != VERSION) {
+        newProgErr() << "Checkpoint " << path << " has version " << version << ", while version " << VERSION
+                     << " is supported\n";
+        return false;
+    }
+
+    uint16_t initPC;
+    size_t nodeCount, edgeCount;
+    uint64_t fp;
+    if (!nextLine() || tokens.size() != 5 || tokens[0] != "G" || !toInt(tokens[1], initPC) ||
+        !toInt(tokens[2], nodeCount) || !toInt(tokens[3], edgeCount) || !toInt(tokens[4], fp)) {
+        return malformed("bad program line");
+    }
+    if (initPC != fg->getInitPC() || nodeCount != fg->allNodes().size() || edgeCount != staticEdgeCount ||
+        fp != fingerprint || fg->allEdges().size() != staticEdgeCount) {
+        newProgErr() << "Checkpoint " << path << " was written for a different program\n";
+        return false;
+    }
+
+    if (!nextLine() || tokens.size() != 6 || tokens[0] != "N" || !toInt(tokens[1], progress.totalInstCount) ||
+        !toInt(tokens[2], progress.maxStepCount) || !toInt(tokens[3], progress.maxSolverCount) ||
+        !toInt(tokens[4], progress.divergeStateCount) || !toInt(tokens[5], progress.searcherLevel)) {
+        return malformed("bad progress line");
+    }
+
+    /// Records
+
+    StateVector heldStates;
+    vector<State *> states;  // by record index, nullptr for spilled ones
+    unordered_map<int, ConstraintSet> loadedFinalConstraintSets;
+    StringRef issueData;
+    bool ended = false;
+    SubroutineTracker::SubroutineInfo *subroutine = nullptr;
+    vector<SubroutineTracker::SubroutineInfo> subroutines;
+
+    while (!ended && nextLine()) {
+        StringRef tag = tokens[0];
+        if (tag == "D") {
+            Node *from, *to;
+            int type;
+            if (tokens.size() != 4 || !toNode(tokens[1], from) || !toNode(tokens[2], to) || !toInt(tokens[3], type)) {
+                return malformed("bad edge");
+            }
+            fg->newEdge(from, to, (Edge::Type) type);
+
+        } else if (tag == "E") {
+            Edge *edge, *associatedEdge;
+            unsigned covered, flags, isImproperRET;
+            if (tokens.size() != 6 || !toEdge(tokens[1], edge) || edge == nullptr || !toInt(tokens[2], covered) ||
+                !toInt(tokens[3], flags) || !toInt(tokens[4], isImproperRET) || !toEdge(tokens[5], associatedEdge)) {
+                return malformed("bad edge state");
+            }
+            edge->covered = covered;
+            edge->flags = flags;
+            edge->isImproperRET = isImproperRET;
+            edge->associatedEdge = associatedEdge;
+
+        } else if (tag == "V") {
+            Node *node;
+            unsigned subroutineEntry, possibleRETPoint;
+            if (tokens.size() < 4 || !toNode(tokens[1], node) || node == nullptr ||
+                !toInt(tokens[2], subroutineEntry) || !toInt(tokens[3], possibleRETPoint)) {
+                return malformed("bad node state");
+            }
+            node->subroutineEntry = subroutineEntry;
+            node->possibleRETPoint = possibleRETPoint;
+            node->subroutineColors.clear();
+            for (size_t i = 4; i < tokens.size(); i++) {
+                uint16_t color;
+                if (!toInt(tokens[i], color)) return malformed("bad node color");
+                node->subroutineColors.insert(color);
+            }
+
+        } else if (tag == "T") {
+            subroutines.emplace_back();
+            subroutine = &subroutines.back();
+            if (tokens.size() != 4 || !toInt(tokens[1], subroutine->color) || !toNode(tokens[2], subroutine->entry)) {
+                return malformed("bad subroutine");
+            }
+            subroutine->name = tokens[3].str();
+
+        } else if (tag == "TX" && subroutine != nullptr) {
+            for (size_t i = 1; i < tokens.size(); i++) {
+                Node *exit;
+                if (!toNode(tokens[i], exit) || exit == nullptr) return malformed("bad subroutine exit");
+                subroutine->exits.push_back(exit);
+            }
+
+        } else if (tag == "TP" && subroutine != nullptr) {
+            for (size_t i = 1; i < tokens.size(); i++) {
+                StringRef entryToken, exitTokens;
+                std::tie(entryToken, exitTokens) = tokens[i].split(':');
+                Edge *entryEdge;
+                if (!toEdge(entryToken, entryEdge) || entryEdge == nullptr) return malformed("bad entry edge");
+                auto &exitEdges = subroutine->eePairs[entryEdge];
+                SmallVector<StringRef, 4> exitTokenList;
+                exitTokens.split(exitTokenList, ',', -1, false);
+                for (const auto &exitToken : exitTokenList) {
+                    Edge *exitEdge;
+                    if (!toEdge(exitToken, exitEdge) || exitEdge == nullptr) return malformed("bad exit edge");
+                    exitEdges.push_back(exitEdge);
+                }
+            }
+
+        } else if (tag == "H") {
+            size_t size;
+            StringRef blob;
+            if (tokens.size() != 2 || !toInt(tokens[1], size) || !nextBlob(size, blob)) {
+                return malformed("bad searcher progress");
+            }
+            if (!searcher->loadProgress(blob)) return malformed("searcher progress does not match the searcher");
+
+        } else if (tag == "X") {
+            size_t size;
+            StringRef blob;
+            if (tokens.size() != 3 || !toInt(tokens[1], size) || !nextBlob(size, blob)) {
+                return malformed("bad state");
+            }
+            if (tokens[2] == "S" && stateSpiller) {
+                if (!stateSpiller->adopt(blob)) return false;
+                states.push_back(nullptr);
+                continue;
+            }
+            State *s = serializer->deserialize(blob, path);
+            if (s == nullptr) return malformed("bad state record " + llvm::Twine(states.size()));
+            states.push_back(s);
+            if (tokens[2] != "I") heldStates.push_back(s);
+
+        } else if (tag == "F") {
+            int index;
+            size_t size;
+            StringRef blob;
+            if (tokens.size() != 3 || !toInt(tokens[1], index) || !toInt(tokens[2], size) || !nextBlob(size, blob) ||
+                !serializer->deserializeConstraints(blob, path, loadedFinalConstraintSets[index])) {
+                return malformed("bad final constraints");
+            }
+
+        } else if (tag == "I") {
+            size_t size;
+            if (tokens.size() != 2 || !toInt(tokens[1], size) || !nextBlob(size, issueData)) {
+                return malformed("bad issues");
+            }
+
+        } else if (tag == "END") {
+            ended = true;
+
+        } else {
+            return malformed("unknown record " + tag);
+        }
+    }
+    if (!ended) return malformed("truncated");
+
+    auto stateByIndex = [&](int index) -> State * {
+        return (index >= 0 && index < (int) states.size()) ? states[index] : nullptr;
+    };
+
+    for (const auto &it : loadedFinalConstraintSets) {
+        State *s = stateByIndex(it.first);
+        if (s == nullptr) return malformed("final constraints of unknown state");
+        (*finalConstraintSets)[s] = it.second;
+    }
+
+    issuePackage->clearIssues();  // the ones raised before exploration are in the checkpoint as well
+    if (!issuePackage->mergeSerialized(issueData, mem, stateByIndex)) return malformed("bad issues");
+
+    for (const auto &info : subroutines) subroutineTracker->restoreSubroutine(info);
+    coverageTracker->recountCoverage();
+    searcher->restore(heldStates);
+    return true;
+}
+
+}
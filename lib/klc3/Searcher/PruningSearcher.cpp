@@ -21,7 +21,7 @@ PruningSearcher::PruningSearcher(const FlowGraph *fg, Searcher *internalSearcher
     for (auto &loop : allLoops) {
         uncoveredLoops[loop] = LoopInfo(loop);
     }
-    time_t seed = std::time(nullptr);
+    unsigned seed = getSearcherSeed();
     progInfo() << "PruningSearcher: seed " << seed << "\n";
     std::srand(seed);
 }
@@ -83,6 +83,7 @@ void PruningSearcher::push(const StateVector &states) {
                 s->avoidLoopReductionPostpone = true;  // it will never get postponed later
             } else {
                 postponedStates.push_back(s);
+                s->postponed = true;
                 statPostponeCount++;
 #if PRUNING_SEARCHER_ECHO_POSTPONE
                 if (onEdge->to) progInfo() << "Postpone S" << s->getUID() << " at " << onEdge->to->inst->sourceContext() << "\n";
@@ -334,6 +335,128 @@ StateVector PruningSearcher::getNormalStates() const {
     return ret;
 }
 
+StateVector PruningSearcher::evict(size_t count, const std::function<bool(const State *)> &canEvict) {
+    // Postponed states have the lowest priority
+    StateVector ret;
+    evictFromFront(postponedStates, count, canEvict, ret);
+    if (ret.size() < count) {
+        StateVector more = internalSearcher->evict(count - ret.size(), canEvict);
+        ret.append(more.begin(), more.end());
+    }
+    return ret;
+}
+
+void PruningSearcher::restore(const StateVector &states) {
+    StateVector statesToGoThrough;
+    for (const auto &s : states) {
+        if (s->postponed) {
+            postponedStates.push_back(s);
+        } else {
+            statesToGoThrough.push_back(s);
+        }
+    }
+    if (!statesToGoThrough.empty()) {
+        internalSearcher->restore(statesToGoThrough);
+    }
+}
+
+StateVector PruningSearcher::getHeldStates() const {
+    StateVector ret = internalSearcher->getHeldStates();
+    ret.append(postponedStates.begin(), postponedStates.end());
+    return ret;
+}
+
+/*
+ * Progress format:
+ *   <statPostponeCount> <statReactivateCount> <startedFetchingPostponedStates>
+ *   L <loop entry addr>                  one for each uncovered loop, followed by its uncovered segments
+ *   H <edge index> ...                   an uncovered H2H segment
+ *   X <edge index> ...                   an uncovered H2X segment
+ * Segments are identified by edges rather than by their order in the sets, which depends on addresses of the edges.
+ */
+
+void PruningSearcher::saveProgress(llvm::raw_ostream &out) const {
+    out << statPostponeCount << " " << statReactivateCount << " " << startedFetchingPostponedStates << "\n";
+    for (const auto &it : uncoveredLoops) {
+        out << "L " << it.first->entryNode()->addr() << "\n";
+        for (const auto &seg : it.second.uncoveredH2HSegments) {
+            out << "H";
+            for (const auto &edge : seg) out << " " << edge->index();
+            out << "\n";
+        }
+        for (const auto &seg : it.second.uncoveredH2XSegments) {
+            out << "X";
+            for (const auto &edge : seg) out << " " << edge->index();
+            out << "\n";
+        }
+    }
+}
+
+bool PruningSearcher::loadProgress(StringRef data) {
+    StringRef line;
+    std::tie(line, data) = data.split('\n');
+    SmallVector<StringRef, 3> stats;
+    line.split(stats, ' ');
+    if (stats.size() != 3 || stats[0].getAsInteger(10, statPostponeCount) ||
+        stats[1].getAsInteger(10, statReactivateCount)) {
+        return false;
+    }
+    startedFetchingPostponedStates = (stats[2] == "1");
+
+    unordered_map<int, Loop *> loopByEntryAddr;
+    for (const auto &it : uncoveredLoops) loopByEntryAddr[it.first->entryNode()->addr()] = it.first;
+
+    unordered_map<Loop *, LoopInfo> loadedLoops;
+    LoopInfo *info = nullptr;
+    map<vector<unsigned>, const Path *> h2hByEdges, h2xByEdges;  // segments of the current loop
+    while (!data.empty()) {
+        std::tie(line, data) = data.split('\n');
+        SmallVector<StringRef, 16> tokens;
+        line.split(tokens, ' ', -1, false);
+        if (tokens.size() < 2) return false;
+
+        if (tokens[0] == "L") {
+            int addr;
+            if (tokens[1].getAsInteger(10, addr) || loopByEntryAddr.find(addr) == loopByEntryAddr.end()) return false;
+            Loop *loop = loopByEntryAddr[addr];
+            info = &loadedLoops[loop];
+            *info = LoopInfo(loop);
+            info->uncoveredH2HSegments.clear();
+            info->uncoveredH2XSegments.clear();
+            h2hByEdges.clear();
+            h2xByEdges.clear();
+            for (const auto &seg : loop->h2hSegments()) {
+                vector<unsigned> edges;
+                for (const auto &edge : seg) edges.push_back(edge->index());
+                h2hByEdges[edges] = &seg;
+            }
+            for (const auto &seg : loop->h2xSegments()) {
+                vector<unsigned> edges;
+                for (const auto &edge : seg) edges.push_back(edge->index());
+                h2xByEdges[edges] = &seg;
+            }
+
+        } else if ((tokens[0] == "H" || tokens[0] == "X") && info != nullptr) {
+            vector<unsigned> edges(tokens.size() - 1);
+            for (size_t i = 1; i < tokens.size(); i++) {
+                if (tokens[i].getAsInteger(10, edges[i - 1])) return false;
+            }
+            auto &segments = (tokens[0] == "H" ? h2hByEdges : h2xByEdges);
+            auto it = segments.find(edges);
+            if (it == segments.end()) return false;
+            if (tokens[0] == "H") info->uncoveredH2HSegments.insert(*it->second);
+            else info->uncoveredH2XSegments.insert(*it->second);
+
+        } else {
+            return false;
+        }
+    }
+
+    // Loops not written are all covered
+    uncoveredLoops = std::move(loadedLoops);
+    return true;
+}
+
 State *PruningSearcher::fetch() {
     State *ret = fetchOneState();
     return ret;
@@ -360,6 +483,7 @@ State *PruningSearcher::fetchOneState() {
             timedInfo() << "Reactivate one state at " << ret->latestNonOSInst[0]->sourceContext() << "\n";
         }
 #endif
+        ret->postponed = false;
         ret->avoidLoopReductionPostpone = true;
         return ret;
     } else {
@@ -11,4 +11,17 @@
 
 namespace klc3 {
 
+extern llvm::cl::OptionCategory KLC3ExecutionCat;
+
+llvm::cl::opt<unsigned> SearcherSeed(
+        "seed",
+        llvm::cl::desc("Seed for searchers that make random choices, such as picking postponed states in "
+                       "PruningSearcher. 0 to use the current time (default=0)"),
+        llvm::cl::init(0),
+        llvm::cl::cat(KLC3ExecutionCat));
+
+unsigned getSearcherSeed() {
+    return SearcherSeed != 0 ? (unsigned) SearcherSeed : (unsigned) std::time(nullptr);
+}
+
 }
\ No newline at end of file
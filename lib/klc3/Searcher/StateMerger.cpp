@@ -0,0 +1,361 @@
+//
+// Created by liuzikai on 10/17/26.
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+
+#include "klc3/Searcher/StateMerger.h"
+
+#include "klee/Expr/ExprHashMap.h"
+
+#include <climits>
+
+namespace klc3 {
+
+StateMerger::StateMerger(ExprBuilder *builder, Executor *executor, const FlowGraph *flowGraph)
+        : WithBuilder(builder), executor(executor) {
+    computeJoinNodes(flowGraph);
+}
+
+void StateMerger::computeJoinNodes(const FlowGraph *flowGraph) {
+    const vector<Node *> &nodes = flowGraph->allNodes();
+    const unsigned exitIndex = nodes.size();  // virtual exit of subroutines
+    unordered_map<const Node *, unsigned> indexOf;
+    for (unsigned i = 0; i < nodes.size(); i++) indexOf[nodes[i]] = i;
+
+    // Successors within the subroutine
+    vector<vector<unsigned>> successors(nodes.size() + 1), predecessors(nodes.size() + 1);
+    for (unsigned i = 0; i < nodes.size(); i++) {
+        for (const Edge *e : nodes[i]->allOutEdges()) {
+            switch (e->type()) {
+                case Edge::NORMAL_EDGE:
+                case Edge::SUBROUTINE_VIRTUAL_EDGE:  // step over JSR
+                case Edge::TRAP_VIRTUAL_EDGE:  // to nullptr for HALT
+                    successors[i].push_back(e->to() ? indexOf[e->to()] : exitIndex);
+                    break;
+                default:
+                    // JSR_EDGE is covered by SUBROUTINE_VIRTUAL_EDGE and RET_EDGE leaves the subroutine. The others
+                    // are either dynamic or non-runtime ones.
+                    break;
+            }
+        }
+        if (successors[i].empty()) successors[i].push_back(exitIndex);  // RET, JMP and JSRR
+        for (unsigned j : successors[i]) predecessors[j].push_back(i);
+    }
+
+    // Post-dominators are dominators on the reverse graph, rooted at the exit. Compute them with the iterative
+    // algorithm of Cooper, Harvey and Kennedy, which needs postorder numbers of the reverse graph.
+    vector<int> postorderNumber(nodes.size() + 1, -1);
+    vector<unsigned> postorder;
+    {
+        vector<bool> visited(nodes.size() + 1, false);
+        vector<pair<unsigned, unsigned>> dfsStack;  // node, index of the next predecessor
+        visited[exitIndex] = true;
+        dfsStack.emplace_back(exitIndex, 0);
+        while (!dfsStack.empty()) {
+            unsigned v = dfsStack.back().first;
+            unsigned &next = dfsStack.back().second;
+            if (next < predecessors[v].size()) {
+                unsigned u = predecessors[v][next++];
+                if (!visited[u]) {
+                    visited[u] = true;
+                    dfsStack.emplace_back(u, 0);
+                }
+            } else {
+                postorderNumber[v] = (int) postorder.size();
+                postorder.push_back(v);
+                dfsStack.pop_back();
+            }
+        }
+    }
+
+    const unsigned UNDEFINED = UINT_MAX;
+    vector<unsigned> ipdom(nodes.size() + 1, UNDEFINED);
+    ipdom[exitIndex] = exitIndex;
+    auto intersect = [&](unsigned a, unsigned b) {
+        while (a != b) {
+            while (postorderNumber[a] < postorderNumber[b]) a = ipdom[a];
+            while (postorderNumber[b] < postorderNumber[a]) b = ipdom[b];
+        }
+        return a;
+    };
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto it = postorder.rbegin(); it != postorder.rend(); ++it) {
+            unsigned v = *it;
+            if (v == exitIndex) continue;
+            unsigned newIpdom = UNDEFINED;
+            for (unsigned s : successors[v]) {
+                if (ipdom[s] == UNDEFINED) continue;  // not processed yet, or can't reach the exit
+                newIpdom = (newIpdom == UNDEFINED ? s : intersect(s, newIpdom));
+            }
+            if (newIpdom != ipdom[v]) {
+                ipdom[v] = newIpdom;
+                changed = true;
+            }
+        }
+    }
+
+    for (unsigned i = 0; i < nodes.size(); i++) {
+        const Node *node = nodes[i];
+        if (node->inst().isNull() || node->inst()->instID() != InstValue::BR) continue;
+        if (ipdom[i] == UNDEFINED || ipdom[i] == exitIndex) continue;  // branches never meet in the subroutine
+        joinNodes[node] = nodes[ipdom[i]];
+    }
+}
+
+void StateMerger::update(State *parent, StateVector &result) {
+    RegionStack parentRegions;
+    auto it = regionsOf.find(parent->getUID());
+    if (it != regionsOf.end()) parentRegions = it->second;
+
+    // Forked states are members of regions of the parent
+    if (!parentRegions.empty()) {
+        for (State *s : result) {
+            if (s == parent) continue;
+            for (auto &region : parentRegions) region->aliveCount++;
+            regionsOf[s->getUID()] = parentRegions;
+        }
+    }
+
+    // A symbolic BR opens a new region
+    if (result.size() > 1) {
+        const ref<InstValue> &inst = parent->latestInst[0];
+        if (!inst.isNull() && inst->instID() == InstValue::BR && inst->node != nullptr) {
+            auto joinIt = joinNodes.find(inst->node);
+            if (joinIt != joinNodes.end()) {
+                auto region = std::make_shared<Region>();
+                region->join = joinIt->second;
+                region->depth = parent->jsrStack.size();
+                for (State *s : result) {
+                    regionsOf[s->getUID()].push_back(region);
+                    region->aliveCount++;
+                }
+                regionCount++;
+            }
+        }
+    }
+
+    if (regionsOf.empty()) return;  // fast path, not in any region
+
+    StateVector released;
+    vector<std::shared_ptr<Region>> dirtyRegions;
+    for (State *s : result) process(s, released, dirtyRegions);
+    while (!dirtyRegions.empty()) {
+        std::shared_ptr<Region> region = std::move(dirtyRegions.back());
+        dirtyRegions.pop_back();
+        if (!region->held.empty() && region->held.size() == (size_t) region->aliveCount) {
+            complete(region, released, dirtyRegions);
+        }
+    }
+    result = std::move(released);
+}
+
+void StateMerger::process(State *s, StateVector &released, vector<std::shared_ptr<Region>> &dirtyRegions) {
+    auto it = regionsOf.find(s->getUID());
+    if (it == regionsOf.end()) {
+        released.push_back(s);
+        return;
+    }
+    RegionStack &regions = it->second;
+
+    // Leave regions of subroutines that have returned, or all regions if the state terminates
+    size_t depth = s->jsrStack.size();
+    while (!regions.empty() && (s->status != State::NORMAL || regions.back()->depth > depth)) {
+        regions.back()->aliveCount--;
+        dirtyRegions.push_back(regions.back());
+        regions.pop_back();
+    }
+    if (regions.empty()) {
+        regionsOf.erase(it);
+        released.push_back(s);
+        return;
+    }
+
+    const std::shared_ptr<Region> &region = regions.back();
+    if (region->depth == depth && s->getPC() == region->join->addr()) {
+        region->held.push_back(s);
+        heldStateCount++;
+        dirtyRegions.push_back(region);
+    } else {
+        released.push_back(s);
+    }
+}
+
+void StateMerger::complete(const std::shared_ptr<Region> &region, StateVector &released,
+                           vector<std::shared_ptr<Region>> &dirtyRegions) {
+    StateVector survivors;
+    for (State *s : region->held) {
+        heldStateCount--;
+        bool merged = false;
+        for (State *survivor : survivors) {
+            if (canMerge(survivor, s) && merge(survivor, s)) {
+                merged = true;
+                break;
+            }
+        }
+        if (!merged) {
+            survivors.push_back(s);
+            continue;
+        }
+
+        // Merged into another state, leave all regions and release it
+        auto it = regionsOf.find(s->getUID());
+        for (auto &r : it->second) {
+            if (r == region) continue;
+            r->aliveCount--;
+            dirtyRegions.push_back(r);
+        }
+        regionsOf.erase(it);
+        executor->releaseState(s);
+        mergedStateCount++;
+    }
+    region->held.clear();
+    region->aliveCount = 0;
+
+    // The rest continue in the enclosing regions
+    for (State *s : survivors) {
+        auto it = regionsOf.find(s->getUID());
+        assert(it != regionsOf.end() && it->second.back() == region && "Held state not in the region");
+        it->second.pop_back();
+        process(s, released, dirtyRegions);
+    }
+}
+
+StateVector StateMerger::flush() {
+    StateVector ret;
+    std::unordered_set<Region *> visited;
+    for (auto &it : regionsOf) {
+        for (auto &region : it.second) {
+            if (!visited.insert(region.get()).second) continue;
+            ret.append(region->held.begin(), region->held.end());
+            region->held.clear();
+        }
+    }
+    regionsOf.clear();
+    heldStateCount = 0;
+    if (!ret.empty()) flushCount++;
+    return ret;
+}
+
+bool StateMerger::canMerge(const State *a, const State *b) {
+    if (a->status != State::NORMAL || b->status != State::NORMAL) return false;
+    if (a->triggerNewIssue || b->triggerNewIssue) return false;  // referred to by issues
+    if (a->getPC() != b->getPC() || a->getCCSrcReg() != b->getCCSrcReg()) return false;
+    if (a->stackHasMessedUp != b->stackHasMessedUp) return false;
+    if (a->lc3Out.size() != b->lc3Out.size()) return false;
+    if (!a->memRegionUpdates.empty() || !b->memRegionUpdates.empty()) return false;  // regions not in mem yet
+
+    // Copying the stacks is O(1)
+    if (a->jsrStack.size() != b->jsrStack.size() || a->colorStack.size() != b->colorStack.size()) return false;
+    auto jsrStackA = a->jsrStack, jsrStackB = b->jsrStack;
+    for (; !jsrStackA.empty(); jsrStackA.pop(), jsrStackB.pop()) {
+        if (jsrStackA.top() != jsrStackB.top()) return false;
+    }
+    auto colorStackA = a->colorStack, colorStackB = b->colorStack;
+    for (; !colorStackA.empty(); colorStackA.pop(), colorStackB.pop()) {
+        if (colorStackA.top() != colorStackB.top()) return false;
+    }
+
+    // Uninitialized registers and memory are tracked by null values, which can't be selected
+    for (int r = R_R0; r <= R_R7; r++) {
+        if (a->getReg((Reg) r).isNull() != b->getReg((Reg) r).isNull()) return false;
+    }
+    if (a->memStoringUninitReg.size() != b->memStoringUninitReg.size()) return false;
+    for (const auto &it : a->memStoringUninitReg) {
+        if (b->memStoringUninitReg.find(it.first) == b->memStoringUninitReg.end()) return false;
+    }
+    bool memCompatible = true;
+    a->mem.forEachDifference(b->mem, [&](uint16_t, const ref<MemValue> &va, const ref<MemValue> &vb) {
+        if (va.get() == vb.get()) return;
+        if (va.isNull() || vb.isNull() ||  // unspecified
+            va->type != MemValue::MEM_DATA || vb->type != MemValue::MEM_DATA ||
+            va->e.isNull() != vb->e.isNull()) {
+            memCompatible = false;
+        }
+    });
+    return memCompatible;
+}
+
+namespace {
+
+bool sameExpr(const ref<Expr> &a, const ref<Expr> &b) {
+    if (a.get() == b.get()) return true;
+    if (a.isNull() || b.isNull()) return false;
+    return a->compare(*b) == 0;
+}
+
+}
+
+bool StateMerger::merge(State *a, const State *b) {
+
+    // Split constraints into the common ones and the path conditions of each
+    klee::ExprHashSet constraintsA(a->constraints.begin(), a->constraints.end());
+    klee::ExprHashSet constraintsB(b->constraints.begin(), b->constraints.end());
+    vector<ref<Expr>> commonConstraints;
+    ref<Expr> condA = builder->True();
+    ref<Expr> condB = builder->True();
+    for (const auto &c : a->constraints) {
+        if (constraintsB.count(c)) commonConstraints.push_back(c);
+        else condA = builder->And(condA, c);
+    }
+    for (const auto &c : b->constraints) {
+        if (!constraintsA.count(c)) condB = builder->And(condB, c);
+    }
+    if (condA->isTrue() || condB->isTrue()) return false;  // can't select between them
+
+    // Collect values that differ before touching a
+    array<ref<Expr>, 8> regs;
+    for (int r = R_R0; r <= R_R7; r++) {
+        ref<Expr> ra = a->getReg((Reg) r), rb = b->getReg((Reg) r);
+        if (sameExpr(ra, rb)) continue;
+        if (ra->getWidth() != rb->getWidth()) return false;
+        regs[r] = builder->Select(condA, ra, rb);
+    }
+
+    bool widthMatched = true;
+    vector<pair<uint16_t, ref<Expr>>> memValues;
+    a->mem.forEachDifference(b->mem, [&](uint16_t addr, const ref<MemValue> &va, const ref<MemValue> &vb) {
+        if (va.get() == vb.get() || sameExpr(va->e, vb->e)) return;  // including uninitialized bits in both
+        if (va->e->getWidth() != vb->e->getWidth()) {
+            widthMatched = false;
+            return;
+        }
+        memValues.emplace_back(addr, builder->Select(condA, va->e, vb->e));
+    });
+    if (!widthMatched) return false;
+
+    vector<pair<size_t, ref<Expr>>> outValues;
+    {
+        size_t i = 0;
+        for (auto itA = a->lc3Out.begin(), itB = b->lc3Out.begin(); itA != a->lc3Out.end(); ++itA, ++itB, ++i) {
+            if (sameExpr(*itA, *itB)) continue;
+            if ((*itA)->getWidth() != (*itB)->getWidth()) return false;
+            outValues.emplace_back(i, builder->Select(condA, *itA, *itB));
+        }
+    }
+
+    // Apply
+    ConstraintSet mergedConstraints;
+    ConstraintManager constraintManager(mergedConstraints);
+    for (const auto &c : commonConstraints) constraintManager.addConstraint(c);
+    constraintManager.addConstraint(builder->Or(condA, condB));
+    a->constraints = mergedConstraints;
+
+    for (int r = R_R0; r <= R_R7; r++) {
+        if (!regs[r].isNull()) a->setReg((Reg) r, regs[r]);
+    }
+    for (const auto &it : memValues) a->mem.writeData(it.first, it.second);
+    a->memRegionUpdates.clear();  // rebuilt from the merged memory
+    for (const auto &it : outValues) a->lc3Out[it.first] = it.second;
+
+    a->stepCount = std::max(a->stepCount, b->stepCount);
+    a->solverCount = std::max(a->solverCount, b->solverCount);
+    a->coveredNewEdge |= b->coveredNewEdge;
+
+    return true;
+}
+
+}
@@ -0,0 +1,365 @@
+//
+// Created by liuzikai on 10/17/26.
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+
+#include "klc3/Searcher/StateSerializer.h"
+
+#include "klee/Expr/ExprPPrinter.h"
+#include "klee/Expr/Parser/Parser.h"
+
+#include "llvm/Support/MemoryBuffer.h"
+
+namespace klc3 {
+
+/*
+ * Record of a state. "$" stands for the next value of the kquery, "-" for null.
+ *   S <stepCount> <solverCount> <PC> <CC source reg> <stackHasMessedUp> <coveredNewEdge> <coveredNewSegment>
+ *     <avoidLoopReductionPostpone> <postponed> <status> <triggerNewIssue>
+ *   R <R0> ... <R7> <IR>                    #<value> for a concrete register
+ *   L <latestInst x2> <latestNonOSInst x2>  instructions as addresses
+ *   C <regChangeLocation x NUM_REGS> <ccChangeLocation>
+ *   U <addr>:<reg>:<inst> ...               memStoringUninitReg
+ *   O <expr> ...                            lc3Out
+ *   P <edge index> ...                      statePath
+ *   K <color> ...                           colorStack from the bottom
+ *   J <node addr> ...                       jsrStack from the bottom
+ *   Q <loop entry addr> <loop color> <edge index> ...   one line per LoopLayer from the outermost
+ *   M <addr>:<forRead | forWrite << 1>:<expr> ...       memory written by the program, with the words of regions
+ *                                                       written at symbolic addresses brought up to date
+ *   E
+ *   <kquery of the constraints, with the values>
+ */
+
+namespace {
+
+template<class T, class Container>
+vector<T> stackToVector(stack<T, Container> s) {
+    vector<T> ret(s.size());
+    for (size_t i = ret.size(); i > 0; i--) {
+        ret[i - 1] = s.top();
+        s.pop();
+    }
+    return ret;
+}
+
+/**
+ * A kquery parsed with arrays created in the given ArrayCache, so that they are the same arrays as the ones in other
+ * states. The parsed expressions are valid after the declarations are released.
+ */
+struct ParsedQuery {
+    std::unique_ptr<llvm::MemoryBuffer> buffer;
+    std::unique_ptr<klee::expr::Parser> parser;
+    vector<std::unique_ptr<klee::expr::Decl>> decls;
+
+    klee::expr::QueryCommand *parse(StringRef data, const string &name, ExprBuilder *builder,
+                                    klee::ArrayCache *arrayCache) {
+        buffer = llvm::MemoryBuffer::getMemBuffer(data, name, false);
+        parser.reset(klee::expr::Parser::Create(name, buffer.get(), builder, arrayCache, false));
+        klee::expr::QueryCommand *query = nullptr;
+        while (klee::expr::Decl *decl = parser->ParseTopLevelDecl()) {
+            decls.emplace_back(decl);
+            if (auto *qc = dyn_cast<klee::expr::QueryCommand>(decl)) query = qc;
+        }
+        return parser->GetNumErrors() > 0 ? nullptr : query;
+    }
+};
+
+}
+
+StateSerializer::StateSerializer(Executor *executor, ExprBuilder *builder, klee::ArrayCache *arrayCache,
+                                 IssuePackage *issuePackage, const FlowGraph *fg, const set<Loop *> &allLoops)
+        : executor(executor), builder(builder), arrayCache(arrayCache), issuePackage(issuePackage), fg(fg) {
+    for (const auto &loop : allLoops) {
+        loopByEntryAddr[loop->entryNode()->addr()] = loop;
+    }
+}
+
+string StateSerializer::serialize(const State *s) const {
+    string data;
+    llvm::raw_string_ostream os(data);
+
+    vector<ref<Expr>> values;
+    auto writeExpr = [&](const ref<Expr> &e) {
+        if (e.isNull()) {
+            os << " -";
+        } else {
+            os << " $";
+            values.push_back(e);
+        }
+    };
+    auto writeInst = [&](const ref<InstValue> &inst) {
+        if (inst.isNull()) os << " -";
+        else os << " " << inst->addr;
+    };
+
+    os << "S " << s->stepCount << " " << s->solverCount << " " << s->getPC() << " " << (int) s->getCCSrcReg() << " "
+       << s->stackHasMessedUp << " " << s->coveredNewEdge << " " << s->coveredNewSegment << " "
+       << s->avoidLoopReductionPostpone << " " << s->postponed << " " << (int) s->status << " "
+       << s->triggerNewIssue << "\n";
+
+    os << "R";
+    for (int i = R_R0; i <= R_R7; i++) {
+        uint16_t value;
+        if (s->getConcreteReg((Reg) i, value)) {
+            os << " #" << value;
+        } else {
+            writeExpr(s->getReg((Reg) i));
+        }
+    }
+    writeExpr(s->getIR());
+    os << "\n";
+
+    os << "L";
+    for (const auto &inst : s->latestInst) writeInst(inst);
+    for (const auto &inst : s->latestNonOSInst) writeInst(inst);
+    os << "\n";
+
+    os << "C";
+    for (const auto &inst : s->regChangeLocation) writeInst(inst);
+    writeInst(s->ccChangeLocation);
+    os << "\n";
+
+    os << "U";
+    for (const auto &it : s->memStoringUninitReg) {
+        os << " " << it.first << ":" << (int) it.second.first << ":";
+        if (it.second.second.isNull()) os << "-";
+        else os << it.second.second->addr;
+    }
+    os << "\n";
+
+    os << "O";
+    for (const auto &e : s->lc3Out) writeExpr(e);
+    os << "\n";
+
+    os << "P";
+    for (const auto &edge : s->statePath) os << " " << edge->index();
+    os << "\n";
+
+    os << "K";
+    for (const auto &color : stackToVector(s->colorStack)) os << " " << color;
+    os << "\n";
+
+    os << "J";
+    for (const auto &node : stackToVector(s->jsrStack)) {
+        if (node == nullptr) os << " -";
+        else os << " " << node->addr();
+    }
+    os << "\n";
+
+    for (const auto &layer : s->loopStack) {
+        os << "Q " << layer.loop->entryNode()->addr() << " " << layer.loopColor;
+        for (const auto &edge : layer.loopPathFromEntry) os << " " << edge->index();
+        os << "\n";
+    }
+
+    map<uint16_t, ref<Expr>> regionWords;
+    executor->getMemRegionWords(s, regionWords);
+    os << "M";
+    for (const auto &val : s->mem.writtenValues()) {
+        if (regionWords.find(val->addr) != regionWords.end()) continue;  // written below
+        const auto *dataVal = dyn_cast<DataValue>(val.get());
+        assert(dataVal && "Only data is written by the program");
+        os << " " << val->addr << ":" << (dataVal->forRead | (dataVal->forWrite << 1)) << ":";
+        if (val->e.isNull()) {
+            os << "-";
+        } else {
+            os << "$";
+            values.push_back(val->e);
+        }
+    }
+    for (const auto &it : regionWords) {
+        os << " " << it.first << ":0:$";
+        values.push_back(it.second);
+    }
+    os << "\n";
+
+    os << "E\n";
+    klee::ExprPPrinter::printQuery(os, s->constraints, ConstantExpr::alloc(0, Expr::Bool),
+                                   values.data(), values.data() + values.size());
+    os.flush();
+    return data;
+}
+
+State *StateSerializer::deserialize(StringRef data, const string &name, const vector<Edge *> *edges) const {
+    size_t headerEnd = data.find("\nE\n");
+    if (headerEnd == StringRef::npos) return nullptr;
+    StringRef header = data.substr(0, headerEnd + 1);
+
+    ParsedQuery parsed;
+    klee::expr::QueryCommand *query = parsed.parse(data.substr(headerEnd + 3), name, builder, arrayCache);
+    if (query == nullptr) return nullptr;
+
+    bool ok = true;
+    size_t nextValue = 0;
+
+    auto nextLine = [&](char tag) {
+        SmallVector<StringRef, 16> tokens;
+        StringRef line;
+        std::tie(line, header) = header.split('\n');
+        if (line.empty() || line[0] != tag) {
+            ok = false;
+            return tokens;
+        }
+        line.drop_front().split(tokens, ' ', -1, false);
+        return tokens;
+    };
+    auto toInt = [&](StringRef token) {
+        int value = 0;
+        if (token.getAsInteger(10, value)) ok = false;
+        return value;
+    };
+    auto toExpr = [&](StringRef token) -> ref<Expr> {
+        if (token == "-") return nullptr;
+        if (token != "$" || nextValue >= query->Values.size()) {
+            ok = false;
+            return nullptr;
+        }
+        return query->Values[nextValue++];
+    };
+    if (edges == nullptr) edges = &fg->allEdges();
+    auto toEdge = [&](StringRef token) -> Edge * {
+        unsigned index = toInt(token);
+        if (index >= edges->size() || (*edges)[index] == nullptr) {
+            ok = false;
+            return nullptr;
+        }
+        return (*edges)[index];
+    };
+
+    auto sFields = nextLine('S');
+    if (!ok || sFields.size() != 11) return nullptr;
+    State *s = executor->createBlankState(toInt(sFields[2]), issuePackage);
+
+    // Instructions are looked up before restoring the written memory, so they come from the base memory
+    auto toInst = [&](StringRef token) -> ref<InstValue> {
+        if (token == "-") return nullptr;
+        ref<MemValue> val = s->mem.read(toInt(token));
+        if (val.isNull() || val->type != MemValue::MEM_INST) {
+            ok = false;
+            return nullptr;
+        }
+        return dyn_cast<InstValue>(val.get());
+    };
+
+    s->stepCount = toInt(sFields[0]);
+    s->solverCount = toInt(sFields[1]);
+    s->setCC((Reg) toInt(sFields[3]));
+    s->stackHasMessedUp = toInt(sFields[4]);
+    s->coveredNewEdge = toInt(sFields[5]);
+    s->coveredNewSegment = toInt(sFields[6]);
+    s->avoidLoopReductionPostpone = toInt(sFields[7]);
+    s->postponed = toInt(sFields[8]);
+    s->status = (State::Status) toInt(sFields[9]);
+    s->triggerNewIssue = toInt(sFields[10]);
+    s->constraints = ConstraintSet(query->Constraints);
+
+    auto rFields = nextLine('R');
+    if (ok && rFields.size() == 9) {
+        for (int i = R_R0; i <= R_R7; i++) {
+            if (rFields[i].startswith("#")) {
+                s->setReg((Reg) i, (uint16_t) toInt(rFields[i].drop_front()));
+            } else {
+                ref<Expr> e = toExpr(rFields[i]);
+                if (!e.isNull()) s->setReg((Reg) i, e);
+            }
+        }
+        s->setIR(toExpr(rFields[8]));
+    } else ok = false;
+
+    auto lFields = nextLine('L');
+    if (ok && lFields.size() == 2 * State::RECORD_FETCHED_INST_COUNT) {
+        for (unsigned i = 0; i < State::RECORD_FETCHED_INST_COUNT; i++) {
+            s->latestInst[i] = toInst(lFields[i]);
+            s->latestNonOSInst[i] = toInst(lFields[State::RECORD_FETCHED_INST_COUNT + i]);
+        }
+    } else ok = false;
+
+    auto cFields = nextLine('C');
+    if (ok && cFields.size() == NUM_REGS + 1) {
+        for (int i = 0; i < NUM_REGS; i++) s->regChangeLocation[i] = toInst(cFields[i]);
+        s->ccChangeLocation = toInst(cFields[NUM_REGS]);
+    } else ok = false;
+
+    for (const auto &token : nextLine('U')) {
+        SmallVector<StringRef, 3> parts;
+        token.split(parts, ':');
+        if (parts.size() != 3) {
+            ok = false;
+            break;
+        }
+        s->memStoringUninitReg[toInt(parts[0])] = std::make_pair((Reg) toInt(parts[1]), toInst(parts[2]));
+    }
+
+    for (const auto &token : nextLine('O')) s->lc3Out.push_back(toExpr(token));
+
+    for (const auto &token : nextLine('P')) s->statePath.append(toEdge(token));
+
+    for (const auto &token : nextLine('K')) s->colorStack.push(toInt(token));
+
+    for (const auto &token : nextLine('J')) {
+        Node *node = nullptr;
+        if (token != "-") {
+            node = fg->getNodeByAddr(toInt(token));
+            if (node == nullptr) ok = false;
+        }
+        s->jsrStack.push(node);
+    }
+
+    while (ok && header.startswith("Q")) {
+        auto qFields = nextLine('Q');
+        if (qFields.size() < 2) {
+            ok = false;
+            break;
+        }
+        auto it = loopByEntryAddr.find(toInt(qFields[0]));
+        if (it == loopByEntryAddr.end()) {
+            ok = false;
+            break;
+        }
+        State::LoopLayer layer;
+        layer.loop = it->second;
+        layer.loopColor = toInt(qFields[1]);
+        for (size_t i = 2; i < qFields.size(); i++) layer.loopPathFromEntry.append(toEdge(qFields[i]));
+        s->loopStack.emplace_back(std::move(layer));
+    }
+
+    for (const auto &token : nextLine('M')) {
+        SmallVector<StringRef, 3> parts;
+        token.split(parts, ':');
+        if (parts.size() != 3) {
+            ok = false;
+            break;
+        }
+        int flags = toInt(parts[1]);
+        uint16_t addr = toInt(parts[0]);
+        s->mem.write(addr, DataValue::alloc(addr, toExpr(parts[2]), flags & 1, flags & 2));
+    }
+
+    if (!ok || nextValue != query->Values.size()) {
+        executor->releaseState(s);
+        return nullptr;
+    }
+    return s;
+}
+
+
+string StateSerializer::serializeConstraints(const ConstraintSet &constraints) const {
+    string data;
+    llvm::raw_string_ostream os(data);
+    klee::ExprPPrinter::printQuery(os, constraints, ConstantExpr::alloc(0, Expr::Bool));
+    os.flush();
+    return data;
+}
+
+bool StateSerializer::deserializeConstraints(StringRef data, const string &name, ConstraintSet &constraints) const {
+    ParsedQuery parsed;
+    klee::expr::QueryCommand *query = parsed.parse(data, name, builder, arrayCache);
+    if (query == nullptr) return false;
+    constraints = ConstraintSet(query->Constraints);
+    return true;
+}
+
+}
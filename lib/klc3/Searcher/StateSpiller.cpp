@@ -0,0 +1,149 @@
+//
+// Created by liuzikai on 10/17/26.
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+
+#include "klc3/Searcher/StateSpiller.h"
+
+#include "llvm/Support/Errno.h"
+
+#include <unistd.h>
+
+namespace klc3 {
+
+namespace {
+
+bool writeAll(int fd, const char *buf, size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t n = pwrite(fd, buf, size, offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;  // interrupted by SIGALRM
+            return false;
+        }
+        buf += n;
+        size -= n;
+        offset += n;
+    }
+    return true;
+}
+
+bool readAll(int fd, char *buf, size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t n = pread(fd, buf, size, offset);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;  // interrupted by SIGALRM
+            return false;
+        }
+        buf += n;
+        size -= n;
+        offset += n;
+    }
+    return true;
+}
+
+}
+
+StateSpiller::StateSpiller(Executor *executor, const StateSerializer *serializer)
+        : executor(executor), serializer(serializer) {}
+
+StateSpiller::~StateSpiller() {
+    closeFile();
+}
+
+bool StateSpiller::openFile() {
+    SmallString<128> tmpPath;
+    if (std::error_code ec = llvm::sys::fs::createTemporaryFile("klc3-spill", "kquery", fd, tmpPath)) {
+        newProgWarn() << "Failed to create spill file: " << ec.message() << "\n";
+        fd = -1;
+        return false;
+    }
+    path = tmpPath.str().str();
+    fileEnd = 0;
+    return true;
+}
+
+void StateSpiller::closeFile() {
+    if (fd < 0) return;
+    close(fd);
+    llvm::sys::fs::remove(path);
+    fd = -1;
+}
+
+void StateSpiller::reset() {
+    // Do not remove the file, which still holds the states of the main worker
+    if (fd >= 0) close(fd);
+    fd = -1;
+    records.clear();
+    fileEnd = 0;
+    heldEnd = 0;
+}
+
+bool StateSpiller::spill(State *s) {
+    assert(canSpill(s) && "Spilling a state that cannot be spilled");
+    if (fd < 0 && !openFile()) return false;
+
+    if (!appendRecord(serializer->serialize(s))) return false;
+    executor->releaseState(s);
+    totalSpillCount++;
+    return true;
+}
+
+bool StateSpiller::adopt(StringRef data) {
+    if (fd < 0 && !openFile()) return false;
+    return appendRecord(data);
+}
+
+bool StateSpiller::appendRecord(StringRef data) {
+    uint64_t offset = std::max(fileEnd, heldEnd);
+    if (!writeAll(fd, data.data(), data.size(), offset)) {
+        newProgWarn() << "Failed to write spill file " << path << ": " << llvm::sys::StrError(errno) << "\n";
+        return false;
+    }
+    records.emplace_back(offset, data.size());
+    fileEnd = offset + data.size();
+    if (fileEnd > peakFileSize) peakFileSize = fileEnd;
+    return true;
+}
+
+void StateSpiller::setHold(bool hold) {
+    heldEnd = hold ? peakFileSize : 0;
+}
+
+bool StateSpiller::forEachRecord(const std::function<bool(StringRef)> &callback) const {
+    string data;
+    for (const auto &record : records) {
+        data.resize(record.second);
+        if (!readAll(fd, &data[0], data.size(), record.first)) {
+            newProgWarn() << "Failed to read spill file " << path << ": " << llvm::sys::StrError(errno) << "\n";
+            return false;
+        }
+        if (!callback(data)) return false;
+    }
+    return true;
+}
+
+StateVector StateSpiller::reload(size_t count) {
+    StateVector ret;
+    while (ret.size() < count && !records.empty()) {
+        auto record = records.back();
+        records.pop_back();
+        fileEnd = record.first;  // the space is reused by later spills, unless held
+
+        string data(record.second, '\0');
+        State *s = nullptr;
+        if (readAll(fd, &data[0], data.size(), record.first)) {
+            s = serializer->deserialize(data, path);
+        }
+        if (s == nullptr) {
+            newProgWarn() << "Failed to reload a state from spill file " << path << ", the state is lost\n";
+            continue;
+        }
+        ret.push_back(s);
+        totalReloadCount++;
+    }
+    return ret;
+}
+
+}
@@ -0,0 +1,534 @@
+//
+// Created by liuzikai on 10/17/26.
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+
+#include "klc3/Searcher/WorkerPool.h"
+#include "klc3/Searcher/StateSpiller.h"
+
+#include "llvm/Support/Errno.h"
+
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace klc3 {
+
+/*
+ * Messages between the main worker and a child are a tag, a 32-bit payload size and the payload.
+ *
+ * Payload of MSG_STATES:
+ *   <edge count>                     count of edges of the sender
+ *   D <from> <to> <type>             each edge of the sender identified since the split, in the order of creation
+ *   <state count>
+ *   <size>                           followed by a StateSerializer record and a newline, for each state
+ *
+ * Payload of MSG_RESULTS:
+ *   <edge count> and D lines         same as above
+ *   C <edge> ...                     edges covered by the sender
+ *   R <edge> ...                     edges marked as improper RET by the sender
+ *   followed by the serialized IssuePackage
+ *
+ * Nodes are written as addresses ("-" for null), and edges as indices of the sender.
+ */
+
+namespace {
+
+constexpr char MSG_REQUEST = 'R';  // child to main: out of states
+constexpr char MSG_DONATE = 'D';   // main to child: donate some states
+constexpr char MSG_STATES = 'S';   // either way: donated states, empty if the donor has none to give
+constexpr char MSG_QUIT = 'Q';     // main to child: stop exploring
+constexpr char MSG_RESULTS = 'F';  // child to main: issues and coverage at the end
+
+constexpr size_t MAX_DONATION = 256;  // max count of states donated at a time
+constexpr int WAIT_TIMEOUT = 200;     // [ms], for checking shouldStop while waiting for work
+
+bool writeAll(int fd, const char *buf, size_t size) {
+    while (size > 0) {
+        ssize_t n = send(fd, buf, size, MSG_NOSIGNAL);  // no SIGPIPE if the other side has exited
+        if (n < 0) {
+            if (errno == EINTR) continue;  // interrupted by SIGALRM
+            return false;
+        }
+        buf += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool readAll(int fd, char *buf, size_t size) {
+    while (size > 0) {
+        ssize_t n = read(fd, buf, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (n == 0) return false;  // the other side has exited
+        buf += n;
+        size -= n;
+    }
+    return true;
+}
+
+bool sendMessage(int fd, char tag, StringRef payload) {
+    char header[5];
+    header[0] = tag;
+    uint32_t size = payload.size();
+    memcpy(header + 1, &size, sizeof(size));
+    return writeAll(fd, header, sizeof(header)) && writeAll(fd, payload.data(), payload.size());
+}
+
+bool receiveMessage(int fd, char &tag, string &payload) {
+    char header[5];
+    if (!readAll(fd, header, sizeof(header))) return false;
+    tag = header[0];
+    uint32_t size;
+    memcpy(&size, header + 1, sizeof(size));
+    payload.resize(size);
+    return readAll(fd, &payload[0], size);
+}
+
+bool waitReadable(int fd, int timeout) {
+    struct pollfd pfd = {fd, POLLIN, 0};
+    return ::poll(&pfd, 1, timeout) > 0;  // false if interrupted, which the caller handles as a timeout
+}
+
+void writeNode(llvm::raw_ostream &out, const Node *node) {
+    if (node == nullptr) out << " -";
+    else out << " " << node->addr();
+}
+
+}
+
+WorkerPool::WorkerPool(unsigned workerCount, Executor *executor, const StateSerializer *serializer, FlowGraph *fg)
+        : workerCount(workerCount), executor(executor), serializer(serializer), fg(fg) {}
+
+bool WorkerPool::split(const StateVector &normalStates, int allocatedStateCount) {
+    if (!isWaitingToSplit() || normalStates.size() < workerCount) return false;
+    hasSplit = true;
+    splitStateCount = allocatedStateCount;
+    splitEdgeCount = fg->allEdges().size();
+    for (unsigned i = 0; i < normalStates.size(); i++) {
+        stateOwners[normalStates[i]] = i % workerCount;
+    }
+
+    // Avoid buffered output getting duplicated in children
+    llvm::outs().flush();
+    llvm::errs().flush();
+    fflush(nullptr);
+
+    for (unsigned index = 1; index < workerCount; index++) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+            newProgWarn() << "Failed to create socket for worker " << index << ": " << llvm::sys::StrError(errno)
+                          << "\n";
+            break;
+        }
+        int pid = fork();
+        if (pid == -1) {
+            newProgWarn() << "Failed to fork worker " << index << ": " << llvm::sys::StrError(errno) << "\n";
+            close(fds[0]);
+            close(fds[1]);
+            break;
+        }
+        if (pid == 0) {
+            // Child worker
+            close(fds[0]);
+            for (const auto &child : children) close(child.fd);  // sockets of previous siblings
+            children.clear();
+            workerIndex = index;
+            socketToMain = fds[1];
+            return true;
+        }
+        close(fds[1]);
+        Child child;
+        child.pid = pid;
+        child.fd = fds[0];
+        children.emplace_back(std::move(child));
+    }
+
+    // If some workers failed to start, their shares are left to the main worker
+    startedWorkerCount = children.size() + 1;
+    return !children.empty();
+}
+
+bool WorkerPool::isForeign(const State *s) const {
+    if (!hasSplit || s->getUID() >= splitStateCount) return false;
+    unsigned owner;
+    auto it = stateOwners.find(s);
+    if (it != stateOwners.end()) {
+        owner = it->second;
+    } else {
+        owner = (unsigned) s->getUID() % workerCount;
+    }
+    if (owner == workerIndex) return false;
+    return isChild() || owner < startedWorkerCount;
+}
+
+bool WorkerPool::poll(Searcher *searcher) {
+    if (!isSplit()) return true;
+
+    if (isChild()) {
+        char tag;
+        string payload;
+        while (waitReadable(socketToMain, 0)) {
+            if (!receiveMessage(socketToMain, tag, payload)) return false;  // the main worker has exited
+            switch (tag) {
+                case MSG_DONATE:
+                    sendMessage(socketToMain, MSG_STATES, donate(searcher));
+                    break;
+                case MSG_STATES:
+                    searcher->restore(adopt(payload));
+                    break;
+                case MSG_QUIT:
+                    return false;
+                default:
+                    break;
+            }
+        }
+        return true;
+    }
+
+    StateVector adopted;
+    receiveFromChildren(0, adopted);
+    if (!adopted.empty()) searcher->restore(adopted);
+    dispatch(searcher, false);
+    return true;
+}
+
+StateVector WorkerPool::requestWork(const std::function<bool()> &shouldStop) {
+    if (!isSplit()) return {};
+
+    if (isChild()) {
+        if (!sendMessage(socketToMain, MSG_REQUEST, "")) return {};
+        char tag;
+        string payload;
+        while (!shouldStop()) {
+            if (!waitReadable(socketToMain, WAIT_TIMEOUT)) continue;
+            if (!receiveMessage(socketToMain, tag, payload)) return {};
+            switch (tag) {
+                case MSG_DONATE:
+                    sendMessage(socketToMain, MSG_STATES, "");  // nothing to donate
+                    break;
+                case MSG_STATES: {
+                    StateVector states = adopt(payload);
+                    if (!states.empty()) return states;
+                    if (!sendMessage(socketToMain, MSG_REQUEST, "")) return {};  // ask again
+                }
+                    break;
+                case MSG_QUIT:
+                    return {};
+                default:
+                    break;
+            }
+        }
+        return {};
+    }
+
+    StateVector adopted;
+    while (!shouldStop()) {
+        dispatch(nullptr, true);
+
+        bool allIdle = (pendingDonationCount == 0);
+        for (const auto &child : children) {
+            if (!child.finished && !child.waiting) allIdle = false;
+        }
+        if (allIdle) break;
+
+        receiveFromChildren(WAIT_TIMEOUT, adopted);
+        if (!adopted.empty()) return adopted;
+    }
+    quitChildren();
+    return {};
+}
+
+void WorkerPool::sendResults(const IssuePackage &issuePackage) {
+    assert(isChild());
+    string payload;
+    {
+        llvm::raw_string_ostream out(payload);
+        writeEdges(out);
+        out << "C";
+        for (const auto &edge : fg->allEdges()) {
+            if (edge->covered) out << " " << edge->index();
+        }
+        out << "\nR";
+        for (const auto &edge : fg->allEdges()) {
+            if (edge->isImproperRET) out << " " << edge->index();
+        }
+        out << "\n";
+        issuePackage.serialize(out);
+    }
+    sendMessage(socketToMain, MSG_RESULTS, payload);
+    close(socketToMain);
+    socketToMain = -1;
+}
+
+int WorkerPool::collectResults(IssuePackage &issuePackage, const map<uint16_t, ref<MemValue>> &mem,
+                               CoverageTracker *coverageTracker) {
+    assert(!isChild());
+    quitChildren();
+
+    int failedExitCode = 0;
+    for (auto &child : children) {
+        // Drop messages sent before the child stopped
+        char tag;
+        string payload;
+        while (!child.finished) {
+            if (!receiveMessage(child.fd, tag, payload)) {
+                child.finished = true;
+            } else if (tag == MSG_RESULTS) {
+                child.results = std::move(payload);
+                child.finished = true;
+            }
+        }
+        close(child.fd);
+
+        int status;
+        while (waitpid(child.pid, &status, 0) < 0 && errno == EINTR) {}
+        if (failedExitCode == 0) {
+            if (!WIFEXITED(status)) {
+                failedExitCode = -1;
+            } else if (WEXITSTATUS(status) != 0) {
+                failedExitCode = WEXITSTATUS(status);
+            }
+        }
+
+        if (child.results.empty()) continue;  // the worker stopped without results
+        if (!mergeResults(child.results, issuePackage, mem)) {
+            newProgWarn() << "Failed to merge results from worker (pid " << child.pid << "), "
+                          << "some issues or coverage may be lost\n";
+        }
+    }
+    children.clear();
+    coverageTracker->recountCoverage();
+    return failedExitCode;
+}
+
+string WorkerPool::donate(Searcher *searcher) {
+    size_t count = std::min(searcher->getNormalStates().size() / 2, MAX_DONATION);
+    if (count == 0) return "";
+    StateVector states = searcher->evict(count, StateSpiller::canSpill);  // states raised issues can't leave
+    if (states.empty()) return "";
+
+    string payload;
+    llvm::raw_string_ostream out(payload);
+    writeEdges(out);
+    out << states.size() << "\n";
+    for (State *s : states) {
+        string record = serializer->serialize(s);
+        out << record.size() << "\n" << record << "\n";
+        executor->releaseState(s);
+    }
+    out.flush();
+    donatedStateCount += states.size();
+    return payload;
+}
+
+StateVector WorkerPool::adopt(StringRef payload) {
+    StateVector ret;
+    vector<Edge *> edges;
+    StringRef data = payload, line;
+    size_t count = 0;
+    if (readEdges(data, edges)) {
+        std::tie(line, data) = data.split('\n');
+        if (line.getAsInteger(10, count)) count = 0;
+    }
+    size_t failedCount = count;
+    for (size_t i = 0; i < count; i++) {
+        size_t size;
+        std::tie(line, data) = data.split('\n');
+        if (line.getAsInteger(10, size) || data.size() < size + 1) break;
+        State *s = serializer->deserialize(data.substr(0, size), "state from another worker", &edges);
+        data = data.drop_front(size + 1);
+        if (s != nullptr) {
+            ret.push_back(s);
+            failedCount--;
+        }
+    }
+    if (failedCount > 0 || (count == 0 && !payload.empty())) {
+        newProgWarn() << "Failed to read states from another worker, some states may be lost\n";
+    }
+    receivedStateCount += ret.size();
+    return ret;
+}
+
+void WorkerPool::writeEdges(llvm::raw_ostream &out) const {
+    const auto &edges = fg->allEdges();
+    out << edges.size() << "\n";
+    for (size_t i = splitEdgeCount; i < edges.size(); i++) {
+        out << "D";
+        writeNode(out, edges[i]->from());
+        writeNode(out, edges[i]->to());
+        out << " " << (int) edges[i]->type() << "\n";
+    }
+}
+
+bool WorkerPool::readEdges(StringRef &data, vector<Edge *> &edges) {
+    auto toNode = [&](StringRef token, Node *&node) {
+        int addr;
+        if (token == "-") {
+            node = nullptr;
+            return true;
+        }
+        if (token.getAsInteger(10, addr) || addr < 0 || addr > 0xFFFF) return false;
+        node = fg->getNodeByAddr(addr);
+        return node != nullptr;
+    };
+
+    StringRef line;
+    size_t count;
+    std::tie(line, data) = data.split('\n');
+    if (line.getAsInteger(10, count) || count < splitEdgeCount) return false;
+
+    edges.assign(fg->allEdges().begin(), fg->allEdges().begin() + splitEdgeCount);
+    SmallVector<StringRef, 4> tokens;
+    while (edges.size() < count) {
+        std::tie(line, data) = data.split('\n');
+        tokens.clear();
+        line.split(tokens, ' ', -1, false);
+        Node *from, *to;
+        int type;
+        if (tokens.size() != 4 || tokens[0] != "D" || !toNode(tokens[1], from) || !toNode(tokens[2], to) ||
+            tokens[3].getAsInteger(10, type)) {
+            return false;
+        }
+
+        // The same edge may have been identified here as well
+        Edge *edge = nullptr;
+        if (from != nullptr) {
+            for (const auto &e : from->allOutEdges()) {
+                if (e->to() == to && e->type() == type) {
+                    edge = e;
+                    break;
+                }
+            }
+        }
+        if (edge == nullptr) edge = fg->newEdge(from, to, (Edge::Type) type);
+        edges.push_back(edge);
+    }
+    return true;
+}
+
+bool WorkerPool::mergeResults(StringRef data, IssuePackage &issuePackage, const map<uint16_t, ref<MemValue>> &mem) {
+    vector<Edge *> edges;
+    if (!readEdges(data, edges)) return false;
+
+    SmallVector<StringRef, 64> tokens;
+    StringRef line;
+    for (char tag : {'C', 'R'}) {
+        std::tie(line, data) = data.split('\n');
+        tokens.clear();
+        line.split(tokens, ' ', -1, false);
+        if (tokens.empty() || tokens[0] != StringRef(&tag, 1)) return false;
+        for (size_t i = 1; i < tokens.size(); i++) {
+            size_t index;
+            if (tokens[i].getAsInteger(10, index) || index >= edges.size()) return false;
+            if (tag == 'C') edges[index]->covered = true;
+            else edges[index]->isImproperRET = true;
+        }
+    }
+
+    return issuePackage.mergeSerialized(data, mem);
+}
+
+void WorkerPool::receiveFromChildren(int timeout, StateVector &adopted) {
+    vector<struct pollfd> fds;
+    vector<Child *> polledChildren;
+    for (auto &child : children) {
+        if (child.finished) continue;
+        fds.push_back({child.fd, POLLIN, 0});
+        polledChildren.push_back(&child);
+    }
+    if (fds.empty() || ::poll(fds.data(), fds.size(), timeout) <= 0) return;
+
+    char tag;
+    string payload;
+    for (size_t i = 0; i < fds.size(); i++) {
+        if (fds[i].revents == 0) continue;
+        Child &child = *polledChildren[i];
+        if (!receiveMessage(child.fd, tag, payload)) {
+            // Exited without results, for example on a gold program issue
+            child.finished = true;
+            tag = 0;
+        }
+        switch (tag) {
+            case MSG_REQUEST:
+                child.waiting = true;
+                break;
+            case MSG_STATES: {
+                if (payload.empty()) break;  // the child has nothing to donate
+                // Hand them over to a waiting child, or take them over here
+                bool handedOver = false;
+                for (auto &other : children) {
+                    if (other.waiting && !other.finished && sendMessage(other.fd, MSG_STATES, payload)) {
+                        other.waiting = false;
+                        handedOver = true;
+                        break;
+                    }
+                }
+                if (!handedOver) {
+                    StateVector states = adopt(payload);
+                    adopted.insert(adopted.end(), states.begin(), states.end());
+                }
+            }
+                break;
+            case MSG_RESULTS:
+                child.results = std::move(payload);
+                child.finished = true;
+                child.waiting = false;
+                break;
+            default:
+                break;
+        }
+        if ((tag == MSG_STATES || child.finished) && child.asked) {
+            // Replied, or won't reply any more
+            child.asked = false;
+            pendingDonationCount--;
+        }
+    }
+}
+
+void WorkerPool::dispatch(Searcher *searcher, bool selfWaiting) {
+    // Serve waiting children with states of the main worker first
+    if (searcher != nullptr) {
+        for (auto &child : children) {
+            if (!child.waiting || child.finished) continue;
+            string payload = donate(searcher);
+            if (payload.empty()) break;
+            if (sendMessage(child.fd, MSG_STATES, payload)) {
+                child.waiting = false;
+            } else {
+                searcher->restore(adopt(payload));  // the child has exited, take them back
+            }
+        }
+    }
+
+    // Ask busy children to donate to the rest
+    int waitingCount = selfWaiting ? 1 : 0;
+    for (const auto &child : children) {
+        if (child.waiting && !child.finished) waitingCount++;
+    }
+    for (auto &child : children) {
+        if (pendingDonationCount >= waitingCount) break;
+        if (child.waiting || child.asked || child.finished) continue;
+        if (sendMessage(child.fd, MSG_DONATE, "")) {
+            child.asked = true;
+            pendingDonationCount++;
+        }
+    }
+}
+
+void WorkerPool::quitChildren() {
+    if (quitSent) return;
+    quitSent = true;
+    for (auto &child : children) {
+        if (!child.finished) sendMessage(child.fd, MSG_QUIT, "");
+    }
+}
+
+}
@@ -68,14 +68,46 @@ vector<Issue::Type> CrossChecker::compare(State *goldState, State *testState, Co
     return ret;
 }
 
+bool CrossChecker::outputMustDiverge(const State *goldState, const State *testState,
+                                     const ConstraintSet &constraints) const {
+    if (testState->lc3Out.size() > goldState->lc3Out.size()) return true;
+
+    // One query on the whole prefix, rather than one for each character
+    ref<Expr> match = builder->True();
+    auto goldIt = goldState->lc3Out.begin();
+    for (auto testIt = testState->lc3Out.begin(); testIt != testState->lc3Out.end(); ++goldIt, ++testIt) {
+        match = builder->And(match, builder->Eq(*goldIt, *testIt));
+    }
+    bool mustNotMatch;
+    bool success = solver->mustBeFalse(Query(constraints, match), mustNotMatch);
+    assert(success && "Unexpected solver failure");
+    return mustNotMatch;
+}
+
+bool CrossChecker::raiseEarlyOutputIssue(State *goldState, State *testState) {
+    auto issueInfo = testState->newStateIssue(Issue::ERR_INCORRECT_OUTPUT, nullptr);
+    if (issueInfo == nullptr) return false;
+
+    issueInfo->note = "Your program was stopped early, as its output so far can't match the expected one.\n";
+
+    auto ptr = new CallBackArg{{{ThingToCompare::OUTPUT, 0, 0, true}}, goldState};
+    issueInfo->descCallback = CrossChecker::generateIssueDesc;
+    issueInfo->descCallbackArg = (void *) ptr;
+    // ptr will be deleted at callback
+
+    goldState->triggerNewIssue = true;  // set this flag so that it won't be recycled
+    return true;
+}
+
 bool CrossChecker::outputDiverge(State *goldState, State *testState, ConstraintSet &finalConstraints) {
     bool ret = false;
     if (goldState->lc3Out.size() != testState->lc3Out.size()) {
         // Incorrect answer with incorrect length
         ret = true;
     } else {
-        for (unsigned i = 0; i < goldState->lc3Out.size(); ++i) {
-            if (!(exprMustEq(goldState->lc3Out[i], testState->lc3Out[i], finalConstraints))) {
+        for (auto goldIt = goldState->lc3Out.begin(), testIt = testState->lc3Out.begin();
+             goldIt != goldState->lc3Out.end(); ++goldIt, ++testIt) {
+            if (!(exprMustEq(*goldIt, *testIt, finalConstraints))) {
                 // Incorrect answer with correct length
                 ret = true;
 #if !AS_DIVERGE_AS_POSSIBLE
@@ -0,0 +1,82 @@
+//
+// Created by liuzikai on 10/17/26.
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+
+#include "klc3/Verification/GoldExecutionTree.h"
+
+namespace klc3 {
+
+GoldExecutionTree::GoldExecutionTree(ExprBuilder *builder, Solver *solver, Executor *goldExecutor,
+                                     State *goldStartupState)
+        : WithBuilder(builder), solver(solver), goldExecutor(goldExecutor) {
+    root = newNode(goldExecutor->forkState(goldStartupState));
+}
+
+std::unique_ptr<GoldExecutionTree::Node> GoldExecutionTree::newNode(State *state) {
+    ref<Expr> pathCondition = builder->True();
+    for (const auto &c : state->constraints) {
+        pathCondition = builder->And(pathCondition, c);
+    }
+    nodeCount++;
+    bool faulty = (state->status == State::BROKEN || state->triggerNewIssue);
+    return std::unique_ptr<Node>(new Node{state, faulty, pathCondition, {}});
+}
+
+bool GoldExecutionTree::expand(Node *node, const std::function<bool()> &shouldStop) {
+    State *s = node->state;
+    StateVector result;
+    while (true) {
+        goldExecutor->step(s, result);
+        if (result.size() > 1) break;  // fork
+        if (s->status != State::NORMAL || s->triggerNewIssue) {
+            node->faulty = (s->status == State::BROKEN || s->triggerNewIssue);
+            return true;  // leaf
+        }
+        if (shouldStop()) return false;
+    }
+
+    for (State *r : result) {
+        node->children.emplace_back(newNode(r));
+    }
+    node->state = nullptr;
+    return true;
+}
+
+bool GoldExecutionTree::isCompatible(const ConstraintSet &constraints, const Node *node) const {
+    bool res;
+    bool success = solver->mayBeTrue(Query(constraints, node->pathCondition), res);
+    assert(success && "Unhandled solver failure");
+    (void) success;
+    return res;
+}
+
+GoldExecutionTree::Result GoldExecutionTree::getLeaves(const ConstraintSet &constraints, StateVector &leaves,
+                                                       const std::function<bool()> &shouldStop) {
+    // The root has only the initial constraints, which are included in constraints of every test state
+    vector<Node *> pending = {root.get()};
+    while (!pending.empty()) {
+        Node *node = pending.back();
+        pending.pop_back();
+
+        if (node->state != nullptr && node->state->status == State::NORMAL && !node->faulty) {
+            if (!expand(node, shouldStop)) return STOPPED;
+        }
+        if (node->faulty) return GOLD_ISSUE;
+
+        if (node->state != nullptr) {
+            assert(node->state->status == State::HALTED);
+            leaves.push_back(node->state);
+        } else {
+            // Push in reverse order so that children are visited in the order of the executor result
+            for (auto it = node->children.rbegin(); it != node->children.rend(); ++it) {
+                if (isCompatible(constraints, it->get())) pending.push_back(it->get());
+            }
+        }
+    }
+    return COMPLETED;
+}
+
+}
@@ -329,6 +329,96 @@ void IssuePackage::callBackForAllDesc(const map<const State *, Assignment> &assi
     }
 }
 
+static void serializeString(llvm::raw_ostream &out, const string &str) {
+    out << str.size() << " " << str;
+}
+
+static bool deserializeString(StringRef &data, string &str) {
+    size_t length;
+    if (data.consumeInteger(10, length) || !data.consume_front(" ") || data.size() < length) return false;
+    str = data.substr(0, length).str();
+    data = data.drop_front(length);
+    return true;
+}
+
+template<class T>
+static bool deserializeInteger(StringRef &data, T &val) {
+    return !data.consumeInteger(10, val) && data.consume_front(" ");
+}
+
+void IssuePackage::serialize(llvm::raw_ostream &out, const std::function<int(const State *)> &stateIndex) const {
+    // Format: <type> <has location> [<addr> <file> <line> <content>] <info count>
+    //         {<state index> <step count> <case name> <note>}
+    for (const auto &it : issues) {
+        const Issue &issue = it.first;
+        out << (int) issue.type << " " << (issue.location.isNull() ? 0 : 1) << " ";
+        if (!issue.location.isNull()) {
+            out << issue.location->addr << " ";
+            serializeString(out, issue.location->sourceFile);
+            out << " " << issue.location->sourceLine << " ";
+            serializeString(out, issue.location->sourceContent);
+            out << " ";
+        }
+        out << it.second.size() << " ";
+        for (const auto &info : it.second) {
+            out << (stateIndex && info.s ? stateIndex(info.s) : -1) << " " << info.stepCount << " ";
+            serializeString(out, info.generatedCaseName);
+            out << " ";
+            serializeString(out, info.note);
+            out << " ";
+        }
+    }
+}
+
+bool IssuePackage::mergeSerialized(StringRef data, const map<uint16_t, ref<MemValue>> &mem,
+                                   const std::function<State *(int)> &stateByIndex) {
+    while (!data.empty()) {
+        int type, hasLocation;
+        if (!deserializeInteger(data, type) || !deserializeInteger(data, hasLocation)) return false;
+
+        ref<MemValue> location;
+        if (hasLocation) {
+            uint16_t addr;
+            string sourceFile, sourceContent;
+            int sourceLine;
+            if (!deserializeInteger(data, addr) ||
+                !deserializeString(data, sourceFile) || !data.consume_front(" ") ||
+                !deserializeInteger(data, sourceLine) ||
+                !deserializeString(data, sourceContent) || !data.consume_front(" ")) {
+                return false;
+            }
+            auto it = mem.find(addr);
+            if (it != mem.end() && it->second->sourceFile == sourceFile && it->second->sourceLine == sourceLine) {
+                location = it->second;
+            } else {
+                location = DataValue::alloc(addr, nullptr);
+                location->sourceFile = sourceFile;
+                location->sourceLine = sourceLine;
+                location->sourceContent = sourceContent;
+            }
+        }
+
+        size_t infoCount;
+        if (!deserializeInteger(data, infoCount)) return false;
+        vector<IssueInfo> &infos = issues[Issue{static_cast<Issue::Type>(type), location}];
+        for (size_t i = 0; i < infoCount; i++) {
+            IssueInfo info;
+            int stateIndex;
+            if (!deserializeInteger(data, stateIndex) || !deserializeInteger(data, info.stepCount) ||
+                !deserializeString(data, info.generatedCaseName) || !data.consume_front(" ") ||
+                !deserializeString(data, info.note) || !data.consume_front(" ")) {
+                return false;
+            }
+            if (stateIndex >= 0 && stateByIndex) {
+                info.s = stateByIndex(stateIndex);
+                if (info.s == nullptr) return false;
+            }
+            infos.emplace_back(std::move(info));
+        }
+    }
+    return true;
+}
+
 Issue::Type IssuePackage::registerIssue(const string &name, Issue::Level level) {
     auto type = static_cast<Issue::Type>(definedIssueCount++);
     issueName[type] = name;
@@ -0,0 +1,36 @@
+; This program writes an array with a symbolic index that may go one past its end
+; With -sym-addr-mode=array, the in-bound writes are kept in the array while the out-of-bound one is forked
+; KLC3 is expected to give warning about the wild write, but not about the concrete read that follows
+
+; KLC3: INPUT_FILE
+
+.ORIG x3000
+
+LD R2, INDEX
+LEA R1, ARRAY
+ADD R1, R1, R2
+AND R0, R0, #0
+ADD R0, R0, #7
+
+; CHECK: ================ REPORT ================
+
+STR R0, R1, #0
+; CHECK: WARN_POSSIBLE_WILD_WRITE
+; CHECK-SAME: STR R0, R1, #0
+
+; The word is brought up to date from the array before it is read
+LD R3, ARRAY
+; CHECK-NOT: LD R3, ARRAY
+
+; CHECK: ================ END OF REPORT ================
+
+HALT
+
+INDEX .BLKW #1  ; KLC3: SYMBOLIC as N
+                ; KLC3: SYMBOLIC N >= #0 & N <= #4
+
+ARRAY .BLKW #4
+
+.END
+
+; RUN: %klc3 %s -sym-addr-mode=array --use-forked-solver=false --output-dir=none --report-to-terminal=true 2>&1 | FileCheck %s
@@ -0,0 +1,19 @@
+; Gold program of stream_output_check.asm: outputs '-' if the input number is negative, or '+' otherwise
+
+.ORIG x3000
+
+LDI R1, DATA_ADDR
+BRn NEGATIVE_CASE
+LD R0, PLUS_ASCII
+OUT
+HALT
+NEGATIVE_CASE
+LD R0, MINUS_ASCII
+OUT
+HALT
+
+PLUS_ASCII .FILL 43   ; '+'
+MINUS_ASCII .FILL 45  ; '-'
+DATA_ADDR .FILL x4000
+
+.END
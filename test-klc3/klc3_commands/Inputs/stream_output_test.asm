@@ -0,0 +1,18 @@
+; Test program of stream_output_check.asm: outputs '+' for negative input numbers, and then never halts
+
+.ORIG x3000
+
+LDI R1, DATA_ADDR
+BRn NEGATIVE_CASE
+LD R0, PLUS_ASCII
+OUT
+HALT
+NEGATIVE_CASE
+LD R0, PLUS_ASCII     ; BUG: should be '-'
+OUT
+LOOP BRnzp LOOP       ; BUG: never halts
+
+PLUS_ASCII .FILL 43   ; '+'
+DATA_ADDR .FILL x4000
+
+.END
@@ -0,0 +1,28 @@
+; This program is tested as a submission in batch mode, together with one that doesn't exist
+; KLC3 is expected to report the issue of this submission, skip the missing one and count it as failed
+
+.ORIG x3000
+
+LEA R1, ARRAY
+LDR R0, R1, #1
+STR R0, R1, #2
+
+; CHECK: ================ batch_submissions (1/2) ================
+; CHECK: ================ REPORT ================
+; CHECK: WARN_POSSIBLE_WILD_WRITE
+; CHECK-SAME: STR R0, R1, #2
+; CHECK: ================ END OF REPORT ================
+
+; Warnings go to stderr, so only the summary on stdout is checked for the missing one
+; CHECK: ================ missing_submission (2/2) ================
+
+; CHECK: Batch finished 2/2 submission(s) in {{[0-9]+}} s, 1 failed
+; CHECK-NEXT: missing_submission: bad input
+
+HALT
+
+ARRAY .BLKW #2
+
+.END
+
+; RUN: not %klc3 --batch=%s --batch=%S/missing_submission.asm --use-forked-solver=false --output-dir=none --report-to-terminal=true 2>/dev/null | FileCheck %s
@@ -0,0 +1,38 @@
+; This program outputs '+', '0' or '-' based on the sign of the input number
+; The second run shares the -cex-cache-file written by the first one
+; KLC3 is expected to load the counterexamples of the first run and to use them in the second run
+
+; KLC3: INPUT_FILE
+
+.ORIG x3000
+
+LD R1, TEST_INPUT
+BRn NEGATIVE_CASE
+BRz ZERO_CASE
+LD R0, PLUS_ASCII
+OUT
+HALT
+ZERO_CASE
+LD R0, ZERO_ASCII
+OUT
+HALT
+NEGATIVE_CASE
+LD R0, MINUS_ASCII
+OUT
+HALT
+
+TEST_INPUT .BLKW #1   ; KLC3: SYMBOLIC as N
+
+PLUS_ASCII .FILL 43   ; '+'
+ZERO_ASCII .FILL 48   ; '0'
+MINUS_ASCII .FILL 45  ; '-'
+
+.END
+
+; FIRST: Loaded 0 counterexample(s) from {{.*}}.cex-cache
+; SECOND: Loaded {{[1-9][0-9]*}} counterexample(s) from {{.*}}.cex-cache
+; SECOND: CexCacheSolver Hits: {{[1-9][0-9]*}}
+
+; RUN: rm -f %t.cex-cache
+; RUN: %klc3 %s -cex-cache-file=%t.cex-cache -interval-presolver=false -enumerate-max-words=0 --dump-issues-to-file=true --use-forked-solver=false --output-dir=none 2>&1 | FileCheck %s --check-prefix=FIRST
+; RUN: %klc3 %s -cex-cache-file=%t.cex-cache -interval-presolver=false -enumerate-max-words=0 --dump-issues-to-file=true --use-forked-solver=false --output-dir=none 2>&1 | FileCheck %s --check-prefix=SECOND
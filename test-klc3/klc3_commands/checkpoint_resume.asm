@@ -0,0 +1,34 @@
+; This program writes past the end of its array and then never halts
+; The first run is stopped by -max-time and writes a checkpoint with the looping state, which the second run resumes
+; KLC3 is expected to keep the issue found before the checkpoint, and to report the step limit after resuming
+
+; KLC3: INPUT_FILE
+
+.ORIG x3000
+
+LEA R1, ARRAY
+LD R2, TEST_INPUT
+STR R2, R1, #2
+
+LOOP
+ADD R2, R2, #1
+BRnzp LOOP
+
+; CHECKPOINT: Exceed global test time limit
+; CHECKPOINT: Checkpoint written to {{.*}}.klc3-out
+
+; RESUME: Resumed from {{.*}}.klc3-out: 1 state(s) to explore, 0 spilled, 1 issue(s)
+; RESUME: ================ REPORT ================
+; RESUME-DAG: WARN_POSSIBLE_WILD_WRITE{{.*}}STR R2, R1, #2
+; RESUME-DAG: ERR_STATE_REACH_STEP_LIMIT
+; RESUME: ================ END OF REPORT ================
+
+TEST_INPUT .BLKW #1      ; KLC3: SYMBOLIC as N
+
+ARRAY .BLKW #2
+
+.END
+
+; RUN: rm -rf %t.klc3-out
+; RUN: %klc3 %s -max-time=1s -checkpoint-interval=60 --use-forked-solver=false --output-dir=%t.klc3-out 2>&1 | FileCheck %s --check-prefix=CHECKPOINT
+; RUN: %klc3 %s -resume=%t.klc3-out -max-lc3-step-count=100000 --use-forked-solver=false --output-dir=none --report-to-terminal=true 2>&1 | FileCheck %s --check-prefix=RESUME
@@ -0,0 +1,59 @@
+; This program writes past the end of its array at three different offsets, on paths that share the A + B branch
+; The paths diverge after the first branch, so the incremental solver has to pop constraints in the middle of the prefix
+; KLC3 is expected to report the same wild writes with and without --use-incremental-solver
+
+; REQUIRES: stp
+; KLC3: INPUT_FILE
+
+.ORIG x3000
+
+AND R0, R0, #0
+LEA R5, ARRAY
+LD R1, INPUT_A
+LD R2, INPUT_B
+LD R3, INPUT_C
+
+ADD R4, R1, R2
+BRzp SUM_NONNEG
+
+; A + B < 0
+ADD R4, R4, R3
+BRnp DONE
+STR R0, R5, #2           ; A + B + C == 0
+BRnzp DONE
+
+SUM_NONNEG
+NOT R4, R3
+ADD R4, R4, #1
+ADD R4, R1, R4
+BRnz CHECK_B_C
+STR R0, R5, #3           ; A - C > 0
+BRnzp DONE
+
+CHECK_B_C
+NOT R4, R3
+ADD R4, R4, #1
+ADD R4, R2, R4
+BRnp DONE
+STR R0, R5, #4           ; A - C <= 0 and B == C
+
+DONE
+HALT
+
+INPUT_A .BLKW #1         ; KLC3: SYMBOLIC as A
+INPUT_B .BLKW #1         ; KLC3: SYMBOLIC as B
+INPUT_C .BLKW #1         ; KLC3: SYMBOLIC as C
+
+ARRAY .BLKW #2
+
+.END
+
+; CHECK: ================ REPORT ================
+; CHECK-DAG: WARN_POSSIBLE_WILD_WRITE{{.*}}STR R0, R5, #2
+; CHECK-DAG: WARN_POSSIBLE_WILD_WRITE{{.*}}STR R0, R5, #3
+; CHECK-DAG: WARN_POSSIBLE_WILD_WRITE{{.*}}STR R0, R5, #4
+; CHECK: ================ END OF REPORT ================
+
+; Queries must reach the core solver for the incremental path to be exercised
+; RUN: %klc3 %s -interval-presolver=false -enumerate-max-words=0 --use-forked-solver=false --output-dir=none --report-to-terminal=true 2>&1 | FileCheck %s
+; RUN: %klc3 %s -interval-presolver=false -enumerate-max-words=0 --use-incremental-solver --use-forked-solver=false --output-dir=none --report-to-terminal=true 2>&1 | FileCheck %s
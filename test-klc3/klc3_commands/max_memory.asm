@@ -0,0 +1,40 @@
+; This program writes past the end of its array only when all three inputs are negative
+; With a memory budget of 1 MB, states may be spilled to disk and reloaded at any time
+; KLC3 is expected to still report the wild write, with no state left on disk at the end
+
+; KLC3: INPUT_FILE
+
+.ORIG x3000
+
+AND R0, R0, #0
+LEA R1, ARRAY
+
+LD R2, INPUT_A
+BRzp DONE
+ADD R0, R0, #1
+LD R2, INPUT_B
+BRzp DONE
+ADD R0, R0, #1
+LD R2, INPUT_C
+BRzp DONE
+
+; Statistics are printed before the report
+; CHECK-NOT: {{[1-9][0-9]*}} left on disk
+; CHECK: ================ REPORT ================
+STR R0, R1, #2
+; CHECK: WARN_POSSIBLE_WILD_WRITE
+; CHECK-SAME: STR R0, R1, #2
+; CHECK: ================ END OF REPORT ================
+
+DONE
+HALT
+
+INPUT_A .BLKW #1      ; KLC3: SYMBOLIC as A
+INPUT_B .BLKW #1      ; KLC3: SYMBOLIC as B
+INPUT_C .BLKW #1      ; KLC3: SYMBOLIC as C
+
+ARRAY .BLKW #2
+
+.END
+
+; RUN: %klc3 %s -max-memory=1 --use-forked-solver=false --output-dir=none --report-to-terminal=true 2>&1 | FileCheck %s
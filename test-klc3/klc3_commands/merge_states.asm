@@ -0,0 +1,37 @@
+; This program takes the absolute value of the input, and writes past the end of its array if it is at least 4
+; With -merge-states, the two sides of the BRzp are merged at ABS_DONE, so that R0 becomes a Select expression
+; KLC3 is expected to merge them, and to still find the wild write, which only negative inputs can reach
+
+; KLC3: INPUT_FILE
+
+.ORIG x3000
+
+LEA R1, ARRAY
+LD R0, TEST_INPUT
+BRzp ABS_DONE
+NOT R0, R0
+ADD R0, R0, #1
+ABS_DONE
+
+ADD R2, R0, #-4
+BRn DONE
+
+; Statistics are printed before the report
+; CHECK: State merging: {{[0-9]+}} region(s), {{[1-9][0-9]*}} state(s) merged
+; CHECK: ================ REPORT ================
+STR R0, R1, #2
+; CHECK: WARN_POSSIBLE_WILD_WRITE
+; CHECK-SAME: STR R0, R1, #2
+; CHECK: ================ END OF REPORT ================
+
+DONE
+HALT
+
+TEST_INPUT .BLKW #1      ; KLC3: SYMBOLIC as N
+                         ; KLC3: SYMBOLIC N >= #-5 & N <= #3
+
+ARRAY .BLKW #2
+
+.END
+
+; RUN: %klc3 %s -merge-states --use-forked-solver=false --output-dir=none --report-to-terminal=true 2>&1 | FileCheck %s
@@ -0,0 +1,38 @@
+; This program outputs '+', '0' or '-' based on the sign of the input number
+; The second run shares the -query-cache-file written by the first one
+; KLC3 is expected to answer the queries of the second run from the cache file
+
+; KLC3: INPUT_FILE
+
+.ORIG x3000
+
+LD R1, TEST_INPUT
+BRn NEGATIVE_CASE
+BRz ZERO_CASE
+LD R0, PLUS_ASCII
+OUT
+HALT
+ZERO_CASE
+LD R0, ZERO_ASCII
+OUT
+HALT
+NEGATIVE_CASE
+LD R0, MINUS_ASCII
+OUT
+HALT
+
+TEST_INPUT .BLKW #1   ; KLC3: SYMBOLIC as N
+
+PLUS_ASCII .FILL 43   ; '+'
+ZERO_ASCII .FILL 48   ; '0'
+MINUS_ASCII .FILL 45  ; '-'
+
+.END
+
+; Queries that the interval pre-solver or the enumeration solver answers don't reach the cache
+; FIRST: CacheSolver Misses: {{[1-9][0-9]*}}
+; SECOND: CacheSolver Hits: {{[1-9][0-9]*}}
+
+; RUN: rm -f %t.query-cache
+; RUN: %klc3 %s -query-cache-file=%t.query-cache -interval-presolver=false -enumerate-max-words=0 --dump-issues-to-file=true --use-forked-solver=false --output-dir=none 2>&1 | FileCheck %s --check-prefix=FIRST
+; RUN: %klc3 %s -query-cache-file=%t.query-cache -interval-presolver=false -enumerate-max-words=0 --dump-issues-to-file=true --use-forked-solver=false --output-dir=none 2>&1 | FileCheck %s --check-prefix=SECOND
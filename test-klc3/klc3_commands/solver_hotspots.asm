@@ -0,0 +1,37 @@
+; This program outputs '+', '0' or '-' based on the sign of the input number
+; Both branches on the symbolic input need the solver, and fork a state
+; KLC3 is expected to attribute the solver queries and the forks to the branch lines
+
+; KLC3: INPUT_FILE
+
+.ORIG x3000
+
+LD R1, TEST_INPUT
+; CHECK: Solver hot spots:
+; CHECK-NEXT: Time (s) Share Queries Calls Forks Source
+; CHECK: {{ *[0-9]+\.[0-9]+ +[0-9]+\.[0-9]+% +[1-9][0-9]* +[1-9][0-9]* +[1-9][0-9]*}} [{{.*}}solver_hotspots.asm:[[@LINE+1]]]
+BRn NEGATIVE_CASE
+; CHECK-SAME: BRn NEGATIVE_CASE
+BRz ZERO_CASE
+LD R0, PLUS_ASCII
+OUT
+HALT
+ZERO_CASE
+LD R0, ZERO_ASCII
+OUT
+HALT
+NEGATIVE_CASE
+LD R0, MINUS_ASCII
+OUT
+HALT
+
+TEST_INPUT .BLKW #1   ; KLC3: SYMBOLIC as N
+
+PLUS_ASCII .FILL 43   ; '+'
+ZERO_ASCII .FILL 48   ; '0'
+MINUS_ASCII .FILL 45  ; '-'
+
+.END
+
+; Queries that the interval pre-solver or the enumeration solver answers don't reach the core solver
+; RUN: %klc3 %s -solver-hotspots -interval-presolver=false -enumerate-max-words=0 --use-forked-solver=false --output-dir=none 2>&1 | FileCheck %s
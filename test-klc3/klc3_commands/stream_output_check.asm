@@ -0,0 +1,21 @@
+; Gold and test programs are in Inputs. The test program outputs a wrong character for negative inputs, and then
+; never halts. With -stream-output-check, the divergence is found as soon as the character is output
+; KLC3 is expected to report the incorrect output, and to stop the state before it reaches the step limit
+
+; KLC3: INPUT_FILE
+
+.ORIG x4000
+
+INPUT_DATA .BLKW #1  ; KLC3: SYMBOLIC as NUM
+
+.END
+
+; Statistics are printed before the report
+; CHECK: Streaming output check stopped 1 state(s) early
+; CHECK: ================ REPORT ================
+; CHECK-NOT: ERR_STATE_REACH_STEP_LIMIT
+; CHECK: ERR_INCORRECT_OUTPUT
+; CHECK-NOT: ERR_STATE_REACH_STEP_LIMIT
+; CHECK: ================ END OF REPORT ================
+
+; RUN: %klc3 %s --test=%S/Inputs/stream_output_test.asm --gold=%S/Inputs/stream_output_gold.asm -stream-output-check -max-lc3-step-count=1000 --use-forked-solver=false --output-dir=none --report-to-terminal=true 2>&1 | FileCheck %s
@@ -0,0 +1,33 @@
+; This program writes past the end of its array on each side of a symbolic branch
+; With -workers=2, the two sides are explored by different workers
+; KLC3 is expected to merge the results of both workers and report both wild writes
+
+; KLC3: INPUT_FILE
+
+.ORIG x3000
+
+AND R0, R0, #0
+LEA R1, ARRAY
+LD R2, TEST_INPUT
+BRn NEGATIVE_CASE
+
+STR R0, R1, #2
+HALT
+
+NEGATIVE_CASE
+STR R0, R1, #3
+HALT
+
+; CHECK: Merged results of all workers
+; CHECK: ================ REPORT ================
+; CHECK-DAG: WARN_POSSIBLE_WILD_WRITE{{.*}}STR R0, R1, #2
+; CHECK-DAG: WARN_POSSIBLE_WILD_WRITE{{.*}}STR R0, R1, #3
+; CHECK: ================ END OF REPORT ================
+
+TEST_INPUT .BLKW #1      ; KLC3: SYMBOLIC as N
+
+ARRAY .BLKW #2
+
+.END
+
+; RUN: %klc3 %s -workers=2 --use-forked-solver=false --output-dir=none --report-to-terminal=true 2>&1 | FileCheck %s
@@ -7,6 +7,8 @@
 
 #include "klc3/Common.h"
 #include "klc3/Core/Executor.h"
+#include "klc3/Core/PhaseProfiler.h"
+#include "klc3/Core/LC3ExprBuilder.h"
 #include "klc3/Loader/Loader.h"
 #include "klc3/FlowAnalysis/FlowGraph.h"
 #include "klc3/FlowAnalysis/SubroutineTracker.h"
@@ -15,14 +17,22 @@
 #include "klc3/Generation/ReportFormatter.h"
 #include "klc3/Verification/CrossChecker.h"
 #include "klc3/Verification/ExecutionLimitChecker.h"
+#include "klc3/Verification/GoldExecutionTree.h"
 #include "klc3/Generation/IssueFilter.h"
 #include "klc3/Generation/ResultGenerator.h"
 #include "klc3/Generation/VariableInductor.h"
 #include "klc3/Searcher/Searcher.h"
 #include "klc3/Searcher/PruningSearcher.h"
+#include "klc3/Searcher/WorkerPool.h"
+#include "klc3/Searcher/StateSpiller.h"
+#include "klc3/Searcher/Checkpointer.h"
+#include "klc3/Searcher/StateMerger.h"
 
 #include "klee/Support/OptionCategories.h"
 #include "klee/Solver/Solver.h"
+#include "klee/Solver/PersistentCexCache.h"
+#include "klee/Statistics/Statistics.h"
+#include "klee/System/MemoryUsage.h"
 
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/raw_ostream.h"
@@ -39,6 +49,8 @@
 #define ENABLE_ISSUE_FILTER                 1
 
 #define ALARM_INTERVAL                      1     // [s], handle report/timeout per this time using SIGALRM
+#define SPILL_RELOAD_BATCH                  64    // spilled states reloaded at a time when the searcher drains
+#define WORKER_POLL_INTERVAL                64    // steps between handling messages from other workers
 #define INTERACTIVE_ECHO                    0
 
 #define DUMP_LOOPS_TO_TERMINAL              1
@@ -115,12 +127,128 @@ llvm::cl::opt<ReactivationOption> ReactivationOperation(
         llvm::cl::init(ReactivationOption::None),
         llvm::cl::cat(KLC3ExecutionCat));
 
+llvm::cl::opt<bool> CacheGoldExploration(
+        "cache-gold-exploration",
+        llvm::cl::desc("Explore the gold program lazily in one execution tree shared by all test states, rather than "
+                       "running the gold program again for each HALTED test state (default=true)"),
+        llvm::cl::init(true),
+        llvm::cl::cat(KLC3ExecutionCat));
+
+llvm::cl::opt<unsigned> WorkerCount(
+        "workers",
+        llvm::cl::desc("Number of processes to explore the test program. Once there are enough states, klc3 forks "
+                       "and each worker explores its share of them. Idle workers take over states from busy ones. "
+                       "Issues and coverage are merged in the end (default=1)"),
+        llvm::cl::init(1),
+        llvm::cl::cat(KLC3ExecutionCat));
+
+llvm::cl::opt<string> QueryCacheFile(
+        "query-cache-file",
+        llvm::cl::desc("Load solver query results from this file at startup and save them back at exit, so that "
+                       "runs on the same input space (such as regrading resubmissions) reuse them (default=none)"),
+        llvm::cl::init(""),
+        llvm::cl::cat(KLC3ExecutionCat));
+
+llvm::cl::opt<unsigned> QueryCacheFileSize(
+        "query-cache-file-size",
+        llvm::cl::desc("Maximal number of query results kept in -query-cache-file. "
+                       "The least recently used ones are dropped (default=65536)"),
+        llvm::cl::init(65536),
+        llvm::cl::cat(KLC3ExecutionCat));
+
+llvm::cl::opt<string> CexCacheFile(
+        "cex-cache-file",
+        llvm::cl::desc("Load counterexamples of the solver from this file after loading input programs and save them "
+                       "back at exit. Counterexamples are matched by names and sizes of input variables, so runs on "
+                       "the same input space start with known models (default=none)"),
+        llvm::cl::init(""),
+        llvm::cl::cat(KLC3ExecutionCat));
+
+llvm::cl::opt<unsigned> CexCacheFileSize(
+        "cex-cache-file-size",
+        llvm::cl::desc("Maximal number of counterexamples kept in -cex-cache-file. "
+                       "The least recently used ones are dropped (default=1024)"),
+        llvm::cl::init(1024),
+        llvm::cl::cat(KLC3ExecutionCat));
+
+llvm::cl::opt<unsigned> MaxMemory(
+        "max-memory",
+        llvm::cl::desc("Memory budget in MB. When exceeded, NORMAL states of the lowest priority (postponed ones "
+                       "first) are spilled to a temporary file, and reloaded when the searcher runs out of states. "
+                       "0 for no limit (default=0)"),
+        llvm::cl::init(0),
+        llvm::cl::cat(KLC3ExecutionCat));
+
+llvm::cl::opt<unsigned> CheckpointInterval(
+        "checkpoint-interval",
+        llvm::cl::desc("Write a checkpoint of the exploration to <output-dir>/checkpoint every ... second(s), and when "
+                       "the exploration stops before completion. It can be continued with -resume. "
+                       "0 for no checkpoint (default=0)"),
+        llvm::cl::init(0),
+        llvm::cl::cat(KLC3ExecutionCat));
+
+llvm::cl::opt<string> ResumeDirectory(
+        "resume",
+        llvm::cl::desc("Continue the exploration from the checkpoint in the given directory (see "
+                       "-checkpoint-interval). The same programs must be given as the run that wrote it."),
+        llvm::cl::value_desc("directory"),
+        llvm::cl::init(""),
+        llvm::cl::cat(KLC3ExecutionCat));
+
+llvm::cl::opt<bool> MergeStates(
+        "merge-states",
+        llvm::cl::desc("Hold states forked at a symbolic BR at the join node (its immediate post-dominator) and merge "
+                       "them into one state with Select expressions over their path conditions. Not supported with "
+                       "-searcher=pruning, -max-memory, checkpoints or multiple workers (default=false)"),
+        llvm::cl::init(false),
+        llvm::cl::cat(KLC3ExecutionCat));
+
+llvm::cl::opt<bool> LC3ExprRewrite(
+        "lc3-expr-rewrite",
+        llvm::cl::desc("Canonicalize expressions of LC-3 idioms (negation, masks, shifts by ADD and comparison by "
+                       "subtraction) when they are built, to shrink solver queries (default=true)"),
+        llvm::cl::init(true),
+        llvm::cl::cat(KLC3ExecutionCat));
+
+llvm::cl::opt<bool> IntervalPresolver(
+        "interval-presolver",
+        llvm::cl::desc("Try to answer solver queries from intervals and known bits learned from the constraints, and "
+                       "from a few assignments picked from those intervals, before querying the caches and STP "
+                       "(default=true)"),
+        llvm::cl::init(true),
+        llvm::cl::cat(KLC3ExecutionCat));
+
+llvm::cl::opt<unsigned> EnumerateMaxWords(
+        "enumerate-max-words",
+        llvm::cl::desc("Answer solver queries that read at most this number of symbolic words by trying all their "
+                       "values instead of calling STP. 0 to disable. Each word multiplies the values to try by "
+                       "65536 (default=1)"),
+        llvm::cl::init(1),
+        llvm::cl::cat(KLC3ExecutionCat));
+
+llvm::cl::opt<bool> StreamOutputCheck(
+        "stream-output-check",
+        llvm::cl::desc("Compare the output of a test state with the gold program whenever the test program outputs, "
+                       "and stop the state once its output can't match any compatible gold state. Requires gold "
+                       "programs and -cache-gold-exploration, and ERR_INCORRECT_OUTPUT at the ERROR level "
+                       "(default=false)"),
+        llvm::cl::init(false),
+        llvm::cl::cat(KLC3ExecutionCat));
+
 llvm::cl::opt<bool> GenerateFinalFlowGraph(
         "output-flowgraph",
         llvm::cl::desc("Generate final flow graph on edge coverage (default=true)"),
         llvm::cl::init(true),
         llvm::cl::cat(KLC3OutputCat));
 
+llvm::cl::opt<bool> SolverHotSpots(
+        "solver-hotspots",
+        llvm::cl::desc("Attribute solver queries, solver time and forks to lines of the test program. Write them to "
+                       "solver-hotspots.log, the most expensive first, and color hot lines in the coverage flow graph "
+                       "(default=false)"),
+        llvm::cl::init(false),
+        llvm::cl::cat(KLC3OutputCat));
+
 llvm::cl::OptionCategory KLC3InputCat("KLC3 input");
 
 llvm::cl::list<string> InputFiles(llvm::cl::Positional,
@@ -140,6 +268,22 @@ llvm::cl::list<string> GoldPrograms("gold",
                                     llvm::cl::ZeroOrMore,
                                     llvm::cl::cat(KLC3InputCat));
 
+llvm::cl::list<string> BatchSubmissions("batch",
+                                        llvm::cl::desc("Submission to test against the same gold and shared programs, "
+                                                       "either an asm file or a directory of asm files. "
+                                                       "Can have multiple. Cannot be used with --test."),
+                                        llvm::cl::value_desc("asm file or directory"),
+                                        llvm::cl::ZeroOrMore,
+                                        llvm::cl::cat(KLC3InputCat));
+
+llvm::cl::opt<string> BatchDirectory("batch-dir",
+                                     llvm::cl::desc("Directory in which each asm file or subdirectory is a submission "
+                                                    "(see --batch). Output of each submission goes to "
+                                                    "<output-dir>/<submission name>."),
+                                     llvm::cl::value_desc("directory"),
+                                     llvm::cl::init(""),
+                                     llvm::cl::cat(KLC3InputCat));
+
 llvm::cl::opt<bool> DumpIssuesToFile(
         "dump-issues-to-file",
         llvm::cl::desc("Dump issues to issues.log in brief format (default=false)"),
@@ -151,20 +295,54 @@ llvm::cl::opt<unsigned int> ProgressReportInterval(
         llvm::cl::desc("Report progress every ... second(s) (0 for no report, default=5)"),
         llvm::cl::init(5),
         llvm::cl::cat(KLC3DebugCat));
+
+llvm::cl::opt<bool> ProfilePhases(
+        "profile-phases",
+        llvm::cl::desc("Time each phase of the exploration (executor step, coverage update, gold execution, etc.) "
+                       "and print a breakdown at the end. Implied by -stats-file (default=false)"),
+        llvm::cl::init(false),
+        llvm::cl::cat(KLC3DebugCat));
+
+llvm::cl::opt<string> StatsFilename(
+        "stats-file",
+        llvm::cl::desc("Write a time series of the exploration (states, inst/s, queries/s, time of each phase) to this "
+                       "file, as CSV if it ends with .csv or JSON lines otherwise. A relative path is under the "
+                       "output directory (default=none)"),
+        llvm::cl::init(""),
+        llvm::cl::cat(KLC3DebugCat));
+
+llvm::cl::opt<unsigned int> StatsInterval(
+        "stats-interval",
+        llvm::cl::desc("Write a sample to -stats-file every ... second(s) (default=5)"),
+        llvm::cl::init(5),
+        llvm::cl::cat(KLC3DebugCat));
 }
 
 ExprBuilder *constructBuilderChain() {
     ExprBuilder *builder;
     builder = klee::createDefaultExprBuilder();
     builder = klee::createConstantFoldingExprBuilder(builder);
+    if (LC3ExprRewrite) builder = new LC3ExprBuilder(builder);
     return builder;
 }
 
-Solver *constructSolverChain() {
+Solver *constructSolverChain(klee::PersistentCexCache *persistentCexCache) {
     assert(klee::CoreSolverToUse == klee::STP_SOLVER && "Only STP solver has been adapted for Int16 -> Int16 arrays");
     Solver *solver = klee::createCoreSolver(klee::CoreSolverToUse);
-    solver = klee::createCexCachingSolver(solver);
+    if (EnumerateMaxWords > 0) {
+        // Right above STP, so that the models found still go into the caches
+        solver = klee::createEnumerationSolver(solver, EnumerateMaxWords);
+    }
+    solver = klee::createCexCachingSolver(solver, persistentCexCache);
     solver = klee::createCachingSolver(solver);
+    if (!QueryCacheFile.empty()) {
+        // After independent constraint slicing, so that irrelevant constraints do not get into the key
+        solver = klee::createPersistentCachingSolver(solver, QueryCacheFile, QueryCacheFileSize);
+    }
+    if (IntervalPresolver) {
+        // After independent constraint slicing, so that only relevant constraints are analyzed
+        solver = klee::createIntervalSolver(solver);
+    }
     solver = klee::createIndependentSolver(solver);
     return solver;
 }
@@ -200,6 +378,90 @@ bool feedASMToLoader(KLC3Loader *loader, const string &filename, bool allowInput
     return loader->load(filename, false, allowInputFile, collectCompileIssues);
 }
 
+void addBatchSubmission(const string &path, vector<pair<string, vector<string>>> &submissions) {
+    if (llvm::sys::fs::is_directory(path)) {
+        vector<string> files;
+        std::error_code errorCode;
+        for (llvm::sys::fs::directory_iterator it(path, errorCode), end; it != end && !errorCode;
+             it.increment(errorCode)) {
+            if (endswith(it->path(), ".asm")) files.emplace_back(it->path());
+        }
+        if (files.empty()) {
+            newProgWarn() << "No asm file in " << path << ", skipped\n";
+            return;
+        }
+        std::sort(files.begin(), files.end());
+        submissions.emplace_back(llvm::sys::path::filename(path).str(), files);
+    } else {
+        submissions.emplace_back(llvm::sys::path::stem(path).str(), vector<string>{path});
+    }
+}
+
+/**
+ * Modules shared by all test programs, prepared once in main()
+ */
+struct SharedModules {
+    ExprBuilder *builder;
+    Solver *solver;  // query caches in the solver chain are reused across test programs
+    ArrayCache *arrayCache;
+    const IssuePackage *issuePackage;  // issues and issue types from shared programs, copied for each test program
+    CrossChecker *crossChecker;  // nullptr if no gold program
+    const KLC3Loader *loader;  // with lc3os and shared programs loaded, copied for each test program
+    Executor *goldExecutor;  // nullptr if no gold program
+    IssuePackage *goldIssuePackage;
+    State *goldStartupState;
+    GoldExecutionTree *goldExecutionTree;  // nullptr if not used
+    string lastInputFilename;
+};
+
+/**
+ * Values of the klee::stats counters at a point. They accumulate over the test programs in batch mode, so each test
+ * program reports the differences from a snapshot taken when its test starts.
+ */
+class StatsSnapshot {
+public:
+    StatsSnapshot() {
+        for (unsigned i = 0; i < klee::theStatisticManager->getNumStatistics(); i++) {
+            values.push_back(klee::theStatisticManager->getStatistic(i).getValue());
+        }
+    }
+
+    uint64_t since(const klee::Statistic &s) const { return s.getValue() - values[s.getID()]; }
+
+private:
+    vector<uint64_t> values;
+};
+
+// Failures that stop testing a program. They do not exit the process, so that batch mode can go on with the next one.
+enum class TestStatus {
+    OK,
+    BAD_INPUT,       // missing or unreadable test program, or unusable output directory
+    RESUME_FAILURE,  // failed to load the checkpoint given by -resume
+    GOLD_ISSUE,      // the gold program has issue on the inputs reached by the test program
+    WORKER_FAILURE,  // a child worker exited abnormally
+    OUTPUT_ERROR,    // failed to write a result file
+};
+
+const char *testStatusDescription(TestStatus status) {
+    switch (status) {
+        case TestStatus::OK:
+            return "OK";
+        case TestStatus::BAD_INPUT:
+            return "bad input";
+        case TestStatus::RESUME_FAILURE:
+            return "failed to resume";
+        case TestStatus::GOLD_ISSUE:
+            return "gold program has issue";
+        case TestStatus::WORKER_FAILURE:
+            return "worker failure";
+        case TestStatus::OUTPUT_ERROR:
+            return "failed to write result";
+    }
+    return "unknown";
+}
+
+TestStatus runTest(const SharedModules &shared, const vector<string> &testPrograms, const string &outputDirectory);
+
 bool InterruptReceived = false;
 
 void handleInterrupt() {
@@ -252,28 +514,44 @@ int main(int argc, char **argv) {
 
     /// ================================ Check for Input Files ================================
 
-    if (InputFiles.empty() && TestPrograms.empty()) {
+    bool batchMode = !BatchSubmissions.empty() || !BatchDirectory.empty();
+
+    if (InputFiles.empty() && TestPrograms.empty() && !batchMode) {
         newProgErr() << "no test program is given\n";
         progExit();
     }
 
-    if (!GoldPrograms.empty() && TestPrograms.empty()) {
+    if (batchMode && !TestPrograms.empty()) {
+        newProgErr() << "--test cannot be used together with --batch or --batch-dir\n";
+        progExit();
+    }
+
+    if (!GoldPrograms.empty() && TestPrograms.empty() && !batchMode) {
         newProgErr() << "gold program is given but no test program is given\n";
         progExit();
     }
 
+    if (batchMode && !ResumeDirectory.empty()) {
+        newProgErr() << "--resume cannot be used together with --batch or --batch-dir\n";
+        progExit();
+    }
+
     /// ================================ Prepare Builder and Solver ================================
 
     // Notice that we must use dynamic allocation since we can't put all these objects on the stack
     // We will use smart pointer so that we can return anywhere
 
     auto builder = std::unique_ptr<ExprBuilder>(constructBuilderChain());
-    auto solver = std::unique_ptr<Solver>(constructSolverChain());
+    std::unique_ptr<klee::PersistentCexCache> persistentCexCache;  // must outlive the solver
+    if (!CexCacheFile.empty()) {
+        persistentCexCache = std::make_unique<klee::PersistentCexCache>(CexCacheFile, CexCacheFileSize);
+    }
+    auto solver = std::unique_ptr<Solver>(constructSolverChain(persistentCexCache.get()));
 
 
     /// ================================ Load (Shared) Programs and Commands ================================
 
-    string lastTestProgramFilename;
+    string lastInputFilename;
 
     auto arrayCache = std::make_unique<ArrayCache>();
     auto issuePackage = std::make_unique<IssuePackage>();
@@ -292,7 +570,7 @@ int main(int argc, char **argv) {
     // Load (shared) input programs
     for (auto &programFilename : InputFiles) {
         feedASMToLoader(loader.get(), programFilename, true, false);
-        lastTestProgramFilename = programFilename;
+        lastInputFilename = programFilename;
     }
 
     /// ================================ Load Gold Programs (if Any) ================================
@@ -305,91 +583,28 @@ int main(int argc, char **argv) {
         }
     }
 
-    /// ================================ Continue Loading Test Programs (if Any) ================================
-
-    bool testProgramsNoError = true;
-    if (!TestPrograms.empty()) {
-        for (auto &programFilename : TestPrograms) {
-            testProgramsNoError &= feedASMToLoader(loader.get(), programFilename, false, true);
-            lastTestProgramFilename = programFilename;
-        }
-    }
-
-    /// ================================ Prepare Output Directory ================================
-
-    PathString outputPath(OutputDirectory);
-    if (outputPath == "none") {
-        outputPath.clear();
-        newProgWarn() << "Using dry-run mode\n";
-    } else if (outputPath.empty()) {
-        PathString basePath;
-        if (!lastTestProgramFilename.empty()) {
-            basePath = lastTestProgramFilename;
-        } else {
-            newProgErr() << "No test program or input file is given\n";
-            progExit();
-        }
-        llvm::sys::path::remove_filename(basePath);
-        outputPath = prepareOutputPath(basePath);
-        progInfo() << "Output to " << outputPath << "\n";
-    } else {
-        if (llvm::sys::fs::exists(outputPath)) {
-            if (llvm::sys::fs::is_directory(outputPath)) {
-                newProgWarn() << "output directory already exists, and KLC3 won't clean the directory\n";
-            } else {
-                newProgErr() << outputPath << " is an existing file.\n";
-                progExit();
-            }
-        } else {
-            llvm::sys::fs::create_directory(outputPath);
-        }
-        progInfo() << "Output to " << outputPath << "\n";
-    }
-
-
-
-    // After this point, empty outputPath means dry-run mode
-
-    /// ================================ Early Exit for Compile Errors ================================
-
-    if (!testProgramsNoError) {
-        // Generate report and exit
-        auto generator = std::make_unique<ResultGenerator>(outputPath, loader->getLoadedPrograms(),
-                                                           loader->getInputFiles(), loader->getInitPC());
-        generator->generateGlobalReport(*issuePackage.get());
-
-        if (DumpIssuesToFile && !outputPath.empty()) {
-            PathString filename(outputPath);
-            llvm::sys::path::append(filename, "issues.log");
-            std::error_code errorCode;
-            llvm::raw_fd_ostream fs(filename, errorCode, llvm::sys::fs::F_None);
-            if (errorCode) {
-                newProgErr() << "Failed to open " << filename << "\n";
-                return 1;
-            }
-            ReportFormatterBrief().generateReport(fs, *issuePackage.get());
-            fs.close();
-        }
-
-        llvm::llvm_shutdown();
-        return 0;
-    }
-
     /// ================================ Sanity Check on Symbols ================================
 
     if (!arrayCache->hasSymbolicArray()) newProgWarn() << "No symbolic variable loaded\n";
 
+    if (persistentCexCache) {
+        unsigned count = persistentCexCache->load(arrayCache->getAllSymbolicArrays());
+        progInfo() << "Loaded " << count << " counterexample(s) from " << CexCacheFile << "\n";
+    }
+
     /// ================================ Prepare Gold Program and Modules ================================
 
     std::unique_ptr<Executor> goldExecutor;
     std::unique_ptr<IssuePackage> goldIssuePackage;
     State *goldStartupState = nullptr;
+    std::unique_ptr<GoldExecutionTree> goldExecutionTree;
 #if ENABLE_GOLD_LOOP_COVERAGE
     StateVector goldLoopCoverageStates;
 #endif
 
     if (!GoldPrograms.empty()) {
-        goldExecutor = std::make_unique<Executor>(builder.get(), solver.get(), goldLoader->getMem());
+        goldExecutor = std::make_unique<Executor>(builder.get(), solver.get(), goldLoader->getMem(),
+                                                  arrayCache.get());
         goldIssuePackage = std::make_unique<IssuePackage>(*issuePackage);  // make a copy for all cross check item
         assert(goldIssuePackage->getIssues().empty());
 
@@ -410,6 +625,11 @@ int main(int argc, char **argv) {
         }
         timedInfo() << "Gold state warm up went through " << goldStartupState->stepCount << " steps\n";
 
+        if (CacheGoldExploration && goldStartupState->status == State::NORMAL) {
+            goldExecutionTree = std::make_unique<GoldExecutionTree>(builder.get(), solver.get(), goldExecutor.get(),
+                                                                    goldStartupState);
+        }
+
 #if ENABLE_GOLD_LOOP_COVERAGE
         progInfo() << "================================ Gold Loop Coverage ================================\n";
         {
@@ -487,6 +707,189 @@ int main(int argc, char **argv) {
 #endif
     }
 
+    /// ================================ Run Test Program(s) ================================
+
+    SharedModules shared = {builder.get(), solver.get(), arrayCache.get(), issuePackage.get(), crossChecker.get(),
+                            loader.get(), goldExecutor.get(), goldIssuePackage.get(), goldStartupState,
+                            goldExecutionTree.get(), lastInputFilename};
+
+    if (!batchMode) {
+        TestStatus status = runTest(shared, TestPrograms, OutputDirectory);
+        if (persistentCexCache) persistentCexCache->save();
+        llvm::llvm_shutdown();
+        return status == TestStatus::OK ? 0 : 1;
+    }
+
+    /// ================================ Batch Mode ================================
+
+    vector<pair<string, vector<string>>> submissions;  // name and asm files of each submission
+    if (!BatchDirectory.empty()) {
+        vector<string> entries;
+        std::error_code errorCode;
+        for (llvm::sys::fs::directory_iterator it(BatchDirectory, errorCode), end; it != end && !errorCode;
+             it.increment(errorCode)) {
+            entries.emplace_back(it->path());
+        }
+        if (errorCode) {
+            newProgErr() << "Failed to read " << BatchDirectory << "\n";
+            progExit();
+        }
+        std::sort(entries.begin(), entries.end());
+        for (const auto &entry : entries) {
+            if (llvm::sys::fs::is_directory(entry) || endswith(entry, ".asm")) {
+                addBatchSubmission(entry, submissions);
+            }
+        }
+    }
+    for (const auto &submission : BatchSubmissions) addBatchSubmission(submission, submissions);
+
+    if (!OutputDirectory.empty() && OutputDirectory != "none") {
+        llvm::sys::fs::create_directories(OutputDirectory.getValue());
+    }
+
+    auto batchStartTime = klee::time::getWallTime();
+    unsigned finishedCount = 0;
+    vector<pair<string, TestStatus>> failedSubmissions;
+    for (const auto &submission : submissions) {
+        progInfo() << "================================ " << submission.first << " ("
+                   << finishedCount + 1 << "/" << submissions.size() << ") ================================\n";
+
+        string outputDirectory;
+        if (OutputDirectory == "none") {
+            outputDirectory = "none";
+        } else if (!OutputDirectory.empty()) {
+            PathString subdir(OutputDirectory);
+            llvm::sys::path::append(subdir, submission.first);
+            outputDirectory = subdir.str().str();
+        }  // otherwise, output next to the submission
+
+        createReportFormatter();  // formatter keeps track of remarks already written
+        TestStatus status = runTest(shared, submission.second, outputDirectory);
+        if (status != TestStatus::OK) {
+            newProgWarn() << "Failed to test " << submission.first << ": " << testStatusDescription(status) << "\n";
+            failedSubmissions.emplace_back(submission.first, status);
+        }
+        finishedCount++;
+
+        if (InterruptReceived) {
+            progErrs() << "INTERRUPT RECEIVED! Skip remaining submissions.\n";
+            break;
+        }
+    }
+    timedInfo() << "Batch finished " << finishedCount << "/" << submissions.size() << " submission(s) in "
+                << (klee::time::getWallTime() - batchStartTime).toMicroseconds() / 1000000 << " s, "
+                << failedSubmissions.size() << " failed\n";
+    for (const auto &failed : failedSubmissions) {
+        progInfo() << "  " << failed.first << ": " << testStatusDescription(failed.second) << "\n";
+    }
+
+    if (persistentCexCache) persistentCexCache->save();
+    llvm::llvm_shutdown();
+    return failedSubmissions.empty() ? 0 : 1;
+}
+
+/**
+ * Load test programs on top of the shared programs, explore them, and generate the result
+ * @param shared
+ * @param testPrograms     Test asm files. If empty, shared programs are tested as the program.
+ * @param outputDirectory  Same as the -output-dir option
+ * @return TestStatus::OK, or the failure that stops testing the program
+ */
+TestStatus runTest(const SharedModules &shared, const vector<string> &testPrograms, const string &outputDirectory) {
+
+    ExprBuilder *builder = shared.builder;
+    Solver *solver = shared.solver;
+    ArrayCache *arrayCache = shared.arrayCache;
+    CrossChecker *crossChecker = shared.crossChecker;
+    Executor *goldExecutor = shared.goldExecutor;
+    IssuePackage *goldIssuePackage = shared.goldIssuePackage;
+    State *goldStartupState = shared.goldStartupState;
+    GoldExecutionTree *goldExecutionTree = shared.goldExecutionTree;
+    SearcherOption searcherType = SearcherType;  // may back off for this test program
+
+    string lastTestProgramFilename = shared.lastInputFilename;
+
+    auto issuePackage = std::make_unique<IssuePackage>(*shared.issuePackage);
+    auto loader = std::make_unique<KLC3Loader>(*shared.loader, issuePackage.get());
+
+    TestStatus status = TestStatus::OK;
+
+    const StatsSnapshot statsAtStart;  // klee::stats are reported as counted for this test program
+
+    /// ================================ Continue Loading Test Programs (if Any) ================================
+
+    bool testProgramsNoError = true;
+    if (!testPrograms.empty()) {
+        for (auto &programFilename : testPrograms) {
+            // The loader exits the process on files it can't open
+            if (!llvm::sys::fs::is_regular_file(programFilename) || access(programFilename.c_str(), R_OK) != 0) {
+                newProgErr() << "Failed to open " << programFilename << "\n";
+                return TestStatus::BAD_INPUT;
+            }
+            testProgramsNoError &= feedASMToLoader(loader.get(), programFilename, false, true);
+            lastTestProgramFilename = programFilename;
+        }
+    }
+
+    /// ================================ Prepare Output Directory ================================
+
+    PathString outputPath(outputDirectory);
+    if (outputPath == "none") {
+        outputPath.clear();
+        newProgWarn() << "Using dry-run mode\n";
+    } else if (outputPath.empty()) {
+        PathString basePath;
+        if (!lastTestProgramFilename.empty()) {
+            basePath = lastTestProgramFilename;
+        } else {
+            newProgErr() << "No test program or input file is given\n";
+            return TestStatus::BAD_INPUT;
+        }
+        llvm::sys::path::remove_filename(basePath);
+        outputPath = prepareOutputPath(basePath);
+        progInfo() << "Output to " << outputPath << "\n";
+    } else {
+        if (llvm::sys::fs::exists(outputPath)) {
+            if (llvm::sys::fs::is_directory(outputPath)) {
+                newProgWarn() << "output directory already exists, and KLC3 won't clean the directory\n";
+            } else {
+                newProgErr() << outputPath << " is an existing file.\n";
+                return TestStatus::BAD_INPUT;
+            }
+        } else {
+            llvm::sys::fs::create_directory(outputPath);
+        }
+        progInfo() << "Output to " << outputPath << "\n";
+    }
+
+
+
+    // After this point, empty outputPath means dry-run mode
+
+    /// ================================ Early Exit for Compile Errors ================================
+
+    if (!testProgramsNoError) {
+        // Generate report and exit
+        auto generator = std::make_unique<ResultGenerator>(outputPath, loader->getLoadedPrograms(),
+                                                           loader->getInputFiles(), loader->getInitPC());
+        generator->generateGlobalReport(*issuePackage.get());
+
+        if (DumpIssuesToFile && !outputPath.empty()) {
+            PathString filename(outputPath);
+            llvm::sys::path::append(filename, "issues.log");
+            std::error_code errorCode;
+            llvm::raw_fd_ostream fs(filename, errorCode, llvm::sys::fs::F_None);
+            if (errorCode) {
+                newProgErr() << "Failed to open " << filename << "\n";
+                return TestStatus::OUTPUT_ERROR;
+            }
+            ReportFormatterBrief().generateReport(fs, *issuePackage.get());
+            fs.close();
+        }
+
+        return TestStatus::OK;
+    }
+
     /// ================================ Prepare FlowGraph ================================
 
     auto flowGraph = std::make_unique<FlowGraph>(loader->getMem(), loader->getInitPC());
@@ -498,14 +901,14 @@ int main(int argc, char **argv) {
     /// ================================ Analyze Loops (if Using PruningSearcher) ================================
 
     std::unique_ptr<LoopAnalyzer> loopAnalyzer;
-    if (SearcherType == SearcherOption::Pruning) {
+    if (searcherType == SearcherOption::Pruning) {
 
         // Check for improper subroutine structures
         for (const auto &node : flowGraph->allNodes()) {
             if (node->subroutineColors.size() > 1) {
                 newProgWarn()
                         << "Detect improper loop structure. Can't run PruningSearcher. Backoff to PrioritizedFILO\n";
-                SearcherType = SearcherOption::PrioritizedFILO;
+                searcherType = SearcherOption::PrioritizedFILO;
                 goto PREPARE_SEARCHER;
             }
         }
@@ -525,7 +928,7 @@ int main(int argc, char **argv) {
         if (loopAnalysisFailed) {
             newProgWarn() << "Detect at least " << loopAnalyzer->getTotalSegmentCount()
                           << " segments. Backoff to PrioritizedFILO\n";
-            SearcherType = SearcherOption::PrioritizedFILO;
+            searcherType = SearcherOption::PrioritizedFILO;
             goto PREPARE_SEARCHER;
         }
 
@@ -543,7 +946,7 @@ int main(int argc, char **argv) {
             llvm::raw_fd_ostream fs(filename, errorCode, llvm::sys::fs::F_None);
             if (errorCode) {
                 newProgErr() << "Failed to open " << filename << "\n";
-                return 1;
+                return TestStatus::OUTPUT_ERROR;
             }
             loopAnalyzer->dump(fs);
             fs.close();
@@ -567,15 +970,15 @@ int main(int argc, char **argv) {
     std::unique_ptr<Searcher> searcher;
     std::unique_ptr<Searcher> innerSearcher;
     int maxSearcherLevel = 0;
-    if (SearcherType == SearcherOption::SimpleFILO) {
+    if (searcherType == SearcherOption::SimpleFILO) {
         progInfo() << "Using searcher: SimpleFILO\n";
         maxSearcherLevel = 0;
         searcher = std::make_unique<SimpleFILOSearcher>();
-    } else if (SearcherType == SearcherOption::PrioritizedFILO) {
+    } else if (searcherType == SearcherOption::PrioritizedFILO) {
         progInfo() << "Using searcher: PrioritizedFILO\n";
         maxSearcherLevel = 0;
         searcher = std::make_unique<PrioritizedFILOSearcher>();
-    } else if (SearcherType == SearcherOption::Pruning) {
+    } else if (searcherType == SearcherOption::Pruning) {
         progInfo() << "Using searcher: Pruning\n";
         if (ReactivationOperation == ReactivationOption::Stop) {
             maxSearcherLevel = 0;  // run until there is no normal states
@@ -593,36 +996,137 @@ int main(int argc, char **argv) {
 
     /// ================================ Setup Execution Modules ================================
 
-    auto executor = std::make_unique<Executor>(builder.get(), solver.get(), loader->getMem());
+    auto executor = std::make_unique<Executor>(builder, solver, loader->getMem(), arrayCache);
+    if (executor->getMemRegionCount() > 0) {
+        progInfo() << "Symbolic addresses access " << executor->getMemRegionCount() << " memory region(s) as arrays\n";
+    }
+
+    std::unique_ptr<SolverCostTracker> solverCostTracker;  // nullptr if not tracking
+    if (SolverHotSpots) {
+        solverCostTracker = std::make_unique<SolverCostTracker>();
+        executor->setSolverCostTracker(solverCostTracker.get());
+    }
 
     auto coverageTracker = std::make_unique<CoverageTracker>(flowGraph.get());
 
-    auto variableInductor = std::make_unique<VariableInductor>(builder.get(), solver.get(),
+    auto variableInductor = std::make_unique<VariableInductor>(builder, solver,
                                                                arrayCache->getAllSymbolicArrays(),
                                                                loader->getPreferences());
 
     unordered_map<const State *, ConstraintSet> finalConstraintSets;  // store final constraints for assignments
 
+    // Assignment of the symbolic variables to describe an issue of a state and to generate its test case
+    auto induceAssignment = [&](const State *s, Issue::Type type) -> Assignment {
+        if (type < klc3::Issue::RUNTIME_ISSUE_COUNT) {
+            // Runtime issues are raised during execution of test program and don't rely on comparison,
+            // So constraints of test state itself suffice.
+            return variableInductor->induceVariables(s->constraints);
+        } else {
+            auto it = finalConstraintSets.find(s);
+            assert(it != finalConstraintSets.end() && "Missing final constraints");
+            return variableInductor->induceVariables(it->second);
+        }
+    };
+
+    auto stateSerializer = std::make_unique<StateSerializer>(
+            executor.get(), builder, arrayCache, issuePackage.get(), flowGraph.get(),
+            loopAnalyzer ? loopAnalyzer->getAllLoops() : set<Loop *>());
+
+    auto workerPool = std::make_unique<WorkerPool>(WorkerCount, executor.get(), stateSerializer.get(),
+                                                   flowGraph.get());
+
+    std::unique_ptr<StateSpiller> stateSpiller;
+    if (MaxMemory) {
+        stateSpiller = std::make_unique<StateSpiller>(executor.get(), stateSerializer.get());
+    }
+
+    std::unique_ptr<Checkpointer> checkpointer;
+    if (CheckpointInterval && outputPath.empty()) {
+        newProgWarn() << "Checkpoints are not written in dry-run mode\n";
+    }
+    if ((CheckpointInterval && !outputPath.empty()) || !ResumeDirectory.empty()) {
+        // All edges are static ones at this point
+        checkpointer = std::make_unique<Checkpointer>(stateSerializer.get(), flowGraph.get(), coverageTracker.get(),
+                                                      subroutineTracker.get(), searcher.get(), issuePackage.get(),
+                                                      stateSpiller.get(), &finalConstraintSets, induceAssignment);
+    }
+
+    std::unique_ptr<StateMerger> stateMerger;  // nullptr if not merging
+    if (MergeStates) {
+        if (searcherType == SearcherOption::Pruning || stateSpiller || checkpointer || WorkerCount > 1) {
+            newProgWarn() << "State merging is not supported with the pruning searcher, -max-memory, checkpoints or "
+                             "multiple workers. Disabled.\n";
+        } else {
+            stateMerger = std::make_unique<StateMerger>(builder, executor.get(), flowGraph.get());
+        }
+    }
+
+    bool streamOutputCheck = false;
+    if (StreamOutputCheck) {
+        if (GoldPrograms.empty() || !crossChecker->comparesOutput() ||
+            issuePackage->getIssueLevel(Issue::ERR_INCORRECT_OUTPUT) != Issue::ERROR) {
+            newProgWarn() << "Streaming output check requires gold programs that compare the output, with "
+                             "ERR_INCORRECT_OUTPUT at the ERROR level. Disabled.\n";
+        } else if (goldStartupState->status != State::HALTED && goldExecutionTree == nullptr) {
+            newProgWarn() << "Streaming output check requires -cache-gold-exploration. Disabled.\n";
+        } else {
+            streamOutputCheck = true;
+        }
+    }
+
     /// ================================ Prepare Test Initial State ================================
 
-    State *initState = executor->createInitState(loader->getConstraints(),
-                                                 loader->getInitPC(),
-                                                 issuePackage.get());
-    subroutineTracker->setupInitState(initState);
+    Checkpointer::Progress resumedProgress;
+    if (ResumeDirectory.empty()) {
+
+        State *initState = executor->createInitState(loader->getConstraints(),
+                                                     loader->getInitPC(),
+                                                     issuePackage.get());
+        subroutineTracker->setupInitState(initState);
 
-    searcher->push({initState});
+        searcher->push({initState});
 
 #if ENABLE_GOLD_LOOP_COVERAGE
-    if (!GoldProgams.empty()) {
-        for (const auto &goldPreState : goldLoopCoverageStates) {
-            State *testPreState = executor->forkState(initState);
-            testPreState->constraints = goldPreState->constraints;
-            testPreState->coveredNewSegment = true;  // do not let it get postponed
-            searcher->push({testPreState});
+        if (!GoldProgams.empty()) {
+            for (const auto &goldPreState : goldLoopCoverageStates) {
+                State *testPreState = executor->forkState(initState);
+                testPreState->constraints = goldPreState->constraints;
+                testPreState->coveredNewSegment = true;  // do not let it get postponed
+                searcher->push({testPreState});
+            }
         }
-    }
 #endif
 
+    } else {
+
+        if (!checkpointer->load(ResumeDirectory, loader->getMem(), resumedProgress)) {
+            newProgErr() << "Failed to resume from " << ResumeDirectory << "\n";
+            return TestStatus::RESUME_FAILURE;
+        }
+        timedInfo() << "Resumed from " << ResumeDirectory << ": " << searcher->getHeldStates().size()
+                    << " state(s) to explore, " << (stateSpiller ? stateSpiller->getSpilledStateCount() : 0)
+                    << " spilled, " << issuePackage->getIssues().size() << " issue(s). "
+                    << "Edge coverage: " << floatToString(coverageTracker->calculateCoverage() * 100, 2) << "%\n";
+    }
+
+    /// ================================ Prepare Profiling ================================
+
+    std::unique_ptr<PhaseProfiler> profiler;  // nullptr if not profiling
+    if (ProfilePhases || !StatsFilename.empty()) {
+        profiler = std::make_unique<PhaseProfiler>();
+    }
+
+    std::unique_ptr<StatsFile> statsFile;
+    if (!StatsFilename.empty()) {
+        PathString filename(StatsFilename);
+        if (llvm::sys::path::is_relative(filename) && !outputPath.empty()) {
+            filename = outputPath;
+            llvm::sys::path::append(filename, StatsFilename);
+        }
+        statsFile = std::make_unique<StatsFile>(filename.str().str(), profiler.get());
+        if (!statsFile->isOpen()) statsFile.reset();
+    }
+
     /// ================================ Go ================================
     timedInfo() << "START!\n";
     alarm(ALARM_INTERVAL);  // start the timer
@@ -630,24 +1134,147 @@ int main(int argc, char **argv) {
         auto globalStartTime = klee::time::getWallTime();
         auto lastReportTime = globalStartTime;
 
-        int divergeStateCount = 0;
-        int maxStepCount = 0;
-        int maxSolverCount = 0;
-        long long totalInstCount = 0;
+        auto lastCheckpointTime = globalStartTime;
+        auto lastStatsTime = globalStartTime;
+
+        int divergeStateCount = resumedProgress.divergeStateCount;
+        int earlyOutputIssueCount = 0;  // test states stopped by the streaming output check
+        int maxStepCount = resumedProgress.maxStepCount;
+        int maxSolverCount = resumedProgress.maxSolverCount;
+        long long totalInstCount = resumedProgress.totalInstCount;
+
+        // Checked while the gold program runs for a test state
+        auto goldShouldStop = [&]() -> bool {
+            if (InterruptReceived) return true;
+            // Do not reset AlarmReceived for outside checking code to terminate the program
+            return AlarmReceived && MaxTime && klee::time::getWallTime() - globalStartTime > MaxTime;
+        };
+
+        int currentSearcherLevel = resumedProgress.searcherLevel;
+        bool midStep = false;  // whether the results of the current step have not been pushed to the searcher
+
+        auto currentProgress = [&]() -> Checkpointer::Progress {
+            return {totalInstCount, maxStepCount, maxSolverCount, divergeStateCount, currentSearcherLevel};
+        };
+
+        auto writeStatsSample = [&]() {
+            statsFile->write({executor->getAllocatedStateCount(), executor->getAliveStateCount(), totalInstCount,
+                              statsAtStart.since(klee::stats::queries), statsAtStart.since(klee::stats::queryTime),
+                              coverageTracker->calculateCoverage(),
+                              issuePackage->getIssues().size()});
+        };
+
+        // Compare a HALTED test state with a HALTED gold state and keep the final constraints if any issue is raised
+        auto compareWithGold = [&](State *goldState, State *testState, ConstraintSet &finalConstraints) {
+            PhaseProfiler::Scope scope(profiler.get(), PhaseProfiler::CROSS_CHECK);
+            // Attributed to the instruction where the test program halts
+            SolverCostTracker::Scope costScope(solverCostTracker.get(), testState->latestNonOSInst[0].get());
+            auto res = crossChecker->compare(goldState, testState, finalConstraints);
+            if (!res.empty()) {
+                finalConstraintSets[testState] = finalConstraints;
+            }
+            return res;
+        };
+
+        // Check the output of a NORMAL test state against all compatible gold states, and raise ERR_INCORRECT_OUTPUT
+        // early if it can't match any of them. Return false if the gold program should stop.
+        auto streamCheckOutput = [&](State *testState) -> bool {
+            PhaseProfiler::Scope scope(profiler.get(), PhaseProfiler::CROSS_CHECK);
+            SolverCostTracker::Scope costScope(solverCostTracker.get(), testState->latestNonOSInst[0].get());
+            testState->checkedOutputLength = testState->lc3Out.size();
+
+            StateVector goldLeaves;
+            if (goldStartupState->status == klc3::State::HALTED) {
+                goldLeaves.push_back(goldStartupState);
+            } else {
+                auto treeResult = goldExecutionTree->getLeaves(testState->constraints, goldLeaves, goldShouldStop);
+                if (treeResult == GoldExecutionTree::GOLD_ISSUE) {
+                    newProgErr() << "Gold program has issue! "
+                                    "Run the gold program in the standalone mode to debug.\n";
+                    status = TestStatus::GOLD_ISSUE;
+                    return false;
+                } else if (treeResult == GoldExecutionTree::STOPPED) {
+                    return false;
+                }
+            }
+            if (goldLeaves.empty()) return true;
+
+            ConstraintSet firstFinalConstraints;
+            for (State *goldLeaf : goldLeaves) {
+                ConstraintSet finalConstraints = testState->constraints;  // copy
+                ConstraintManager finalConstraintManager(finalConstraints);
+                for (const auto &c : goldLeaf->constraints) {
+                    finalConstraintManager.addConstraint(c);
+                }
+                if (!crossChecker->outputMustDiverge(goldLeaf, testState, finalConstraints)) {
+                    return true;  // may still match
+                }
+                if (goldLeaf == goldLeaves[0]) firstFinalConstraints = finalConstraints;
+            }
+
+            if (crossChecker->raiseEarlyOutputIssue(goldLeaves[0], testState)) {
+                finalConstraintSets[testState] = firstFinalConstraints;
+            }
+            earlyOutputIssueCount++;
+            return true;
+        };
+
+        // Checked while waiting for states from other workers. A child worker otherwise waits for the main worker to
+        // tell it to stop.
+        auto workerShouldStop = [&]() -> bool {
+            if (InterruptReceived) return true;
+            return !workerPool->isChild() && MaxTime && klee::time::getWallTime() - globalStartTime > MaxTime;
+        };
+
+        // Spilled states may be postponed ones, which are only fetched at the last level. So reload them when the
+        // searcher drains at the last level. If none of the reloaded states can be fetched, the rest are left spilled.
+        auto fetchTestState = [&]() -> State * {
+            PhaseProfiler::Scope scope(profiler.get(), PhaseProfiler::SEARCHER);
+            State *ret = searcher->fetch();
+            if (ret == nullptr && stateSpiller && stateSpiller->getSpilledStateCount() > 0 &&
+                currentSearcherLevel == maxSearcherLevel) {
+                searcher->restore(stateSpiller->reload(SPILL_RELOAD_BATCH));
+                ret = searcher->fetch();
+            }
+            if (ret == nullptr && stateMerger && stateMerger->getHeldStateCount() > 0) {
+                // Some members of a region are out of sight. Give up merging the held states.
+                searcher->push(stateMerger->flush());
+                ret = searcher->fetch();
+            }
+            if (ret == nullptr && workerPool->isSplit() && currentSearcherLevel == maxSearcherLevel) {
+                // Take over states from busy workers, until all workers run out of states
+                StateVector received;
+                while (ret == nullptr && !(received = workerPool->requestWork(workerShouldStop)).empty()) {
+                    searcher->restore(received);
+                    ret = searcher->fetch();
+                }
+            }
+            return ret;
+        };
 
-        int currentSearcherLevel = 0;
         while (currentSearcherLevel <= maxSearcherLevel) {
 
             // Set searcher level
             searcher->setLevel(currentSearcherLevel);
 
             // Run until the level is done
-            State *testFetchedState = searcher->fetch();
+            State *testFetchedState = fetchTestState();
             while (testFetchedState != nullptr) {
                 assert(testFetchedState->status == klc3::State::NORMAL);
 
+                if (workerPool->isForeign(testFetchedState)) {
+                    // Explored by another worker
+                    executor->releaseState(testFetchedState);
+                    testFetchedState = fetchTestState();
+                    continue;
+                }
+
                 StateVector testStepResult;  // store states from executor->step
-                executor->step(testFetchedState, testStepResult);
+                midStep = true;
+                {
+                    PhaseProfiler::Scope scope(profiler.get(), PhaseProfiler::EXECUTOR_STEP);
+                    executor->step(testFetchedState, testStepResult);
+                }
                 totalInstCount++;
 
                 // Update statistics
@@ -655,10 +1282,18 @@ int main(int argc, char **argv) {
                 if (testFetchedState->solverCount > maxSolverCount) maxSolverCount = testFetchedState->solverCount;
 
                 // FlowGraph update included, which must be before subroutineTracker update
-                for (auto &testResultState : testStepResult) coverageTracker->updateGraphAndCoverage(testResultState);
+                {
+                    PhaseProfiler::Scope scope(profiler.get(), PhaseProfiler::COVERAGE_UPDATE);
+                    for (auto &testResultState : testStepResult) {
+                        coverageTracker->updateGraphAndCoverage(testResultState);
+                    }
+                }
 
                 // SubroutineTracker updates must be before searcher update (may change the State)
-                for (auto &testResultState : testStepResult) subroutineTracker->updateColors(testResultState);
+                {
+                    PhaseProfiler::Scope scope(profiler.get(), PhaseProfiler::SUBROUTINE_UPDATE);
+                    for (auto &testResultState : testStepResult) subroutineTracker->updateColors(testResultState);
+                }
 
                 for (auto &testResultState : testStepResult) {
 
@@ -668,19 +1303,54 @@ int main(int argc, char **argv) {
                         // If a state reaches its limit, it is set to BROKEN
                     }
 
+                    // Check new output once the state returns from the TRAP
+                    if (streamOutputCheck && testResultState->status == State::NORMAL &&
+                        testResultState->lc3Out.size() > testResultState->checkedOutputLength &&
+                        testResultState->latestInst[0].get() == testResultState->latestNonOSInst[0].get()) {
+                        if (!streamCheckOutput(testResultState)) {
+                            if (InterruptReceived) timedInfo() << "INTERRUPT RECEIVED!\n";
+                            goto FINISH_SEARCHER;
+                        }
+                    }
+
                     if (testResultState->status == klc3::State::HALTED) {
 
                         subroutineTracker->postCheckState(testResultState);
 
                         if (!GoldPrograms.empty()) {
+                            PhaseProfiler::Scope goldScope(profiler.get(), PhaseProfiler::GOLD_EXECUTION);
+
                             if (goldStartupState->status == klc3::State::HALTED) {
                                 // goldStartupState finished running without forking
 
                                 ConstraintSet finalConstraints = testResultState->constraints;  // copy
-                                auto res = crossChecker->compare(goldStartupState, testResultState, finalConstraints);
-                                if (!res.empty()) {
-                                    finalConstraintSets[testResultState] = finalConstraints;
+                                compareWithGold(goldStartupState, testResultState, finalConstraints);
+
+                            } else if (goldExecutionTree != nullptr) {
+                                // A test state is HALTED, compare with compatible leaves of the gold execution tree
+
+                                StateVector goldLeaves;
+                                auto treeResult = goldExecutionTree->getLeaves(testResultState->constraints, goldLeaves,
+                                                                               goldShouldStop);
+                                if (treeResult == GoldExecutionTree::GOLD_ISSUE) {
+                                    newProgErr() << "Gold program has issue! "
+                                                    "Run the gold program in the standalone mode to debug.\n";
+                                    status = TestStatus::GOLD_ISSUE;
+                                    goto FINISH_SEARCHER;
+                                } else if (treeResult == GoldExecutionTree::STOPPED) {
+                                    if (InterruptReceived) timedInfo() << "INTERRUPT RECEIVED!\n";
+                                    goto FINISH_SEARCHER;
+                                }
+
+                                for (State *goldLeaf : goldLeaves) {
+                                    ConstraintSet finalConstraints = testResultState->constraints;  // copy
+                                    ConstraintManager finalConstraintManager(finalConstraints);
+                                    for (const auto &c : goldLeaf->constraints) {
+                                        finalConstraintManager.addConstraint(c);
+                                    }
+                                    compareWithGold(goldLeaf, testResultState, finalConstraints);
                                 }
+                                if (goldLeaves.size() > 1) divergeStateCount++;
 
                             } else {
                                 // A test state is HALTED, launch a corresponding gold state
@@ -725,11 +1395,8 @@ int main(int argc, char **argv) {
                                             switch (goldResultState->status) {
                                                 case klc3::State::HALTED: {
                                                     ConstraintSet finalConstraints = goldResultState->constraints;  // copy
-                                                    auto res = crossChecker->compare(goldResultState, testResultState,
-                                                                                     finalConstraints);
-                                                    if (!res.empty()) {
-                                                        finalConstraintSets[testResultState] = finalConstraints;
-                                                    }
+                                                    auto res = compareWithGold(goldResultState, testResultState,
+                                                                               finalConstraints);
 #if ENABLE_PARTIAL_GOLD_COMPARE
                                                     triggeredCrossIssues.insert(res.begin(), res.end());
 #endif
@@ -738,7 +1405,8 @@ int main(int argc, char **argv) {
                                                 case klc3::State::BROKEN:
                                                     newProgErr()
                                                             << "Gold program has issue! Run the gold program in the standalone mode to debug.\n";
-                                                    progExit();
+                                                    status = TestStatus::GOLD_ISSUE;
+                                                    goto FINISH_SEARCHER;
                                                 default:
                                                     break;
                                             }
@@ -785,7 +1453,8 @@ int main(int argc, char **argv) {
                                 if (!goldIssuePackage->getIssues().empty()) {
                                     newProgErr() << "Gold program has issue! "
                                                     "Run the gold program in the standalone mode to debug.\n";
-                                    progExit();
+                                    status = TestStatus::GOLD_ISSUE;
+                                    goto FINISH_SEARCHER;
                                 }
                                 if (goldStateCount > 1) {
 #if INTERACTIVE_ECHO
@@ -804,7 +1473,13 @@ int main(int argc, char **argv) {
                 }
 
                 // Searcher takes in states of all status
-                searcher->push(testStepResult);
+                {
+                    PhaseProfiler::Scope scope(profiler.get(), PhaseProfiler::SEARCHER);
+                    // States held at join nodes are taken out, and merged ones are put in
+                    if (stateMerger) stateMerger->update(testFetchedState, testStepResult);
+                    searcher->push(testStepResult);
+                }
+                midStep = false;
 
 #if ENABLE_STATE_EARLY_RELEASE
                 for (auto &testResultState : testStepResult) {
@@ -822,6 +1497,32 @@ int main(int argc, char **argv) {
                 }
 #endif
 
+                if (workerPool->isWaitingToSplit()) {
+                    if (workerPool->split(searcher->getNormalStates(), executor->getAllocatedStateCount())) {
+                        if (workerPool->isChild()) {
+                            alarm(ALARM_INTERVAL);  // alarm is not inherited by the child process
+                            TestCaseNameSuffix = TestCaseNameSuffix + "-w" +
+                                                 std::to_string(workerPool->getWorkerIndex());
+                            // States spilled before the split are left to the main worker
+                            if (stateSpiller) stateSpiller->reset();
+                            statsFile.reset();  // samples are only written by the main worker
+                            issuePackage->clearIssues();  // issues raised before the split are reported by the main worker
+                        } else if (checkpointer) {
+                            timedInfo() << "Checkpoints are not written after workers split\n";
+                        }
+                        checkpointer.reset();  // a checkpoint would only cover the share of one worker
+                        timedInfo() << "Worker " << workerPool->getWorkerIndex() << " started\n";
+                    }
+                }
+
+                if (workerPool->isSplit() && totalInstCount % WORKER_POLL_INTERVAL == 0) {
+                    PhaseProfiler::Scope scope(profiler.get(), PhaseProfiler::MAINTENANCE);
+                    if (!workerPool->poll(searcher.get())) {
+                        timedInfo() << "Stopped by the main worker\n";
+                        goto FINISH_SEARCHER;
+                    }
+                }
+
                 if (InterruptReceived) {
                     progErrs() << "INTERRUPT RECEIVED!\n";
                     goto FINISH_SEARCHER;
@@ -832,6 +1533,7 @@ int main(int argc, char **argv) {
                     // Due to high kernel cost of now() on the server, we reduce the frequency of these time-related checks
                     if (AlarmReceived) {
                         AlarmReceived = false;
+                        PhaseProfiler::Scope scope(profiler.get(), PhaseProfiler::MAINTENANCE);
 
                         auto now = klee::time::getWallTime();  // this is costly on the server
 
@@ -850,6 +1552,39 @@ int main(int argc, char **argv) {
                             }
                         }
 
+                        if (statsFile && (now - lastStatsTime).toMicroseconds() / 1000000 >= StatsInterval) {
+                            writeStatsSample();
+                            lastStatsTime = now;
+                        }
+
+                        // Check for memory budget
+                        if (stateSpiller) {
+                            size_t mallocUsage = klee::util::GetTotalMallocUsage() >> 20U;
+                            if (mallocUsage > MaxMemory) {
+                                // Spill up to half of the alive states, the lowest priority first
+                                StateVector victims = searcher->evict(executor->getAliveStateCount() / 2,
+                                                                      StateSpiller::canSpill);
+                                StateVector failedVictims;
+                                for (State *s : victims) {
+                                    if (!stateSpiller->spill(s)) failedVictims.push_back(s);
+                                }
+                                if (!failedVictims.empty()) searcher->restore(failedVictims);
+                                timedInfo() << "Memory usage " << mallocUsage << " MB exceeds " << MaxMemory
+                                            << " MB. Spilled " << victims.size() - failedVictims.size()
+                                            << " state(s), " << stateSpiller->getSpilledStateCount()
+                                            << " on disk\n";
+                            }
+                        }
+
+                        // Write a checkpoint in the background
+                        if (checkpointer && CheckpointInterval) {
+                            checkpointer->poll();
+                            if ((now - lastCheckpointTime).toMicroseconds() / 1000000 >= CheckpointInterval &&
+                                checkpointer->startWrite(outputPath.str().str(), currentProgress())) {
+                                lastCheckpointTime = now;
+                            }
+                        }
+
                         // Check for global limits
                         if (MaxTime) {
                             if (now - globalStartTime > MaxTime) {
@@ -871,7 +1606,7 @@ int main(int argc, char **argv) {
                 }
 
                 // Fetch next test state
-                testFetchedState = searcher->fetch();
+                testFetchedState = fetchTestState();
 
             }
 
@@ -881,6 +1616,24 @@ int main(int argc, char **argv) {
 
         FINISH_SEARCHER:
 
+        if (stateMerger) searcher->push(stateMerger->flush());  // so that held states are counted below
+
+        if (statsFile) writeStatsSample();
+
+        if (checkpointer && CheckpointInterval) {
+            // If the exploration stops before completion, write a final checkpoint to continue from. Not if stopped
+            // in the middle of a step, when the results of the step are not in the searcher.
+            bool completed = searcher->getHeldStates().empty() &&
+                             (!stateSpiller || stateSpiller->getSpilledStateCount() == 0);
+            if (!completed && !midStep && status == TestStatus::OK) {
+                if (checkpointer->write(outputPath.str().str(), currentProgress())) {
+                    timedInfo() << "Checkpoint written to " << outputPath << "\n";
+                }
+            } else {
+                checkpointer->poll(true);
+            }
+        }
+
         searcher->setLevel(0);  // so that PruningSearcher reports non-postponed state count below
 
         timedInfo() << "DONE! "
@@ -895,26 +1648,95 @@ int main(int argc, char **argv) {
         progInfo() << "Total inst: " << totalInstCount << "\n";
         progInfo() << "Max step count: " << maxStepCount << "\n";
         progInfo() << "Max solver count: " << maxSolverCount << "\n";
+        if (stateSpiller && stateSpiller->getTotalSpillCount() > 0) {
+            progInfo() << "Spilled states: " << stateSpiller->getTotalSpillCount() << " spills, "
+                       << stateSpiller->getTotalReloadCount() << " reloads, "
+                       << stateSpiller->getSpilledStateCount() << " left on disk, "
+                       << "peak " << stateSpiller->getPeakFileSize() / 1024 << " KB\n";
+        }
+        if (streamOutputCheck) {
+            progInfo() << "Streaming output check stopped " << earlyOutputIssueCount << " state(s) early\n";
+        }
+        if (IntervalPresolver) {
+            uint64_t queries = statsAtStart.since(klee::stats::intervalSolverQueries);
+            uint64_t hits = statsAtStart.since(klee::stats::intervalSolverHits);
+            progInfo() << "Interval pre-solver: resolved " << hits << " of " << queries << " queries ("
+                       << floatToString(queries == 0 ? 0 : 100.0 * hits / queries, 2) << "%)\n";
+        }
+        if (EnumerateMaxWords > 0) {
+            progInfo() << "Enumeration solver: resolved " << statsAtStart.since(klee::stats::enumerationSolverHits)
+                       << " of " << statsAtStart.since(klee::stats::enumerationSolverQueries) << " queries\n";
+        }
+        if (workerPool->getDonatedStateCount() > 0 || workerPool->getReceivedStateCount() > 0) {
+            progInfo() << "Worker " << workerPool->getWorkerIndex() << ": donated "
+                       << workerPool->getDonatedStateCount() << " state(s), received "
+                       << workerPool->getReceivedStateCount() << " state(s)\n";
+        }
+        if (stateMerger) {
+            progInfo() << "State merging: " << stateMerger->getRegionCount() << " region(s), "
+                       << stateMerger->getMergedStateCount() << " state(s) merged, "
+                       << stateMerger->getFlushCount() << " flush(es)\n";
+        }
+        {
+            const StateAllocator &stateAllocator = executor->getStateAllocator();
+            int allocatedCount = stateAllocator.getAllocatedStateCount();
+            progInfo() << "State pool: peak " << stateAllocator.getPeakAliveStateCount() << " alive, "
+                       << stateAllocator.getPoolBytes() / 1024 << " KB, "
+                       << floatToString(allocatedCount == 0 ? 0 :
+                                        100.0 * stateAllocator.getReusedSlotCount() / allocatedCount, 2)
+                       << "% allocations reused\n";
+        }
+
+        if (solverCostTracker && !solverCostTracker->empty()) {
+            progInfo() << "Solver hot spots:\n";
+            solverCostTracker->printReport(progInfo(), 10);
+
+            if (!outputPath.empty()) {
+                PathString filename(outputPath);
+                llvm::sys::path::append(filename, "solver-hotspots" + TestCaseNameSuffix + ".log");
+                std::error_code errorCode;
+                llvm::raw_fd_ostream fs(filename, errorCode, llvm::sys::fs::F_None);
+                if (errorCode) {
+                    newProgErr() << "Failed to open " << filename << "\n";
+                } else {
+                    solverCostTracker->printReport(fs);
+                }
+            }
+        }
 
         if (DumpIssuesToFile) {
-            progInfo() << "IndependentSolver Queries: " << klee::stats::independentSolverQueries << "\n";
-            progInfo() << "IndependentSolver Time: " << klee::stats::independentSolverTime << "\n";
-            progInfo() << "getIndependentConstraints Time: " << klee::stats::getIndependentConstraintsTime << "\n";
-            progInfo() << "IndElemSet Cache Hits: " << klee::stats::independentElementSetCacheHits << "\n";
-            progInfo() << "IndElemSet Cache Misses: " << klee::stats::independentElementSetCacheMisses << "\n";
+            progInfo() << "IndependentSolver Queries: "
+                       << statsAtStart.since(klee::stats::independentSolverQueries) << "\n";
+            progInfo() << "IndependentSolver Time: " << statsAtStart.since(klee::stats::independentSolverTime) << "\n";
+            progInfo() << "getIndependentConstraints Time: "
+                       << statsAtStart.since(klee::stats::getIndependentConstraintsTime) << "\n";
+            progInfo() << "IndElemSet Cache Hits: "
+                       << statsAtStart.since(klee::stats::independentElementSetCacheHits) << "\n";
+            progInfo() << "IndElemSet Cache Misses: "
+                       << statsAtStart.since(klee::stats::independentElementSetCacheMisses) << "\n";
+            // The cache is shared by all test programs
             progInfo() << "IndElemSet Cache Size: " << klee::stats::independentElementSetCacheSize << "\n";
-            progInfo() << "IndElemSet Cache Lookup Time: " << klee::stats::independentElementSetCacheLookupTime << "\n";
-            progInfo() << "IndElemSet Cache Construct Time: " << klee::stats::independentElementSetConstructTime << "\n";
+            progInfo() << "IndElemSet Cache Lookup Time: "
+                       << statsAtStart.since(klee::stats::independentElementSetCacheLookupTime) << "\n";
+            progInfo() << "IndElemSet Cache Construct Time: "
+                       << statsAtStart.since(klee::stats::independentElementSetConstructTime) << "\n";
+
+            progInfo() << "IntervalSolver Queries: " << statsAtStart.since(klee::stats::intervalSolverQueries) << "\n";
+            progInfo() << "IntervalSolver Hits: " << statsAtStart.since(klee::stats::intervalSolverHits) << "\n";
+
+            progInfo() << "EnumerationSolver Queries: "
+                       << statsAtStart.since(klee::stats::enumerationSolverQueries) << "\n";
+            progInfo() << "EnumerationSolver Hits: " << statsAtStart.since(klee::stats::enumerationSolverHits) << "\n";
 
-            progInfo() << "CacheSolver Hits: " << klee::stats::queryCacheHits << "\n";
-            progInfo() << "CacheSolver Misses: " << klee::stats::queryCacheMisses << "\n";
+            progInfo() << "CacheSolver Hits: " << statsAtStart.since(klee::stats::queryCacheHits) << "\n";
+            progInfo() << "CacheSolver Misses: " << statsAtStart.since(klee::stats::queryCacheMisses) << "\n";
 
-            progInfo() << "CexCacheSolver Hits: " << klee::stats::queryCexCacheHits << "\n";
-            progInfo() << "CexCacheSolver Misses: " << klee::stats::queryCexCacheMisses << "\n";
-            progInfo() << "CexCacheSolver Time: " << klee::stats::cexCacheTime << "\n";
+            progInfo() << "CexCacheSolver Hits: " << statsAtStart.since(klee::stats::queryCexCacheHits) << "\n";
+            progInfo() << "CexCacheSolver Misses: " << statsAtStart.since(klee::stats::queryCexCacheMisses) << "\n";
+            progInfo() << "CexCacheSolver Time: " << statsAtStart.since(klee::stats::cexCacheTime) << "\n";
 
-            progInfo() << "STPSolver Queries: " << klee::stats::queries << "\n";
-            progInfo() << "STPSolver Time: " << klee::stats::queryTime << "\n";
+            progInfo() << "STPSolver Queries: " << statsAtStart.since(klee::stats::queries) << "\n";
+            progInfo() << "STPSolver Time: " << statsAtStart.since(klee::stats::queryTime) << "\n";
 
             progInfo() << "SymAddr Cache Hits: " << executor->symAddrCacheHits;
             if (goldExecutor) progInfo() << ", " << goldExecutor->symAddrCacheHits;
@@ -922,8 +1744,30 @@ int main(int argc, char **argv) {
             progInfo() << "SymAddr Cache Misses: " << executor->symAddrCacheMisses;
             if (goldExecutor) progInfo() << ", " << goldExecutor->symAddrCacheMisses;
             progInfo() << "\n";
+            if (goldExecutionTree) {
+                progInfo() << "Gold Execution Tree Nodes: " << goldExecutionTree->getNodeCount() << "\n";
+            }
         }
 
+        if (workerPool->isSplit() && !workerPool->isChild()) {
+            // Stop other workers and merge their issues and coverage
+            int failedExitCode = workerPool->collectResults(*issuePackage, loader->getMem(), coverageTracker.get());
+            timedInfo() << "Merged results of all workers. "
+                        << "Edge coverage: " << floatToString(coverageTracker->calculateCoverage() * 100, 2) << "%\n";
+            if (failedExitCode != 0 && status == TestStatus::OK) {
+                status = failedExitCode == (int) TestStatus::GOLD_ISSUE ? TestStatus::GOLD_ISSUE
+                                                                        : TestStatus::WORKER_FAILURE;
+            }
+        }
+    }
+
+    if (status != TestStatus::OK) {
+        // Results are incomplete. Do not generate test cases or report for this test program.
+        if (workerPool->isChild()) {
+            llvm::llvm_shutdown();
+            exit((int) status);  // picked up by the main worker in collectIssues()
+        }
+        return status;
     }
 
 #if DUMP_SEGMENT_COVERING_STATES
@@ -960,8 +1804,10 @@ int main(int argc, char **argv) {
                                                        loader->getInitPC());
 
     // Generate coverage graph
-    if (!outputPath.empty() && GenerateFinalFlowGraph) {
-        FlowGraphVisualizer::visualizeCoverage(outputPath, flowGraph.get(), coverageTracker.get());
+    if (!outputPath.empty() && GenerateFinalFlowGraph && !workerPool->isChild()) {
+        PhaseProfiler::Scope scope(profiler.get(), PhaseProfiler::RESULT_GENERATION);
+        FlowGraphVisualizer::visualizeCoverage(outputPath, flowGraph.get(), coverageTracker.get(),
+                                               solverCostTracker.get());
     }
 
 #if VISUALIZE_SEGMENT_COVERING_PATHS
@@ -989,21 +1835,15 @@ int main(int argc, char **argv) {
 
     map<const State *, Assignment> assignments;
 
-    for (const auto &it : filteredPackage.getIssues()) {
-        for (const auto &info : it.second) {
-            if (info.s != nullptr) {
-                // Generate each test case only for once (may be reused in multiple issues)
-                if (assignments.find(info.s) == assignments.end()) {
-                    if (it.first.type < klc3::Issue::RUNTIME_ISSUE_COUNT) {
-                        // Runtime issues are raised during execution of test program and don't rely on comparison,
-                        // So constraints of test state itself suffice.
-                        assignments.emplace(info.s, variableInductor->induceVariables(info.s->constraints));
-                    } else {
-                        auto it2 = finalConstraintSets.find(info.s);
-                        assert(it2 != finalConstraintSets.end() && "Missing final constraints");
-                        assignments.emplace(info.s, variableInductor->induceVariables(it2->second));
+    {
+        PhaseProfiler::Scope scope(profiler.get(), PhaseProfiler::VARIABLE_INDUCTION);
+        for (const auto &it : filteredPackage.getIssues()) {
+            for (const auto &info : it.second) {
+                if (info.s != nullptr) {
+                    // Generate each test case only for once (may be reused in multiple issues)
+                    if (assignments.find(info.s) == assignments.end()) {
+                        assignments.emplace(info.s, induceAssignment(info.s, it.first.type));
                     }
-
                 }
             }
         }
@@ -1016,22 +1856,39 @@ int main(int argc, char **argv) {
     /// ================================ Generate Test Case Files ================================
 
     // Generate states that triggered issues
-    map<const State *, string> testCaseBasenames;
-    for (const auto &it : filteredPackage.getIssues()) {
-        for (const auto &info : it.second) {
-            if (info.s != nullptr) {
-                // Generate each test case only for once (may be reused in multiple issues)
-                if (testCaseBasenames.find(info.s) == testCaseBasenames.end()) {
-                    testCaseBasenames[info.s] = generator->completeState(info.s, assignments[info.s], {});
-                    // progInfo() << "S" << info.s->getUID() << " generated as " << testCaseBasenames[info.s] << "\n";
+    {
+        PhaseProfiler::Scope scope(profiler.get(), PhaseProfiler::RESULT_GENERATION);
+        map<const State *, string> testCaseBasenames;
+        for (const auto &it : filteredPackage.getIssues()) {
+            for (const auto &info : it.second) {
+                if (info.s != nullptr) {
+                    // Generate each test case only for once (may be reused in multiple issues)
+                    if (testCaseBasenames.find(info.s) == testCaseBasenames.end()) {
+                        testCaseBasenames[info.s] = generator->completeState(info.s, assignments[info.s], {});
+                        // progInfo() << "S" << info.s->getUID() << " generated as " << testCaseBasenames[info.s] << "\n";
+                    }
+                    info.generatedCaseName = testCaseBasenames[info.s];
                 }
-                info.generatedCaseName = testCaseBasenames[info.s];
             }
         }
     }
 
+    if (profiler) {
+        progInfo() << "Phase breakdown";
+        if (workerPool->getWorkerIndex() != 0) progInfo() << " of worker " << workerPool->getWorkerIndex();
+        progInfo() << ":\n";
+        profiler->printBreakdown(progInfo());
+    }
+
     /// ================================ Generate Report ================================
 
+    if (workerPool->isChild()) {
+        // Only the main worker generates the report
+        workerPool->sendResults(filteredPackage);
+        llvm::llvm_shutdown();
+        exit(0);  // do not go back to main()
+    }
+
     generator->generateGlobalReport(filteredPackage);
 
     if (DumpIssuesToFile && !outputPath.empty()) {
@@ -1041,7 +1898,7 @@ int main(int argc, char **argv) {
         llvm::raw_fd_ostream fs(filename, errorCode, llvm::sys::fs::F_None);
         if (errorCode) {
             newProgErr() << "Failed to open " << filename << "\n";
-            return 1;
+            return TestStatus::OUTPUT_ERROR;
         }
         ReportFormatterBrief().generateReport(fs, filteredPackage);
         fs.close();
@@ -1054,6 +1911,5 @@ int main(int argc, char **argv) {
      * are still alive, so that we don't need to care about the order of destruction.
      */
 
-    llvm::llvm_shutdown();
-    return 0;
+    return TestStatus::OK;
 }
@@ -0,0 +1,256 @@
+//===-- ExprTapeTest.cpp --------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+// NOTE: [liuzikai] added for klc3
+
+#include "gtest/gtest.h"
+
+#include "klee/Expr/ArrayCache.h"
+#include "klee/Expr/Assignment.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Expr/ExprTape.h"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+static ArrayCache ac;
+
+ref<Expr> int16(uint64_t value) {
+  return ConstantExpr::create(value, Expr::Int16);
+}
+
+class ExprTapeTest : public ::testing::Test {
+protected:
+  const Array *words; // Int16 -> Int16, as klc3 creates
+  const Array *bytes; // Int32 -> Int8
+  const Array *table; // constant
+  ref<Expr> w[4];
+  std::vector<ref<Expr>> exprs;
+
+  std::mt19937 rng{0};
+  std::vector<std::unique_ptr<Assignment>> assignments;
+
+  void SetUp() override {
+    words = ac.CreateArray("tape_words", 4, nullptr, nullptr, Expr::Int16,
+                           Expr::Int16);
+    bytes = ac.CreateArray("tape_bytes", 4);
+    std::vector<ref<ConstantExpr>> tableValues;
+    for (unsigned i = 0; i < 4; i++)
+      tableValues.push_back(ConstantExpr::create(0x1111 * (i + 1), Expr::Int16));
+    table = ac.CreateArray("tape_table", 4, &tableValues.front(),
+                           &tableValues.back() + 1, Expr::Int16, Expr::Int16);
+
+    UpdateList wordUpdates(words, nullptr);
+    for (unsigned i = 0; i < 4; i++)
+      w[i] = ReadExpr::create(wordUpdates, int16(i));
+    ref<Expr> b32 = Expr::createTempRead(bytes, Expr::Int32);
+    ref<Expr> shift = AndExpr::create(w[1], int16(15));
+    ref<Expr> divisor = OrExpr::create(w[1], int16(1));
+
+    // Reads with symbolic indices, through updates and from a constant array
+    UpdateList updated = wordUpdates;
+    updated.extend(int16(1), w[3]);
+    updated.extend(AndExpr::create(w[2], int16(3)), int16(0x1234));
+    ref<Expr> index = AndExpr::create(w[0], int16(3));
+
+    exprs = {
+        AddExpr::create(w[0], MulExpr::create(w[1], int16(3))),
+        SubExpr::create(NotExpr::create(w[0]), w[2]),
+        AndExpr::create(OrExpr::create(w[0], w[1]),
+                        XorExpr::create(w[2], int16(0x00FF))),
+        ShlExpr::create(w[0], shift),
+        LShrExpr::create(w[0], shift),
+        AShrExpr::create(w[0], shift),
+        UDivExpr::create(w[0], divisor),
+        SDivExpr::create(w[0], divisor),
+        URemExpr::create(w[0], divisor),
+        SRemExpr::create(w[0], divisor),
+        SelectExpr::create(UltExpr::create(w[0], w[1]), w[2], w[3]),
+        EqExpr::create(w[0], w[1]),
+        NeExpr::create(w[0], w[1]),
+        UltExpr::create(w[0], w[1]),
+        UleExpr::create(w[0], w[1]),
+        SltExpr::create(w[0], w[1]),
+        SleExpr::create(w[0], w[1]),
+        ExtractExpr::create(w[0], 3, Expr::Int8),
+        SExtExpr::create(ExtractExpr::create(w[0], 0, Expr::Int8), Expr::Int16),
+        ZExtExpr::create(ExtractExpr::create(w[1], 4, Expr::Bool), Expr::Int16),
+        ConcatExpr::create(w[0], w[1]),
+        AddExpr::create(b32, ConstantExpr::create(0x80000000, Expr::Int32)),
+        SExtExpr::create(b32, Expr::Int64),
+        ReadExpr::create(updated, index),
+        ReadExpr::create(UpdateList(table, nullptr), index),
+        // Shared subexpressions
+        AddExpr::create(MulExpr::create(w[1], int16(3)),
+                        SubExpr::create(NotExpr::create(w[0]), w[2])),
+    };
+
+    // Boundary values and random ones
+    const unsigned char pool[] = {0x00, 0x01, 0x7F, 0x80, 0xFF};
+    for (unsigned i = 0; i < 64; i++) {
+      std::vector<unsigned char> wordBytes(8), byteBytes(4);
+      for (auto &v : wordBytes)
+        v = (rng() & 1) ? pool[rng() % 5] : (unsigned char) rng();
+      for (auto &v : byteBytes)
+        v = (rng() & 1) ? pool[rng() % 5] : (unsigned char) rng();
+      assignments.push_back(std::make_unique<Assignment>(
+          std::vector<const Array *>{words, bytes},
+          std::vector<std::vector<unsigned char>>{wordBytes, byteBytes}));
+    }
+  }
+
+  static uint64_t evaluate(const Assignment &a, const ref<Expr> &e) {
+    ref<Expr> value = a.evaluate(e);
+    EXPECT_TRUE(isa<ConstantExpr>(value)) << e;
+    return isa<ConstantExpr>(value) ? cast<ConstantExpr>(value)->getZExtValue()
+                                    : 0;
+  }
+
+  std::unique_ptr<Assignment> withWord(unsigned index, uint16_t value) {
+    std::vector<unsigned char> wordBytes(8, 0x55);
+    wordBytes[index * 2] = (unsigned char) value;
+    wordBytes[index * 2 + 1] = (unsigned char) (value >> 8);
+    return std::make_unique<Assignment>(
+        std::vector<const Array *>{words},
+        std::vector<std::vector<unsigned char>>{wordBytes});
+  }
+};
+
+TEST_F(ExprTapeTest, RunMatchesEvaluate) {
+  ExprTape tape;
+  for (const auto &e : exprs)
+    EXPECT_EQ(tape.compile(e), tape.getRoots().size() - 1);
+
+  for (const auto &a : assignments) {
+    ASSERT_TRUE(tape.run(*a));
+    for (unsigned r = 0; r < exprs.size(); r++)
+      EXPECT_EQ(evaluate(*a, exprs[r]), tape.getValue(r)) << exprs[r];
+  }
+}
+
+TEST_F(ExprTapeTest, RunBatchMatchesEvaluate) {
+  ExprTape tape;
+  for (const auto &e : exprs)
+    tape.compile(e);
+
+  // A partial batch first, then full ones and the rest
+  std::vector<const Assignment *> batch;
+  std::vector<bool> evaluated;
+  for (size_t begin = 0; begin < assignments.size(); begin += batch.size()) {
+    size_t size = std::min((size_t) ExprTape::BatchSize,
+                           assignments.size() - begin);
+    if (begin == 0)
+      size = 7;
+    batch.clear();
+    for (size_t i = 0; i < size; i++)
+      batch.push_back(assignments[begin + i].get());
+
+    tape.runBatch(batch, evaluated);
+    for (size_t i = 0; i < size; i++) {
+      ASSERT_TRUE(evaluated[i]);
+      for (unsigned r = 0; r < exprs.size(); r++)
+        EXPECT_EQ(evaluate(*batch[i], exprs[r]), tape.getBatchValue(r, i))
+            << exprs[r];
+    }
+  }
+}
+
+TEST_F(ExprTapeTest, Failures) {
+  // Division by zero fails only under the assignments that divide by zero
+  ExprTape division;
+  division.compile(UDivExpr::create(w[0], w[1]));
+  division.compile(AddExpr::create(w[0], w[1]));
+  auto zero = withWord(1, 0);
+  auto nonZero = withWord(1, 7);
+  EXPECT_FALSE(division.run(*zero));
+  ASSERT_TRUE(division.run(*nonZero));
+  EXPECT_EQ(evaluate(*nonZero, division.getRoots()[0]), division.getValue(0));
+
+  std::vector<bool> evaluated;
+  division.runBatch({nonZero.get(), zero.get(), nonZero.get()}, evaluated);
+  EXPECT_TRUE(evaluated[0]);
+  EXPECT_FALSE(evaluated[1]);
+  EXPECT_TRUE(evaluated[2]);
+  EXPECT_EQ(evaluate(*nonZero, division.getRoots()[1]),
+            division.getBatchValue(1, 2));
+
+  // Free values are not evaluated, while missing bindings read as 0 otherwise
+  ExprTape read;
+  read.compile(AddExpr::create(w[0], int16(1)));
+  Assignment freeValues(true), missing(false);
+  EXPECT_FALSE(read.run(freeValues));
+  ASSERT_TRUE(read.run(missing));
+  EXPECT_EQ(evaluate(missing, read.getRoots()[0]), read.getValue(0));
+  read.runBatch({&freeValues, &missing, assignments[0].get()}, evaluated);
+  EXPECT_FALSE(evaluated[0]);
+  EXPECT_TRUE(evaluated[1]);
+  EXPECT_TRUE(evaluated[2]);
+  EXPECT_EQ(1u, read.getBatchValue(0, 1));
+
+  // Roots wider than 64 bits are not supported
+  ExprTape wide;
+  ref<Expr> b64 =
+      SExtExpr::create(Expr::createTempRead(bytes, Expr::Int32), Expr::Int64);
+  wide.compile(EqExpr::create(w[0], w[1]));
+  wide.compile(ConcatExpr::create(b64, b64));
+  EXPECT_FALSE(wide.run(*assignments[0]));
+  wide.runBatch({assignments[0].get()}, evaluated);
+  EXPECT_FALSE(evaluated[0]);
+}
+
+TEST_F(ExprTapeTest, AssignmentBatchFindsFirstSatisfying) {
+  // Constraints satisfied by about one in eight assignments
+  ExprTape key;
+  key.compile(UltExpr::create(w[0], int16(0x8000)));
+  key.compile(EqExpr::create(AndExpr::create(w[1], int16(3)), int16(1)));
+  key.compile(NeExpr::create(w[2], w[3]));
+  key.compile(NeExpr::create(UDivExpr::create(w[0], w[2]), int16(0xFFFF)));
+  const std::vector<ref<Expr>> &roots = key.getRoots();
+
+  // Candidates that can't be evaluated on the tape, which fall back to
+  // Assignment::evaluate. The one dividing by zero satisfies the other
+  // constraints.
+  Assignment freeValues(true);
+  auto divisorZero = withWord(2, 0);
+
+  std::vector<Assignment *> candidates;
+  for (unsigned i = 0; i < assignments.size(); i++) {
+    if (i % 10 == 3)
+      candidates.push_back(&freeValues);
+    if (i % 10 == 6)
+      candidates.push_back(divisorZero.get());
+    candidates.push_back(assignments[i].get());
+  }
+
+  // From each offset, so that the first satisfying candidate is found in full
+  // batches, in the partial one at the end, or not at all
+  for (unsigned offset = 0; offset < candidates.size(); offset += 5) {
+    Assignment *expected = nullptr;
+    for (unsigned i = offset; i < candidates.size() && !expected; i++) {
+      if (candidates[i]->satisfies(roots.begin(), roots.end()))
+        expected = candidates[i];
+    }
+
+    AssignmentBatch batch(key);
+    bool found = false;
+    for (unsigned i = offset; i < candidates.size() && !found; i++)
+      found = batch.add(candidates[i]);
+    if (!found)
+      found = batch.flush();
+    EXPECT_EQ(expected != nullptr, found) << "offset " << offset;
+    EXPECT_EQ(expected, batch.found) << "offset " << offset;
+  }
+}
+
+} // namespace
@@ -0,0 +1,206 @@
+//
+// Created by liuzikai on 10/17/26.
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+
+#include "gtest/gtest.h"
+
+#include "klc3/Core/LC3ExprBuilder.h"
+
+#include "klee/Expr/ArrayCache.h"
+#include "klee/Expr/Assignment.h"
+
+#include <functional>
+
+namespace klc3 {
+namespace {
+
+using BuildFunction = std::function<ref<Expr>(ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &y)>;
+
+// Words around the boundaries of the LC-3 idioms (signs, masks, overflow)
+const uint16_t values[] = {0x0000, 0x0001, 0x0002, 0x0003, 0x0007, 0x0008, 0x000F, 0x0010, 0x007F, 0x0080, 0x00FF,
+                           0x0100, 0x1234, 0x3FFF, 0x4000, 0x7FFE, 0x7FFF, 0x8000, 0x8001, 0xC000, 0xFF00, 0xFFFE,
+                           0xFFFF};
+
+class LC3ExprBuilderTest : public ::testing::Test {
+protected:
+
+    klee::ArrayCache arrayCache;
+    const Array *array;
+    ref<Expr> x, y;
+
+    std::unique_ptr<ExprBuilder> defaultBuilder;
+    std::unique_ptr<ExprBuilder> lc3Builder;
+
+    void SetUp() override {
+        array = arrayCache.CreateArray("xy", 2, nullptr, nullptr, Expr::Int16, Expr::Int16);
+        UpdateList updates(array, nullptr);
+        x = klee::ReadExpr::create(updates, ConstantExpr::create(0, Expr::Int16));
+        y = klee::ReadExpr::create(updates, ConstantExpr::create(1, Expr::Int16));
+        defaultBuilder.reset(klee::createConstantFoldingExprBuilder(klee::createDefaultExprBuilder()));
+        lc3Builder.reset(new LC3ExprBuilder(klee::createConstantFoldingExprBuilder(klee::createDefaultExprBuilder())));
+    }
+
+    uint64_t evaluate(const ref<Expr> &e, uint16_t xValue, uint16_t yValue) {
+        vector<unsigned char> bytes = {(unsigned char) xValue, (unsigned char) (xValue >> 8),
+                                       (unsigned char) yValue, (unsigned char) (yValue >> 8)};
+        Assignment assignment(vector<const Array *>{array}, vector<vector<unsigned char>>{bytes});
+        auto value = dyn_cast<ConstantExpr>(assignment.evaluate(e));
+        EXPECT_TRUE(value != nullptr) << e;
+        return value != nullptr ? value->getZExtValue() : 0;
+    }
+
+    /**
+     * Check that the rewritten expression has the same value as the one of the default builder on all pairs of
+     * values
+     */
+    void expectEquivalent(const BuildFunction &build) {
+        ref<Expr> expected = build(defaultBuilder.get(), x, y);
+        ref<Expr> rewritten = build(lc3Builder.get(), x, y);
+        ASSERT_EQ(expected->getWidth(), rewritten->getWidth());
+        for (uint16_t xValue : values) {
+            for (uint16_t yValue : values) {
+                EXPECT_EQ(evaluate(expected, xValue, yValue), evaluate(rewritten, xValue, yValue))
+                                    << "x = " << xValue << ", y = " << yValue << "\n"
+                                    << "default: " << expected << "\n"
+                                    << "rewritten: " << rewritten;
+            }
+        }
+    }
+};
+
+ref<Expr> c16(ExprBuilder *b, uint16_t value) { return b->Constant(value, Expr::Int16); }
+
+// -x as built by NOT then ADD #1
+ref<Expr> negate(ExprBuilder *b, const ref<Expr> &e) { return b->Add(b->Not(e), c16(b, 1)); }
+
+TEST_F(LC3ExprBuilderTest, Sums) {
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &) {
+        return negate(b, x);
+    });
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &y) {
+        return b->Add(x, negate(b, y));
+    });
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &y) {
+        return b->Sub(b->Add(x, c16(b, 5)), b->Add(y, c16(b, 7)));
+    });
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &) {
+        ref<Expr> e = x;
+        for (int i = 0; i < 4; i++) e = b->Add(e, e);  // ADD R,R,R
+        return e;
+    });
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &y) {
+        return b->Not(b->Sub(b->Mul(c16(b, 3), x), y));
+    });
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &y) {
+        return b->Mul(b->Add(x, b->Not(y)), c16(b, 0xFFFF));
+    });
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &) {
+        return b->Not(b->Not(x));
+    });
+}
+
+TEST_F(LC3ExprBuilderTest, Equalities) {
+    // NOT, ADD #1, ADD, BRz
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &y) {
+        return b->Eq(b->Add(negate(b, y), x), c16(b, 0));
+    });
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &) {
+        return b->Eq(b->Add(x, c16(b, 0xFFD0)), c16(b, 0));  // x == '0'
+    });
+    // Odd and even coefficients
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &) {
+        return b->Eq(b->Mul(c16(b, 3), x), c16(b, 7));
+    });
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &) {
+        return b->Eq(b->Mul(c16(b, 12), x), c16(b, 0x0030));
+    });
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &) {
+        return b->Eq(b->Mul(c16(b, 12), x), c16(b, 0x0032));
+    });
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &y) {
+        return b->Ne(b->Add(x, b->Mul(c16(b, 2), y)), b->Sub(y, c16(b, 1)));
+    });
+}
+
+TEST_F(LC3ExprBuilderTest, Masks) {
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &) {
+        return b->And(b->And(x, c16(b, 0x00FF)), c16(b, 0x0F0F));
+    });
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &) {
+        return b->And(c16(b, 0x7FFF), b->And(x, c16(b, 0x00FF)));
+    });
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &) {
+        return b->And(b->And(x, c16(b, 0x00F0)), c16(b, 0x000F));
+    });
+    // AND R2,R1,R3; BRz with a single-bit mask
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &) {
+        return b->Eq(b->And(x, c16(b, 0x0008)), c16(b, 0));
+    });
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &) {
+        return b->Eq(b->And(c16(b, 0x8000), x), c16(b, 0x8000));
+    });
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &) {
+        return b->Eq(b->And(x, c16(b, 0x0008)), c16(b, 0x0004));
+    });
+}
+
+TEST_F(LC3ExprBuilderTest, SignTests) {
+    // ADD R1,R1,R1; BRn
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &) {
+        return b->Slt(b->Add(x, x), c16(b, 0));
+    });
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &) {
+        return b->Sge(b->Mul(c16(b, 4), x), c16(b, 0));
+    });
+    // Comparisons that can't overflow
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &y) {
+        return b->Sle(b->Sub(b->And(x, c16(b, 0x00FF)), b->And(y, c16(b, 0x00FF))), c16(b, 0));
+    });
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &) {
+        return b->Slt(c16(b, 0), b->Add(b->And(x, c16(b, 0x007F)), c16(b, 0xFFD0)));
+    });
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &) {
+        return b->Sgt(b->Add(b->And(x, c16(b, 0x007F)), c16(b, 3)), c16(b, 0));
+    });
+    // Comparisons that may overflow, where the overflow is part of the semantics
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &y) {
+        return b->Slt(b->Sub(x, y), c16(b, 0));
+    });
+    expectEquivalent([](ExprBuilder *b, const ref<Expr> &x, const ref<Expr> &) {
+        return b->Sle(b->Add(x, c16(b, 5)), c16(b, 0));
+    });
+}
+
+TEST_F(LC3ExprBuilderTest, Simplifications) {
+    ExprBuilder *b = lc3Builder.get();
+
+    // Terms that cancel out are dropped
+    EXPECT_EQ(x, b->Sub(b->Add(x, y), y));
+    EXPECT_EQ(x, b->Not(b->Not(x)));
+    EXPECT_TRUE(b->Sub(x, x)->isZero());
+    EXPECT_TRUE(b->Eq(b->Add(x, c16(b, 5)), b->Add(c16(b, 7), x))->isFalse());
+
+    // Repeated doubling is one multiplication
+    ref<Expr> e = x;
+    for (int i = 0; i < 4; i++) e = b->Add(e, e);
+    EXPECT_EQ(Expr::Mul, e->getKind());
+
+    // 12 * x can't be odd
+    EXPECT_TRUE(b->Eq(b->Mul(c16(b, 12), x), c16(b, 0x0031))->isFalse());
+
+    // A single-bit mask tested against zero is a bit extraction
+    ref<Expr> bit = b->Eq(b->And(x, c16(b, 0x0008)), c16(b, 0x0008));
+    ASSERT_EQ(Expr::Extract, bit->getKind());
+    EXPECT_EQ(x, bit->getKid(0));
+
+    // Expressions of other widths are built as they are
+    ref<Expr> x8 = b->Extract(x, 0, Expr::Int8);
+    ref<Expr> sum8 = b->Add(x8, x8);
+    EXPECT_EQ(Expr::Add, sum8->getKind());
+}
+
+}
+}
@@ -0,0 +1,164 @@
+//
+// Created by liuzikai on 10/17/26.
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+
+#include "gtest/gtest.h"
+
+#include "klc3/Core/MemoryManager.h"
+
+#include <random>
+
+namespace klc3 {
+namespace {
+
+class MemoryManagerTest : public ::testing::Test {
+protected:
+
+    std::unique_ptr<ExprBuilder> builder;
+    vector<ref<MemValue>> baseMem;
+
+    void SetUp() override {
+        builder.reset(klee::createDefaultExprBuilder());
+        baseMem.assign(0x10000, nullptr);
+        for (uint16_t addr : {0x3000, 0x3001, 0x30FF, 0x4000, 0x7FFF}) baseMem[addr] = value(addr, 0xBA5E);
+    }
+
+    ref<MemValue> value(uint16_t addr, uint16_t v) {
+        return DataValue::alloc(addr, builder->Constant(v, Expr::Int16));
+    }
+
+    static uint16_t constantOf(const ref<MemValue> &val) {
+        return (uint16_t) dyn_cast<ConstantExpr>(val->e)->getZExtValue();
+    }
+
+    // Addresses that cross the nibbles of every level of the trie, avoiding device registers
+    static vector<uint16_t> spreadAddresses() {
+        return {0x0000, 0x000F, 0x0010, 0x00FF, 0x0100, 0x0FFF, 0x1000, 0x3000, 0x3001, 0x30FF, 0x4000, 0x7FFF,
+                0x8000, 0xFDFF, 0xFFFF};
+    }
+};
+
+TEST_F(MemoryManagerTest, ReadWrite) {
+    MemoryManager mem(builder.get(), baseMem.data());
+    EXPECT_EQ(0u, mem.memUsage());
+    EXPECT_TRUE(mem.writtenValues().empty());
+    EXPECT_EQ(baseMem[0x3000].get(), mem.read(0x3000).get());
+    EXPECT_TRUE(mem.read(0x5000).isNull());
+
+    vector<uint16_t> addresses = spreadAddresses();
+    for (auto it = addresses.rbegin(); it != addresses.rend(); ++it) {
+        EXPECT_EQ(MemoryManager::WRITE_SUCCESS, mem.write(*it, value(*it, *it ^ 0x5A5A)));
+    }
+    EXPECT_EQ(addresses.size(), mem.memUsage());
+    for (uint16_t addr : addresses) EXPECT_EQ(addr ^ 0x5A5A, constantOf(mem.read(addr)));
+    EXPECT_EQ(baseMem[0x3002].get(), mem.read(0x3002).get());
+
+    // Overwriting doesn't take another slot
+    mem.writeData(0x3000, builder->Constant(1, Expr::Int16));
+    EXPECT_EQ(addresses.size(), mem.memUsage());
+    EXPECT_EQ(1, constantOf(mem.read(0x3000)));
+
+    // In the order of addresses
+    vector<ref<MemValue>> written = mem.writtenValues();
+    ASSERT_EQ(addresses.size(), written.size());
+    for (size_t i = 0; i < written.size(); i++) EXPECT_EQ(addresses[i], written[i]->addr);
+}
+
+TEST_F(MemoryManagerTest, DeviceRegisters) {
+    MemoryManager mem(builder.get(), baseMem.data());
+    EXPECT_EQ(MemoryManager::WRITE_DDR, mem.writeData(0xFE06, builder->Constant('A', Expr::Int16)));
+    EXPECT_EQ(MemoryManager::WRITE_SUCCESS, mem.writeData(0xFFFE, builder->Constant(0x8000, Expr::Int16)));
+    EXPECT_EQ(MemoryManager::WRITE_HALT, mem.writeData(0xFFFE, builder->Constant(0, Expr::Int16)));
+    EXPECT_EQ(0x8000, constantOf(mem.read(0xFE04)));
+    EXPECT_EQ(0u, mem.memUsage());
+}
+
+TEST_F(MemoryManagerTest, CopyOnWrite) {
+    MemoryManager a(builder.get(), baseMem.data());
+    for (uint16_t addr : spreadAddresses()) a.write(addr, value(addr, 1));
+
+    MemoryManager b(a);
+    b.write(0x3000, value(0x3000, 2));
+    b.write(0x3002, value(0x3002, 2));
+    a.write(0x0010, value(0x0010, 3));
+
+    EXPECT_EQ(1, constantOf(a.read(0x3000)));
+    EXPECT_EQ(2, constantOf(b.read(0x3000)));
+    EXPECT_EQ(baseMem[0x3002].get(), a.read(0x3002).get());
+    EXPECT_EQ(2, constantOf(b.read(0x3002)));
+    EXPECT_EQ(3, constantOf(a.read(0x0010)));
+    EXPECT_EQ(1, constantOf(b.read(0x0010)));
+    EXPECT_EQ(a.read(0xFFFF).get(), b.read(0xFFFF).get());  // untouched values are shared
+    EXPECT_EQ(spreadAddresses().size(), a.memUsage());
+    EXPECT_EQ(spreadAddresses().size() + 1, b.memUsage());
+}
+
+// Random writes to forked copies, checked against a map per copy
+TEST_F(MemoryManagerTest, MatchesModel) {
+    std::mt19937 rng(0);
+    // Clustered addresses share trie nodes, scattered ones don't
+    auto randomAddress = [&]() -> uint16_t {
+        uint16_t addr = (rng() & 1) ? (uint16_t) (0x3000 + rng() % 0x140) : (uint16_t) rng();
+        return (addr >= 0xFE00) ? (uint16_t) (addr - 0x200) : addr;
+    };
+
+    vector<MemoryManager> mems(1, MemoryManager(builder.get(), baseMem.data()));
+    vector<map<uint16_t, ref<MemValue>>> models(1);
+    uint16_t counter = 0;
+
+    for (int step = 0; step < 2000; step++) {
+        size_t i = rng() % mems.size();
+        if (rng() % 16 == 0 && mems.size() < 12) {
+            mems.push_back(mems[i]);
+            models.push_back(models[i]);
+            continue;
+        }
+        uint16_t addr = randomAddress();
+        ref<MemValue> val = value(addr, counter++);  // fresh values, so that differences are by pointer
+        mems[i].write(addr, val);
+        models[i][addr] = val;
+    }
+
+    for (size_t i = 0; i < mems.size(); i++) {
+        const MemoryManager &mem = mems[i];
+        const auto &model = models[i];
+        ASSERT_EQ(model.size(), mem.memUsage());
+        for (const auto &it : model) EXPECT_EQ(it.second.get(), mem.read(it.first).get());
+        vector<ref<MemValue>> written = mem.writtenValues();
+        ASSERT_EQ(model.size(), written.size());
+        size_t k = 0;
+        for (const auto &it : model) EXPECT_EQ(it.second.get(), written[k++].get());
+        for (int n = 0; n < 64; n++) {
+            uint16_t addr = randomAddress();
+            if (model.find(addr) == model.end()) {
+                EXPECT_EQ(baseMem[addr].get(), mem.read(addr).get());
+            }
+        }
+    }
+
+    for (size_t i = 0; i < mems.size(); i++) {
+        for (size_t j = 0; j < mems.size(); j++) {
+            set<uint16_t> candidates;
+            for (const auto &it : models[i]) candidates.insert(it.first);
+            for (const auto &it : models[j]) candidates.insert(it.first);
+            set<uint16_t> expected;
+            for (uint16_t addr : candidates) {
+                if (mems[i].read(addr).get() != mems[j].read(addr).get()) expected.insert(addr);
+            }
+
+            set<uint16_t> visited;
+            mems[i].forEachDifference(mems[j], [&](uint16_t addr, const ref<MemValue> &va, const ref<MemValue> &vb) {
+                EXPECT_TRUE(visited.insert(addr).second) << "visited twice: " << addr;
+                EXPECT_EQ(mems[i].read(addr).get(), va.get());
+                EXPECT_EQ(mems[j].read(addr).get(), vb.get());
+            });
+            EXPECT_EQ(expected, visited) << "between copies " << i << " and " << j;
+        }
+    }
+}
+
+}
+}
@@ -0,0 +1,157 @@
+//
+// Created by liuzikai on 10/17/26.
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+
+#include "gtest/gtest.h"
+
+#include "klc3/Core/PersistentVector.hpp"
+
+#include <random>
+
+namespace klc3 {
+namespace {
+
+// Small chunks, so that a few elements cross chunk boundaries
+using Vector4 = PersistentVector<int, 4>;
+
+void expectSame(const vector<int> &expected, const Vector4 &v) {
+    ASSERT_EQ(expected.size(), v.size());
+    EXPECT_EQ(expected.empty(), v.empty());
+    for (size_t i = 0; i < expected.size(); i++) EXPECT_EQ(expected[i], v[i]) << "at " << i;
+    EXPECT_EQ(expected, vector<int>(v.begin(), v.end()));
+    if (!expected.empty()) {
+        EXPECT_EQ(expected.front(), v.front());
+        EXPECT_EQ(expected.back(), v.back());
+    }
+}
+
+TEST(PersistentVectorTest, Basic) {
+    Vector4 v;
+    expectSame({}, v);
+    vector<int> expected;
+    for (int i = 0; i < 10; i++) {
+        v.push_back(i);
+        expected.push_back(i);
+        expectSame(expected, v);
+    }
+    v.back() = 100;
+    v[2] = 200;
+    expected.back() = 100;
+    expected[2] = 200;
+    expectSame(expected, v);
+    while (!expected.empty()) {
+        v.pop_back();
+        expected.pop_back();
+        expectSame(expected, v);
+    }
+
+    Vector4 init = {1, 2, 3, 4, 5};
+    expectSame({1, 2, 3, 4, 5}, init);
+    EXPECT_EQ(5, init.emplace_back(5));
+    init.clear();
+    expectSame({}, init);
+}
+
+TEST(PersistentVectorTest, IteratorArithmetic) {
+    Vector4 v = {0, 1, 2, 3, 4, 5, 6, 7, 8};
+    auto begin = v.begin(), end = v.end();
+    EXPECT_EQ(9, end - begin);
+    EXPECT_EQ(5, *(begin + 5));
+    EXPECT_EQ(8, *(end - 1));
+    EXPECT_EQ(6, begin[6]);
+    auto it = begin;
+    it += 4;
+    EXPECT_EQ(4, *it++);
+    EXPECT_EQ(5, *it);
+    EXPECT_EQ(4, *--it);
+    EXPECT_TRUE(begin < it && it <= end && end > it && it >= begin);
+    EXPECT_EQ(v.cend(), std::find(v.cbegin(), v.cend(), 42));
+    EXPECT_EQ(3, std::find(v.begin(), v.end(), 3) - v.begin());
+}
+
+TEST(PersistentVectorTest, Comparisons) {
+    Vector4 a = {1, 2, 3, 4, 5}, b = {1, 2, 3, 4, 6}, prefix = {1, 2, 3, 4};
+    Vector4 copy = a;
+    EXPECT_TRUE(a == copy);
+    EXPECT_TRUE(a == Vector4({1, 2, 3, 4, 5}));
+    EXPECT_TRUE(a != b);
+    EXPECT_TRUE(a < b && b > a && a <= b && b >= a);
+    EXPECT_TRUE(prefix < a);
+    EXPECT_FALSE(a < copy);
+    EXPECT_TRUE(a <= copy && a >= copy);
+}
+
+TEST(PersistentVectorTest, AsStackContainer) {
+    stack<int, Vector4> s;
+    for (int i = 0; i < 6; i++) s.push(i);
+    stack<int, Vector4> t = s;
+    t.pop();
+    t.push(42);
+    EXPECT_EQ(5, s.top());
+    EXPECT_EQ(42, t.top());
+    EXPECT_EQ(6u, s.size());
+    EXPECT_FALSE(s == t);
+    t.pop();
+    t.push(5);
+    EXPECT_TRUE(s == t);
+}
+
+// Random operations on forked copies, checked against std::vector per copy
+TEST(PersistentVectorTest, CopiesAreIndependent) {
+    std::mt19937 rng(0);
+    vector<Vector4> vs(1);
+    vector<vector<int>> models(1);
+
+    for (int step = 0; step < 5000; step++) {
+        size_t i = rng() % vs.size();
+        Vector4 &v = vs[i];
+        vector<int> &model = models[i];
+        int value = (int) (rng() % 1000);
+        switch (rng() % 8) {
+            case 0:
+                if (vs.size() < 16) {
+                    vs.push_back(vs[i]);  // may reallocate, so v and model are not used after this
+                    models.push_back(models[i]);
+                }
+                break;
+            case 1:
+                if (!model.empty()) {
+                    v.pop_back();
+                    model.pop_back();
+                }
+                break;
+            case 2:
+                if (!model.empty()) {
+                    v.back() = value;
+                    model.back() = value;
+                }
+                break;
+            case 3:
+                if (!model.empty()) {
+                    size_t k = rng() % model.size();
+                    v[k] = value;
+                    model[k] = value;
+                }
+                break;
+            default:
+                v.push_back(value);
+                model.push_back(value);
+                break;
+        }
+    }
+
+    for (size_t i = 0; i < vs.size(); i++) {
+        SCOPED_TRACE("copy " + std::to_string(i));
+        expectSame(models[i], vs[i]);
+        for (size_t j = 0; j < vs.size(); j++) {
+            EXPECT_EQ(models[i] == models[j], vs[i] == vs[j]);
+            EXPECT_EQ(models[i] < models[j], vs[i] < vs[j]);
+        }
+    }
+}
+
+}
+}
@@ -0,0 +1,59 @@
+//===-- EnumerationSolverTest.cpp -----------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+// NOTE: [liuzikai] added for klc3
+
+#include "IncompleteSolverCheck.h"
+
+#include "klee/Expr/ArrayCache.h"
+#include "klee/Solver/SolverCmdLine.h"
+
+#include <memory>
+
+using namespace klee;
+
+namespace {
+
+// Kept alive for the core solver, as in SolverTest
+ArrayCache ac;
+
+// Queries over x alone are enumerated, the ones that also read y are forwarded
+TEST(EnumerationSolverTest, AgreesWithCoreSolver) {
+  const Array *array = ac.CreateArray("enumeration_xy", 2, nullptr, nullptr,
+                                      Expr::Int16, Expr::Int16);
+  UpdateList updates(array, nullptr);
+  ref<Expr> x = ReadExpr::create(updates, int16(0));
+  ref<Expr> y = ReadExpr::create(updates, int16(1));
+
+  std::unique_ptr<Solver> core(createCoreSolver(CoreSolverToUse));
+  std::unique_ptr<Solver> stage(createEnumerationSolver(createDummySolver(), 1));
+
+  std::vector<CheckedQuery> queries = lc3Queries(x, y);
+  unsigned answered = checkAgainstCoreSolver(*stage, *core, {array}, queries);
+  EXPECT_GT(answered, 0u);
+}
+
+TEST(EnumerationSolverTest, ForwardsToSecondarySolver) {
+  const Array *array = ac.CreateArray("enumeration_fwd_xy", 2, nullptr, nullptr,
+                                      Expr::Int16, Expr::Int16);
+  UpdateList updates(array, nullptr);
+  ref<Expr> x = ReadExpr::create(updates, int16(0));
+  ref<Expr> y = ReadExpr::create(updates, int16(1));
+
+  // Every query is answered, by the stage or by the core solver behind it
+  std::unique_ptr<Solver> core(createCoreSolver(CoreSolverToUse));
+  std::unique_ptr<Solver> chain(
+      createEnumerationSolver(createCoreSolver(CoreSolverToUse), 1));
+
+  std::vector<CheckedQuery> queries = lc3Queries(x, y);
+  unsigned answered = checkAgainstCoreSolver(*chain, *core, {array}, queries);
+  EXPECT_EQ(queries.size(), answered);
+}
+
+} // namespace
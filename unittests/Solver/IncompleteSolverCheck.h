@@ -0,0 +1,140 @@
+//===-- IncompleteSolverCheck.h ---------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+// NOTE: [liuzikai] added for klc3
+
+#ifndef KLEE_UNITTEST_INCOMPLETESOLVERCHECK_H
+#define KLEE_UNITTEST_INCOMPLETESOLVERCHECK_H
+
+#include "gtest/gtest.h"
+
+#include "klee/Expr/Assignment.h"
+#include "klee/Expr/Constraints.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Solver/Solver.h"
+#include "klee/Solver/SolverImpl.h"
+
+#include <vector>
+
+namespace klee {
+
+struct CheckedQuery {
+  std::vector<ref<Expr>> constraints;
+  ref<Expr> expr;
+};
+
+inline ref<Expr> int16(uint64_t value) {
+  return ConstantExpr::create(value, Expr::Int16);
+}
+
+/// Queries over two symbolic words, x and y, in the shape of the branch
+/// conditions of LC-3 programs under the constraints of their input spaces
+inline std::vector<CheckedQuery> lc3Queries(const ref<Expr> &x,
+                                            const ref<Expr> &y) {
+  std::vector<std::vector<ref<Expr>>> constraintSets = {
+      {},
+      {SleExpr::create(int16(0), x), SleExpr::create(x, int16(9))},
+      {UleExpr::create(int16(0x20), x), UleExpr::create(x, int16(0x7E))},
+      {EqExpr::create(AndExpr::create(x, int16(0xF000)), int16(0))},
+      {SltExpr::create(x, int16(3)), SltExpr::create(int16(5), x)}, // infeasible
+      {SleExpr::create(int16(0), x), SleExpr::create(x, int16(9)),
+       SleExpr::create(int16(0), y), SleExpr::create(y, int16(9))},
+  };
+  std::vector<ref<Expr>> exprs = {
+      EqExpr::create(x, int16(7)),
+      SltExpr::create(x, int16(0)),
+      UltExpr::create(AddExpr::create(x, int16(0xFFD0)), int16(10)), // digit
+      EqExpr::create(AndExpr::create(x, int16(1)), int16(0)),
+      SleExpr::create(AddExpr::create(x, int16(0xFFF6)), int16(0)),
+      UltExpr::create(int16(0x7E), x),
+      EqExpr::create(x, y),
+      SltExpr::create(AddExpr::create(x, y), int16(10)),
+  };
+  std::vector<CheckedQuery> queries;
+  for (const auto &constraints : constraintSets)
+    for (const auto &e : exprs)
+      queries.push_back({constraints, e});
+  return queries;
+}
+
+/// Check every answer that a solver stage gives on its own against the core
+/// solver. The stage should be built on top of the dummy solver, so that
+/// queries it forwards fail instead of being answered by another solver.
+/// \param objects - The arrays read by the queries
+/// \return The number of queries the stage answered at least in part
+inline unsigned checkAgainstCoreSolver(Solver &stage, Solver &core,
+                                       const std::vector<const Array *> &objects,
+                                       const std::vector<CheckedQuery> &queries) {
+  unsigned answered = 0;
+  for (const auto &q : queries) {
+    ConstraintSet constraints;
+    ConstraintManager cm(constraints);
+    for (const auto &c : q.constraints)
+      cm.addConstraint(c);
+    Query query(constraints, q.expr);
+
+    Solver::Validity expected;
+    bool feasible;
+    bool coreSuccess =
+        core.evaluate(query, expected) &&
+        core.mayBeTrue(query.withExpr(ConstantExpr::alloc(1, Expr::Bool)),
+                       feasible);
+    EXPECT_TRUE(coreSuccess) << "Core solver failed";
+    if (!coreSuccess)
+      continue;
+
+    bool hit = false;
+
+    Solver::Validity validity;
+    if (stage.evaluate(query, validity)) {
+      hit = true;
+      EXPECT_EQ(expected, validity) << "evaluate " << q.expr;
+    }
+
+    bool mustBeTrue;
+    if (stage.mustBeTrue(query, mustBeTrue)) {
+      hit = true;
+      EXPECT_EQ(expected == Solver::True, mustBeTrue) << "mustBeTrue " << q.expr;
+    }
+
+    ref<ConstantExpr> value;
+    if (stage.getValue(query, value)) {
+      hit = true;
+      EXPECT_TRUE(feasible) << "getValue " << q.expr;
+      bool possible = false;
+      EXPECT_TRUE(core.mayBeTrue(query.withExpr(EqExpr::create(q.expr, value)),
+                                 possible) &&
+                  possible)
+          << "getValue " << q.expr << " = " << value;
+    }
+
+    std::vector<std::vector<unsigned char>> values;
+    bool hasSolution;
+    if (stage.impl->computeInitialValues(query, objects, values, hasSolution)) {
+      hit = true;
+      EXPECT_EQ(expected != Solver::True, hasSolution)
+          << "getInitialValues " << q.expr;
+      if (hasSolution) {
+        Assignment assignment(objects, values);
+        EXPECT_TRUE(assignment.satisfies(constraints.begin(), constraints.end()))
+            << "getInitialValues " << q.expr;
+        EXPECT_TRUE(assignment.evaluate(q.expr)->isFalse())
+            << "getInitialValues " << q.expr;
+      }
+    }
+
+    if (hit)
+      answered++;
+  }
+  return answered;
+}
+
+} // namespace klee
+
+#endif /* KLEE_UNITTEST_INCOMPLETESOLVERCHECK_H */
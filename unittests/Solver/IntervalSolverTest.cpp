@@ -0,0 +1,58 @@
+//===-- IntervalSolverTest.cpp --------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+// NOTE: [liuzikai] added for klc3
+
+#include "IncompleteSolverCheck.h"
+
+#include "klee/Expr/ArrayCache.h"
+#include "klee/Solver/SolverCmdLine.h"
+
+#include <memory>
+
+using namespace klee;
+
+namespace {
+
+// Kept alive for the core solver, as in SolverTest
+ArrayCache ac;
+
+TEST(IntervalSolverTest, AgreesWithCoreSolver) {
+  const Array *array = ac.CreateArray("interval_xy", 2, nullptr, nullptr,
+                                      Expr::Int16, Expr::Int16);
+  UpdateList updates(array, nullptr);
+  ref<Expr> x = ReadExpr::create(updates, int16(0));
+  ref<Expr> y = ReadExpr::create(updates, int16(1));
+
+  std::unique_ptr<Solver> core(createCoreSolver(CoreSolverToUse));
+  std::unique_ptr<Solver> stage(createIntervalSolver(createDummySolver()));
+
+  std::vector<CheckedQuery> queries = lc3Queries(x, y);
+  unsigned answered = checkAgainstCoreSolver(*stage, *core, {array}, queries);
+  EXPECT_GT(answered, 0u);
+}
+
+TEST(IntervalSolverTest, ForwardsToSecondarySolver) {
+  const Array *array = ac.CreateArray("interval_fwd_xy", 2, nullptr, nullptr,
+                                      Expr::Int16, Expr::Int16);
+  UpdateList updates(array, nullptr);
+  ref<Expr> x = ReadExpr::create(updates, int16(0));
+  ref<Expr> y = ReadExpr::create(updates, int16(1));
+
+  // Every query is answered, by the stage or by the core solver behind it
+  std::unique_ptr<Solver> core(createCoreSolver(CoreSolverToUse));
+  std::unique_ptr<Solver> chain(
+      createIntervalSolver(createCoreSolver(CoreSolverToUse)));
+
+  std::vector<CheckedQuery> queries = lc3Queries(x, y);
+  unsigned answered = checkAgainstCoreSolver(*chain, *core, {array}, queries);
+  EXPECT_EQ(queries.size(), answered);
+}
+
+} // namespace